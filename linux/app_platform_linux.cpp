@@ -0,0 +1,146 @@
+/*
+   M5NanoC6 Matter Switch - Linux Platform Hooks
+
+   app_switch_platform.h on the connectedhomeip Linux platform: the LED is
+   a log line, the OnOff attribute lives in the ZAP data model and the
+   button is a FIFO read by a helper thread that hands clicks to the CHIP
+   event loop.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include <app-common/zap-generated/attributes/Accessors.h>
+#include <lib/support/logging/CHIPLogging.h>
+#include <platform/PlatformManager.h>
+
+#include "app_platform_linux.h"
+#include "app_switch.h"
+#include "app_switch_platform.h"
+
+using namespace chip;
+using namespace chip::app::Clusters;
+using chip::Protocols::InteractionModel::Status;
+
+static uint32_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void app_platform_led_set_power(bool on)
+{
+    ChipLogProgress(AppServer, "LED: %s (%u ms)", on ? "ON" : "OFF", monotonic_ms());
+}
+
+void app_platform_led_identify_start(void)
+{
+    ChipLogProgress(AppServer, "LED: identify start (%u ms)", monotonic_ms());
+}
+
+void app_platform_led_identify_stop(bool current_power)
+{
+    ChipLogProgress(AppServer, "LED: identify stop, restore %s (%u ms)", current_power ? "ON" : "OFF", monotonic_ms());
+}
+
+void app_platform_led_ota_progress(uint8_t percent)
+{
+    ChipLogProgress(AppServer, "LED: OTA %u%%", percent);
+}
+
+bool app_platform_onoff_get(uint16_t endpoint_id)
+{
+    bool value = false;
+    Status status = OnOff::Attributes::OnOff::Get(endpoint_id, &value);
+    if (status != Status::Success) {
+        ChipLogError(AppServer, "OnOff read failed on endpoint %u: 0x%x", endpoint_id, to_underlying(status));
+    }
+    return value;
+}
+
+void app_platform_onoff_set(uint16_t endpoint_id, bool on)
+{
+    Status status = OnOff::Attributes::OnOff::Set(endpoint_id, on);
+    if (status != Status::Success) {
+        ChipLogError(AppServer, "OnOff write failed on endpoint %u: 0x%x", endpoint_id, to_underlying(status));
+    }
+}
+
+void app_platform_onoff_timer_store(uint16_t endpoint_id, uint16_t on_time, uint16_t off_wait_time, bool report)
+{
+    // Countdown steps update the stored value without a report
+    app::MarkAttributeDirty mark = report ? app::MarkAttributeDirty::kIfChanged : app::MarkAttributeDirty::kNo;
+    Status status = OnOff::Attributes::OnTime::Set(endpoint_id, on_time, mark);
+    if (status == Status::Success) {
+        status = OnOff::Attributes::OffWaitTime::Set(endpoint_id, off_wait_time, mark);
+    }
+    if (status != Status::Success) {
+        ChipLogError(AppServer, "OnTime/OffWaitTime write failed on endpoint %u: 0x%x", endpoint_id,
+                     to_underlying(status));
+    }
+}
+
+static void button_click_work(intptr_t arg)
+{
+    app_switch_toggle();
+}
+
+static void button_thread(void)
+{
+    // O_RDWR keeps the FIFO open between writers, so read() blocks instead of returning EOF
+    int fd = open(APP_LINUX_BUTTON_FIFO, O_RDWR);
+    if (fd < 0) {
+        ChipLogError(AppServer, "Button FIFO open failed: %s", strerror(errno));
+        return;
+    }
+
+    char line[64];
+    size_t len = 0;
+    for (;;) {
+        char c;
+        if (read(fd, &c, 1) != 1) {
+            break;
+        }
+        if (c != '\n') {
+            if (len < sizeof(line) - 1) {
+                line[len++] = c;
+            }
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+
+        if (strcmp(line, "click") == 0) {
+            // Attribute access must happen on the CHIP event loop
+            DeviceLayer::PlatformMgr().ScheduleWork(button_click_work);
+        } else if (line[0] != '\0') {
+            ChipLogError(AppServer, "Button FIFO: unknown command '%s'", line);
+        }
+    }
+    close(fd);
+}
+
+void app_platform_linux_button_start(void)
+{
+    if (mkfifo(APP_LINUX_BUTTON_FIFO, 0600) != 0 && errno != EEXIST) {
+        ChipLogError(AppServer, "Button FIFO create failed: %s", strerror(errno));
+        return;
+    }
+
+    // Reader blocks for the life of the process
+    std::thread(button_thread).detach();
+    ChipLogProgress(AppServer, "Virtual button: echo click > %s", APP_LINUX_BUTTON_FIFO);
+}
+
+void app_platform_linux_button_stop(void)
+{
+    unlink(APP_LINUX_BUTTON_FIFO);
+}
@@ -0,0 +1,19 @@
+/*
+   M5NanoC6 Matter Switch - Linux Platform Header
+
+   Virtual button: write "click" lines to APP_LINUX_BUTTON_FIFO to toggle
+   the switch, e.g. `echo click > /tmp/m5nanoc6-switch-button`.
+   The virtual LED logs its state (tag "LED") with a monotonic timestamp.
+*/
+
+#pragma once
+
+#define APP_LINUX_BUTTON_FIFO   "/tmp/m5nanoc6-switch-button"
+
+/** Create the button FIFO and start the reader thread
+ */
+void app_platform_linux_button_start(void);
+
+/** Remove the button FIFO
+ */
+void app_platform_linux_button_stop(void);
@@ -0,0 +1,83 @@
+/*
+   M5NanoC6 Matter Switch - Linux Application
+
+   Runs the same switch logic as the firmware (app/app_switch.cpp) on the
+   connectedhomeip Linux platform, so the full Matter path (commissioning,
+   invokes, subscriptions) can be exercised with chip-tool over loopback.
+   Command line options are the standard Linux example app options
+   (--discriminator, --passcode, --KVS, --secured-device-port, ...).
+*/
+
+#include <string.h>
+
+#include <AppMain.h>
+
+#include <app/ConcreteAttributePath.h>
+#include <app/clusters/identify-server/identify-server.h>
+#include <lib/support/CodeUtils.h>
+
+#include "app_platform_linux.h"
+#include "app_switch.h"
+
+using namespace chip;
+using namespace chip::app;
+
+static constexpr EndpointId kSwitchEndpointId = 1;
+
+static void OnIdentifyStart(Identify *identify)
+{
+    app_switch_identify(APP_SWITCH_IDENTIFY_START);
+}
+
+static void OnIdentifyStop(Identify *identify)
+{
+    app_switch_identify(APP_SWITCH_IDENTIFY_STOP);
+}
+
+static void OnTriggerEffect(Identify *identify)
+{
+    app_switch_identify(APP_SWITCH_IDENTIFY_EFFECT);
+}
+
+static Identify gIdentify1 = {
+    kSwitchEndpointId,
+    OnIdentifyStart,
+    OnIdentifyStop,
+    Clusters::Identify::IdentifyTypeEnum::kVisibleIndicator,
+    OnTriggerEffect,
+};
+
+void MatterPostAttributeChangeCallback(const ConcreteAttributePath &attributePath, uint8_t type, uint16_t size,
+                                       uint8_t *value)
+{
+    // Switch logic only consumes boolean, uint8 and uint16 attributes
+    uint32_t v;
+    if (size == 1) {
+        v = value[0];
+    } else if (size == 2) {
+        uint16_t u16;
+        memcpy(&u16, value, sizeof(u16));
+        v = u16;
+    } else {
+        return;
+    }
+    app_switch_attribute_changed(attributePath.mEndpointId, attributePath.mClusterId, attributePath.mAttributeId, v);
+}
+
+void ApplicationInit()
+{
+    app_switch_init(kSwitchEndpointId);
+    app_platform_linux_button_start();
+}
+
+void ApplicationShutdown()
+{
+    app_platform_linux_button_stop();
+}
+
+int main(int argc, char *argv[])
+{
+    VerifyOrDie(ChipLinuxAppInit(argc, argv) == 0);
+    ChipLinuxAppMainLoop();
+    return 0;
+}
@@ -0,0 +1,356 @@
+/*
+   M5NanoC6 Matter Switch - Hot Path Microbenchmarks
+
+   Each case runs APP_BENCH_WARMUP untimed calls, then n timed calls. Every
+   call is timed on its own with esp_cpu_get_cycle_count(). Work that is not
+   part of the measured path runs in untimed before/after hooks: taking the
+   CHIP stack lock around data model calls, the LED lock around strip
+   updates, and stopping the timer after a period change. The samples are
+   sorted, so interrupts and preemption only move p90 and max. Min and
+   median stay stable run to run. With CONFIG_PM_ENABLE the CPU is held at
+   its maximum frequency during the run.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_app_desc.h>
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_matter_console.h>
+#include <esp_rom_sys.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/timers.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+#include <app_priv.h>
+#include "app_bench.h"
+#include "app_config.h"
+#include "app_state.h"
+#include "app_switch.h"
+#include "app_ws2812.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static const char *TAG = "app_bench";
+
+typedef struct {
+    const char *name;
+    bool (*setup)(void);        // false: not available (e.g. LED not initialized)
+    void (*before)(void);       // Untimed, before each call (NULL = none)
+    void (*run)(void);          // Timed
+    void (*after)(void);        // Untimed, after each call (NULL = none)
+    void (*teardown)(void);     // NULL = none
+} bench_case_t;
+
+static uint32_t s_samples[APP_BENCH_MAX_ITERATIONS];
+static uint32_t s_errors = 0;               // Calls that reported failure in the current case
+static volatile uint32_t s_sink;
+
+static attribute_t *s_onoff_attr = NULL;    // Cached like s_onoff_attribute in app_platform_esp32.cpp
+static esp_matter_attr_val_t s_val;
+static uint32_t s_onoff_value;
+static app_onoff_timer_t s_scratch_timers;  // Timer table for attr_dispatch, never the live one
+
+static app_ws2812_t *s_strip = NULL;
+static uint8_t s_grb[APP_WS2812_BYTES_PER_PIXEL];  // Color shown before the case
+static uint8_t s_blue_lsb = 0;
+
+static TimerHandle_t s_timer = NULL;
+static StaticTimer_t s_timer_buf;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_pm_lock = NULL;
+#endif
+
+static void chip_lock(void)
+{
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+}
+
+static void chip_unlock(void)
+{
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+}
+
+static void led_lock(void)
+{
+    if (!app_driver_led_lock()) {
+        s_errors++;
+    }
+}
+
+static void led_unlock(void)
+{
+    app_driver_led_unlock();
+}
+
+// app_attribute_update_cb -> app_switch_attribute_changed with the current OnOff value. The timer
+// logic runs on an empty scratch table (no timed on/off in progress, the common case), so live
+// OnTime/OffWaitTime countdowns are not cleared and nothing is written back to the attributes.
+static bool dispatch_setup(void)
+{
+    s_onoff_value = app_state_power(app_state_get());
+    return app_switch_get_endpoint() != 0;
+}
+
+static void dispatch_before(void)
+{
+    chip_lock();
+    app_onoff_timer_init(&s_scratch_timers);
+    app_switch_bench_timers(&s_scratch_timers);
+}
+
+static void dispatch_run(void)
+{
+    app_switch_attribute_changed(app_switch_get_endpoint(), OnOff::Id, OnOff::Attributes::OnOff::Id, s_onoff_value);
+}
+
+static void dispatch_after(void)
+{
+    app_switch_bench_timers(NULL);
+    chip_unlock();
+}
+
+static bool get_val_setup(void)
+{
+    if (!s_onoff_attr) {
+        s_onoff_attr = attribute::get(app_switch_get_endpoint(), OnOff::Id, OnOff::Attributes::OnOff::Id);
+    }
+    return s_onoff_attr != NULL;
+}
+
+static void get_val_run(void)
+{
+    if (attribute::get_val(s_onoff_attr, &s_val) != ESP_OK) {
+        s_errors++;
+    }
+}
+
+static bool state_get_setup(void)
+{
+    return true;
+}
+
+static void state_get_run(void)
+{
+    s_sink = app_state_get();
+}
+
+static bool led_setup(void)
+{
+    s_strip = app_driver_get_led_strip();
+    if (!s_strip || !app_driver_led_lock()) {
+        return false;
+    }
+    memcpy(s_grb, s_strip->fb.grb, sizeof(s_grb));
+    app_driver_led_unlock();
+    s_blue_lsb = 0;
+    return true;
+}
+
+static void led_teardown(void)
+{
+    if (app_driver_led_lock()) {
+        app_ws2812_set_pixel(s_strip, 0, s_grb[1], s_grb[0], s_grb[2]);
+        app_ws2812_refresh(s_strip, app_config_get()->led_refresh_timeout_ms);
+        app_driver_led_unlock();
+    }
+}
+
+static void led_lock_run(void)
+{
+    if (app_driver_led_lock()) {
+        app_driver_led_unlock();
+    } else {
+        s_errors++;
+    }
+}
+
+// One-pixel frame: the blue LSB alternates so every refresh is sent (not visible)
+static void led_frame_run(void)
+{
+    s_blue_lsb ^= 1;
+    app_ws2812_set_pixel(s_strip, 0, s_grb[1], s_grb[0], s_grb[2] ^ s_blue_lsb);
+    if (app_ws2812_refresh(s_strip, app_config_get()->led_refresh_timeout_ms) != ESP_OK) {
+        s_errors++;
+    }
+}
+
+// Same color again: the refresh finds nothing dirty and returns without transmitting
+static void led_unchanged_run(void)
+{
+    app_ws2812_set_pixel(s_strip, 0, s_grb[1], s_grb[0], s_grb[2]);
+    app_ws2812_refresh(s_strip, app_config_get()->led_refresh_timeout_ms);
+}
+
+static void timer_noop_cb(TimerHandle_t timer)
+{
+}
+
+static bool timer_setup(void)
+{
+    if (!s_timer) {
+        // Same kind of timer as the identify/OTA blink timers, never allowed to fire
+        s_timer = xTimerCreateStatic("bench", pdMS_TO_TICKS(app_config_get()->identify_blink_ms), pdFALSE, NULL,
+                                     timer_noop_cb, &s_timer_buf);
+    }
+    return s_timer != NULL;
+}
+
+static void timer_run(void)
+{
+    if (xTimerChangePeriod(s_timer, pdMS_TO_TICKS(app_config_get()->identify_blink_ms), 0) != pdPASS) {
+        s_errors++;
+    }
+}
+
+static void timer_after(void)
+{
+    xTimerStop(s_timer, 0);
+    vTaskDelay(1);      // Let the timer task drain its command queue
+}
+
+static const bench_case_t s_cases[] = {
+    {"attr_dispatch", dispatch_setup, dispatch_before, dispatch_run, dispatch_after, NULL},
+    {"onoff_get_val", get_val_setup, chip_lock, get_val_run, chip_unlock, NULL},
+    {"state_get", state_get_setup, NULL, state_get_run, NULL, NULL},
+    {"led_lock", led_setup, NULL, led_lock_run, NULL, NULL},
+    {"led_set_refresh", led_setup, led_lock, led_frame_run, led_unlock, led_teardown},
+    {"led_set_unchanged", led_setup, led_lock, led_unchanged_run, led_unlock, led_teardown},
+    {"timer_change_period", timer_setup, NULL, timer_run, timer_after, NULL},
+};
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *static_cast<const uint32_t *>(a);
+    uint32_t y = *static_cast<const uint32_t *>(b);
+    return x < y ? -1 : x > y;
+}
+
+// Cost of reading the counter twice, subtracted from every sample
+static uint32_t counter_overhead(void)
+{
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < 32; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    return best;
+}
+
+static void run_case(const bench_case_t *c, int n, uint32_t overhead, uint32_t cpu_mhz, bool first)
+{
+    printf("%s{\"name\":\"%s\"", first ? "" : ",", c->name);
+    if (!c->setup()) {
+        printf(",\"skipped\":true}");
+        return;
+    }
+
+    s_errors = 0;
+    for (int i = 0; i < APP_BENCH_WARMUP + n; i++) {
+        if (c->before) {
+            c->before();
+        }
+        uint32_t start = esp_cpu_get_cycle_count();
+        c->run();
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (c->after) {
+            c->after();
+        }
+        if (i >= APP_BENCH_WARMUP) {
+            s_samples[i - APP_BENCH_WARMUP] = cycles > overhead ? cycles - overhead : 0;
+        }
+    }
+    if (c->teardown) {
+        c->teardown();
+    }
+
+    qsort(s_samples, n, sizeof(s_samples[0]), compare_u32);
+    uint32_t median = s_samples[n / 2];
+    printf(",\"n\":%d,\"min\":%" PRIu32 ",\"median\":%" PRIu32 ",\"p90\":%" PRIu32 ",\"max\":%" PRIu32
+           ",\"median_ns\":%" PRIu32 ",\"errors\":%" PRIu32 "}",
+           n, s_samples[0], median, s_samples[n * 9 / 10], s_samples[n - 1], median * 1000 / cpu_mhz, s_errors);
+}
+
+static esp_err_t bench_handler(int argc, char **argv)
+{
+    const char *only = argc > 0 && strcmp(argv[0], "all") != 0 ? argv[0] : NULL;
+    int n = argc > 1 ? atoi(argv[1]) : APP_BENCH_DEFAULT_ITERATIONS;
+    if (n < 1 || n > APP_BENCH_MAX_ITERATIONS) {
+        printf("Usage: bench [all|<case>] [iterations 1-%d]\n", APP_BENCH_MAX_ITERATIONS);
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool found = !only;
+    for (const bench_case_t &c : s_cases) {
+        found = found || strcmp(c.name, only) == 0;
+    }
+    if (!found) {
+        printf("{\"error\":\"unknown case\",\"cases\":[");
+        for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+            printf("%s\"%s\"", i ? "," : "", s_cases[i].name);
+        }
+        printf("]}\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_PM_ENABLE
+    if (s_pm_lock) {
+        esp_pm_lock_acquire(s_pm_lock);
+    }
+#endif
+    uint32_t cpu_mhz = esp_rom_get_cpu_ticks_per_us();
+    uint32_t overhead = counter_overhead();
+    ESP_LOGI(TAG, "Running %s, %d iterations at %" PRIu32 " MHz", only ? only : "all cases", n, cpu_mhz);
+
+    printf("{\"bench\":{\"target\":\"%s\",\"transport\":\"%s\",\"version\":\"%s\",\"cpu_mhz\":%" PRIu32
+           ",\"unit\":\"cycles\",\"overhead\":%" PRIu32 ",\"cases\":[",
+           CONFIG_IDF_TARGET, CHIP_DEVICE_CONFIG_ENABLE_THREAD ? "thread" : "wifi",
+           esp_app_get_description()->version, cpu_mhz, overhead);
+    bool first = true;
+    for (const bench_case_t &c : s_cases) {
+        if (!only || strcmp(c.name, only) == 0) {
+            run_case(&c, n, overhead, cpu_mhz, first);
+            first = false;
+        }
+    }
+    printf("]}}\n");
+
+#if CONFIG_PM_ENABLE
+    if (s_pm_lock) {
+        esp_pm_lock_release(s_pm_lock);
+    }
+#endif
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_bench_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+#if CONFIG_PM_ENABLE
+    // Created at boot so the run itself allocates nothing
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "bench", &s_pm_lock) != ESP_OK) {
+        ESP_LOGW(TAG, "No PM lock: cycle counts may include frequency changes");
+    }
+#endif
+    static const esp_matter::console::command_t command = {
+        .name = "bench",
+        .description = "Time the toggle/LED hot paths in CPU cycles, JSON: bench [all|<case>] [iterations]",
+        .handler = bench_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
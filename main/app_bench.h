@@ -0,0 +1,38 @@
+/*
+   M5NanoC6 Matter Switch - Hot Path Microbenchmarks Header
+
+   "matter bench [case] [iterations]" times the toggle and LED paths on the
+   device with the CPU cycle counter and prints one JSON line:
+     {"bench":{"target":"esp32c6","cpu_mhz":160,...,"cases":[{"name":...,
+      "n":64,"min":...,"median":...,"p90":...,"max":...,"median_ns":...}]}}
+   Cycles are per call, with the cost of reading the counter subtracted.
+   scripts/bench.py reads the line over serial and compares it with the
+   baselines in scripts/bench_baselines.json.
+
+   The cases leave the visible state unchanged. The LED is refreshed with
+   its current color (blue LSB toggled), and the attribute dispatch repeats
+   the current OnOff value.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_BENCH_DEFAULT_ITERATIONS    64
+#define APP_BENCH_MAX_ITERATIONS        256     // Samples kept per case (sorted for percentiles)
+#define APP_BENCH_WARMUP                8       // Untimed calls before each case (cache, lazy init)
+
+/**
+ * @brief Register the "bench" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_bench_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,178 @@
+/*
+   M5NanoC6 Matter Switch - BLE Lifecycle
+
+   BLEManager::Shutdown() stops the CHIPoBLE service; its state machine then
+   deinitializes the NimBLE host and controller (freeing their heap) and
+   posts kBLEDeinitialized, where the reclaimed heap is measured against a
+   snapshot taken just before the shutdown. BLEManager::Init() reverses it:
+   the controller and host are initialized again, and advertising starts
+   once the commissioning window asks for it. A window requested while a
+   shutdown is still in flight waits for kBLEDeinitialized: Init() cannot
+   run until the deinit has finished, and skipping it would leave the
+   window on a stack that is about to go away.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+
+#include <app/server/CommissioningWindowManager.h>
+#include <app/server/Server.h>
+#include <platform/CHIPDeviceLayer.h>
+#if CHIP_DEVICE_CONFIG_ENABLE_CHIPOBLE
+#include <platform/internal/BLEManager.h>
+#endif
+
+#include "app_ble.h"
+
+static const char *TAG = "app_ble";
+
+typedef enum {
+    BLE_STATE_RUNNING,
+    BLE_STATE_STOPPING,         // Shutdown requested, waiting for kBLEDeinitialized
+    BLE_STATE_STOPPED,
+} ble_state_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_ble_stats_t s_stats = {.running = CHIP_DEVICE_CONFIG_ENABLE_CHIPOBLE != 0};
+// Matter thread only
+static ble_state_t s_state = BLE_STATE_RUNNING;
+static size_t s_free_before = 0;
+static size_t s_largest_before = 0;
+static uint16_t s_pending_window_s = 0;     // Window requested while STOPPING; 0 = none
+
+void app_ble_release(void)
+{
+#if CHIP_DEVICE_CONFIG_ENABLE_CHIPOBLE
+    if (s_state != BLE_STATE_RUNNING) {
+        return;
+    }
+    chip::Server &server = chip::Server::GetInstance();
+    if (server.GetFabricTable().FabricCount() == 0 || server.GetCommissioningWindowManager().IsCommissioningWindowOpen() ||
+        chip::DeviceLayer::ConnectivityMgr().NumBLEConnections() > 0) {
+        return;
+    }
+
+    s_free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s_largest_before = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s_state = BLE_STATE_STOPPING;
+    chip::DeviceLayer::Internal::BLEMgr().Shutdown();
+    ESP_LOGI(TAG, "Commissioned: shutting BLE down (free heap %u)", (unsigned) s_free_before);
+#endif
+}
+
+void app_ble_deinitialized(void)
+{
+    if (s_state != BLE_STATE_STOPPING) {
+        return;     // Not a shutdown of ours
+    }
+    size_t free_now = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest_now = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s_state = BLE_STATE_STOPPED;
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.running = false;
+    s_stats.shutdowns++;
+    s_stats.last_reclaimed = static_cast<int32_t>(free_now) - static_cast<int32_t>(s_free_before);
+    s_stats.last_largest_gain = static_cast<int32_t>(largest_now) - static_cast<int32_t>(s_largest_before);
+    app_ble_stats_t st = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "BLE deinitialized: reclaimed %" PRId32 " bytes (free %u, largest block %u, %+" PRId32 ")",
+             st.last_reclaimed, (unsigned) free_now, (unsigned) largest_now, st.last_largest_gain);
+
+    if (s_pending_window_s) {
+        uint16_t timeout_s = s_pending_window_s;
+        s_pending_window_s = 0;
+        ESP_LOGI(TAG, "Opening the deferred commissioning window");
+        app_ble_open_commissioning_window(timeout_s);
+    }
+}
+
+esp_err_t app_ble_open_commissioning_window(uint16_t timeout_s)
+{
+    chip::CommissioningWindowManager &commissionMgr = chip::Server::GetInstance().GetCommissioningWindowManager();
+    if (commissionMgr.IsCommissioningWindowOpen()) {
+        return ESP_OK;
+    }
+
+    chip::CommissioningWindowAdvertisement advertisement = chip::CommissioningWindowAdvertisement::kDnssdOnly;
+#if CHIP_DEVICE_CONFIG_ENABLE_CHIPOBLE
+    if (s_state == BLE_STATE_STOPPING) {
+        // Init() would fail against the running deinit: open once it completes
+        s_pending_window_s = timeout_s;
+        ESP_LOGI(TAG, "BLE shutdown in progress: commissioning window deferred until it completes");
+        return ESP_OK;
+    }
+    bool ble_ready = (s_state == BLE_STATE_RUNNING);
+    if (!ble_ready) {
+        size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        CHIP_ERROR err = chip::DeviceLayer::Internal::BLEMgr().Init();
+        if (err == CHIP_NO_ERROR) {
+            ble_ready = true;
+            portENTER_CRITICAL(&s_lock);
+            s_stats.restarts++;
+            portEXIT_CRITICAL(&s_lock);
+            ESP_LOGI(TAG, "BLE restarted for commissioning (free heap %u -> %u)", (unsigned) free_before,
+                     (unsigned) heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        } else {
+            ESP_LOGE(TAG, "Failed to restart BLE, opening window on DNS-SD only: %" CHIP_ERROR_FORMAT, err.Format());
+        }
+    }
+    if (ble_ready) {
+        s_state = BLE_STATE_RUNNING;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.running = true;
+        portEXIT_CRITICAL(&s_lock);
+        advertisement = chip::CommissioningWindowAdvertisement::kAllSupported;
+    }
+#endif
+
+    CHIP_ERROR err = commissionMgr.OpenBasicCommissioningWindow(chip::System::Clock::Seconds16(timeout_s), advertisement);
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to open commissioning window, err:%" CHIP_ERROR_FORMAT, err.Format());
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void app_ble_get_stats(app_ble_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t ble_stats_handler(int argc, char **argv)
+{
+    app_ble_stats_t st;
+    app_ble_get_stats(&st);
+    printf("{\"running\":%s,\"shutdowns\":%" PRIu32 ",\"restarts\":%" PRIu32 ",\"last_reclaimed\":%" PRId32
+           ",\"last_largest_gain\":%" PRId32 ",\"free\":%u}\n",
+           st.running ? "true" : "false", st.shutdowns, st.restarts, st.last_reclaimed, st.last_largest_gain,
+           (unsigned) heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_ble_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "ble-stats",
+        .description = "Print BLE shutdown/restart counts and the heap reclaimed as JSON",
+        .handler = ble_stats_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
@@ -0,0 +1,68 @@
+/*
+   M5NanoC6 Matter Switch - BLE Lifecycle Header
+
+   BLE is only needed for commissioning. Once the device is commissioned
+   and no commissioning window is open, the CHIPoBLE layer and the NimBLE
+   host/controller are shut down and the heap they held is reported. A
+   basic commissioning window opened through app_ble_open_commissioning_window()
+   brings them back for its duration.
+
+   CONFIG_USE_BLE_ONLY_FOR_COMMISSIONING stays off: it also releases the
+   controller's static memory, which cannot be undone without a reboot.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+typedef struct {
+    bool running;               // NimBLE initialized (advertising or not)
+    uint32_t shutdowns;         // Completed shutdowns since boot
+    uint32_t restarts;          // Restarts for a commissioning window
+    int32_t last_reclaimed;     // Free heap gained by the last shutdown (bytes)
+    int32_t last_largest_gain;  // Largest free block gained by the last shutdown (bytes)
+} app_ble_stats_t;
+
+/**
+ * @brief Shut BLE down if the device no longer needs it
+ *
+ * Does nothing while uncommissioned, while a commissioning window is open
+ * or while a BLE connection is up. Call from the Matter thread on
+ * kServerReady, kCommissioningComplete and kCommissioningWindowClosed.
+ */
+void app_ble_release(void);
+
+/**
+ * @brief Report the heap reclaimed by a shutdown
+ *
+ * Call from the Matter thread on kBLEDeinitialized.
+ */
+void app_ble_deinitialized(void);
+
+/**
+ * @brief Open a basic commissioning window over BLE and DNS-SD
+ *
+ * Restarts BLE first if it was shut down; if it cannot be restarted the
+ * window is opened for DNS-SD only. While a shutdown is still completing
+ * the window is deferred to app_ble_deinitialized() and ESP_OK returned.
+ * Call from the Matter thread.
+ *
+ * @param timeout_s Window duration in seconds
+ * @return ESP_OK on success
+ */
+esp_err_t app_ble_open_commissioning_window(uint16_t timeout_s);
+
+/**
+ * @brief Copy BLE lifecycle statistics
+ *
+ * @param[out] out Statistics snapshot
+ */
+void app_ble_get_stats(app_ble_stats_t *out);
+
+/**
+ * @brief Register "ble-stats" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_ble_register_commands(void);
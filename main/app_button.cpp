@@ -0,0 +1,256 @@
+/*
+   M5NanoC6 Matter Switch - Button Driver
+
+   The GPIO ISR only timestamps the edge and queues it. The button task
+   blocks on the queue with a timeout set to the engine's next deadline
+   (debounce lockout expiry or long press), so an untouched button costs
+   no CPU wakeups and a press is reported on its first edge.
+
+   With CONFIG_PM_ENABLE, light sleep can only be woken by a level
+   interrupt, and gpio_wakeup_enable() puts that level type on the same pin
+   as the edge interrupt. A level interrupt keeps firing while the line
+   stays at that level. So the wakeup level is armed only while the engine
+   is idle. The ISR puts the pin back to ANYEDGE on the first interrupt,
+   and a no-light-sleep PM lock is held until the engine is idle again.
+*/
+
+#include <atomic>
+#include <inttypes.h>
+
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#include <hal/gpio_ll.h>
+#endif
+
+#include "app_button.h"
+#include "app_config.h"
+#include "app_evlog.h"
+#include "app_priv.h"
+
+static const char *TAG = "app_button";
+
+typedef struct {
+    int64_t time_us;
+    bool pressed;
+} button_edge_t;
+
+// Callback slot per APP_BUTTON_EVENT_* bit
+#define BUTTON_EVENT_COUNT  4
+
+typedef struct {
+    gpio_num_t gpio;
+    app_button_engine_t engine;         // Only touched by the button task
+    std::atomic<bool> pressed;
+    app_button_cb_t cb[BUTTON_EVENT_COUNT];
+    void *cb_data[BUTTON_EVENT_COUNT];
+} app_button_t;
+
+static app_button_t s_button;
+static QueueHandle_t s_edge_queue = NULL;
+static TaskHandle_t s_button_task = NULL;
+
+// Statically allocated RTOS objects (no heap use after boot)
+static StaticQueue_t s_edge_queue_buf;
+static uint8_t s_edge_queue_storage[BUTTON_EDGE_QUEUE_LEN * sizeof(button_edge_t)];
+static StaticTask_t s_button_task_buf;
+static StackType_t s_button_task_stack[BUTTON_TASK_STACK_SIZE];
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_pm_lock = NULL;   // No light sleep while a gesture is in progress
+static bool s_wake_armed = false;               // Pin has the level wakeup type (button task only)
+#endif
+
+static inline bool read_pressed(gpio_num_t gpio)
+{
+    return gpio_get_level(gpio) == 0;   // Active low
+}
+
+static void IRAM_ATTR button_isr(void *arg)
+{
+#if CONFIG_PM_ENABLE
+    // Back to edges before the level interrupt can fire again (gpio_set_intr_type() is not in IRAM)
+    gpio_ll_set_intr_type(GPIO_LL_GET_HW(GPIO_PORT_0), s_button.gpio, GPIO_INTR_ANYEDGE);
+#endif
+    button_edge_t edge = {
+        .time_us = esp_timer_get_time(),
+        .pressed = read_pressed(s_button.gpio),
+    };
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(s_edge_queue, &edge, &woken);   // Full queue: a later edge or deadline catches up
+    portYIELD_FROM_ISR(woken);
+}
+
+static void dispatch(uint32_t event)
+{
+    for (int i = 0; i < BUTTON_EVENT_COUNT; i++) {
+        if ((event & (1U << i)) && s_button.cb[i]) {
+            s_button.cb[i](&s_button, s_button.cb_data[i]);
+        }
+    }
+}
+
+static TickType_t ticks_until(int64_t deadline_us)
+{
+    if (deadline_us == APP_BUTTON_NO_DEADLINE) {
+        return portMAX_DELAY;
+    }
+    int64_t remaining_us = deadline_us - esp_timer_get_time();
+    if (remaining_us <= 0) {
+        return 0;
+    }
+    // Round up so the deadline has passed when the wait ends
+    return static_cast<TickType_t>((remaining_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+}
+
+#if CONFIG_PM_ENABLE
+// Engine idle: wake on the opposite of the debounced level and allow light sleep
+static void arm_wakeup(void)
+{
+    s_wake_armed = true;
+    gpio_wakeup_enable(s_button.gpio, s_button.engine.pressed ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    esp_pm_lock_release(s_pm_lock);
+}
+
+// Woken by the level interrupt (the ISR has restored ANYEDGE): stay awake until idle
+static void disarm_wakeup(void)
+{
+    s_wake_armed = false;
+    esp_pm_lock_acquire(s_pm_lock);
+}
+#endif
+
+static void button_task(void *pvParameters)
+{
+    for (;;) {
+        int64_t deadline = app_button_engine_next_deadline(&s_button.engine);
+#if CONFIG_PM_ENABLE
+        if (deadline == APP_BUTTON_NO_DEADLINE && !s_wake_armed) {
+            arm_wakeup();
+        }
+#endif
+        button_edge_t edge;
+        if (xQueueReceive(s_edge_queue, &edge, ticks_until(deadline)) != pdTRUE) {
+            // Deadline reached: sample the current level
+            edge.time_us = esp_timer_get_time();
+            edge.pressed = read_pressed(s_button.gpio);
+        }
+#if CONFIG_PM_ENABLE
+        if (s_wake_armed) {
+            disarm_wakeup();
+        }
+#endif
+
+        uint32_t events = app_button_engine_feed(&s_button.engine, edge.time_us, edge.pressed);
+        if (!events) {
+            continue;
+        }
+
+        s_button.pressed = s_button.engine.pressed;
+        if (events & APP_BUTTON_EVENT_PRESS_DOWN) {
+            ESP_LOGD(TAG, "Press detected %" PRIu32 " us after edge",
+                     static_cast<uint32_t>(esp_timer_get_time() - edge.time_us));
+        }
+        uint32_t gestures = events & (APP_BUTTON_EVENT_SINGLE_CLICK | APP_BUTTON_EVENT_LONG_PRESS_START);
+        if (gestures) {
+            app_evlog_record(APP_EVLOG_BUTTON, &gestures, 1);
+        }
+        dispatch(events);
+    }
+}
+
+extern "C" void *app_button_create(int gpio_num)
+{
+    if (s_button_task) {
+        ESP_LOGE(TAG, "Button already created");
+        return NULL;
+    }
+
+    s_button.gpio = static_cast<gpio_num_t>(gpio_num);
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << gpio_num),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO config failed: %d", err);
+        return NULL;
+    }
+
+    bool pressed = read_pressed(s_button.gpio);
+    // Timings are copied into the engine once; the runtime config does not change after boot
+    const app_config_t *config = app_config_get();
+    app_button_engine_init(&s_button.engine, config->button_debounce_ms, config->button_long_press_ms, pressed,
+                           esp_timer_get_time());
+    s_button.pressed = pressed;
+
+#if CONFIG_PM_ENABLE
+    // Held from boot until the button task first arms the wakeup level
+    err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "button", &s_pm_lock);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "PM lock create failed: %d", err);
+        return NULL;
+    }
+    esp_pm_lock_acquire(s_pm_lock);
+#endif
+
+    s_edge_queue = xQueueCreateStatic(BUTTON_EDGE_QUEUE_LEN, sizeof(button_edge_t), s_edge_queue_storage,
+                                      &s_edge_queue_buf);
+
+    // Shared ISR service: may already be installed by another driver
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO ISR service install failed: %d", err);
+        return NULL;
+    }
+    err = gpio_isr_handler_add(s_button.gpio, button_isr, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO ISR handler add failed: %d", err);
+        return NULL;
+    }
+
+#if CONFIG_PM_ENABLE
+    // The wakeup level itself is armed by the button task once the engine is idle
+    esp_sleep_enable_gpio_wakeup();
+#endif
+
+    // Started after the ISR is attached: the task arms the wakeup level, which only the ISR clears
+    s_button_task = xTaskCreateStatic(button_task, "button", BUTTON_TASK_STACK_SIZE, NULL, BUTTON_TASK_PRIORITY,
+                                      s_button_task_stack, &s_button_task_buf);
+
+    return &s_button;
+}
+
+extern "C" esp_err_t app_button_register_cb(void *handle, uint32_t event, app_button_cb_t cb, void *data)
+{
+    if (handle != &s_button || !cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < BUTTON_EVENT_COUNT; i++) {
+        if (event == (1U << i)) {
+            if (s_button.cb[i]) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            s_button.cb_data[i] = data;
+            s_button.cb[i] = cb;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+extern "C" bool app_button_is_pressed(void *handle)
+{
+    return handle == &s_button && s_button.pressed.load();
+}
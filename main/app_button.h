@@ -0,0 +1,61 @@
+/*
+   M5NanoC6 Matter Switch - Button Driver Header
+
+   GPIO edge-interrupt button driver. Edges are timestamped in the ISR and
+   fed to the debounce/gesture engine (app_button_engine.h) by a task that
+   sleeps until the next edge or engine deadline - no polling while idle.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#include "app_button_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Button event callback
+ *
+ * Runs in the button task. Callbacks may block; edges that arrive
+ * meanwhile are queued with their timestamps and processed afterwards.
+ *
+ * @param arg Button handle
+ * @param data User data passed to app_button_register_cb()
+ */
+typedef void (*app_button_cb_t)(void *arg, void *data);
+
+/**
+ * @brief Create the button on an active-low GPIO
+ *
+ * @param gpio_num Button GPIO (internal pull-up enabled)
+ * @return Button handle, NULL on failure
+ */
+void *app_button_create(int gpio_num);
+
+/**
+ * @brief Register a callback for one event
+ *
+ * @param handle Button handle from app_button_create()
+ * @param event One APP_BUTTON_EVENT_* bit
+ * @param cb Callback
+ * @param data User data passed to the callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the event already has a callback
+ */
+esp_err_t app_button_register_cb(void *handle, uint32_t event, app_button_cb_t cb, void *data);
+
+/**
+ * @brief Debounced button state
+ *
+ * @param handle Button handle from app_button_create()
+ * @return true if pressed
+ */
+bool app_button_is_pressed(void *handle);
+
+#ifdef __cplusplus
+}
+#endif
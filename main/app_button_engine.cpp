@@ -0,0 +1,67 @@
+/*
+   M5NanoC6 Matter Switch - Button Debounce/Gesture Engine
+
+   No ESP-IDF dependencies: see app_button_engine.h.
+*/
+
+#include "app_button_engine.h"
+
+void app_button_engine_init(app_button_engine_t *engine, uint32_t debounce_ms, uint32_t long_press_ms,
+                            bool pressed, int64_t now_us)
+{
+    engine->debounce_us = static_cast<int64_t>(debounce_ms) * 1000;
+    engine->long_press_us = static_cast<int64_t>(long_press_ms) * 1000;
+    engine->last_change_us = now_us - engine->debounce_us;
+    engine->pressed_at_us = now_us;
+    engine->raw_pressed = pressed;
+    engine->pressed = pressed;
+    engine->long_fired = pressed;   // Held at boot: no gesture until released
+}
+
+uint32_t app_button_engine_feed(app_button_engine_t *engine, int64_t now_us, bool pressed)
+{
+    uint32_t events = 0;
+    engine->raw_pressed = pressed;
+
+    // Accept a level change once the lockout from the previous one has passed
+    if (engine->raw_pressed != engine->pressed && now_us - engine->last_change_us >= engine->debounce_us) {
+        engine->pressed = engine->raw_pressed;
+        engine->last_change_us = now_us;
+        if (engine->pressed) {
+            engine->pressed_at_us = now_us;
+            engine->long_fired = false;
+            events |= APP_BUTTON_EVENT_PRESS_DOWN;
+        } else {
+            events |= APP_BUTTON_EVENT_PRESS_UP;
+            if (!engine->long_fired) {
+                events |= APP_BUTTON_EVENT_SINGLE_CLICK;
+            }
+        }
+    }
+
+    if (engine->pressed && !engine->long_fired && now_us - engine->pressed_at_us >= engine->long_press_us) {
+        engine->long_fired = true;
+        events |= APP_BUTTON_EVENT_LONG_PRESS_START;
+    }
+
+    return events;
+}
+
+int64_t app_button_engine_next_deadline(const app_button_engine_t *engine)
+{
+    int64_t deadline = APP_BUTTON_NO_DEADLINE;
+
+    // Level changed during the lockout: re-check when it expires
+    if (engine->raw_pressed != engine->pressed) {
+        deadline = engine->last_change_us + engine->debounce_us;
+    }
+
+    if (engine->pressed && !engine->long_fired) {
+        int64_t long_press_at = engine->pressed_at_us + engine->long_press_us;
+        if (long_press_at < deadline) {
+            deadline = long_press_at;
+        }
+    }
+
+    return deadline;
+}
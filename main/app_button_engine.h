@@ -0,0 +1,74 @@
+/*
+   M5NanoC6 Matter Switch - Button Debounce/Gesture Engine
+
+   Hardware-independent state machine fed with timestamped button levels.
+   The driver calls app_button_engine_feed() on every GPIO edge and again
+   at app_button_engine_next_deadline(); nothing runs while the button is
+   idle. Same input sequence always produces the same events, so recorded
+   edge traces can be replayed through it off-target.
+
+   Debounce is leading-edge: a level change is accepted immediately if the
+   previous accepted change is at least debounce_us old, otherwise it is
+   re-checked once the lockout expires.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Event bits returned by app_button_engine_feed()
+#define APP_BUTTON_EVENT_PRESS_DOWN         (1U << 0)
+#define APP_BUTTON_EVENT_PRESS_UP           (1U << 1)
+#define APP_BUTTON_EVENT_SINGLE_CLICK       (1U << 2)   // Released before long press
+#define APP_BUTTON_EVENT_LONG_PRESS_START   (1U << 3)
+
+#define APP_BUTTON_NO_DEADLINE              INT64_MAX
+
+typedef struct {
+    int64_t debounce_us;
+    int64_t long_press_us;
+    int64_t last_change_us;     // Last accepted level change
+    int64_t pressed_at_us;
+    bool raw_pressed;           // Most recent level fed in
+    bool pressed;               // Debounced level
+    bool long_fired;
+} app_button_engine_t;
+
+/**
+ * @brief Initialize engine state
+ *
+ * @param engine Engine instance
+ * @param debounce_ms Lockout after an accepted level change
+ * @param long_press_ms Hold time before APP_BUTTON_EVENT_LONG_PRESS_START
+ * @param pressed Button level at init
+ * @param now_us Current time
+ */
+void app_button_engine_init(app_button_engine_t *engine, uint32_t debounce_ms, uint32_t long_press_ms,
+                            bool pressed, int64_t now_us);
+
+/**
+ * @brief Feed a button level sample
+ *
+ * Call on every edge with the edge timestamp, and at the deadline
+ * returned by app_button_engine_next_deadline() with the current level.
+ * Timestamps must not go backwards.
+ *
+ * @return Bitmask of APP_BUTTON_EVENT_* raised by this sample
+ */
+uint32_t app_button_engine_feed(app_button_engine_t *engine, int64_t now_us, bool pressed);
+
+/**
+ * @brief Time at which the engine next needs a sample
+ *
+ * @return Absolute time in microseconds, or APP_BUTTON_NO_DEADLINE when idle
+ */
+int64_t app_button_engine_next_deadline(const app_button_engine_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
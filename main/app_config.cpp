@@ -0,0 +1,144 @@
+/*
+   M5NanoC6 Matter Switch - Runtime Configuration
+
+   The partition stays mapped for the life of the firmware, and
+   app_config_get() returns a pointer into the mapping. The MMU maps whole
+   pages, so the mapping costs address space but no RAM. If the partition is
+   missing, erased or fails a check, the compiled defaults are used, and the
+   reason is logged and shown by the "config" command.
+*/
+
+#include <stdio.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_partition.h>
+
+#include "app_config.h"
+#include "app_priv.h"
+
+static const char *TAG = "app_config";
+
+static const app_config_t s_defaults = {
+    .identify_blink_ms = LED_IDENTIFY_BLINK_MS,
+    .ota_blink_ms = LED_OTA_BLINK_MS,
+    .led_refresh_timeout_ms = LED_REFRESH_TIMEOUT_MS,
+    .button_debounce_ms = BUTTON_DEBOUNCE_MS,
+    .button_long_press_ms = BUTTON_LONG_PRESS_MS,
+    .id_bit_ms = FIRMWARE_CONFIG_ID_BIT_DELAY_MS,
+    .id_pattern_gap_ms = FIRMWARE_CONFIG_ID_PATTERN_DELAY_MS,
+    .reset_start_delay_ms = FIRMWARE_CONFIG_ID_START_DELAY_MS,
+    .reset_result_ms = FIRMWARE_CONFIG_ID_RESULT_MS,
+    .id_bits = FIRMWARE_CONFIG_ID_BITS,
+    .reset_repeat_count = FIRMWARE_CONFIG_ID_REPEAT_COUNT,
+    .identify_repeat_count = IDENTIFY_CONFIG_ID_REPEAT_COUNT,
+    .on = {LED_COLOR_ON_R, LED_COLOR_ON_G, LED_COLOR_ON_B},
+    .off = {LED_COLOR_OFF_R, LED_COLOR_OFF_G, LED_COLOR_OFF_B},
+    .identify = {LED_COLOR_IDENTIFY_R, LED_COLOR_IDENTIFY_G, LED_COLOR_IDENTIFY_B},
+    .bit_1 = {LED_COLOR_BIT_1_R, LED_COLOR_BIT_1_G, LED_COLOR_BIT_1_B},
+    .bit_0 = {LED_COLOR_BIT_0_R, LED_COLOR_BIT_0_G, LED_COLOR_BIT_0_B},
+    .cancel = {LED_COLOR_CANCEL_R, LED_COLOR_CANCEL_G, LED_COLOR_CANCEL_B},
+    .confirm = {LED_COLOR_CONFIRM_R, LED_COLOR_CONFIRM_G, LED_COLOR_CONFIRM_B},
+    .ota_min = {LED_COLOR_OTA_R, LED_COLOR_OTA_GB_MIN, LED_COLOR_OTA_GB_MIN},
+    .ota_max = {LED_COLOR_OTA_R, LED_COLOR_OTA_GB_MAX, LED_COLOR_OTA_GB_MAX},
+    .reserved = {0, 0},
+};
+
+static const app_config_t *s_config = &s_defaults;
+static app_config_status_t s_status = APP_CONFIG_ERASED;
+static bool s_found = false;
+static esp_partition_mmap_handle_t s_mmap;
+
+esp_err_t app_config_init(void)
+{
+    const char *bad_field = app_config_values_check(&s_defaults);
+    if (bad_field) {
+        ESP_LOGE(TAG, "Compiled default %s is out of range (app_priv.h)", bad_field);
+    }
+
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, static_cast<esp_partition_subtype_t>(APP_CONFIG_PARTITION_SUBTYPE),
+        APP_CONFIG_PARTITION_LABEL);
+    if (!partition) {
+        ESP_LOGW(TAG, "No \"%s\" partition, using compiled defaults", APP_CONFIG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_found = true;
+
+    const void *view = NULL;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &view, &s_mmap);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map \"%s\": %s", APP_CONFIG_PARTITION_LABEL, esp_err_to_name(err));
+        return err;
+    }
+
+    const app_config_t *config = NULL;
+    s_status = app_config_blob_check(static_cast<const uint8_t *>(view), partition->size, &config);
+    if (s_status != APP_CONFIG_OK) {
+        // Nothing points into the view: give the address space back
+        esp_partition_munmap(s_mmap);
+        if (s_status == APP_CONFIG_ERASED) {
+            ESP_LOGI(TAG, "No configuration blob, using compiled defaults");
+        } else {
+            ESP_LOGW(TAG, "Configuration blob rejected (%s), using compiled defaults",
+                     app_config_status_name(s_status));
+        }
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_config = config;
+    ESP_LOGI(TAG, "Configuration blob v%d, %u bytes, mapped at %p", APP_CONFIG_VERSION,
+             static_cast<unsigned>(sizeof(app_config_t)), view);
+    return ESP_OK;
+}
+
+const app_config_t *app_config_get(void)
+{
+    return s_config;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void print_color(const char *name, const app_config_color_t *c)
+{
+    printf(",\"%s\":[%u,%u,%u]", name, c->r, c->g, c->b);
+}
+
+static esp_err_t config_handler(int argc, char **argv)
+{
+    const app_config_t *c = s_config;
+    printf("{\"source\":\"%s\",\"status\":\"%s\",\"version\":%d", c == &s_defaults ? "defaults" : "partition",
+           s_found ? app_config_status_name(s_status) : "no-partition", APP_CONFIG_VERSION);
+    printf(",\"identify_blink_ms\":%u,\"ota_blink_ms\":%u,\"led_refresh_timeout_ms\":%u", c->identify_blink_ms,
+           c->ota_blink_ms, c->led_refresh_timeout_ms);
+    printf(",\"button_debounce_ms\":%u,\"button_long_press_ms\":%u", c->button_debounce_ms,
+           c->button_long_press_ms);
+    printf(",\"id_bit_ms\":%u,\"id_pattern_gap_ms\":%u,\"reset_start_delay_ms\":%u,\"reset_result_ms\":%u",
+           c->id_bit_ms, c->id_pattern_gap_ms, c->reset_start_delay_ms, c->reset_result_ms);
+    printf(",\"id_bits\":%u,\"reset_repeat_count\":%u,\"identify_repeat_count\":%u", c->id_bits,
+           c->reset_repeat_count, c->identify_repeat_count);
+    print_color("on", &c->on);
+    print_color("off", &c->off);
+    print_color("identify", &c->identify);
+    print_color("bit_1", &c->bit_1);
+    print_color("bit_0", &c->bit_0);
+    print_color("cancel", &c->cancel);
+    print_color("confirm", &c->confirm);
+    print_color("ota_min", &c->ota_min);
+    print_color("ota_max", &c->ota_max);
+    printf("}\n");
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_config_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "config",
+        .description = "Print the runtime configuration (appcfg partition or compiled defaults) as JSON",
+        .handler = config_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
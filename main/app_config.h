@@ -0,0 +1,53 @@
+/*
+   M5NanoC6 Matter Switch - Runtime Configuration Header
+
+   LED colors, blink periods and button/reset timings. They come from the
+   "appcfg" partition when it holds a valid blob (format:
+   app_config_engine.h) and from the compiled defaults in app_priv.h
+   otherwise. The blob is read in place through a memory-mapped view of the
+   partition, with no RAM copy. Build and flash blobs with
+   "make config-blob" / "make flash-config" (scripts/app_config_tool.py).
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#include "app_config_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_CONFIG_PARTITION_LABEL      "appcfg"
+#define APP_CONFIG_PARTITION_SUBTYPE    0x41    // Custom data subtype (partitions.csv)
+
+/**
+ * @brief Map the partition and select the blob or the compiled defaults
+ *
+ * Call early in app_main, before app_driver_led_init().
+ *
+ * @return ESP_OK if the blob is used, ESP_ERR_NOT_FOUND or
+ *         ESP_ERR_INVALID_STATE if the defaults are used
+ */
+esp_err_t app_config_init(void);
+
+/**
+ * @brief Active configuration
+ *
+ * Never NULL: the compiled defaults until app_config_init() selects the
+ * blob. The values do not change after init. Points into flash: do not
+ * read it from ISRs that run while the flash cache is disabled.
+ */
+const app_config_t *app_config_get(void);
+
+/**
+ * @brief Register the "config" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_config_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+   M5NanoC6 Matter Switch - Runtime Configuration Engine
+
+   No ESP-IDF dependencies: see app_config_engine.h.
+*/
+
+#include <string.h>
+
+#include "app_config_engine.h"
+
+static_assert(sizeof(app_config_t) == 50, "app_config_t is the wire format: append fields, never reorder");
+static_assert(offsetof(app_config_t, on) == 21, "app_config_t must not contain padding");
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+uint32_t app_config_crc32(const uint8_t *data, size_t len)
+{
+    // Bitwise: the payload is checked once per boot, a table is not worth its flash
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static bool in_range(uint32_t value, uint32_t min, uint32_t max)
+{
+    return value >= min && value <= max;
+}
+
+const char *app_config_values_check(const app_config_t *c)
+{
+    if (!in_range(c->identify_blink_ms, 20, 10000)) {
+        return "identify_blink_ms";
+    }
+    if (!in_range(c->ota_blink_ms, 20, 10000)) {
+        return "ota_blink_ms";
+    }
+    if (!in_range(c->led_refresh_timeout_ms, 10, 1000)) {
+        return "led_refresh_timeout_ms";
+    }
+    if (!in_range(c->button_debounce_ms, 1, 200)) {
+        return "button_debounce_ms";
+    }
+    if (!in_range(c->button_long_press_ms, 300, 10000) || c->button_long_press_ms <= c->button_debounce_ms) {
+        return "button_long_press_ms";
+    }
+    if (!in_range(c->id_bit_ms, 50, 5000)) {
+        return "id_bit_ms";
+    }
+    if (c->id_pattern_gap_ms > 10000) {
+        return "id_pattern_gap_ms";
+    }
+    if (c->reset_start_delay_ms > 10000) {
+        return "reset_start_delay_ms";
+    }
+    if (c->reset_result_ms > 10000) {
+        return "reset_result_ms";
+    }
+    if (!in_range(c->id_bits, 1, 8)) {
+        return "id_bits";
+    }
+    if (!in_range(c->reset_repeat_count, 1, 20)) {
+        return "reset_repeat_count";
+    }
+    if (!in_range(c->identify_repeat_count, 1, 20)) {
+        return "identify_repeat_count";
+    }
+    if (c->reserved[0] || c->reserved[1]) {
+        return "reserved";
+    }
+    return NULL;
+}
+
+app_config_status_t app_config_blob_check(const uint8_t *blob, size_t size, const app_config_t **out)
+{
+    if (size < APP_CONFIG_HEADER_SIZE) {
+        return APP_CONFIG_BAD_LENGTH;
+    }
+    uint32_t magic = get_u32(blob);
+    if (magic == 0xFFFFFFFFU) {
+        return APP_CONFIG_ERASED;
+    }
+    if (magic != APP_CONFIG_MAGIC) {
+        return APP_CONFIG_BAD_MAGIC;
+    }
+    if (get_u16(blob + 4) != APP_CONFIG_VERSION) {
+        return APP_CONFIG_BAD_VERSION;
+    }
+    size_t length = get_u16(blob + 6);
+    if (length < sizeof(app_config_t) || length > size - APP_CONFIG_HEADER_SIZE) {
+        return APP_CONFIG_BAD_LENGTH;
+    }
+    const uint8_t *payload = blob + APP_CONFIG_HEADER_SIZE;
+    if (app_config_crc32(payload, length) != get_u32(blob + 8)) {
+        return APP_CONFIG_BAD_CRC;
+    }
+    const app_config_t *config = reinterpret_cast<const app_config_t *>(payload);
+    if (app_config_values_check(config)) {
+        return APP_CONFIG_BAD_VALUE;
+    }
+    *out = config;
+    return APP_CONFIG_OK;
+}
+
+size_t app_config_blob_build(const app_config_t *config, uint8_t *out)
+{
+    uint8_t *payload = out + APP_CONFIG_HEADER_SIZE;
+    memcpy(payload, config, sizeof(*config));
+    put_u32(out, APP_CONFIG_MAGIC);
+    put_u16(out + 4, APP_CONFIG_VERSION);
+    put_u16(out + 6, sizeof(*config));
+    put_u32(out + 8, app_config_crc32(payload, sizeof(*config)));
+    return APP_CONFIG_HEADER_SIZE + sizeof(*config);
+}
+
+const char *app_config_status_name(app_config_status_t status)
+{
+    static const char *const names[] = {"ok", "erased", "bad-magic", "bad-version", "bad-length", "bad-crc",
+                                        "bad-value"};
+    return static_cast<size_t>(status) < sizeof(names) / sizeof(names[0]) ? names[status] : "?";
+}
@@ -0,0 +1,117 @@
+/*
+   M5NanoC6 Matter Switch - Runtime Configuration Engine
+
+   Layout and checks for the configuration blob stored in the "appcfg"
+   flash partition. The blob holds LED colors, blink periods and the
+   button/reset timings, so one firmware image can serve every variant.
+   The firmware reads the blob in place through a memory-mapped view of
+   the partition (app_config.h). This file only checks it.
+   scripts/app_config_tool.py builds blobs and checks them by building
+   this file for the host.
+
+   Blob layout (little-endian, at offset 0 of the partition):
+     Header:  magic u32 "ACFG", version u16, length u16 (payload bytes),
+              crc32 u32 (IEEE 802.3, over the payload)
+     Payload: app_config_t
+
+   version changes only when existing fields change meaning or position.
+   New fields are appended without changing it. Firmware ignores payload
+   bytes beyond the fields it knows. A blob that is shorter than the
+   firmware's app_config_t is rejected, and the compiled defaults are used.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_CONFIG_MAGIC        0x47464341U     // "ACFG"
+#define APP_CONFIG_VERSION      1
+#define APP_CONFIG_HEADER_SIZE  12
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} app_config_color_t;
+
+// Field order is the wire format: append only, every field naturally aligned
+typedef struct {
+    uint16_t identify_blink_ms;         // Identify timer period
+    uint16_t ota_blink_ms;              // OTA overlay alternation period
+    uint16_t led_refresh_timeout_ms;    // WS2812 transmit timeout
+    uint16_t button_debounce_ms;        // Lockout after an accepted edge
+    uint16_t button_long_press_ms;      // Hold time that starts the factory reset sequence
+    uint16_t id_bit_ms;                 // Config ID pattern: time per bit
+    uint16_t id_pattern_gap_ms;         // Config ID pattern: pause between repetitions
+    uint16_t reset_start_delay_ms;      // Hold time after the long press before the pattern starts
+    uint16_t reset_result_ms;           // Cancel/confirm color shown after the pattern
+    uint8_t id_bits;                    // Config ID bits shown, 1-8
+    uint8_t reset_repeat_count;         // Pattern repetitions while the button is held
+    uint8_t identify_repeat_count;      // Pattern repetitions for Identify
+    app_config_color_t on;
+    app_config_color_t off;
+    app_config_color_t identify;
+    app_config_color_t bit_1;           // Config ID pattern: 1 bit
+    app_config_color_t bit_0;           // Config ID pattern: 0 bit
+    app_config_color_t cancel;          // Reset cancelled (button released)
+    app_config_color_t confirm;         // Reset confirmed (button held)
+    app_config_color_t ota_min;         // OTA overlay at 0 %
+    app_config_color_t ota_max;         // OTA overlay at 100 %
+    uint8_t reserved[2];                // Zero
+} app_config_t;
+
+typedef enum {
+    APP_CONFIG_OK = 0,
+    APP_CONFIG_ERASED,          // Partition never written
+    APP_CONFIG_BAD_MAGIC,
+    APP_CONFIG_BAD_VERSION,
+    APP_CONFIG_BAD_LENGTH,      // Shorter than app_config_t, or past the end of the partition
+    APP_CONFIG_BAD_CRC,
+    APP_CONFIG_BAD_VALUE,       // A field out of range (app_config_values_check())
+} app_config_status_t;
+
+/**
+ * @brief Check a blob and locate its payload
+ *
+ * @param blob Start of the partition (memory-mapped on the device)
+ * @param size Bytes readable at blob
+ * @param[out] out Payload inside blob, set only on APP_CONFIG_OK
+ * @return APP_CONFIG_OK or the first problem found
+ */
+app_config_status_t app_config_blob_check(const uint8_t *blob, size_t size, const app_config_t **out);
+
+/**
+ * @brief Range-check the fields of a configuration
+ *
+ * @return NULL if every field is usable, otherwise the name of the first bad field
+ */
+const char *app_config_values_check(const app_config_t *config);
+
+/**
+ * @brief Write a blob (header and payload) for a configuration
+ *
+ * @param config Values to store
+ * @param[out] out Buffer of at least APP_CONFIG_HEADER_SIZE + sizeof(app_config_t) bytes
+ * @return Bytes written
+ */
+size_t app_config_blob_build(const app_config_t *config, uint8_t *out);
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as zlib.crc32)
+ */
+uint32_t app_config_crc32(const uint8_t *data, size_t len);
+
+/**
+ * @brief Short name of a status ("ok", "erased", "bad-crc", ...)
+ */
+const char *app_config_status_name(app_config_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
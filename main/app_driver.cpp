@@ -5,24 +5,29 @@
    - Button: GPIO 9 (active low)
    - WS2812 LED Data: GPIO 20
    - WS2812 LED Power Enable: GPIO 19
+   - Optional WS2812 status bar on the Grove port (CONFIG_APP_LED_BAR_PIXELS)
 */
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <atomic>
 
 #include <esp_log.h>
 #include <esp_matter.h>
+#include <esp_matter_console.h>
 #include <driver/gpio.h>
-#include <driver/rmt.h>
-#include <led_strip.h>
-#include <iot_button.h>
-#include <button_gpio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/timers.h>
 
 #include <app_priv.h>
+#include "app_button.h"
+#include "app_config.h"
+#include "app_log.h"
+#include "app_state.h"
+#include "app_ws2812.h"
 #include "include/CHIPPairingConfig.h"
 
 using namespace chip::app::Clusters;
@@ -30,20 +35,90 @@ using namespace esp_matter;
 
 static const char *TAG = "app_driver";
 
-static led_strip_t *s_led_strip = NULL;
+static app_ws2812_t *s_led_strip = NULL;   // &s_led once initialized
 static SemaphoreHandle_t s_led_mutex = NULL;
 static TimerHandle_t s_identify_timer = NULL;
-static std::atomic<bool> s_identify_blink_state{false};
-static std::atomic<bool> s_identify_running{false};
+static std::atomic<bool> s_identify_busy{false};     // Identify task is showing a pattern
 static TaskHandle_t s_identify_task = NULL;
+static TimerHandle_t s_ota_timer = NULL;
+
+// Statically allocated RTOS objects (no heap use after boot)
+static StaticSemaphore_t s_led_mutex_buf;
+static app_ws2812_t s_led;
+static uint8_t s_led_fb[APP_WS2812_BYTES_PER_PIXEL];
+#if CONFIG_APP_LED_BAR_PIXELS
+// Owned by the bar task once it runs; other paths only post a request
+static app_ws2812_t s_bar;
+static uint8_t s_bar_fb[CONFIG_APP_LED_BAR_PIXELS * APP_WS2812_BYTES_PER_PIXEL];
+static bool s_bar_ready = false;
+static TaskHandle_t s_bar_task = NULL;
+static std::atomic<int> s_bar_request{0};         // Latest frame: (ota_percent + 1) << 1 | power
+static StaticTask_t s_bar_task_buf;
+static StackType_t s_bar_task_stack[BAR_TASK_STACK_SIZE];
+#endif
+static StaticTimer_t s_identify_timer_buf;
+static StaticTimer_t s_ota_timer_buf;
+static StaticTask_t s_identify_task_buf;
+static StackType_t s_identify_task_stack[IDENTIFY_TASK_STACK_SIZE];
 
 // Helper macro for LED mutex lock/unlock with timeout
 #define LED_MUTEX_TIMEOUT_MS 50
 #define LED_LOCK() (s_led_mutex && xSemaphoreTake(s_led_mutex, pdMS_TO_TICKS(LED_MUTEX_TIMEOUT_MS)) == pdTRUE)
 #define LED_UNLOCK() do { if (s_led_mutex) xSemaphoreGive(s_led_mutex); } while(0)
 
-// Forward declaration for timer callback
+// Forward declarations for timer callbacks and identify task
 static void identify_timer_cb(TimerHandle_t timer);
+static void ota_timer_cb(TimerHandle_t timer);
+static void identify_pattern_task(void *pvParameters);
+
+// Colors and timings come from app_config (appcfg partition or app_priv.h defaults)
+static void strip_refresh(app_ws2812_t *strip)
+{
+    app_ws2812_refresh(strip, app_config_get()->led_refresh_timeout_ms);
+}
+
+static void led_set_color(const app_config_color_t *color)
+{
+    app_ws2812_set_pixel(s_led_strip, 0, color->r, color->g, color->b);
+}
+
+#if CONFIG_APP_LED_BAR_PIXELS
+static void strip_fill(app_ws2812_t *strip, uint16_t first, uint16_t count, const app_config_color_t *color)
+{
+    app_ws2812_fill(strip, first, count, color->r, color->g, color->b);
+}
+
+// Whole bar in the on/off color, with OTA progress (percent >= 0) filling it from the start.
+// Only pixels that change are sent, so progress steps cost a short partial frame. Bar task only.
+static void bar_render(bool power, int ota_percent)
+{
+    uint16_t lit = ota_percent < 0 ? 0 : static_cast<uint16_t>(CONFIG_APP_LED_BAR_PIXELS * ota_percent / 100);
+    const app_config_t *config = app_config_get();
+    strip_fill(&s_bar, 0, lit, &config->ota_max);
+    strip_fill(&s_bar, lit, CONFIG_APP_LED_BAR_PIXELS - lit, power ? &config->on : &config->off);
+    strip_refresh(&s_bar);
+}
+
+// A full frame of a long bar blocks for up to ~31 ms (1024 px) while it is sent, so the
+// Matter thread and the timer task only record the frame they want and wake this task
+static void bar_task(void *pvParameters)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int request = s_bar_request.load();
+        bar_render(request & 1, (request >> 1) - 1);
+    }
+}
+
+// Requests made while a frame is being sent collapse into one repaint with the latest state
+static void bar_request(bool power, int ota_percent)
+{
+    s_bar_request = ((ota_percent + 1) << 1) | (power ? 1 : 0);
+    if (s_bar_task) {
+        xTaskNotifyGive(s_bar_task);
+    }
+}
+#endif
 
 app_driver_handle_t app_driver_led_init(void)
 {
@@ -67,47 +142,45 @@ app_driver_handle_t app_driver_led_init(void)
     }
     ESP_LOGI(TAG, "Enabled WS2812 power on GPIO %d", M5NANOC6_LED_POWER_GPIO);
 
-    // Configure RMT for WS2812
-    rmt_config_t rmt_cfg = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(M5NANOC6_LED_DATA_GPIO),
-                                                  static_cast<rmt_channel_t>(M5NANOC6_RMT_CHANNEL));
-    rmt_cfg.clk_div = 2;
-
-    err = rmt_config(&rmt_cfg);
+    // On-board WS2812: a one-pixel strip on its own RMT channel
+    err = app_ws2812_init(&s_led, M5NANOC6_LED_DATA_GPIO, s_led_fb, 1);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "RMT config failed: %d", err);
-        return NULL;
-    }
-
-    err = rmt_driver_install(rmt_cfg.channel, 0, 0);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "RMT driver install failed: %d", err);
-        return NULL;
-    }
-
-    // Create LED strip using RMT
-    led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(1, reinterpret_cast<led_strip_dev_t>(rmt_cfg.channel));
-    s_led_strip = led_strip_new_rmt_ws2812(&strip_config);
-    if (!s_led_strip) {
         ESP_LOGE(TAG, "Failed to create WS2812 LED strip");
-        rmt_driver_uninstall(rmt_cfg.channel);  // Cleanup on failure
         return NULL;
     }
+    s_led_strip = &s_led;
+
+#if CONFIG_APP_LED_BAR_PIXELS
+    // Status bar on the Grove port; the on-board LED works without it
+    s_bar_ready = (app_ws2812_init(&s_bar, CONFIG_APP_LED_BAR_GPIO, s_bar_fb, CONFIG_APP_LED_BAR_PIXELS) == ESP_OK);
+#endif
 
     // Create mutex for thread-safe LED access
-    s_led_mutex = xSemaphoreCreateMutex();
-    if (!s_led_mutex) {
-        ESP_LOGW(TAG, "Failed to create LED mutex");
-    }
+    s_led_mutex = xSemaphoreCreateMutexStatic(&s_led_mutex_buf);
 
     // Set initial LED state (off = dim blue)
-    s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_OFF_G, LED_COLOR_OFF_R, LED_COLOR_OFF_B);
-    s_led_strip->refresh(s_led_strip, LED_REFRESH_TIMEOUT_MS);
+    led_set_color(&app_config_get()->off);
+    strip_refresh(s_led_strip);
+#if CONFIG_APP_LED_BAR_PIXELS
+    if (s_bar_ready) {
+        s_bar_task = xTaskCreateStatic(bar_task, "led_bar", BAR_TASK_STACK_SIZE, NULL, BAR_TASK_PRIORITY,
+                                       s_bar_task_stack, &s_bar_task_buf);
+        bar_request(false, -1);
+    }
+#endif
 
     // Pre-create identify timer to avoid allocation during operation
-    s_identify_timer = xTimerCreate("identify", pdMS_TO_TICKS(LED_IDENTIFY_BLINK_MS), pdTRUE, NULL, identify_timer_cb);
-    if (!s_identify_timer) {
-        ESP_LOGW(TAG, "Failed to create identify timer");
-    }
+    const app_config_t *config = app_config_get();
+    s_identify_timer = xTimerCreateStatic("identify", pdMS_TO_TICKS(config->identify_blink_ms), pdTRUE, NULL,
+                                          identify_timer_cb, &s_identify_timer_buf);
+
+    // Pre-create OTA overlay timer (started when a download begins)
+    s_ota_timer = xTimerCreateStatic("ota_led", pdMS_TO_TICKS(config->ota_blink_ms), pdTRUE, NULL, ota_timer_cb,
+                                     &s_ota_timer_buf);
+
+    // Identify task lives for the life of the device and waits for a notification
+    s_identify_task = xTaskCreateStatic(identify_pattern_task, "identify", IDENTIFY_TASK_STACK_SIZE, NULL,
+                                        IDENTIFY_TASK_PRIORITY, s_identify_task_stack, &s_identify_task_buf);
 
     ESP_LOGI(TAG, "LED driver initialized on GPIO %d", M5NANOC6_LED_DATA_GPIO);
     return static_cast<app_driver_handle_t>(s_led_strip);
@@ -115,18 +188,8 @@ app_driver_handle_t app_driver_led_init(void)
 
 app_driver_handle_t app_driver_button_init(void)
 {
-    // Initialize button using iot_button
-    button_config_t btn_cfg = {
-        .type = BUTTON_TYPE_GPIO,
-        .long_press_time = 0,
-        .short_press_time = 0,
-        .gpio_button_config = {
-            .gpio_num = M5NANOC6_BUTTON_GPIO,
-            .active_level = 0,  // Active low
-        },
-    };
-
-    button_handle_t btn_handle = iot_button_create(&btn_cfg);
+    // Edge-interrupt button: no polling timer while idle
+    void *btn_handle = app_button_create(M5NANOC6_BUTTON_GPIO);
     if (!btn_handle) {
         ESP_LOGE(TAG, "Failed to create button device");
         return NULL;
@@ -141,63 +204,35 @@ esp_err_t app_driver_led_set_power(app_driver_handle_t handle, bool power)
     (void)handle;  // Unused - always use global LED strip
 
     if (!s_led_strip) {
-        ESP_LOGE(TAG, "LED strip not initialized");
+        APP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
     if (!LED_LOCK()) {
-        ESP_LOGW(TAG, "LED mutex timeout");
+        APP_LOGW(TAG, "LED mutex timeout");
         return ESP_ERR_TIMEOUT;
     }
 
-    if (power) {
-        // ON state = bright blue
-        s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_ON_G, LED_COLOR_ON_R, LED_COLOR_ON_B);
-    } else {
-        // OFF state = dim blue
-        s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_OFF_G, LED_COLOR_OFF_R, LED_COLOR_OFF_B);
-    }
-
-    s_led_strip->refresh(s_led_strip, LED_REFRESH_TIMEOUT_MS);
+    // ON = bright blue, OFF = dim blue (defaults)
+    led_set_color(power ? &app_config_get()->on : &app_config_get()->off);
+    strip_refresh(s_led_strip);
     LED_UNLOCK();
+#if CONFIG_APP_LED_BAR_PIXELS
+    bar_request(power, -1);
+#endif
 
-    ESP_LOGD(TAG, "LED set to %s", power ? "ON" : "OFF");
+    APP_LOGD(TAG, "LED set to %s", power ? "ON" : "OFF");
     return ESP_OK;
 }
 
-esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
-                                      uint32_t attribute_id, const esp_matter_attr_val_t *val)
-{
-    if (!val) {
-        ESP_LOGE(TAG, "Attribute value is NULL");
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    esp_err_t err = ESP_OK;
-
-    if (cluster_id == OnOff::Id) {
-        if (attribute_id == OnOff::Attributes::OnOff::Id) {
-            ESP_LOGD(TAG, "OnOff: endpoint %d, value %d", endpoint_id, val->val.b);
-            err = app_driver_led_set_power(driver_handle, val->val.b);
-        }
-    }
-
-    return err;
-}
-
 // Display a single bit via LED color (MSB first order)
 static void display_config_bit(bool bit_value)
 {
     if (!LED_LOCK()) return;
     if (s_led_strip) {
-        if (bit_value) {
-            // Binary 1 = White (RGB order)
-            s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_BIT_1_R, LED_COLOR_BIT_1_G, LED_COLOR_BIT_1_B);
-        } else {
-            // Binary 0 = Red (RGB order)
-            s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_BIT_0_R, LED_COLOR_BIT_0_G, LED_COLOR_BIT_0_B);
-        }
-        s_led_strip->refresh(s_led_strip, LED_REFRESH_TIMEOUT_MS);
+        // Binary 1 = white, 0 = red (Thread defaults)
+        led_set_color(bit_value ? &app_config_get()->bit_1 : &app_config_get()->bit_0);
+        strip_refresh(s_led_strip);
     }
     LED_UNLOCK();
 }
@@ -207,29 +242,51 @@ static void config_led_off(void)
 {
     if (!LED_LOCK()) return;
     if (s_led_strip) {
-        s_led_strip->set_pixel(s_led_strip, 0, 0, 0, 0);
-        s_led_strip->refresh(s_led_strip, LED_REFRESH_TIMEOUT_MS);
+        app_ws2812_set_pixel(s_led_strip, 0, 0, 0, 0);
+        strip_refresh(s_led_strip);
     }
     LED_UNLOCK();
 }
 
-void app_driver_display_config_id_pattern(int repeat_count)
+// Delay in short steps so a pattern can be cancelled
+// Returns false if the keep_running state bit was cleared (0 = not cancellable)
+static bool pattern_delay(uint32_t delay_ms, uint32_t keep_running)
 {
-    uint8_t config_id = FIRMWARE_CONFIG_ID & 0x0F;
+    if (!keep_running) {
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        return true;
+    }
+    while (delay_ms > 0) {
+        if (!(app_state_get() & keep_running)) {
+            return false;
+        }
+        uint32_t wait = delay_ms < 50 ? delay_ms : 50;
+        vTaskDelay(pdMS_TO_TICKS(wait));
+        delay_ms -= wait;
+    }
+    return (app_state_get() & keep_running) != 0;
+}
+
+// Display config ID pattern; stops early if the keep_running state bit is cleared (0 = not cancellable)
+static void display_config_id_pattern(int repeat_count, uint32_t keep_running)
+{
+    const app_config_t *config = app_config_get();
+    uint8_t config_id = FIRMWARE_CONFIG_ID & ((1U << config->id_bits) - 1);
 
-    ESP_LOGI(TAG, "Displaying config ID %d (0b%d%d%d%d, MSB first), %d repetitions",
-             config_id,
-             (config_id >> 3) & 1, (config_id >> 2) & 1,
-             (config_id >> 1) & 1, config_id & 1,
+    ESP_LOGI(TAG, "Displaying config ID %d (%d bits, MSB first), %d repetitions", config_id, config->id_bits,
              repeat_count);
 
     for (int repeat = 0; repeat < repeat_count; repeat++) {
-        // Display 4 bits, MSB first (bit 3, 2, 1, 0)
-        for (int bit = FIRMWARE_CONFIG_ID_BITS - 1; bit >= 0; bit--) {
+        // MSB first
+        for (int bit = config->id_bits - 1; bit >= 0; bit--) {
             bool bit_value = (config_id >> bit) & 1;
             display_config_bit(bit_value);
 
-            vTaskDelay(pdMS_TO_TICKS(FIRMWARE_CONFIG_ID_BIT_DELAY_MS));
+            if (!pattern_delay(config->id_bit_ms, keep_running)) {
+                config_led_off();
+                ESP_LOGI(TAG, "Config ID pattern cancelled");
+                return;
+            }
 
             // Turn off between bits
             if (bit > 0) {
@@ -241,7 +298,10 @@ void app_driver_display_config_id_pattern(int repeat_count)
         // Turn off and delay between patterns
         if (repeat < repeat_count - 1) {
             config_led_off();
-            vTaskDelay(pdMS_TO_TICKS(FIRMWARE_CONFIG_ID_PATTERN_DELAY_MS));
+            if (!pattern_delay(config->id_pattern_gap_ms, keep_running)) {
+                ESP_LOGI(TAG, "Config ID pattern cancelled");
+                return;
+            }
         }
     }
 
@@ -251,17 +311,23 @@ void app_driver_display_config_id_pattern(int repeat_count)
     ESP_LOGI(TAG, "Config ID pattern complete");
 }
 
+void app_driver_display_config_id_pattern(int repeat_count)
+{
+    display_config_id_pattern(repeat_count, 0);
+}
+
 // FreeRTOS task for identify pattern (displays config ID binary pattern)
+// Created once at init; each notification runs one pattern
 static void identify_pattern_task(void *pvParameters)
 {
-    app_driver_display_config_id_pattern(IDENTIFY_CONFIG_ID_REPEAT_COUNT);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-    // Clear running flag and task handle
-    s_identify_running = false;
-    s_identify_task = NULL;
+        display_config_id_pattern(app_config_get()->identify_repeat_count, APP_STATE_IDENTIFY);
 
-    // Task self-terminates
-    vTaskDelete(NULL);
+        app_state_update(APP_STATE_IDENTIFY, 0);
+        s_identify_busy = false;
+    }
 }
 
 // Timer callback for identify blink
@@ -271,15 +337,16 @@ static void identify_timer_cb(TimerHandle_t timer)
         return;
     }
 
-    s_identify_blink_state = !s_identify_blink_state;
-    if (s_identify_blink_state) {
+    bool blink_on = !(app_state_get() & APP_STATE_LED_PHASE);
+    app_state_update(APP_STATE_LED_PHASE, blink_on ? APP_STATE_LED_PHASE : 0);
+    if (blink_on) {
         // Blink ON - white flash
-        s_led_strip->set_pixel(s_led_strip, 0, LED_COLOR_IDENTIFY_G, LED_COLOR_IDENTIFY_R, LED_COLOR_IDENTIFY_B);
+        led_set_color(&app_config_get()->identify);
     } else {
         // Blink OFF
-        s_led_strip->set_pixel(s_led_strip, 0, 0, 0, 0);
+        app_ws2812_set_pixel(s_led_strip, 0, 0, 0, 0);
     }
-    s_led_strip->refresh(s_led_strip, LED_REFRESH_TIMEOUT_MS);
+    strip_refresh(s_led_strip);
     LED_UNLOCK();
 }
 
@@ -287,29 +354,20 @@ esp_err_t app_driver_led_identify_start(void)
 {
     ESP_LOGI(TAG, "Starting identify pattern");
 
-    // Only start if not already running
-    bool expected = false;
-    if (!s_identify_running.compare_exchange_strong(expected, true)) {
-        ESP_LOGW(TAG, "Identify already running");
+    if (!s_identify_task) {
+        ESP_LOGE(TAG, "Identify task not created");
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Create task to run the identify pattern
-    BaseType_t result = xTaskCreate(
-        identify_pattern_task,
-        "identify",
-        4096,  // Stack size
-        NULL,  // Parameters
-        5,     // Priority
-        &s_identify_task
-    );
-
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create identify task");
-        s_identify_running = false;
-        return ESP_FAIL;
+    // Only start if the task is idle (previous pattern fully stopped)
+    bool expected = false;
+    if (!s_identify_busy.compare_exchange_strong(expected, true)) {
+        ESP_LOGW(TAG, "Identify already running");
+        return ESP_ERR_INVALID_STATE;
     }
 
+    app_state_update(APP_STATE_IDENTIFY | APP_STATE_LED_PHASE, APP_STATE_IDENTIFY);
+    xTaskNotifyGive(s_identify_task);
     return ESP_OK;
 }
 
@@ -318,27 +376,85 @@ esp_err_t app_driver_led_identify_stop(bool current_power)
     ESP_LOGI(TAG, "Stopping identify pattern");
 
     // Signal task to stop
-    s_identify_running = false;
-
-    // Wait for task to terminate (with timeout)
-    if (s_identify_task) {
-        // Wait up to 3 seconds for pattern to complete
-        for (int i = 0; i < 60 && s_identify_task != NULL; i++) {
-            vTaskDelay(pdMS_TO_TICKS(50));
-        }
+    app_state_update(APP_STATE_IDENTIFY, 0);
 
-        if (s_identify_task) {
-            ESP_LOGW(TAG, "Identify task did not terminate, forcing delete");
-            vTaskDelete(s_identify_task);
-            s_identify_task = NULL;
-        }
+    // Wait for the pattern to wind down (it checks the flag between steps)
+    for (int i = 0; i < 60 && s_identify_busy; i++) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (s_identify_busy) {
+        ESP_LOGW(TAG, "Identify pattern did not stop within 3s");
     }
 
     // Restore normal LED state
     return app_driver_led_set_power(NULL, current_power);
 }
 
-led_strip_t *app_driver_get_led_strip(void)
+// Timer callback for OTA overlay: alternate on/off color with progress color
+static void ota_timer_cb(TimerHandle_t timer)
+{
+    // One snapshot for the whole frame; the identify pattern owns the LED while running
+    app_state_t state = app_state_get();
+    if ((state & APP_STATE_IDENTIFY) || !s_led_strip) {
+        return;
+    }
+
+    bool show_progress = !(state & APP_STATE_LED_PHASE);
+    bool power = app_state_power(state);
+    uint8_t percent = app_state_ota_percent(state);
+
+    if (!LED_LOCK()) {
+        return;
+    }
+
+    app_state_update(APP_STATE_LED_PHASE, show_progress ? APP_STATE_LED_PHASE : 0);
+    const app_config_t *config = app_config_get();
+    if (show_progress) {
+        // Brightens from ota_min to ota_max with progress
+        const app_config_color_t *lo = &config->ota_min;
+        const app_config_color_t *hi = &config->ota_max;
+        app_ws2812_set_pixel(s_led_strip, 0, lo->r + (hi->r - lo->r) * percent / 100,
+                             lo->g + (hi->g - lo->g) * percent / 100, lo->b + (hi->b - lo->b) * percent / 100);
+    } else {
+        led_set_color(power ? &config->on : &config->off);
+    }
+    strip_refresh(s_led_strip);
+    LED_UNLOCK();
+#if CONFIG_APP_LED_BAR_PIXELS
+    bar_request(power, percent);
+#endif
+}
+
+esp_err_t app_driver_led_ota_start(void)
+{
+    if (!s_ota_timer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    app_state_update(APP_STATE_OTA | APP_STATE_OTA_PERCENT_MASK | APP_STATE_LED_PHASE, APP_STATE_OTA);
+    return xTimerStart(s_ota_timer, 0) == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+void app_driver_led_ota_progress(uint8_t percent)
+{
+    app_state_update(APP_STATE_OTA_PERCENT_MASK, app_state_ota_percent_bits(percent));
+}
+
+esp_err_t app_driver_led_ota_stop(bool current_power)
+{
+    app_state_t state = app_state_update(APP_STATE_OTA | APP_STATE_OTA_PERCENT_MASK, 0);
+    if (!s_ota_timer || !xTimerIsTimerActive(s_ota_timer)) {
+        return ESP_OK;
+    }
+    xTimerStop(s_ota_timer, 0);
+
+    // Restore normal LED state unless identify is showing its pattern
+    if (state & APP_STATE_IDENTIFY) {
+        return ESP_OK;
+    }
+    return app_driver_led_set_power(NULL, current_power);
+}
+
+app_ws2812_t *app_driver_get_led_strip(void)
 {
     return s_led_strip;
 }
@@ -352,3 +468,48 @@ void app_driver_led_unlock(void)
 {
     LED_UNLOCK();
 }
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static int format_strip(char *buf, size_t size, const char *name, const app_ws2812_t *strip)
+{
+    return snprintf(buf, size,
+                    "\"%s\":{\"pixels\":%u,\"refreshes\":%" PRIu32 ",\"partial\":%" PRIu32 ",\"skipped\":%" PRIu32
+                    ",\"last_pixels\":%" PRIu32 ",\"last_us\":%" PRIu32 "}",
+                    name, strip->fb.count, strip->refreshes, strip->partial, strip->skipped, strip->last_pixels,
+                    strip->last_us);
+}
+
+static esp_err_t led_stats_handler(int argc, char **argv)
+{
+    char led[160] = "";
+    char bar[160] = "";
+    if (!LED_LOCK()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (s_led_strip) {
+        format_strip(led, sizeof(led), "led", s_led_strip);
+    }
+#if CONFIG_APP_LED_BAR_PIXELS
+    if (s_bar_ready) {
+        format_strip(bar, sizeof(bar), "bar", &s_bar);
+    }
+#endif
+    LED_UNLOCK();
+    printf("{%s%s%s}\n", led, (led[0] && bar[0]) ? "," : "", bar);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_driver_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "led-stats",
+        .description = "Print WS2812 frame counts and last frame time (on-board LED and status bar) as JSON",
+        .handler = led_stats_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
@@ -0,0 +1,399 @@
+/*
+   M5NanoC6 Matter Switch - Persistent Event Log
+
+   Two record buffers live in RTC memory that is not initialized at boot,
+   so records survive software, watchdog and panic resets (not power
+   loss). Records go into the active buffer under a spinlock. When it is
+   full it is sealed, the other buffer takes over and the writer task
+   appends the sealed one to the flash ring as a single chunk: normally
+   one sector erase and one sector write per ~4 KB of records. Logging
+   never waits for flash.
+
+   The panic handler is wrapped (see main/CMakeLists.txt) to copy a short
+   core summary into RTC memory. The next boot appends it after the
+   retained records of the crashed boot and writes them out before
+   recording the new boot.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_app_desc.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_memory_utils.h>
+#include <esp_partition.h>
+#include <esp_private/panic_internal.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <riscv/rvruntime-frames.h>
+
+#include <platform/CHIPDeviceLayer.h>
+
+#include "app_evlog.h"
+#include "app_priv.h"
+
+static const char *TAG = "app_evlog";
+
+#define PANIC_MAGIC         0x43494E50U     // "PNIC"
+#define PANIC_STACK_WORDS   4
+#define PANIC_WORDS         (7 + PANIC_STACK_WORDS)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t words[PANIC_WORDS];    // core, exception, mcause, mepc, mtval, ra, sp, stack[]
+} panic_summary_t;
+
+static RTC_NOINIT_ATTR app_evlog_buffer_t s_buffers[2];
+static RTC_NOINIT_ATTR panic_summary_t s_panic;
+
+// Buffer ownership, under s_lock
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t s_active = 0;
+static bool s_sealed[2] = {};
+static uint32_t s_order = 0;
+static uint32_t s_records = 0;
+static uint32_t s_dropped = 0;          // Since the last LOST record
+static uint32_t s_dropped_total = 0;
+
+// Flash ring, under s_flush_mutex
+static const esp_partition_t *s_partition = NULL;
+static app_evlog_ring_t s_ring;
+static SemaphoreHandle_t s_flush_mutex = NULL;
+static StaticSemaphore_t s_flush_mutex_buf;
+
+static TaskHandle_t s_task = NULL;
+static StaticTask_t s_task_buf;
+static StackType_t s_task_stack[EVLOG_TASK_STACK_SIZE];
+
+static int flash_read(void *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    return esp_partition_read(s_partition, offset, buf, len);
+}
+
+static int flash_write(void *ctx, uint32_t offset, const void *buf, uint32_t len)
+{
+    return esp_partition_write(s_partition, offset, buf, len);
+}
+
+static int flash_erase_sector(void *ctx, uint32_t offset)
+{
+    return esp_partition_erase_range(s_partition, offset, APP_EVLOG_SECTOR_SIZE);
+}
+
+static uint32_t now_ms(void)
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+// Caller holds s_lock; sets *wake when a buffer was sealed for the writer
+static bool add_locked(uint8_t type, uint32_t ms, const uint32_t *args, uint8_t nargs, bool *wake)
+{
+    if (app_evlog_buffer_add(&s_buffers[s_active], type, ms, args, nargs)) {
+        return true;
+    }
+    uint8_t other = s_active ^ 1;
+    if (s_sealed[other]) {
+        return false;       // Writer has not caught up: drop
+    }
+    s_sealed[s_active] = true;
+    s_active = other;
+    app_evlog_buffer_reset(&s_buffers[other], ++s_order);
+    *wake = true;
+    if (s_dropped) {
+        app_evlog_buffer_add(&s_buffers[other], APP_EVLOG_LOST, ms, &s_dropped, 1);
+        s_dropped = 0;
+    }
+    return app_evlog_buffer_add(&s_buffers[other], type, ms, args, nargs);
+}
+
+void app_evlog_record(uint8_t type, const uint32_t *args, uint8_t nargs)
+{
+    if (!s_partition) {
+        return;
+    }
+    uint32_t ms = now_ms();
+    bool wake = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (add_locked(type, ms, args, nargs, &wake)) {
+        s_records++;
+    } else {
+        s_dropped++;
+        s_dropped_total++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (wake) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+// Caller holds s_flush_mutex. Writes sealed buffers oldest first.
+static void write_sealed(void)
+{
+    for (;;) {
+        int index = -1;
+        portENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < 2; i++) {
+            if (s_sealed[i] && (index < 0 || s_buffers[i].order < s_buffers[index].order)) {
+                index = i;
+            }
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (index < 0) {
+            return;
+        }
+
+        // Recording never touches a sealed buffer: no lock needed for the flash write
+        int err = app_evlog_ring_append(&s_ring, s_buffers[index].data, s_buffers[index].len);
+        if (err) {
+            ESP_LOGW(TAG, "Chunk write failed: %s", esp_err_to_name(err));
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_buffers[index].len = 0;       // Not replayed after a reset
+        s_sealed[index] = false;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static void writer_task(void *pvParameters)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(s_flush_mutex, portMAX_DELAY);
+        write_sealed();
+        xSemaphoreGive(s_flush_mutex);
+    }
+}
+
+esp_err_t app_evlog_flush(void)
+{
+    if (!s_partition) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_flush_mutex, portMAX_DELAY);
+    uint32_t errors = s_ring.errors;
+    write_sealed();
+
+    // Seal the partially filled buffer too
+    portENTER_CRITICAL(&s_lock);
+    uint8_t other = s_active ^ 1;
+    if (s_buffers[s_active].len > 0 && !s_sealed[other]) {
+        s_sealed[s_active] = true;
+        s_active = other;
+        app_evlog_buffer_reset(&s_buffers[other], ++s_order);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    write_sealed();
+    errors = s_ring.errors - errors;
+    xSemaphoreGive(s_flush_mutex);
+    return errors ? ESP_FAIL : ESP_OK;
+}
+
+static void shutdown_handler(void)
+{
+    uint32_t kind = APP_EVLOG_RESET_RESTART;
+    app_evlog_record(APP_EVLOG_RESET, &kind, 1);
+    app_evlog_flush();
+}
+
+extern "C" void __real_esp_panic_handler(panic_info_t *info);
+
+// Runs with interrupts off and possibly the flash cache disabled: plain stores only
+extern "C" void IRAM_ATTR __wrap_esp_panic_handler(panic_info_t *info)
+{
+    const RvExcFrame *frame = static_cast<const RvExcFrame *>(info->frame);
+    s_panic.words[0] = static_cast<uint32_t>(info->core);
+    s_panic.words[1] = static_cast<uint32_t>(info->exception);
+    for (int i = 2; i < PANIC_WORDS; i++) {
+        s_panic.words[i] = 0;
+    }
+    if (frame) {
+        s_panic.words[2] = frame->mcause;
+        s_panic.words[3] = frame->mepc;
+        s_panic.words[4] = frame->mtval;
+        s_panic.words[5] = frame->ra;
+        s_panic.words[6] = frame->sp;
+        const uint32_t *stack = reinterpret_cast<const uint32_t *>(frame->sp);
+        if (esp_ptr_in_dram(stack) && esp_ptr_in_dram(stack + PANIC_STACK_WORDS - 1)) {
+            for (int i = 0; i < PANIC_STACK_WORDS; i++) {
+                s_panic.words[7 + i] = stack[i];
+            }
+        }
+    }
+    s_panic.magic = PANIC_MAGIC;
+    __real_esp_panic_handler(info);
+}
+
+// Write out what the previous boot left in RTC memory, then start empty
+static void recover_retained(bool warm)
+{
+    app_evlog_buffer_t *order[2] = {};
+    int count = 0;
+    if (warm) {
+        for (int i = 0; i < 2; i++) {
+            if (app_evlog_buffer_valid(&s_buffers[i]) && s_buffers[i].len > 0) {
+                order[count++] = &s_buffers[i];
+            }
+        }
+        if (count == 2 && order[0]->order > order[1]->order) {
+            app_evlog_buffer_t *tmp = order[0];
+            order[0] = order[1];
+            order[1] = tmp;
+        }
+    }
+
+    uint32_t last_ms = 0;
+    for (int i = 0; i < count; i++) {
+        app_evlog_ring_append(&s_ring, order[i]->data, order[i]->len);
+        last_ms = order[i]->last_ms;
+    }
+    if (count) {
+        ESP_LOGI(TAG, "Recovered %d buffered chunk(s) from the previous boot", count);
+    }
+
+    app_evlog_buffer_reset(&s_buffers[0], ++s_order);
+    app_evlog_buffer_reset(&s_buffers[1], 0);
+    s_active = 0;
+
+    if (warm && s_panic.magic == PANIC_MAGIC) {
+        // Same boot as the retained records: its own chunk, stamped at the last record
+        app_evlog_buffer_add(&s_buffers[0], APP_EVLOG_PANIC, last_ms, s_panic.words, PANIC_WORDS);
+        app_evlog_ring_append(&s_ring, s_buffers[0].data, s_buffers[0].len);
+        app_evlog_buffer_reset(&s_buffers[0], ++s_order);
+        ESP_LOGW(TAG, "Panic recorded: mcause 0x%" PRIx32 " mepc 0x%08" PRIx32, s_panic.words[2], s_panic.words[3]);
+    }
+    s_panic.magic = 0;
+}
+
+esp_err_t app_evlog_init(void)
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, static_cast<esp_partition_subtype_t>(APP_EVLOG_PARTITION_SUBTYPE),
+        APP_EVLOG_PARTITION_LABEL);
+    if (!partition) {
+        ESP_LOGW(TAG, "No \"%s\" partition, event log disabled", APP_EVLOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_partition = partition;
+
+    const app_evlog_flash_t flash = {
+        .read = flash_read,
+        .write = flash_write,
+        .erase_sector = flash_erase_sector,
+        .ctx = NULL,
+        .sector_count = partition->size / APP_EVLOG_SECTOR_SIZE,
+    };
+    int err = app_evlog_ring_open(&s_ring, &flash);
+    if (err) {
+        ESP_LOGE(TAG, "Failed to read event log: %s", esp_err_to_name(err));
+        s_partition = NULL;
+        return err;
+    }
+
+    esp_reset_reason_t reason = esp_reset_reason();
+    recover_retained(reason != ESP_RST_POWERON);
+
+    s_flush_mutex = xSemaphoreCreateMutexStatic(&s_flush_mutex_buf);
+    s_task = xTaskCreateStatic(writer_task, "evlog", EVLOG_TASK_STACK_SIZE, NULL, EVLOG_TASK_PRIORITY, s_task_stack,
+                               &s_task_buf);
+    esp_register_shutdown_handler(shutdown_handler);
+
+    const uint8_t *sha = esp_app_get_description()->app_elf_sha256;
+    uint32_t boot[] = {
+        static_cast<uint32_t>(reason),
+        (static_cast<uint32_t>(sha[0]) << 24) | (sha[1] << 16) | (sha[2] << 8) | sha[3],
+    };
+    app_evlog_record(APP_EVLOG_BOOT, boot, 2);
+
+    ESP_LOGI(TAG, "Event log: %" PRIu32 " sectors, writing sector %" PRIu32 " (seq %" PRIu32 ") at %" PRIu32,
+             flash.sector_count, s_ring.sector, s_ring.seq, s_ring.offset);
+    return ESP_OK;
+}
+
+void app_evlog_matter_event(uint16_t event_type)
+{
+    using namespace chip::DeviceLayer::DeviceEventType;
+
+    uint32_t code;
+    switch (event_type) {
+    case kInterfaceIpAddressChanged:    code = APP_EVLOG_EV_IP_CHANGED; break;
+    case kCommissioningComplete:        code = APP_EVLOG_EV_COMMISSIONING_COMPLETE; break;
+    case kFailSafeTimerExpired:         code = APP_EVLOG_EV_FAIL_SAFE_EXPIRED; break;
+    case kCommissioningSessionStarted:  code = APP_EVLOG_EV_SESSION_STARTED; break;
+    case kCommissioningSessionStopped:  code = APP_EVLOG_EV_SESSION_STOPPED; break;
+    case kCommissioningWindowOpened:    code = APP_EVLOG_EV_WINDOW_OPENED; break;
+    case kCommissioningWindowClosed:    code = APP_EVLOG_EV_WINDOW_CLOSED; break;
+    case kFabricRemoved:                code = APP_EVLOG_EV_FABRIC_REMOVED; break;
+    case kFabricWillBeRemoved:          code = APP_EVLOG_EV_FABRIC_WILL_BE_REMOVED; break;
+    case kFabricUpdated:                code = APP_EVLOG_EV_FABRIC_UPDATED; break;
+    case kFabricCommitted:              code = APP_EVLOG_EV_FABRIC_COMMITTED; break;
+    case kBLEDeinitialized:             code = APP_EVLOG_EV_BLE_DEINITIALIZED; break;
+    case kServerReady:                  code = APP_EVLOG_EV_SERVER_READY; break;
+    default:
+        return;
+    }
+    app_evlog_record(APP_EVLOG_EVENT, &code, 1);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t evlog_stats_handler(int argc, char **argv)
+{
+    if (!s_partition) {
+        printf("{\"enabled\":false}\n");
+        return ESP_OK;
+    }
+    xSemaphoreTake(s_flush_mutex, portMAX_DELAY);
+    app_evlog_ring_t ring = s_ring;
+    xSemaphoreGive(s_flush_mutex);
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t records = s_records;
+    uint32_t dropped = s_dropped_total;
+    uint32_t buffered = s_buffers[0].len + s_buffers[1].len;
+    portEXIT_CRITICAL(&s_lock);
+
+    printf("{\"enabled\":true,\"sectors\":%" PRIu32 ",\"sector\":%" PRIu32 ",\"offset\":%" PRIu32 ",\"seq\":%" PRIu32
+           ",\"erases\":%" PRIu32 ",\"chunks\":%" PRIu32 ",\"bytes\":%" PRIu32 ",\"errors\":%" PRIu32
+           ",\"records\":%" PRIu32 ",\"dropped\":%" PRIu32 ",\"buffered\":%" PRIu32 "}\n",
+           ring.flash.sector_count, ring.sector, ring.offset, ring.seq, ring.erases, ring.chunks, ring.bytes,
+           ring.errors, records, dropped, buffered);
+    return ESP_OK;
+}
+
+static esp_err_t evlog_flush_handler(int argc, char **argv)
+{
+    esp_err_t err = app_evlog_flush();
+    printf("{\"flushed\":%s}\n", err == ESP_OK ? "true" : "false");
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_evlog_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t commands[] = {
+        {
+            .name = "evlog-stats",
+            .description = "Print event log ring position and write counters as JSON",
+            .handler = evlog_stats_handler,
+        },
+        {
+            .name = "evlog-flush",
+            .description = "Write buffered event log records to flash now",
+            .handler = evlog_flush_handler,
+        },
+    };
+    return esp_matter::console::add_commands(commands, sizeof(commands) / sizeof(commands[0]));
+#else
+    return ESP_OK;
+#endif
+}
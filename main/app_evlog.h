@@ -0,0 +1,75 @@
+/*
+   M5NanoC6 Matter Switch - Persistent Event Log Header
+
+   Compact binary log of boot reasons, Matter events, button gestures,
+   resets, OTA outcomes and panics, kept in the "evlog" flash partition
+   (format: app_evlog_engine.h). Records collect in two RAM buffers that
+   survive software resets and panics, and are written to flash a sector
+   at a time by a low-priority task. Read the partition back with
+   "make evlog-dump" (scripts/evlog_decode.py).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#include "app_evlog_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_EVLOG_PARTITION_LABEL   "evlog"
+#define APP_EVLOG_PARTITION_SUBTYPE 0x40    // Custom data subtype (partitions.csv)
+
+/**
+ * @brief Open the log and record the boot
+ *
+ * Flushes records retained in RAM across the reset (including a panic
+ * summary), then records the boot reason. Call early in app_main, after
+ * nvs_flash_init() and before anything that logs events.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND without the partition
+ *         (recording then does nothing)
+ */
+esp_err_t app_evlog_init(void);
+
+/**
+ * @brief Record an event
+ *
+ * Safe from any task (not from ISRs). Never blocks on flash.
+ *
+ * @param type app_evlog_type_t
+ * @param args Arguments (may be NULL if nargs is 0)
+ * @param nargs Number of arguments, at most APP_EVLOG_MAX_ARGS
+ */
+void app_evlog_record(uint8_t type, const uint32_t *args, uint8_t nargs);
+
+/**
+ * @brief Record a Matter device event handled by app_event_cb
+ *
+ * @param event_type ChipDeviceEvent type; events without an app_evlog_event_t code are ignored
+ */
+void app_evlog_matter_event(uint16_t event_type);
+
+/**
+ * @brief Write everything buffered to flash now
+ *
+ * Blocks on flash; called before restarts and from the shell.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_evlog_flush(void);
+
+/**
+ * @brief Register "evlog-stats" and "evlog-flush" shell commands
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_evlog_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,230 @@
+/*
+   M5NanoC6 Matter Switch - Event Log Engine
+
+   No ESP-IDF dependencies: see app_evlog_engine.h.
+*/
+
+#include <string.h>
+
+#include "app_evlog_engine.h"
+
+#define ERASED_U16          0xFFFFU
+#define ERASED_U32          0xFFFFFFFFU
+#define VARINT_MAX          5
+#define CRC_READ_CHUNK      64
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+size_t app_evlog_varint_put(uint8_t *out, uint32_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+uint16_t app_evlog_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void app_evlog_buffer_reset(app_evlog_buffer_t *buf, uint32_t order)
+{
+    buf->magic = APP_EVLOG_BUFFER_MAGIC;
+    buf->order = order;
+    buf->last_ms = 0;
+    buf->len = 0;
+}
+
+bool app_evlog_buffer_valid(const app_evlog_buffer_t *buf)
+{
+    return buf->magic == APP_EVLOG_BUFFER_MAGIC && buf->len <= APP_EVLOG_CHUNK_MAX;
+}
+
+bool app_evlog_buffer_add(app_evlog_buffer_t *buf, uint8_t type, uint32_t now_ms, const uint32_t *args,
+                          uint8_t nargs)
+{
+    uint8_t record[VARINT_MAX * (3 + APP_EVLOG_MAX_ARGS)];
+    size_t n = 0;
+
+    if (nargs > APP_EVLOG_MAX_ARGS) {
+        return false;
+    }
+    uint32_t last_ms = buf->last_ms;
+    if (buf->len == 0) {
+        n += app_evlog_varint_put(record, now_ms);     // Chunk base time
+        last_ms = now_ms;
+    }
+    n += app_evlog_varint_put(record + n, (static_cast<uint32_t>(type) << 4) | nargs);
+    n += app_evlog_varint_put(record + n, now_ms >= last_ms ? now_ms - last_ms : 0);
+    for (uint8_t i = 0; i < nargs; i++) {
+        n += app_evlog_varint_put(record + n, args[i]);
+    }
+
+    if (buf->len + n > APP_EVLOG_CHUNK_MAX) {
+        return false;
+    }
+    memcpy(buf->data + buf->len, record, n);
+    buf->len += n;
+    buf->last_ms = (now_ms >= last_ms) ? now_ms : last_ms;
+    return true;
+}
+
+// Offset of the first free chunk in a sector; APP_EVLOG_SECTOR_SIZE if it must not be appended to
+static int scan_sector(const app_evlog_ring_t *ring, uint32_t sector, uint32_t *out)
+{
+    const uint32_t base = sector * APP_EVLOG_SECTOR_SIZE;
+    uint32_t offset = APP_EVLOG_SECTOR_HEADER;
+
+    while (offset + APP_EVLOG_CHUNK_HEADER <= APP_EVLOG_SECTOR_SIZE) {
+        uint8_t header[APP_EVLOG_CHUNK_HEADER];
+        int err = ring->flash.read(ring->flash.ctx, base + offset, header, sizeof(header));
+        if (err) {
+            return err;
+        }
+        uint16_t len = get_u16(header);
+        uint16_t crc = get_u16(header + 2);
+        if (len == ERASED_U16) {
+            *out = (crc == ERASED_U16) ? offset : APP_EVLOG_SECTOR_SIZE;
+            return 0;
+        }
+        if (len == 0 || offset + APP_EVLOG_CHUNK_HEADER + len > APP_EVLOG_SECTOR_SIZE) {
+            break;
+        }
+
+        uint16_t actual = 0xFFFF;
+        for (uint32_t pos = 0; pos < len; pos += CRC_READ_CHUNK) {
+            uint8_t data[CRC_READ_CHUNK];
+            uint32_t n = (len - pos < CRC_READ_CHUNK) ? len - pos : CRC_READ_CHUNK;
+            err = ring->flash.read(ring->flash.ctx, base + offset + APP_EVLOG_CHUNK_HEADER + pos, data, n);
+            if (err) {
+                return err;
+            }
+            actual = app_evlog_crc16(actual, data, n);
+        }
+        if (actual != crc) {
+            break;      // Torn write: close the sector
+        }
+        offset += APP_EVLOG_CHUNK_HEADER + len;
+    }
+    *out = APP_EVLOG_SECTOR_SIZE;
+    return 0;
+}
+
+int app_evlog_ring_open(app_evlog_ring_t *ring, const app_evlog_flash_t *flash)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->flash = *flash;
+    // Empty partition: the first append starts at sector 0
+    ring->sector = flash->sector_count - 1;
+    ring->offset = APP_EVLOG_SECTOR_SIZE;
+
+    bool found = false;
+    for (uint32_t s = 0; s < flash->sector_count; s++) {
+        uint8_t header[APP_EVLOG_SECTOR_HEADER];
+        int err = flash->read(flash->ctx, s * APP_EVLOG_SECTOR_SIZE, header, sizeof(header));
+        if (err) {
+            return err;
+        }
+        uint32_t seq = get_u32(header + 4);
+        if (get_u32(header) != APP_EVLOG_MAGIC || seq == ERASED_U32) {
+            continue;
+        }
+        if (!found || seq > ring->seq) {
+            ring->sector = s;
+            ring->seq = seq;
+            found = true;
+        }
+    }
+    return found ? scan_sector(ring, ring->sector, &ring->offset) : 0;
+}
+
+static int next_sector(app_evlog_ring_t *ring)
+{
+    uint32_t sector = (ring->sector + 1) % ring->flash.sector_count;
+    uint32_t base = sector * APP_EVLOG_SECTOR_SIZE;
+
+    int err = ring->flash.erase_sector(ring->flash.ctx, base);
+    if (!err) {
+        uint8_t header[APP_EVLOG_SECTOR_HEADER];
+        put_u32(header, APP_EVLOG_MAGIC);
+        put_u32(header + 4, ring->seq + 1);
+        err = ring->flash.write(ring->flash.ctx, base, header, sizeof(header));
+    }
+    if (err) {
+        ring->errors++;
+        return err;
+    }
+    ring->sector = sector;
+    ring->offset = APP_EVLOG_SECTOR_HEADER;
+    ring->seq++;
+    ring->erases++;
+    return 0;
+}
+
+int app_evlog_ring_append(app_evlog_ring_t *ring, const uint8_t *payload, uint16_t len)
+{
+    if (len == 0) {
+        return 0;
+    }
+    if (len > APP_EVLOG_CHUNK_MAX) {
+        ring->errors++;
+        return -1;
+    }
+    if (ring->offset + APP_EVLOG_CHUNK_HEADER + len > APP_EVLOG_SECTOR_SIZE) {
+        int err = next_sector(ring);
+        if (err) {
+            return err;
+        }
+    }
+
+    // Header first: a torn write then fails the CRC instead of looking erased
+    uint8_t header[APP_EVLOG_CHUNK_HEADER];
+    put_u16(header, len);
+    put_u16(header + 2, app_evlog_crc16(0xFFFF, payload, len));
+    uint32_t at = ring->sector * APP_EVLOG_SECTOR_SIZE + ring->offset;
+    int err = ring->flash.write(ring->flash.ctx, at, header, sizeof(header));
+    if (!err) {
+        err = ring->flash.write(ring->flash.ctx, at + APP_EVLOG_CHUNK_HEADER, payload, len);
+    }
+    if (err) {
+        // Readers stop at a bad chunk: continue in a fresh sector
+        ring->offset = APP_EVLOG_SECTOR_SIZE;
+        ring->errors++;
+        return err;
+    }
+    ring->offset += APP_EVLOG_CHUNK_HEADER + len;
+    ring->chunks++;
+    ring->bytes += len;
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+   M5NanoC6 Matter Switch - Event Log Engine
+
+   Hardware-independent encoding and flash ring for the persistent event
+   log. Records are collected in a RAM buffer and written to flash one
+   buffer (chunk) at a time, so a sector is normally erased and filled by
+   a single write. The flash is reached through callbacks. The same code
+   runs against the "evlog" partition on the device and against a
+   simulated flash in scripts/evlog_decode.py --selftest, which builds
+   this file for the host.
+
+   Flash layout (APP_EVLOG_SECTOR_SIZE sectors, little-endian):
+     Sector:  magic u32, seq u32, then chunks until 0xFFFF (erased)
+     Chunk:   len u16, crc16 u16 (CCITT-FALSE over the payload), payload
+     Payload: varint base_ms (uptime of the first record), then records
+     Record:  varint (type << 4 | nargs), varint dt_ms, nargs varints
+
+   dt_ms is the time since the previous record of the chunk. All records
+   of a chunk belong to one boot. The sector with the highest seq is the
+   one being filled; the sector after it is the oldest.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_EVLOG_SECTOR_SIZE       4096
+#define APP_EVLOG_MAGIC             0x474C5645U     // "EVLG"
+#define APP_EVLOG_SECTOR_HEADER     8
+#define APP_EVLOG_CHUNK_HEADER      4
+#define APP_EVLOG_CHUNK_MAX         (APP_EVLOG_SECTOR_SIZE - APP_EVLOG_SECTOR_HEADER - APP_EVLOG_CHUNK_HEADER)
+#define APP_EVLOG_MAX_ARGS          15
+#define APP_EVLOG_BUFFER_MAGIC      0x46554245U     // "EBUF"
+
+typedef enum {
+    APP_EVLOG_BOOT = 1,         // reset_reason, elf_sha256 (first 4 bytes)
+    APP_EVLOG_EVENT = 2,        // app_evlog_event_t
+    APP_EVLOG_BUTTON = 3,       // APP_BUTTON_EVENT_* bits
+    APP_EVLOG_RESET = 4,        // app_evlog_reset_t
+    APP_EVLOG_OTA = 5,          // app_evlog_ota_t, image bytes
+    APP_EVLOG_PANIC = 6,        // core, exception, mcause, mepc, mtval, ra, sp, stack[4]
+    APP_EVLOG_LOST = 7,         // records dropped while both buffers were full
+} app_evlog_type_t;
+
+// Matter device events (stable codes; CHIP's event type values are not)
+typedef enum {
+    APP_EVLOG_EV_IP_CHANGED = 1,
+    APP_EVLOG_EV_COMMISSIONING_COMPLETE = 2,
+    APP_EVLOG_EV_FAIL_SAFE_EXPIRED = 3,
+    APP_EVLOG_EV_SESSION_STARTED = 4,
+    APP_EVLOG_EV_SESSION_STOPPED = 5,
+    APP_EVLOG_EV_WINDOW_OPENED = 6,
+    APP_EVLOG_EV_WINDOW_CLOSED = 7,
+    APP_EVLOG_EV_FABRIC_REMOVED = 8,
+    APP_EVLOG_EV_FABRIC_WILL_BE_REMOVED = 9,
+    APP_EVLOG_EV_FABRIC_UPDATED = 10,
+    APP_EVLOG_EV_FABRIC_COMMITTED = 11,
+    APP_EVLOG_EV_BLE_DEINITIALIZED = 12,
+    APP_EVLOG_EV_SERVER_READY = 13,
+} app_evlog_event_t;
+
+typedef enum {
+    APP_EVLOG_RESET_FACTORY = 1,        // Button factory reset
+    APP_EVLOG_RESET_RESTART = 2,        // esp_restart() from any caller
+} app_evlog_reset_t;
+
+typedef enum {
+    APP_EVLOG_OTA_STARTED = 1,
+    APP_EVLOG_OTA_COMPLETE = 2,
+    APP_EVLOG_OTA_FAILED = 3,
+    APP_EVLOG_OTA_ABORTED = 4,
+    APP_EVLOG_OTA_APPLY_FAILED = 5,
+} app_evlog_ota_t;
+
+// RAM record buffer; laid out to survive a software reset in retained memory
+typedef struct {
+    uint32_t magic;             // APP_EVLOG_BUFFER_MAGIC when the fields below are valid
+    uint32_t order;             // Fill order, to flush retained buffers oldest first
+    uint32_t last_ms;           // Uptime of the newest record
+    uint16_t len;
+    uint8_t data[APP_EVLOG_CHUNK_MAX];
+} app_evlog_buffer_t;
+
+typedef struct {
+    int (*read)(void *ctx, uint32_t offset, void *buf, uint32_t len);
+    int (*write)(void *ctx, uint32_t offset, const void *buf, uint32_t len);
+    int (*erase_sector)(void *ctx, uint32_t offset);
+    void *ctx;
+    uint32_t sector_count;
+} app_evlog_flash_t;            // Callbacks return 0 on success
+
+typedef struct {
+    app_evlog_flash_t flash;
+    uint32_t sector;            // Sector being filled
+    uint32_t offset;            // Next chunk offset in it
+    uint32_t seq;               // Its sequence number
+    uint32_t erases;
+    uint32_t chunks;
+    uint32_t bytes;
+    uint32_t errors;
+} app_evlog_ring_t;
+
+/**
+ * @brief Encode an unsigned varint (LEB128)
+ *
+ * @return Bytes written (1-5)
+ */
+size_t app_evlog_varint_put(uint8_t *out, uint32_t value);
+
+/**
+ * @brief CRC-16/CCITT-FALSE, as stored in chunk headers
+ */
+uint16_t app_evlog_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Empty a buffer and stamp it as valid
+ */
+void app_evlog_buffer_reset(app_evlog_buffer_t *buf, uint32_t order);
+
+/**
+ * @brief Check a buffer found in retained memory after a reset
+ *
+ * @return true if magic and length are consistent
+ */
+bool app_evlog_buffer_valid(const app_evlog_buffer_t *buf);
+
+/**
+ * @brief Append one record
+ *
+ * @param buf Buffer
+ * @param type app_evlog_type_t
+ * @param now_ms Uptime; earlier than the previous record is recorded as dt 0
+ * @param args Arguments (may be NULL if nargs is 0)
+ * @param nargs Number of arguments, at most APP_EVLOG_MAX_ARGS
+ * @return false if the record does not fit (buffer unchanged)
+ */
+bool app_evlog_buffer_add(app_evlog_buffer_t *buf, uint8_t type, uint32_t now_ms, const uint32_t *args,
+                          uint8_t nargs);
+
+/**
+ * @brief Find the newest sector and its write position
+ *
+ * Chunks with a bad CRC (power lost during the write) close their sector:
+ * the next chunk goes to a fresh one.
+ *
+ * @return 0 on success, else the first flash callback error
+ */
+int app_evlog_ring_open(app_evlog_ring_t *ring, const app_evlog_flash_t *flash);
+
+/**
+ * @brief Write a buffer as one chunk
+ *
+ * Moves to the next sector (erasing the oldest) if the chunk does not fit
+ * in the current one.
+ *
+ * @return 0 on success, else the flash callback error
+ */
+int app_evlog_ring_append(app_evlog_ring_t *ring, const uint8_t *payload, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,205 @@
+/*
+   M5NanoC6 Matter Switch - Heap Monitor
+
+   All app-owned RTOS objects (LED mutex, timers, identify task) are created
+   with static buffers, so after boot the app itself never touches the heap.
+   This module verifies that: the heap allocation hook records any
+   allocation made after app_main returns, including ones pulled in from
+   esp-matter on the toggle/identify paths, and the periodic report prints
+   them with a backtrace that idf.py monitor decodes.
+*/
+
+#include <atomic>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_memory_utils.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+#include "app_heap.h"
+
+static const char *TAG = "app_heap";
+
+#if CONFIG_APP_HEAP_REPORT_INTERVAL_S > 0
+static TimerHandle_t s_report_timer = NULL;
+static StaticTimer_t s_report_timer_buf;
+#endif
+
+#if CONFIG_APP_HEAP_TRACE_AFTER_BOOT
+
+typedef struct {
+    uint32_t seq;                                   // Slot index + 1 once the record is complete
+    void *ptr;
+    uint32_t size;
+    uint32_t caps;
+    uint32_t pc[CONFIG_APP_HEAP_TRACE_DEPTH];
+    char task[configMAX_TASK_NAME_LEN];
+} post_boot_alloc_t;
+
+static post_boot_alloc_t s_records[APP_HEAP_TRACE_RECORDS];
+static std::atomic<uint32_t> s_write_idx{0};
+static uint32_t s_read_idx = 0;
+static std::atomic<bool> s_armed{false};
+static std::atomic<uint32_t> s_alloc_count{0};
+static std::atomic<uint32_t> s_alloc_bytes{0};
+static TaskHandle_t s_report_task = NULL;          // Allocations made while reporting are ignored
+
+// Collect return addresses starting at the hook's caller
+static IRAM_ATTR void capture_backtrace(uint32_t *pc, int depth)
+{
+    for (int i = 0; i < depth; i++) {
+        pc[i] = 0;
+    }
+#if CONFIG_ESP_SYSTEM_USE_FRAME_POINTER
+    // RISC-V frame: return address at fp-4, caller's frame pointer at fp-8
+    uint32_t fp = reinterpret_cast<uint32_t>(__builtin_frame_address(0));
+    for (int i = 0; i < depth && esp_stack_ptr_is_sane(fp); i++) {
+        uint32_t ra = reinterpret_cast<uint32_t *>(fp)[-1];
+        if (!esp_ptr_executable(reinterpret_cast<void *>(ra))) {
+            break;
+        }
+        pc[i] = ra;
+        fp = reinterpret_cast<uint32_t *>(fp)[-2];
+    }
+#else
+    pc[0] = reinterpret_cast<uint32_t>(__builtin_return_address(0));
+#endif
+}
+
+// Called by the heap component after every successful allocation (CONFIG_HEAP_USE_HOOKS)
+extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (!s_armed.load(std::memory_order_relaxed) || !ptr) {
+        return;
+    }
+
+    bool in_isr = xPortInIsrContext();
+    if (!in_isr && s_report_task && xTaskGetCurrentTaskHandle() == s_report_task) {
+        return;
+    }
+
+    s_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    s_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    uint32_t idx = s_write_idx.fetch_add(1);
+    post_boot_alloc_t *rec = &s_records[idx % APP_HEAP_TRACE_RECORDS];
+    rec->seq = 0;
+    rec->ptr = ptr;
+    rec->size = size;
+    rec->caps = caps;
+    capture_backtrace(rec->pc, CONFIG_APP_HEAP_TRACE_DEPTH);
+
+    // Copy task name by hand: the hook may run with flash cache disabled
+    const char *name = in_isr ? "ISR" : pcTaskGetName(NULL);
+    size_t i = 0;
+    for (; name && name[i] && i < sizeof(rec->task) - 1; i++) {
+        rec->task[i] = name[i];
+    }
+    rec->task[i] = '\0';
+    rec->seq = idx + 1;
+}
+
+static void report_post_boot_allocs(void)
+{
+    uint32_t write_idx = s_write_idx.load();
+    if (write_idx - s_read_idx > APP_HEAP_TRACE_RECORDS) {
+        ESP_LOGW(TAG, "%" PRIu32 " post-boot allocations not shown (record buffer full)",
+                 write_idx - s_read_idx - APP_HEAP_TRACE_RECORDS);
+        s_read_idx = write_idx - APP_HEAP_TRACE_RECORDS;
+    }
+
+    for (; s_read_idx != write_idx; s_read_idx++) {
+        const post_boot_alloc_t *rec = &s_records[s_read_idx % APP_HEAP_TRACE_RECORDS];
+        if (rec->seq != s_read_idx + 1) {
+            continue;  // Overwritten or still being written
+        }
+
+        char backtrace[12 * CONFIG_APP_HEAP_TRACE_DEPTH + 1] = {};
+        int len = 0;
+        for (int i = 0; i < CONFIG_APP_HEAP_TRACE_DEPTH && rec->pc[i]; i++) {
+            len += snprintf(backtrace + len, sizeof(backtrace) - len, " 0x%08" PRIx32, rec->pc[i]);
+        }
+        ESP_LOGW(TAG, "Post-boot alloc: %" PRIu32 " bytes at %p (caps 0x%" PRIx32 ") task %s",
+                 rec->size, rec->ptr, rec->caps, rec->task);
+        ESP_LOGW(TAG, "Backtrace:%s", backtrace);
+    }
+}
+
+#endif // CONFIG_APP_HEAP_TRACE_AFTER_BOOT
+
+void app_heap_report(void)
+{
+#if CONFIG_APP_HEAP_TRACE_AFTER_BOOT
+    s_report_task = xTaskGetCurrentTaskHandle();
+#endif
+
+    size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    // Largest block as a share of free heap: low values mean fragmentation
+    ESP_LOGI(TAG, "Heap: free %u, min free %u, largest block %u (%u%% of free)",
+             (unsigned)free_bytes, (unsigned)min_free, (unsigned)largest,
+             free_bytes ? (unsigned)(largest * 100 / free_bytes) : 0);
+
+#if CONFIG_APP_HEAP_TRACE_AFTER_BOOT
+    uint32_t count = s_alloc_count.load();
+    if (count) {
+        ESP_LOGW(TAG, "Post-boot allocations: %" PRIu32 " (%" PRIu32 " bytes total)", count, s_alloc_bytes.load());
+        report_post_boot_allocs();
+    }
+    s_report_task = NULL;
+#endif
+}
+
+#if CONFIG_APP_HEAP_REPORT_INTERVAL_S > 0
+static void report_timer_cb(TimerHandle_t timer)
+{
+    app_heap_report();
+}
+#endif
+
+void app_heap_boot_complete(void)
+{
+    ESP_LOGI(TAG, "Boot complete");
+    app_heap_report();
+
+#if CONFIG_APP_HEAP_TRACE_AFTER_BOOT
+    s_armed = true;
+    ESP_LOGI(TAG, "Post-boot heap allocation tracer armed");
+#endif
+
+#if CONFIG_APP_HEAP_REPORT_INTERVAL_S > 0
+    s_report_timer = xTimerCreateStatic("heap", pdMS_TO_TICKS(CONFIG_APP_HEAP_REPORT_INTERVAL_S * 1000), pdTRUE,
+                                        NULL, report_timer_cb, &s_report_timer_buf);
+    xTimerStart(s_report_timer, 0);
+#endif
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t heap_report_handler(int argc, char **argv)
+{
+    app_heap_report();
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_heap_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "heap-report",
+        .description = "Log heap watermarks and post-boot allocations",
+        .handler = heap_report_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
@@ -0,0 +1,42 @@
+/*
+   M5NanoC6 Matter Switch - Heap Monitor Header
+
+   Periodic heap health report (free, minimum free, largest free block) and,
+   with CONFIG_APP_HEAP_TRACE_AFTER_BOOT, a tracer that flags every heap
+   allocation made after app_main returns.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Post-boot allocations kept for the next report (older ones are counted, not kept)
+#define APP_HEAP_TRACE_RECORDS      16
+
+/**
+ * @brief Mark the end of boot
+ *
+ * Logs the boot heap snapshot, arms the post-boot allocation tracer and
+ * starts the periodic heap report. Call as the last step of app_main.
+ */
+void app_heap_boot_complete(void);
+
+/**
+ * @brief Log heap watermarks and any post-boot allocations recorded since the last report
+ */
+void app_heap_report(void);
+
+/**
+ * @brief Register "heap-report" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_heap_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
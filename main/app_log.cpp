@@ -0,0 +1,234 @@
+/*
+   M5NanoC6 Matter Switch - Deferred Logging
+
+   Producers claim a ring slot, fill it and commit it without taking a
+   lock. The log task sleeps on a task notification. A producer only
+   notifies it when the task has said it is about to sleep, so a burst of
+   log calls costs one wake-up. The task takes records in order, formats
+   them and writes them with esp_log_write(), using the timestamp captured
+   at the call. Dropped records are reported as one warning line each time
+   the count goes up.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "app_log.h"
+#include "app_priv.h"
+
+static const char *TAG = "app_log";
+
+#define LOG_LINE_MAX        160     // Formatted message, longer lines are truncated
+#define POS_INLINE          UINT32_MAX
+
+static_assert((CONFIG_APP_LOG_RING_SLOTS & (CONFIG_APP_LOG_RING_SLOTS - 1)) == 0, "ring slots must be a power of two");
+
+static app_log_slot_t s_slots[CONFIG_APP_LOG_RING_SLOTS];
+static app_log_ring_t s_ring;
+static app_log_levels_t s_levels;
+static bool s_levels_ready = false;
+static bool s_ready = false;
+static uint32_t s_sleeping = 0;         // Set by the log task before it blocks
+static uint32_t s_inline = 0;           // Records written inline before app_log_init()
+
+static TaskHandle_t s_task = NULL;
+static StaticTask_t s_task_buf;
+static StackType_t s_task_stack[LOG_TASK_STACK_SIZE];
+
+static void emit(const app_log_record_t *record)
+{
+    static const char letters[] = "NEWIDV";
+    static const char *const colors[] = {"", LOG_COLOR_E, LOG_COLOR_W, LOG_COLOR_I, LOG_COLOR_D, LOG_COLOR_V};
+    uint8_t level = record->level <= APP_LOG_VERBOSE ? record->level : APP_LOG_VERBOSE;
+
+    char msg[LOG_LINE_MAX];
+    app_log_format(record, msg, sizeof(msg));
+    esp_log_write(static_cast<esp_log_level_t>(level), record->tag, "%s%c (%" PRIu32 ") %s: %s%s\n", colors[level],
+                  letters[level], record->ms, record->tag, msg, level <= APP_LOG_INFO ? LOG_RESET_COLOR : "");
+}
+
+static void log_task(void *pvParameters)
+{
+    app_log_record_t record;
+    uint32_t reported_drops = 0;
+    for (;;) {
+        bool took = false;
+        while (app_log_ring_take(&s_ring, &record)) {
+            emit(&record);
+            took = true;
+        }
+
+        uint32_t dropped = __atomic_load_n(&s_ring.dropped, __ATOMIC_RELAXED);
+        if (dropped != reported_drops) {
+            ESP_LOGW(TAG, "%" PRIu32 " log records dropped (ring full)", dropped - reported_drops);
+            reported_drops = dropped;
+        }
+
+        if (app_log_ring_pending(&s_ring) > 0) {
+            if (!took) {
+                vTaskDelay(1);      // Next slot claimed but not committed yet
+            }
+            continue;
+        }
+        __atomic_store_n(&s_sleeping, 1, __ATOMIC_SEQ_CST);
+        if (app_log_ring_pending(&s_ring) > 0) {
+            // Committed between the check and the flag: no notification will come
+            __atomic_store_n(&s_sleeping, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+static void levels_init(void)
+{
+    if (!s_levels_ready) {
+        app_log_levels_init(&s_levels, CONFIG_LOG_DEFAULT_LEVEL);
+        s_levels_ready = true;
+    }
+}
+
+esp_err_t app_log_init(void)
+{
+    if (s_ready) {
+        return ESP_OK;
+    }
+    levels_init();
+    app_log_ring_init(&s_ring, s_slots, CONFIG_APP_LOG_RING_SLOTS);
+    s_task = xTaskCreateStatic(log_task, "log", LOG_TASK_STACK_SIZE, NULL, LOG_TASK_PRIORITY, s_task_stack,
+                               &s_task_buf);
+    __atomic_store_n(&s_ready, true, __ATOMIC_RELEASE);
+    ESP_LOGI(TAG, "Deferred logging: %d slots of %u bytes", CONFIG_APP_LOG_RING_SLOTS,
+             static_cast<unsigned>(sizeof(app_log_slot_t)));
+    return ESP_OK;
+}
+
+bool app_log_enabled(uint8_t level, const char *tag)
+{
+    if (!s_levels_ready) {
+        return level <= CONFIG_LOG_DEFAULT_LEVEL;
+    }
+    return app_log_levels_enabled(&s_levels, level, tag);
+}
+
+app_log_record_t *app_log_claim(uint32_t *pos, app_log_record_t *local)
+{
+    if (!__atomic_load_n(&s_ready, __ATOMIC_ACQUIRE)) {
+        *pos = POS_INLINE;
+        return local;
+    }
+    return app_log_ring_claim(&s_ring, pos);
+}
+
+void app_log_commit(app_log_record_t *record, uint32_t pos)
+{
+    if (pos == POS_INLINE) {
+        s_inline++;
+        emit(record);
+        return;
+    }
+    app_log_ring_commit(&s_ring, pos);
+    if (__atomic_exchange_n(&s_sleeping, 0, __ATOMIC_SEQ_CST)) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(s_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(s_task);
+        }
+    }
+}
+
+esp_err_t app_log_set_level(const char *tag, uint8_t level)
+{
+    levels_init();
+    if (!app_log_levels_set(&s_levels, tag, level)) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_log_level_set(tag, static_cast<esp_log_level_t>(level));
+    return ESP_OK;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static const char *const s_level_names[] = {"none", "error", "warn", "info", "debug", "verbose"};
+
+static int parse_level(const char *name)
+{
+    for (int i = 0; i < static_cast<int>(sizeof(s_level_names) / sizeof(s_level_names[0])); i++) {
+        if (strcmp(name, s_level_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void print_levels(void)
+{
+    levels_init();
+    printf("{\"*\":\"%s\"", s_level_names[s_levels.default_level]);
+    for (uint8_t i = 0; i < s_levels.count; i++) {
+        // Entries reset by "*" stay in the table at the default level
+        if (s_levels.tags[i].level != s_levels.default_level) {
+            printf(",\"%s\":\"%s\"", s_levels.tags[i].tag, s_level_names[s_levels.tags[i].level]);
+        }
+    }
+    printf("}\n");
+}
+
+static esp_err_t log_level_handler(int argc, char **argv)
+{
+    if (argc == 0) {
+        print_levels();
+        return ESP_OK;
+    }
+    int level = argc == 2 ? parse_level(argv[1]) : -1;
+    if (level < 0) {
+        printf("Usage: log-level [<tag|*> <none|error|warn|info|debug|verbose>]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = app_log_set_level(argv[0], static_cast<uint8_t>(level));
+    if (err != ESP_OK) {
+        printf("{\"error\":\"tag table full or tag longer than %d characters\"}\n", APP_LOG_TAG_LEN);
+        return err;
+    }
+    print_levels();
+    return ESP_OK;
+}
+
+static esp_err_t log_stats_handler(int argc, char **argv)
+{
+    printf("{\"slots\":%d,\"written\":%" PRIu32 ",\"dropped\":%" PRIu32 ",\"pending\":%" PRIu32
+           ",\"high_water\":%" PRIu32 ",\"inline\":%" PRIu32 "}\n",
+           CONFIG_APP_LOG_RING_SLOTS, __atomic_load_n(&s_ring.written, __ATOMIC_RELAXED),
+           __atomic_load_n(&s_ring.dropped, __ATOMIC_RELAXED), app_log_ring_pending(&s_ring), s_ring.high_water,
+           s_inline);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_log_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t commands[] = {
+        {
+            .name = "log-level",
+            .description = "Show log levels, or set one: log-level <tag|*> <none|error|warn|info|debug|verbose>",
+            .handler = log_level_handler,
+        },
+        {
+            .name = "log-stats",
+            .description = "Print deferred log ring counters as JSON",
+            .handler = log_stats_handler,
+        },
+    };
+    return esp_matter::console::add_commands(commands, sizeof(commands) / sizeof(commands[0]));
+#else
+    return ESP_OK;
+#endif
+}
@@ -0,0 +1,102 @@
+/*
+   M5NanoC6 Matter Switch - Deferred Logging Header
+
+   APP_LOGE/W/I/D/V take the same arguments as ESP_LOGx. The difference is
+   that the calling task only copies the format pointer and the arguments
+   into a lock-free ring (app_log_engine.h). A low-priority "log" task
+   formats the records later and writes them through esp_log_write(). Use
+   these macros where the caller's latency matters: Matter event and
+   identify callbacks, button callbacks, LED updates. ESP_LOGx stays fine
+   for init code.
+
+   Formats and tags must be string literals. %s arguments are copied, up to
+   APP_LOG_TEXT_BYTES per call. When the ring is full the record is dropped,
+   and the log task reports the count. Records still in the ring are lost on
+   a panic. Records logged before app_log_init() are written inline.
+
+   Levels can be set per tag at runtime with "matter log-level <tag|*>
+   <level>". The level is also applied to ESP_LOGx through
+   esp_log_level_set(). A disabled call costs a level check.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include "app_log_engine.h"
+
+/**
+ * @brief Set up the ring and start the log task
+ *
+ * Call first thing in app_main.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_log_init(void);
+
+/**
+ * @brief Whether a call at this level and tag is recorded
+ */
+bool app_log_enabled(uint8_t level, const char *tag);
+
+/**
+ * @brief Claim a record for APP_LOGx
+ *
+ * @param[out] pos Ring position for app_log_commit()
+ * @param local Record used before app_log_init() (written inline on commit)
+ * @return Record to fill, or NULL if the ring is full
+ */
+app_log_record_t *app_log_claim(uint32_t *pos, app_log_record_t *local);
+
+/**
+ * @brief Publish a filled record and wake the log task if it sleeps
+ */
+void app_log_commit(app_log_record_t *record, uint32_t pos);
+
+/**
+ * @brief Set the level of a tag ("*" for all), for APP_LOGx and ESP_LOGx
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the tag table is full
+ */
+esp_err_t app_log_set_level(const char *tag, uint8_t level);
+
+/**
+ * @brief Register "log-level" and "log-stats" shell commands
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_log_register_commands(void);
+
+// Lets the compiler check the format against the arguments; never called
+static inline void app_log_check_format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void app_log_check_format(const char *, ...) {}
+
+template <typename... Args> inline void app_log_write(uint8_t level, const char *tag, const char *fmt, Args... args)
+{
+    app_log_record_t local;
+    uint32_t pos;
+    app_log_record_t *record = app_log_claim(&pos, &local);
+    if (record) {
+        app_log_capture(record, level, tag, esp_log_timestamp(), fmt, args...);
+        app_log_commit(record, pos);
+    }
+}
+
+#define APP_LOG_LEVEL(level, tag, fmt, ...)                                 \
+    do {                                                                    \
+        if (LOG_LOCAL_LEVEL >= (level) && app_log_enabled((level), (tag))) { \
+            if (0) {                                                        \
+                app_log_check_format(fmt, ##__VA_ARGS__);                   \
+            }                                                               \
+            app_log_write((level), (tag), fmt, ##__VA_ARGS__);              \
+        }                                                                   \
+    } while (0)
+
+#define APP_LOGE(tag, fmt, ...) APP_LOG_LEVEL(APP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGW(tag, fmt, ...) APP_LOG_LEVEL(APP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGI(tag, fmt, ...) APP_LOG_LEVEL(APP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGD(tag, fmt, ...) APP_LOG_LEVEL(APP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define APP_LOGV(tag, fmt, ...) APP_LOG_LEVEL(APP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
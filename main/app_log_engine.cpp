@@ -0,0 +1,323 @@
+/*
+   M5NanoC6 Matter Switch - Deferred Log Engine
+
+   No ESP-IDF dependencies: see app_log_engine.h.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_log_engine.h"
+
+bool app_log_ring_init(app_log_ring_t *ring, app_log_slot_t *slots, uint32_t count)
+{
+    if (count == 0 || (count & (count - 1)) != 0) {
+        return false;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = slots;
+    ring->mask = count - 1;
+    for (uint32_t i = 0; i < count; i++) {
+        slots[i].seq = i;
+    }
+    return true;
+}
+
+app_log_record_t *app_log_ring_claim(app_log_ring_t *ring, uint32_t *pos)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    for (;;) {
+        app_log_slot_t *slot = &ring->slots[head & ring->mask];
+        int32_t diff = static_cast<int32_t>(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - head);
+        if (diff == 0) {
+            // Free for this position: claim it (on failure head holds the current value)
+            if (__atomic_compare_exchange_n(&ring->head, &head, head + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                *pos = head;
+                return &slot->record;
+            }
+        } else if (diff < 0) {
+            // Still holds a record from one lap ago: full
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return NULL;
+        } else {
+            head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void app_log_ring_commit(app_log_ring_t *ring, uint32_t pos)
+{
+    __atomic_store_n(&ring->slots[pos & ring->mask].seq, pos + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&ring->written, 1, __ATOMIC_RELAXED);
+}
+
+bool app_log_ring_take(app_log_ring_t *ring, app_log_record_t *out)
+{
+    uint32_t tail = ring->tail;
+    app_log_slot_t *slot = &ring->slots[tail & ring->mask];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+        return false;
+    }
+    uint32_t pending = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - tail;
+    if (pending > ring->high_water) {
+        ring->high_water = pending;
+    }
+    *out = slot->record;
+    // Free for the position one lap ahead
+    __atomic_store_n(&slot->seq, tail + ring->mask + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+uint32_t app_log_ring_pending(const app_log_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+// Size in bytes that printf reads for an integer conversion with this length modifier
+static size_t modifier_size(const char *mod, char conv)
+{
+    if (!*mod) {
+        return conv == 'c' ? sizeof(unsigned char) : sizeof(int);
+    }
+    if (strcmp(mod, "hh") == 0) return sizeof(char);
+    if (strcmp(mod, "h") == 0) return sizeof(short);
+    if (strcmp(mod, "l") == 0) return sizeof(long);
+    if (strcmp(mod, "ll") == 0 || strcmp(mod, "q") == 0) return sizeof(long long);
+    if (strcmp(mod, "j") == 0) return sizeof(intmax_t);
+    if (strcmp(mod, "z") == 0) return sizeof(size_t);
+    if (strcmp(mod, "t") == 0) return sizeof(ptrdiff_t);
+    return sizeof(long long);
+}
+
+// Value of an integer argument as printf would read it with this conversion
+static long long integer_value(const app_log_record_t *record, int i, size_t size, bool is_signed)
+{
+    uint64_t v = record->args[i];
+    uint8_t type = record->types[i] & 0x0F;
+    if (type == APP_LOG_ARG_DOUBLE) {
+        double d;
+        memcpy(&d, &v, sizeof(d));
+        return static_cast<long long>(d);
+    }
+    size_t arg_size = record->types[i] >> 4;
+    if (arg_size && arg_size < size) {
+        size = arg_size;
+    }
+    if (size < sizeof(uint64_t)) {
+        uint64_t mask = (1ULL << (size * 8)) - 1;
+        v &= mask;
+        if (is_signed && (v >> (size * 8 - 1)) & 1) {
+            v |= ~mask;
+        }
+    }
+    return static_cast<long long>(v);
+}
+
+size_t app_log_format(const app_log_record_t *record, char *buf, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    size_t len = 0;
+    int arg = 0;
+    const char *p = record->fmt;
+
+    // Appends up to the end of buf; len keeps counting so truncation is detected
+#define APPEND(...)                                                                         \
+    do {                                                                                    \
+        int n_ = snprintf(buf + (len < size ? len : size - 1), len < size ? size - len : 1, \
+                          __VA_ARGS__);                                                     \
+        if (n_ > 0) {                                                                       \
+            len += static_cast<size_t>(n_);                                                 \
+        }                                                                                   \
+    } while (0)
+
+    while (*p) {
+        const char *start = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        if (p > start) {
+            APPEND("%.*s", static_cast<int>(p - start), start);
+        }
+        if (!*p) {
+            break;
+        }
+        if (p[1] == '%') {
+            APPEND("%%");
+            p += 2;
+            continue;
+        }
+
+        // Rebuild the conversion: flags, width and precision kept ('*' filled in), length dropped
+        char spec[48];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0", *p) && s < 8) {
+            spec[s++] = *p++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*p != '.') {
+                    break;
+                }
+                spec[s++] = *p++;
+            }
+            if (*p == '*') {
+                p++;
+                int value = arg < record->nargs ? static_cast<int>(integer_value(record, arg, sizeof(int), true)) : 0;
+                arg++;
+                s += static_cast<size_t>(snprintf(spec + s, 12, "%d", value));
+            } else {
+                while (*p >= '0' && *p <= '9' && s < 20) {
+                    spec[s++] = *p++;
+                }
+            }
+        }
+        char mod[3] = "";
+        size_t m = 0;
+        while (*p && strchr("hljztLq", *p)) {
+            if (m < 2) {
+                mod[m++] = *p;
+                mod[m] = '\0';
+            }
+            p++;
+        }
+        char conv = *p;
+        if (!conv) {
+            break;
+        }
+        p++;
+        if (!strchr("diouxXcfFeEgGaAsp", conv)) {
+            continue;       // %n and unknown conversions print nothing
+        }
+        if (arg >= record->nargs) {
+            APPEND("(?)");
+            continue;
+        }
+        int i = arg++;
+        uint8_t type = record->types[i] & 0x0F;
+
+        if (conv == 's') {
+            spec[s++] = 's';
+            spec[s] = '\0';
+            const char *text = "(?)";
+            if (type == APP_LOG_ARG_STRING) {
+                text = record->args[i] < record->text_len ? record->text + record->args[i] : "";
+            }
+            APPEND(spec, text);
+        } else if (conv == 'p') {
+            spec[s++] = 'p';
+            spec[s] = '\0';
+            APPEND(spec, reinterpret_cast<void *>(static_cast<uintptr_t>(record->args[i])));
+        } else if (strchr("fFeEgGaA", conv)) {
+            double d;
+            if (type == APP_LOG_ARG_DOUBLE) {
+                memcpy(&d, &record->args[i], sizeof(d));
+            } else {
+                d = static_cast<double>(integer_value(record, i, sizeof(long long), type == APP_LOG_ARG_SIGNED));
+            }
+            spec[s++] = conv;
+            spec[s] = '\0';
+            APPEND(spec, d);
+        } else if (conv == 'c') {
+            spec[s++] = 'c';
+            spec[s] = '\0';
+            APPEND(spec, static_cast<int>(integer_value(record, i, sizeof(unsigned char), false)));
+        } else {
+            bool is_signed = conv == 'd' || conv == 'i';
+            long long v = integer_value(record, i, modifier_size(mod, conv), is_signed);
+            spec[s++] = 'l';
+            spec[s++] = 'l';
+            spec[s++] = conv;
+            spec[s] = '\0';
+            if (is_signed) {
+                APPEND(spec, v);
+            } else {
+                APPEND(spec, static_cast<unsigned long long>(v));
+            }
+        }
+    }
+#undef APPEND
+
+    if (len >= size) {
+        len = size - 1;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static void update_max_level(app_log_levels_t *levels)
+{
+    uint8_t max_level = levels->default_level;
+    for (uint8_t i = 0; i < levels->count; i++) {
+        if (levels->tags[i].level > max_level) {
+            max_level = levels->tags[i].level;
+        }
+    }
+    __atomic_store_n(&levels->max_level, max_level, __ATOMIC_RELAXED);
+}
+
+void app_log_levels_init(app_log_levels_t *levels, uint8_t default_level)
+{
+    memset(levels, 0, sizeof(*levels));
+    levels->default_level = default_level;
+    levels->max_level = default_level;
+}
+
+bool app_log_levels_set(app_log_levels_t *levels, const char *tag, uint8_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        // Published entries are never rewritten (a reader may be comparing their tag): reset them in place
+        if (level > levels->max_level) {
+            __atomic_store_n(&levels->max_level, level, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&levels->default_level, level, __ATOMIC_RELAXED);
+        for (uint8_t i = 0; i < levels->count; i++) {
+            __atomic_store_n(&levels->tags[i].level, level, __ATOMIC_RELAXED);
+        }
+        update_max_level(levels);
+        return true;
+    }
+    if (strlen(tag) > APP_LOG_TAG_LEN) {
+        return false;
+    }
+    for (uint8_t i = 0; i < levels->count; i++) {
+        if (strcmp(levels->tags[i].tag, tag) == 0) {
+            // Raise the fast-path limit before the entry, lower it after
+            if (level > levels->max_level) {
+                __atomic_store_n(&levels->max_level, level, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&levels->tags[i].level, level, __ATOMIC_RELAXED);
+            update_max_level(levels);
+            return true;
+        }
+    }
+    if (levels->count >= APP_LOG_MAX_TAGS) {
+        return false;
+    }
+    app_log_tag_level_t *entry = &levels->tags[levels->count];
+    strcpy(entry->tag, tag);
+    entry->level = level;
+    if (level > levels->max_level) {
+        __atomic_store_n(&levels->max_level, level, __ATOMIC_RELAXED);
+    }
+    // Entry complete before readers can see it
+    __atomic_store_n(&levels->count, static_cast<uint8_t>(levels->count + 1), __ATOMIC_RELEASE);
+    update_max_level(levels);
+    return true;
+}
+
+uint8_t app_log_levels_get(const app_log_levels_t *levels, const char *tag)
+{
+    uint8_t count = __atomic_load_n(&levels->count, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < count; i++) {
+        const app_log_tag_level_t *entry = &levels->tags[i];
+        if (strcmp(entry->tag, tag) == 0) {
+            return __atomic_load_n(&entry->level, __ATOMIC_RELAXED);
+        }
+    }
+    return __atomic_load_n(&levels->default_level, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,252 @@
+/*
+   M5NanoC6 Matter Switch - Deferred Log Engine
+
+   Hardware-independent parts of the deferred logger: a lock-free ring of
+   fixed-size records, argument capture, the formatter and per-tag levels.
+   A log call stores the format string pointer, the tag pointer and the raw
+   arguments in a ring slot. No formatting happens on the calling task. A
+   low-priority task later takes the records out and formats them with
+   app_log_format(). scripts/log_bench.py builds this file for the host.
+
+   Ring: bounded multi-producer queue, one sequence word per slot. A
+   producer claims a slot with one compare-and-swap on the head and
+   publishes it by storing the slot sequence. There is no lock, so a task
+   preempted while filling its slot never blocks the other producers. When
+   the ring is full the record is dropped and counted.
+
+   Arguments are captured by type (C++ templates, app_log_capture()).
+   Integers are stored as 64-bit values together with their promoted size,
+   and doubles as doubles. Pointers are stored as their address. The text
+   of %s arguments is copied into the record, up to APP_LOG_TEXT_BYTES per
+   record and truncated beyond that. Format strings and tags must be string
+   literals (or otherwise live forever): only their pointers are stored.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_LOG_MAX_ARGS    6
+#define APP_LOG_TEXT_BYTES  40      // %s text copied per record (all strings together)
+#define APP_LOG_MAX_TAGS    16      // Tags with their own level
+#define APP_LOG_TAG_LEN     23
+
+// Same values as esp_log_level_t
+typedef enum {
+    APP_LOG_NONE = 0,
+    APP_LOG_ERROR = 1,
+    APP_LOG_WARN = 2,
+    APP_LOG_INFO = 3,
+    APP_LOG_DEBUG = 4,
+    APP_LOG_VERBOSE = 5,
+} app_log_level_t;
+
+typedef enum {
+    APP_LOG_ARG_SIGNED = 0,
+    APP_LOG_ARG_UNSIGNED = 1,
+    APP_LOG_ARG_DOUBLE = 2,
+    APP_LOG_ARG_POINTER = 3,
+    APP_LOG_ARG_STRING = 4,     // value = offset of the text in record.text
+} app_log_arg_type_t;
+
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    uint32_t ms;                            // Timestamp of the call
+    uint8_t level;
+    uint8_t nargs;
+    uint8_t text_len;
+    uint8_t types[APP_LOG_MAX_ARGS];        // app_log_arg_type_t | size << 4 (bytes after promotion)
+    uint64_t args[APP_LOG_MAX_ARGS];        // Raw bits (doubles by memcpy)
+    char text[APP_LOG_TEXT_BYTES];
+} app_log_record_t;
+
+typedef struct {
+    uint32_t seq;                           // Ring position this slot is ready for
+    app_log_record_t record;
+} app_log_slot_t;
+
+typedef struct {
+    app_log_slot_t *slots;
+    uint32_t mask;                          // Slot count - 1 (power of two)
+    uint32_t head;                          // Next position to claim (producers)
+    uint32_t tail;                          // Next position to read (consumer)
+    // Statistics
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t high_water;                    // Most records waiting at once
+} app_log_ring_t;
+
+typedef struct {
+    char tag[APP_LOG_TAG_LEN + 1];
+    uint8_t level;
+} app_log_tag_level_t;
+
+typedef struct {
+    app_log_tag_level_t tags[APP_LOG_MAX_TAGS];
+    uint8_t count;
+    uint8_t default_level;
+    uint8_t max_level;                      // Highest level of any entry: rejects most calls without a lookup
+} app_log_levels_t;
+
+/**
+ * @brief Attach slots to a ring and empty it
+ *
+ * @param ring Ring
+ * @param slots Slot array
+ * @param count Number of slots, a power of two
+ * @return false if count is not a power of two
+ */
+bool app_log_ring_init(app_log_ring_t *ring, app_log_slot_t *slots, uint32_t count);
+
+/**
+ * @brief Claim a slot for a new record
+ *
+ * Lock-free; safe from any task and from interrupts. Fill the returned
+ * record, then publish it with app_log_ring_commit().
+ *
+ * @param ring Ring
+ * @param[out] pos Position to pass to app_log_ring_commit()
+ * @return Record to fill, or NULL if the ring is full (counted as dropped)
+ */
+app_log_record_t *app_log_ring_claim(app_log_ring_t *ring, uint32_t *pos);
+
+/**
+ * @brief Publish a record filled after app_log_ring_claim()
+ */
+void app_log_ring_commit(app_log_ring_t *ring, uint32_t pos);
+
+/**
+ * @brief Take the oldest published record (single consumer)
+ *
+ * @param ring Ring
+ * @param[out] out Copy of the record
+ * @return false if nothing is ready. Records are taken in claim order: a
+ *         slot that is claimed but not yet committed holds back the later ones.
+ */
+bool app_log_ring_take(app_log_ring_t *ring, app_log_record_t *out);
+
+/**
+ * @brief Number of claimed records not yet taken
+ */
+uint32_t app_log_ring_pending(const app_log_ring_t *ring);
+
+/**
+ * @brief Format a record's message (without level, timestamp or tag)
+ *
+ * Handles the printf conversions with flags, width, precision (including
+ * '*') and length modifiers. A conversion without a matching argument
+ * prints "(?)".
+ *
+ * @param record Record
+ * @param buf Output buffer, always NUL-terminated
+ * @param size Size of buf
+ * @return Length of the message (truncated to size - 1)
+ */
+size_t app_log_format(const app_log_record_t *record, char *buf, size_t size);
+
+/**
+ * @brief Reset to one level for every tag
+ */
+void app_log_levels_init(app_log_levels_t *levels, uint8_t default_level);
+
+/**
+ * @brief Set a tag's level ("*" sets the default and resets every tag to it)
+ *
+ * Readers on other tasks see either the old or the new level. Entries are
+ * only ever appended, so the table holds APP_LOG_MAX_TAGS distinct tags
+ * since init; "*" does not free them.
+ *
+ * @return false if the table is full or the tag is longer than APP_LOG_TAG_LEN
+ */
+bool app_log_levels_set(app_log_levels_t *levels, const char *tag, uint8_t level);
+
+/**
+ * @brief Level in effect for a tag
+ */
+uint8_t app_log_levels_get(const app_log_levels_t *levels, const char *tag);
+
+/**
+ * @brief Whether a call at this level and tag should be recorded
+ */
+static inline bool app_log_levels_enabled(const app_log_levels_t *levels, uint8_t level, const char *tag)
+{
+    if (level > levels->max_level) {
+        return false;
+    }
+    if (levels->count == 0) {
+        return true;
+    }
+    return level <= app_log_levels_get(levels, tag);
+}
+
+#ifdef __cplusplus
+}
+
+#include <type_traits>
+
+namespace app_log_detail {
+
+template <typename T> inline void capture_arg(app_log_record_t *record, T value)
+{
+    using U = typename std::decay<T>::type;
+    const int i = record->nargs++;
+    if constexpr (std::is_same<U, char *>::value || std::is_same<U, const char *>::value) {
+        const char *text = value ? value : "(null)";
+        size_t room = APP_LOG_TEXT_BYTES - record->text_len;
+        size_t len = room ? strnlen(text, room - 1) : 0;
+        if (room) {
+            memcpy(record->text + record->text_len, text, len);
+            record->text[record->text_len + len] = '\0';
+        }
+        record->types[i] = APP_LOG_ARG_STRING;
+        record->args[i] = room ? record->text_len : APP_LOG_TEXT_BYTES;   // Out of room: prints ""
+        record->text_len = static_cast<uint8_t>(record->text_len + (room ? len + 1 : 0));
+    } else if constexpr (std::is_floating_point<U>::value) {
+        double d = static_cast<double>(value);
+        memcpy(&record->args[i], &d, sizeof(d));
+        record->types[i] = APP_LOG_ARG_DOUBLE | (sizeof(double) << 4);
+    } else if constexpr (std::is_pointer<U>::value || std::is_null_pointer<U>::value) {
+        record->args[i] = reinterpret_cast<uintptr_t>(static_cast<const void *>(value));
+        record->types[i] = APP_LOG_ARG_POINTER | (sizeof(void *) << 4);
+    } else if constexpr (std::is_enum<U>::value) {
+        using E = typename std::underlying_type<U>::type;
+        using P = decltype(+static_cast<E>(0));         // Promoted as printf sees it
+        record->args[i] = static_cast<uint64_t>(static_cast<P>(static_cast<E>(value)));
+        record->types[i] = (std::is_signed<P>::value ? APP_LOG_ARG_SIGNED : APP_LOG_ARG_UNSIGNED) | (sizeof(P) << 4);
+    } else {
+        static_assert(std::is_integral<U>::value, "unsupported log argument type");
+        using P = decltype(+value);                     // Integer promotion
+        record->args[i] = static_cast<uint64_t>(static_cast<P>(value));
+        record->types[i] = (std::is_signed<P>::value ? APP_LOG_ARG_SIGNED : APP_LOG_ARG_UNSIGNED) | (sizeof(P) << 4);
+    }
+}
+
+} // namespace app_log_detail
+
+/**
+ * @brief Fill a claimed record
+ *
+ * At most APP_LOG_MAX_ARGS arguments (checked at compile time).
+ */
+template <typename... Args>
+inline void app_log_capture(app_log_record_t *record, uint8_t level, const char *tag, uint32_t ms, const char *fmt,
+                            Args... args)
+{
+    static_assert(sizeof...(Args) <= APP_LOG_MAX_ARGS, "too many log arguments");
+    record->tag = tag;
+    record->fmt = fmt;
+    record->ms = ms;
+    record->level = level;
+    record->nargs = 0;
+    record->text_len = 0;
+    (app_log_detail::capture_arg(record, args), ...);
+}
+#endif
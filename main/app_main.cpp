@@ -15,10 +15,24 @@
 #include <esp_matter_console.h>
 #include <esp_matter_ota.h>  // Required for CONFIG_ENABLE_OTA_REQUESTOR
 
-#include <iot_button.h>
 #include <common_macros.h>
 #include <app_priv.h>
 #include "app_reset.h"
+#include "app_ota.h"
+#include "app_ble.h"
+#include "app_bench.h"
+#include "app_button.h"
+#include "app_config.h"
+#include "app_evlog.h"
+#include "app_heap.h"
+#include "app_log.h"
+#include "app_switch.h"
+#include "app_subs.h"
+#include "app_scenes.h"
+#include "app_power.h"
+#include "app_schedule.h"
+#include "app_state.h"
+#include "app_thread.h"
 
 #if !CHIP_DEVICE_CONFIG_ENABLE_THREAD
 #include <esp_wifi.h>
@@ -46,6 +60,8 @@
 
 #include <app/server/CommissioningWindowManager.h>
 #include <app/server/Server.h>
+#include <platform/CommissionableDataProvider.h>
+#include <platform/DeviceInstanceInfoProvider.h>
 
 #include "include/CHIPProjectConfig.h"
 #include <esp_app_desc.h>
@@ -62,76 +78,114 @@ constexpr auto k_timeout_seconds = 300;
 // Driver handles
 static app_driver_handle_t s_led_handle = NULL;
 static app_driver_handle_t s_button_handle = NULL;
-static uint16_t s_switch_endpoint_id = 0;
 
-// Cached attribute pointer for fast button toggle
-static attribute_t *s_onoff_attribute = NULL;
+// Mirror link status into the state word (runs on the Matter thread)
+static void update_network_state(void)
+{
+#if CHIP_DEVICE_CONFIG_ENABLE_THREAD
+    bool up = chip::DeviceLayer::ConnectivityMgr().IsThreadAttached();
+#else
+    bool up = chip::DeviceLayer::ConnectivityMgr().IsWiFiStationConnected();
+#endif
+    app_state_update(APP_STATE_NETWORK, up ? APP_STATE_NETWORK : 0);
+}
 
-// Cluster/attribute IDs (compile-time constants)
-static constexpr uint32_t ONOFF_CLUSTER_ID = OnOff::Id;
-static constexpr uint32_t ONOFF_ATTRIBUTE_ID = OnOff::Attributes::OnOff::Id;
+static void update_commissioned_state(void)
+{
+    bool commissioned = chip::Server::GetInstance().GetFabricTable().FabricCount() > 0;
+    app_state_update(APP_STATE_COMMISSIONED, commissioned ? APP_STATE_COMMISSIONED : 0);
+}
 
 static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 {
+    app_evlog_matter_event(event->Type);
+
     switch (event->Type) {
     case chip::DeviceLayer::DeviceEventType::kInterfaceIpAddressChanged:
-        ESP_LOGI(TAG, "Interface IP Address changed");
+        APP_LOGI(TAG, "Interface IP Address changed");
+        update_network_state();
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kThreadStateChange:
+    case chip::DeviceLayer::DeviceEventType::kThreadConnectivityChange:
+    case chip::DeviceLayer::DeviceEventType::kWiFiConnectivityChange:
+        update_network_state();
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
-        ESP_LOGI(TAG, "Commissioning complete");
+        APP_LOGI(TAG, "Commissioning complete");
+        app_state_update(APP_STATE_COMMISSIONED, APP_STATE_COMMISSIONED);
+        app_ble_release();
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFailSafeTimerExpired:
-        ESP_LOGI(TAG, "Commissioning failed, fail safe timer expired");
+        APP_LOGI(TAG, "Commissioning failed, fail safe timer expired");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningSessionStarted:
-        ESP_LOGI(TAG, "Commissioning session started");
+        APP_LOGI(TAG, "Commissioning session started");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningSessionStopped:
-        ESP_LOGI(TAG, "Commissioning session stopped");
+        APP_LOGI(TAG, "Commissioning session stopped");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowOpened:
-        ESP_LOGI(TAG, "Commissioning window opened");
+        APP_LOGI(TAG, "Commissioning window opened");
+        app_state_update(APP_STATE_WINDOW_OPEN, APP_STATE_WINDOW_OPEN);
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowClosed:
-        ESP_LOGI(TAG, "Commissioning window closed");
+        APP_LOGI(TAG, "Commissioning window closed");
+        app_state_update(APP_STATE_WINDOW_OPEN, 0);
+        app_ble_release();
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kCHIPoBLEConnectionClosed:
+        app_ble_release();
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricRemoved: {
-        ESP_LOGI(TAG, "Fabric removed successfully");
+        APP_LOGI(TAG, "Fabric removed successfully");
+        update_commissioned_state();
         if (chip::Server::GetInstance().GetFabricTable().FabricCount() == 0) {
-            chip::CommissioningWindowManager &commissionMgr = chip::Server::GetInstance().GetCommissioningWindowManager();
-            constexpr auto kTimeoutSeconds = chip::System::Clock::Seconds16(k_timeout_seconds);
-            if (!commissionMgr.IsCommissioningWindowOpen()) {
-                CHIP_ERROR err = commissionMgr.OpenBasicCommissioningWindow(kTimeoutSeconds,
-                                                                            chip::CommissioningWindowAdvertisement::kDnssdOnly);
-                if (err != CHIP_NO_ERROR) {
-                    ESP_LOGE(TAG, "Failed to open commissioning window, err:%" CHIP_ERROR_FORMAT, err.Format());
-                }
-            }
+            // Brings BLE back if it was shut down after commissioning
+            app_ble_open_commissioning_window(k_timeout_seconds);
         }
         break;
     }
 
     case chip::DeviceLayer::DeviceEventType::kFabricWillBeRemoved:
-        ESP_LOGI(TAG, "Fabric will be removed");
+        APP_LOGI(TAG, "Fabric will be removed");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricUpdated:
-        ESP_LOGI(TAG, "Fabric is updated");
+        APP_LOGI(TAG, "Fabric is updated");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricCommitted:
-        ESP_LOGI(TAG, "Fabric is committed");
+        APP_LOGI(TAG, "Fabric is committed");
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kOtaStateChanged:
+        app_ota_state_changed(event->OtaStateChanged.newState);
         break;
 
     case chip::DeviceLayer::DeviceEventType::kBLEDeinitialized:
-        ESP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
+        app_ble_deinitialized();
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kServerReady:
+        update_commissioned_state();
+        update_network_state();
+        // Scene table is initialized by the server; move it onto the RAM cache
+        app_scenes_init(app_switch_get_endpoint());
+        // Cluster servers are up: start power sampling
+        app_power_init();
+        // Arm the schedule timer (polls until the clock has been set)
+        app_schedule_init();
+        // Already commissioned at boot: BLE is not needed
+        app_ble_release();
         break;
 
     default:
@@ -142,19 +196,14 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 static esp_err_t app_identification_cb(identification::callback_type_t type, uint16_t endpoint_id, uint8_t effect_id,
                                        uint8_t effect_variant, void *priv_data)
 {
-    ESP_LOGI(TAG, "Identification callback: type: %u, effect: %u, variant: %u", type, effect_id, effect_variant);
+    APP_LOGI(TAG, "Identification callback: type: %u, effect: %u, variant: %u", type, effect_id, effect_variant);
 
-    if (type == identification::callback_type_t::START || type == identification::callback_type_t::EFFECT) {
-        app_driver_led_identify_start();
+    if (type == identification::callback_type_t::START) {
+        app_switch_identify(APP_SWITCH_IDENTIFY_START);
+    } else if (type == identification::callback_type_t::EFFECT) {
+        app_switch_identify(APP_SWITCH_IDENTIFY_EFFECT);
     } else if (type == identification::callback_type_t::STOP) {
-        // Get current OnOff state to restore LED
-        bool current_power = false;
-        if (s_onoff_attribute) {
-            esp_matter_attr_val_t val = esp_matter_invalid(NULL);
-            attribute::get_val(s_onoff_attribute, &val);
-            current_power = val.val.b;
-        }
-        app_driver_led_identify_stop(current_power);
+        app_switch_identify(APP_SWITCH_IDENTIFY_STOP);
     }
 
     return ESP_OK;
@@ -163,52 +212,65 @@ static esp_err_t app_identification_cb(identification::callback_type_t type, uin
 static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
                                          uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
 {
-    esp_err_t err = ESP_OK;
-
-    if (type == PRE_UPDATE) {
-        auto driver_handle = static_cast<app_driver_handle_t>(priv_data);
-        err = app_driver_attribute_update(driver_handle, endpoint_id, cluster_id, attribute_id, val);
+    if (type == PRE_UPDATE && val) {
+        // Switch logic only consumes boolean, uint8 and uint16 attributes
+        uint32_t value;
+        if (val->type == ESP_MATTER_VAL_TYPE_BOOLEAN) {
+            value = val->val.b;
+        } else if (val->type == ESP_MATTER_VAL_TYPE_UINT16) {
+            value = val->val.u16;
+        } else {
+            value = val->val.u8;
+        }
+        app_switch_attribute_changed(endpoint_id, cluster_id, attribute_id, value);
     }
 
-    return err;
+    return ESP_OK;
 }
 
-// Button callback to toggle switch state
+// Button callback to toggle switch state (shared logic in app_switch.cpp)
 static void button_toggle_cb(void *arg, void *data)
 {
-    if (!s_onoff_attribute) {
-        ESP_LOGW(TAG, "OnOff attribute not cached");
-        return;
-    }
-
-    // Get current OnOff state using cached attribute pointer (fast path)
-    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
-    attribute::get_val(s_onoff_attribute, &val);
-    bool current_state = val.val.b;
-
-    // Toggle the state
-    val.val.b = !current_state;
-    ESP_LOGD(TAG, "Button: toggle %d -> %d", current_state, val.val.b);
-
-    // Update the attribute (this will trigger the callback and update the LED)
-    attribute::update(s_switch_endpoint_id, ONOFF_CLUSTER_ID, ONOFF_ATTRIBUTE_ID, &val);
+    app_switch_toggle();
 }
 
-// Get current on/off power state (used by app_reset to restore LED after cancelled reset)
-extern "C" bool app_get_current_power_state(void)
+static void log_commissioning_info(void)
 {
-    if (!s_onoff_attribute) {
-        return false;
+    ESP_LOGI(TAG, "=== Commissioning Info ===");
+#if CONFIG_ENABLE_ESP32_FACTORY_DATA_PROVIDER
+    // Commissioning data comes from the fctry partition
+    // Generate per-device partitions with: scripts/generate_factory_partitions.py
+    uint16_t discriminator = 0;
+    if (chip::DeviceLayer::GetCommissionableDataProvider()->GetSetupDiscriminator(discriminator) == CHIP_NO_ERROR) {
+        ESP_LOGI(TAG, "Discriminator: %d (0x%03X)", discriminator, discriminator);
+    } else {
+        ESP_LOGE(TAG, "No discriminator in fctry partition - flash factory data first");
+    }
+    char serial[32] = {};
+    if (chip::DeviceLayer::GetDeviceInstanceInfoProvider()->GetSerialNumber(serial, sizeof(serial)) == CHIP_NO_ERROR) {
+        ESP_LOGI(TAG, "Serial: %s", serial);
     }
-    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
-    attribute::get_val(s_onoff_attribute, &val);
-    return val.val.b;
+    ESP_LOGI(TAG, "Passcode: see device label");
+#else
+    // Log commissioning info from CHIPProjectConfig.h
+    // To change these values, edit main/include/CHIPProjectConfig.h
+    // and regenerate using: python3 scripts/generate_pairing_config.py
+    ESP_LOGI(TAG, "Discriminator: %d (0x%03X)",
+             CHIP_DEVICE_CONFIG_USE_TEST_SETUP_DISCRIMINATOR,
+             CHIP_DEVICE_CONFIG_USE_TEST_SETUP_DISCRIMINATOR);
+    ESP_LOGI(TAG, "Passcode: %d", CHIP_DEVICE_CONFIG_USE_TEST_SETUP_PIN_CODE);
+    ESP_LOGI(TAG, "Run 'scripts/generate_pairing_config.py' for QR code");
+#endif
+    ESP_LOGI(TAG, "==========================");
 }
 
 extern "C" void app_main()
 {
     esp_err_t err = ESP_OK;
 
+    // Deferred logging for the Matter/button/LED callbacks (APP_LOGx)
+    app_log_init();
+
     // Initialize NVS with error recovery
     err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -218,6 +280,12 @@ extern "C" void app_main()
     }
     ESP_ERROR_CHECK(err);
 
+    // Persistent event log: flush what the last boot left in RTC memory, record this boot
+    app_evlog_init();
+
+    // LED colors and timings: appcfg partition blob, or the compiled defaults
+    app_config_init();
+
     // Initialize LED driver first (for visual feedback)
     s_led_handle = app_driver_led_init();
     if (!s_led_handle) {
@@ -239,19 +307,37 @@ extern "C" void app_main()
     endpoint_t *endpoint = on_off_plug_in_unit::create(node, &plug_config, ENDPOINT_FLAG_NONE, s_led_handle);
     ABORT_APP_ON_FAILURE(endpoint != nullptr, ESP_LOGE(TAG, "Failed to create plug endpoint"));
 
-    s_switch_endpoint_id = endpoint::get_id(endpoint);
-    ESP_LOGI(TAG, "Created on_off_plug_in_unit endpoint with ID %d", s_switch_endpoint_id);
+    uint16_t switch_endpoint_id = endpoint::get_id(endpoint);
+    ESP_LOGI(TAG, "Created on_off_plug_in_unit endpoint with ID %d", switch_endpoint_id);
 
-    // Cache OnOff attribute pointer for fast button toggle
-    s_onoff_attribute = attribute::get(s_switch_endpoint_id, ONOFF_CLUSTER_ID, ONOFF_ATTRIBUTE_ID);
-    if (!s_onoff_attribute) {
-        ESP_LOGW(TAG, "Failed to cache OnOff attribute");
+    // On/Off Lighting feature: OnTime/OffWaitTime and OnWithTimedOff (handled in app_switch.cpp)
+    cluster_t *on_off_cluster = cluster::get(endpoint, OnOff::Id);
+    if (on_off_cluster && !attribute::get(on_off_cluster, OnOff::Attributes::OnTime::Id)) {
+        cluster::on_off::feature::lighting::config_t lighting_config;
+        cluster::on_off::feature::lighting::add(on_off_cluster, &lighting_config);
     }
 
+    // Scenes Management (scene table served from RAM, see app_scenes.cpp)
+    if (!cluster::get(endpoint, ScenesManagement::Id)) {
+        cluster::scenes_management::config_t scenes_config;
+        cluster::scenes_management::create(endpoint, &scenes_config, CLUSTER_FLAG_SERVER);
+    }
+
+    // Electrical Power/Energy Measurement (simulated source unless a meter driver is installed)
+    err = app_power_create_clusters(endpoint);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to create power measurement clusters"));
+
+    // Weekly on/off schedule (vendor cluster) and Time Synchronization on the root endpoint
+    err = app_schedule_create_cluster(endpoint);
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to create schedule cluster"));
+
+    app_switch_init(switch_endpoint_id);
+    app_platform_state_init(switch_endpoint_id);
+
     // Initialize button and register callbacks
     s_button_handle = app_driver_button_init();
     if (s_button_handle) {
-        iot_button_register_cb(static_cast<button_handle_t>(s_button_handle), BUTTON_SINGLE_CLICK, button_toggle_cb, NULL);
+        app_button_register_cb(s_button_handle, APP_BUTTON_EVENT_SINGLE_CLICK, button_toggle_cb, NULL);
         app_reset_button_register(s_button_handle);
         ESP_LOGI(TAG, "Button initialized with toggle and factory reset callbacks");
     }
@@ -270,6 +356,12 @@ extern "C" void app_main()
     err = esp_matter::start(app_event_cb);
     ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start Matter, err:%d", err));
 
+    // Per-subscription heap accounting (scripts/subs_bench.py)
+    app_subs_init();
+
+    // Attach/SRP/CASE timing and router role restore (Thread builds only)
+    app_thread_init();
+
 #if !CHIP_DEVICE_CONFIG_ENABLE_THREAD
     // Log WiFi provisioning status
     if (!chip::DeviceLayer::ConnectivityMgr().IsWiFiStationProvisioned()) {
@@ -280,24 +372,32 @@ extern "C" void app_main()
     const esp_app_desc_t *app_desc = esp_app_get_description();
     ESP_LOGI(TAG, "M5NanoC6 Matter Switch v%s started", app_desc->version);
 
-    // Log commissioning info from CHIPProjectConfig.h
-    // To change these values, edit main/include/CHIPProjectConfig.h
-    // and regenerate using: python3 scripts/generate_pairing_config.py
-    ESP_LOGI(TAG, "=== Commissioning Info ===");
-    ESP_LOGI(TAG, "Discriminator: %d (0x%03X)",
-             CHIP_DEVICE_CONFIG_USE_TEST_SETUP_DISCRIMINATOR,
-             CHIP_DEVICE_CONFIG_USE_TEST_SETUP_DISCRIMINATOR);
-    ESP_LOGI(TAG, "Passcode: %d", CHIP_DEVICE_CONFIG_USE_TEST_SETUP_PIN_CODE);
-    ESP_LOGI(TAG, "Run 'scripts/generate_pairing_config.py' for QR code");
-    ESP_LOGI(TAG, "==========================");
+    log_commissioning_info();
 
 #if CONFIG_ENABLE_CHIP_SHELL
     esp_matter::console::diagnostics_register_commands();
     esp_matter::console::wifi_register_commands();
     esp_matter::console::factoryreset_register_commands();
+    app_log_register_commands();
+    app_ota_register_commands();
+    app_evlog_register_commands();
+    app_heap_register_commands();
+    app_subs_register_commands();
+    app_scenes_register_commands();
+    app_power_register_commands();
+    app_schedule_register_commands();
+    app_thread_register_commands();
+    app_ble_register_commands();
+    app_driver_register_commands();
+    app_state_register_commands();
+    app_config_register_commands();
+    app_bench_register_commands();
 #if CONFIG_OPENTHREAD_CLI
     esp_matter::console::otcli_register_commands();
 #endif
     esp_matter::console::init();
 #endif
+
+    // Everything app-owned is allocated by now; flag any heap use from here on
+    app_heap_boot_complete();
 }
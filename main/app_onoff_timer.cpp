@@ -0,0 +1,195 @@
+/*
+   M5NanoC6 Matter Switch - OnOff Timed State Engine
+
+   No ESP-IDF or CHIP dependencies: see app_onoff_timer.h.
+*/
+
+#include <stddef.h>
+
+#include "app_onoff_timer.h"
+
+static app_onoff_timer_slot_t *find_slot(app_onoff_timer_t *timer, uint16_t endpoint_id, bool create)
+{
+    app_onoff_timer_slot_t *free_slot = NULL;
+    for (app_onoff_timer_slot_t &slot : timer->slots) {
+        if (slot.used && slot.endpoint_id == endpoint_id) {
+            return &slot;
+        }
+        if (!slot.used && !free_slot) {
+            free_slot = &slot;
+        }
+    }
+    if (create && free_slot) {
+        *free_slot = {};
+        free_slot->endpoint_id = endpoint_id;
+        free_slot->used = true;
+    }
+    return create ? free_slot : NULL;
+}
+
+// Both counters back at zero: nothing left to track for this endpoint
+static void release_if_idle(app_onoff_timer_slot_t *slot)
+{
+    if (slot->on_time == 0 && slot->off_wait_time == 0) {
+        slot->used = false;
+    }
+}
+
+// Quieter reporting: report changes to or from zero and increases, store the rest silently
+static uint32_t counter_actions(uint16_t before, uint16_t after)
+{
+    if (before == after) {
+        return 0;
+    }
+    if ((before == 0) != (after == 0) || after > before) {
+        return APP_ONOFF_TIMER_STORE | APP_ONOFF_TIMER_REPORT;
+    }
+    return APP_ONOFF_TIMER_STORE;
+}
+
+static bool counting(const app_onoff_timer_slot_t *slot)
+{
+    if (!slot->used) {
+        return false;
+    }
+    if (slot->on) {
+        return slot->on_time > 0 && slot->on_time != APP_ONOFF_TIMER_FOREVER &&
+               slot->off_wait_time != APP_ONOFF_TIMER_FOREVER;
+    }
+    return slot->off_wait_time > 0 && slot->off_wait_time != APP_ONOFF_TIMER_FOREVER;
+}
+
+void app_onoff_timer_init(app_onoff_timer_t *timer)
+{
+    *timer = {};
+}
+
+uint32_t app_onoff_timer_on_with_timed_off(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on,
+                                           bool accept_only_when_on, uint16_t on_time, uint16_t off_wait_time)
+{
+    if (accept_only_when_on && !on) {
+        return 0;
+    }
+
+    app_onoff_timer_slot_t *slot = find_slot(timer, endpoint_id, true);
+    if (!slot) {
+        return APP_ONOFF_TIMER_NO_SLOT;
+    }
+    if (on_time > APP_ONOFF_TIMER_MAX) {
+        on_time = APP_ONOFF_TIMER_MAX;
+    }
+    if (off_wait_time > APP_ONOFF_TIMER_MAX) {
+        off_wait_time = APP_ONOFF_TIMER_MAX;
+    }
+    slot->on = on;
+    uint16_t old_on_time = slot->on_time;
+    uint16_t old_off_wait_time = slot->off_wait_time;
+    uint32_t actions = 0;
+
+    if (!on && slot->off_wait_time > 0) {
+        // Delayed off guard: only shorten the wait, stay off
+        if (off_wait_time < slot->off_wait_time) {
+            slot->off_wait_time = off_wait_time;
+        }
+    } else {
+        if (on_time > slot->on_time) {
+            slot->on_time = on_time;
+        }
+        slot->off_wait_time = off_wait_time;
+        if (!on) {
+            // The OnOff change this causes must keep the new OffWaitTime
+            slot->on = true;
+            actions |= APP_ONOFF_TIMER_TURN_ON;
+        }
+    }
+
+    actions |= counter_actions(old_on_time, slot->on_time) | counter_actions(old_off_wait_time, slot->off_wait_time);
+    release_if_idle(slot);
+    return actions;
+}
+
+uint32_t app_onoff_timer_onoff_changed(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on)
+{
+    app_onoff_timer_slot_t *slot = find_slot(timer, endpoint_id, false);
+    if (!slot || slot->on == on) {
+        return 0;
+    }
+    slot->on = on;
+
+    uint32_t actions = 0;
+    if (on && slot->on_time == 0) {
+        actions = counter_actions(slot->off_wait_time, 0);
+        slot->off_wait_time = 0;
+    } else if (!on) {
+        actions = counter_actions(slot->on_time, 0);
+        slot->on_time = 0;
+    }
+    release_if_idle(slot);
+    return actions;
+}
+
+void app_onoff_timer_attribute_written(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on, bool is_on_time,
+                                       uint16_t value)
+{
+    app_onoff_timer_slot_t *slot = find_slot(timer, endpoint_id, value != 0);
+    if (!slot) {
+        return;
+    }
+    slot->on = on;
+    if (is_on_time) {
+        slot->on_time = value;
+    } else {
+        slot->off_wait_time = value;
+    }
+    release_if_idle(slot);
+}
+
+void app_onoff_timer_tick(app_onoff_timer_t *timer, app_onoff_timer_cb_t cb, void *arg)
+{
+    for (app_onoff_timer_slot_t &slot : timer->slots) {
+        if (!counting(&slot)) {
+            continue;
+        }
+
+        uint32_t actions;
+        if (slot.on) {
+            slot.on_time--;
+            actions = counter_actions(slot.on_time + 1, slot.on_time);
+            if (slot.on_time == 0) {
+                // Timed on expired: off with no delayed off guard
+                actions |= counter_actions(slot.off_wait_time, 0) | APP_ONOFF_TIMER_TURN_OFF;
+                slot.off_wait_time = 0;
+            }
+        } else {
+            slot.off_wait_time--;
+            actions = counter_actions(slot.off_wait_time + 1, slot.off_wait_time);
+        }
+
+        // Report before the slot may be released
+        app_onoff_timer_slot_t snapshot = slot;
+        release_if_idle(&slot);
+        if (cb) {
+            cb(&snapshot, actions, arg);
+        }
+    }
+}
+
+bool app_onoff_timer_running(const app_onoff_timer_t *timer)
+{
+    for (const app_onoff_timer_slot_t &slot : timer->slots) {
+        if (counting(&slot)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const app_onoff_timer_slot_t *app_onoff_timer_get(const app_onoff_timer_t *timer, uint16_t endpoint_id)
+{
+    for (const app_onoff_timer_slot_t &slot : timer->slots) {
+        if (slot.used && slot.endpoint_id == endpoint_id) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,122 @@
+/*
+   M5NanoC6 Matter Switch - OnOff Timed State Engine
+
+   Hardware-independent OnTime/OffWaitTime handling of the On/Off cluster
+   Lighting feature (OnWithTimedOff, On/Off side effects, countdown).
+   State for every endpoint lives in one fixed slot table and is advanced
+   by a single shared tick of APP_ONOFF_TIMER_TICK_MS (the attribute unit),
+   which only runs while some endpoint is counting down. Adding endpoints
+   adds a slot, not a timer.
+
+   The engine only computes; the caller applies the returned actions to
+   the data model (app_switch.cpp). scripts/onoff_timer_replay.py checks
+   it against the On/Off cluster rules on the host.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_ONOFF_TIMER_SLOTS       4       // Endpoints with timed state at the same time
+#define APP_ONOFF_TIMER_TICK_MS     100     // OnTime/OffWaitTime are in 1/10 s
+#define APP_ONOFF_TIMER_FOREVER     0xFFFF  // Counter value that disables the countdown
+#define APP_ONOFF_TIMER_MAX         0xFFFE  // Largest OnTime/OffWaitTime a command can set
+
+// Action bits returned to the caller
+#define APP_ONOFF_TIMER_TURN_ON     (1U << 0)
+#define APP_ONOFF_TIMER_TURN_OFF    (1U << 1)
+#define APP_ONOFF_TIMER_STORE       (1U << 2)   // OnTime/OffWaitTime changed: write them back
+#define APP_ONOFF_TIMER_REPORT      (1U << 3)   // ...and report (to/from zero or increase; quieter otherwise)
+#define APP_ONOFF_TIMER_NO_SLOT     (1U << 4)   // Slot table full, request not applied
+
+typedef struct {
+    uint16_t endpoint_id;
+    uint16_t on_time;           // 1/10 s
+    uint16_t off_wait_time;     // 1/10 s
+    bool on;                    // OnOff as last seen (or as turned on by a command)
+    bool used;
+} app_onoff_timer_slot_t;
+
+typedef struct {
+    app_onoff_timer_slot_t slots[APP_ONOFF_TIMER_SLOTS];
+} app_onoff_timer_t;
+
+/**
+ * @brief Callback for actions raised by app_onoff_timer_tick()
+ *
+ * @param slot Endpoint state after the tick
+ * @param actions APP_ONOFF_TIMER_* bits
+ * @param arg User argument
+ */
+typedef void (*app_onoff_timer_cb_t)(const app_onoff_timer_slot_t *slot, uint32_t actions, void *arg);
+
+/**
+ * @brief Clear all endpoint state
+ */
+void app_onoff_timer_init(app_onoff_timer_t *timer);
+
+/**
+ * @brief Apply an OnWithTimedOff command
+ *
+ * @param timer Engine instance
+ * @param endpoint_id Endpoint the command targets
+ * @param on Current OnOff value
+ * @param accept_only_when_on OnOffControl AcceptOnlyWhenOn bit
+ * @param on_time Command OnTime (1/10 s), clamped to APP_ONOFF_TIMER_MAX
+ * @param off_wait_time Command OffWaitTime (1/10 s), clamped to APP_ONOFF_TIMER_MAX
+ * @return Actions; 0 when the command is discarded
+ */
+uint32_t app_onoff_timer_on_with_timed_off(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on,
+                                           bool accept_only_when_on, uint16_t on_time, uint16_t off_wait_time);
+
+/**
+ * @brief Track an OnOff change from any source (command, button, scene, tick)
+ *
+ * Turning on clears OffWaitTime when OnTime is zero; turning off clears
+ * OnTime, which starts the OffWaitTime countdown (delayed off guard).
+ * Repeats of the last seen value, including the change back from a
+ * TURN_ON action, have no effect.
+ *
+ * @return Actions
+ */
+uint32_t app_onoff_timer_onoff_changed(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on);
+
+/**
+ * @brief Track a write of OnTime or OffWaitTime from the data model
+ *
+ * @param on Current OnOff value
+ * @param is_on_time true for OnTime, false for OffWaitTime
+ */
+void app_onoff_timer_attribute_written(app_onoff_timer_t *timer, uint16_t endpoint_id, bool on, bool is_on_time,
+                                       uint16_t value);
+
+/**
+ * @brief Advance every counting endpoint by one tick
+ *
+ * @param cb Called once per endpoint that raised actions
+ * @param arg Passed to cb
+ */
+void app_onoff_timer_tick(app_onoff_timer_t *timer, app_onoff_timer_cb_t cb, void *arg);
+
+/**
+ * @brief Whether the shared tick needs to run
+ *
+ * @return true if any endpoint is counting down
+ */
+bool app_onoff_timer_running(const app_onoff_timer_t *timer);
+
+/**
+ * @brief Endpoint state
+ *
+ * @return Slot, or NULL when the endpoint has no timed state
+ */
+const app_onoff_timer_slot_t *app_onoff_timer_get(const app_onoff_timer_t *timer, uint16_t endpoint_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,395 @@
+/*
+   M5NanoC6 Matter Switch - OTA Download Instrumentation
+
+   The OTA requestor (BDX downloader + ESP32 image processor) is owned by
+   esp-matter. Its flash writes are intercepted with linker wraps of
+   esp_ota_begin/write/end/abort (see main/CMakeLists.txt), which gives
+   exact flash write time and block arrival times without patching the SDK.
+
+   Block round trip = time from finishing a block's flash write (the image
+   processor then fetches the next block) to the next block arriving.
+
+   Flash write batching adapts to the link: when flash time per block is
+   significant compared to the round trip, blocks are coalesced into
+   sector-sized writes; on slow links blocks are written through.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+
+#include "app_evlog.h"
+#include "app_ota.h"
+#include "app_priv.h"
+#include "app_scenes.h"
+
+#if CONFIG_ENABLE_OTA_REQUESTOR
+
+static const char *TAG = "app_ota";
+
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_ota_stats_t s_stats = {};
+
+// Current transfer (only touched from the Matter thread)
+static esp_ota_handle_t s_handle = 0;
+static bool s_active = false;
+static int64_t s_start_us = 0;
+static int64_t s_last_write_done_us = 0;
+static uint64_t s_rtt_sum_us = 0;
+static uint32_t s_rtt_count = 0;
+static uint64_t s_flash_us = 0;
+
+// Exponential moving averages (1/8 weight) for adaptation
+static uint32_t s_rtt_ewma_us = 0;
+static uint32_t s_flash_per_kb_ewma_us = 0;
+
+// Write batch; first block always goes straight through so header checks are not deferred
+static uint8_t s_batch[OTA_WRITE_BATCH_MAX];
+static size_t s_batch_len = 0;
+static size_t s_batch_target = 0;
+
+extern "C" esp_err_t __real_esp_ota_begin(const esp_partition_t *partition, size_t image_size,
+                                          esp_ota_handle_t *out_handle);
+extern "C" esp_err_t __real_esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+extern "C" esp_err_t __real_esp_ota_end(esp_ota_handle_t handle);
+extern "C" esp_err_t __real_esp_ota_abort(esp_ota_handle_t handle);
+
+static inline uint32_t ewma(uint32_t avg, uint32_t sample)
+{
+    return avg ? avg - avg / 8 + sample / 8 : sample;
+}
+
+static void adapt_batch(void)
+{
+    if (!s_rtt_ewma_us || !s_flash_per_kb_ewma_us || !s_stats.blocks) {
+        return;
+    }
+
+    uint32_t avg_block = s_stats.bytes / s_stats.blocks;
+    uint32_t flash_per_block_us = s_flash_per_kb_ewma_us * avg_block / 1024;
+    size_t target = s_batch_target;
+
+    if (flash_per_block_us * OTA_FLASH_RTT_RATIO_GROW > s_rtt_ewma_us) {
+        target = target ? target * 2 : OTA_WRITE_BATCH_MIN;
+        if (target > OTA_WRITE_BATCH_MAX) {
+            target = OTA_WRITE_BATCH_MAX;
+        }
+    } else if (flash_per_block_us * OTA_FLASH_RTT_RATIO_SHRINK < s_rtt_ewma_us) {
+        target = target / 2 < OTA_WRITE_BATCH_MIN ? 0 : target / 2;
+    }
+
+    if (target != s_batch_target) {
+        ESP_LOGD(TAG, "Write batch %u -> %u (rtt %" PRIu32 "us, flash/block %" PRIu32 "us)",
+                 (unsigned)s_batch_target, (unsigned)target, s_rtt_ewma_us, flash_per_block_us);
+        s_batch_target = target;
+    }
+}
+
+static esp_err_t timed_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = __real_esp_ota_write(handle, data, size);
+    uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - t0);
+
+    s_flash_us += elapsed;
+    if (size >= 256) {
+        s_flash_per_kb_ewma_us = ewma(s_flash_per_kb_ewma_us, elapsed * 1024 / size);
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.flash_writes++;
+    s_stats.flash_ms = static_cast<uint32_t>(s_flash_us / 1000);
+    portEXIT_CRITICAL(&s_stats_lock);
+    return err;
+}
+
+static esp_err_t flush_batch(esp_ota_handle_t handle)
+{
+    if (!s_batch_len) {
+        return ESP_OK;
+    }
+    esp_err_t err = timed_write(handle, s_batch, s_batch_len);
+    s_batch_len = 0;
+    return err;
+}
+
+static void record_block(int64_t now, size_t size)
+{
+    bool new_block = true;
+    uint32_t gap = 0;
+
+    if (s_last_write_done_us) {
+        gap = static_cast<uint32_t>(now - s_last_write_done_us);
+        new_block = gap >= OTA_BLOCK_GAP_MIN_US;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.bytes += size;
+    if (new_block) {
+        s_stats.blocks++;
+        if (gap) {
+            if (s_rtt_ewma_us && gap > OTA_STALL_MIN_US && gap > s_rtt_ewma_us * OTA_STALL_FACTOR) {
+                s_stats.stalls++;
+            }
+            s_rtt_sum_us += gap;
+            s_rtt_count++;
+            s_stats.rtt_avg_us = static_cast<uint32_t>(s_rtt_sum_us / s_rtt_count);
+            if (!s_stats.rtt_min_us || gap < s_stats.rtt_min_us) {
+                s_stats.rtt_min_us = gap;
+            }
+            if (gap > s_stats.rtt_max_us) {
+                s_stats.rtt_max_us = gap;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    if (new_block && gap) {
+        s_rtt_ewma_us = ewma(s_rtt_ewma_us, gap);
+    }
+}
+
+static void finish_transfer(bool success)
+{
+    if (!s_active) {
+        return;
+    }
+    s_active = false;
+
+    uint32_t duration_ms = static_cast<uint32_t>((esp_timer_get_time() - s_start_us) / 1000);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    if (success) {
+        s_stats.completed++;
+    } else {
+        s_stats.failed++;
+    }
+    s_stats.duration_ms = duration_ms;
+    s_stats.bytes_per_sec = duration_ms ? static_cast<uint32_t>(s_stats.bytes * 1000ULL / duration_ms) : 0;
+    s_stats.batch_size = s_batch_target;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+extern "C" esp_err_t __wrap_esp_ota_begin(const esp_partition_t *partition, size_t image_size,
+                                          esp_ota_handle_t *out_handle)
+{
+    esp_err_t err = __real_esp_ota_begin(partition, image_size, out_handle);
+    if (err != ESP_OK || !out_handle) {
+        return err;
+    }
+
+    // A begin without a matching end means the previous transfer was dropped
+    finish_transfer(false);
+
+    s_handle = *out_handle;
+    s_active = true;
+    s_start_us = esp_timer_get_time();
+    s_last_write_done_us = 0;
+    s_rtt_sum_us = 0;
+    s_rtt_count = 0;
+    s_flash_us = 0;
+    s_batch_len = 0;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.transfers++;
+    s_stats.bytes = 0;
+    s_stats.blocks = 0;
+    s_stats.duration_ms = 0;
+    s_stats.bytes_per_sec = 0;
+    s_stats.rtt_avg_us = 0;
+    s_stats.rtt_min_us = 0;
+    s_stats.rtt_max_us = 0;
+    s_stats.flash_ms = 0;
+    s_stats.flash_writes = 0;
+    s_stats.batch_size = s_batch_target;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    return ESP_OK;
+}
+
+extern "C" esp_err_t __wrap_esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (!s_active || handle != s_handle) {
+        return __real_esp_ota_write(handle, data, size);
+    }
+
+    record_block(esp_timer_get_time(), size);
+
+    esp_err_t err = ESP_OK;
+    bool first_block = s_stats.blocks <= 1;
+
+    if (first_block || !s_batch_target || size > sizeof(s_batch)) {
+        err = flush_batch(handle);
+        if (err == ESP_OK) {
+            err = timed_write(handle, data, size);
+        }
+    } else {
+        if (s_batch_len + size > sizeof(s_batch)) {
+            err = flush_batch(handle);
+        }
+        if (err == ESP_OK) {
+            memcpy(s_batch + s_batch_len, data, size);
+            s_batch_len += size;
+            if (s_batch_len >= s_batch_target) {
+                err = flush_batch(handle);
+            }
+        }
+    }
+
+    adapt_batch();
+    s_last_write_done_us = esp_timer_get_time();
+    return err;
+}
+
+extern "C" esp_err_t __wrap_esp_ota_end(esp_ota_handle_t handle)
+{
+    if (!s_active || handle != s_handle) {
+        return __real_esp_ota_end(handle);
+    }
+
+    esp_err_t err = flush_batch(handle);
+    if (err != ESP_OK) {
+        __real_esp_ota_abort(handle);
+        finish_transfer(false);
+        return err;
+    }
+
+    // esp_ota_end validates the image (including the appended SHA-256)
+    err = __real_esp_ota_end(handle);
+    finish_transfer(err == ESP_OK);
+    return err;
+}
+
+extern "C" esp_err_t __wrap_esp_ota_abort(esp_ota_handle_t handle)
+{
+    if (s_active && handle == s_handle) {
+        s_batch_len = 0;
+        finish_transfer(false);
+    }
+    return __real_esp_ota_abort(handle);
+}
+
+void app_ota_get_stats(app_ota_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static int format_stats(char *buf, size_t len)
+{
+    app_ota_stats_t st;
+    app_ota_get_stats(&st);
+    return snprintf(buf, len,
+                    "{\"transfers\":%" PRIu32 ",\"completed\":%" PRIu32 ",\"failed\":%" PRIu32
+                    ",\"stalls\":%" PRIu32 ",\"bytes\":%" PRIu32 ",\"blocks\":%" PRIu32
+                    ",\"duration_ms\":%" PRIu32 ",\"bytes_per_sec\":%" PRIu32
+                    ",\"rtt_avg_us\":%" PRIu32 ",\"rtt_min_us\":%" PRIu32 ",\"rtt_max_us\":%" PRIu32
+                    ",\"flash_ms\":%" PRIu32 ",\"flash_writes\":%" PRIu32 ",\"batch_size\":%" PRIu32 "}",
+                    st.transfers, st.completed, st.failed, st.stalls, st.bytes, st.blocks,
+                    st.duration_ms, st.bytes_per_sec, st.rtt_avg_us, st.rtt_min_us, st.rtt_max_us,
+                    st.flash_ms, st.flash_writes, st.batch_size);
+}
+
+static void log_stats(void)
+{
+    char buf[384];
+    format_stats(buf, sizeof(buf));
+    ESP_LOGI(TAG, "OTA stats: %s", buf);
+}
+
+static void evlog_outcome(app_evlog_ota_t outcome)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    uint32_t args[] = {static_cast<uint32_t>(outcome), s_stats.bytes};
+    portEXIT_CRITICAL(&s_stats_lock);
+    app_evlog_record(APP_EVLOG_OTA, args, 2);
+}
+
+void app_ota_state_changed(chip::DeviceLayer::OtaState state)
+{
+    using chip::DeviceLayer::OtaState;
+
+    switch (state) {
+    case OtaState::kOtaDownloadInProgress:
+        ESP_LOGI(TAG, "OTA download started");
+        evlog_outcome(APP_EVLOG_OTA_STARTED);
+        app_driver_led_ota_start();
+        break;
+
+    case OtaState::kOtaDownloadComplete:
+        ESP_LOGI(TAG, "OTA download complete");
+        evlog_outcome(APP_EVLOG_OTA_COMPLETE);
+        app_driver_led_ota_stop(app_get_current_power_state());
+        log_stats();
+        app_scenes_flush();     // The apply restart follows
+        break;
+
+    case OtaState::kOtaDownloadFailed:
+    case OtaState::kOtaDownloadAborted:
+        ESP_LOGW(TAG, "OTA download %s", state == OtaState::kOtaDownloadFailed ? "failed" : "aborted");
+        evlog_outcome(state == OtaState::kOtaDownloadFailed ? APP_EVLOG_OTA_FAILED : APP_EVLOG_OTA_ABORTED);
+        app_driver_led_ota_stop(app_get_current_power_state());
+        log_stats();
+        break;
+
+    case OtaState::kOtaApplyFailed:
+        ESP_LOGE(TAG, "OTA apply failed");
+        evlog_outcome(APP_EVLOG_OTA_APPLY_FAILED);
+        break;
+
+    default:
+        break;
+    }
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t ota_stats_handler(int argc, char **argv)
+{
+    char buf[384];
+    format_stats(buf, sizeof(buf));
+    printf("%s\n", buf);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_ota_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "ota-stats",
+        .description = "Print OTA download statistics as JSON",
+        .handler = ota_stats_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
+
+#else // CONFIG_ENABLE_OTA_REQUESTOR
+
+void app_ota_state_changed(chip::DeviceLayer::OtaState state) {}
+
+void app_ota_get_stats(app_ota_stats_t *out)
+{
+    if (out) {
+        memset(out, 0, sizeof(*out));
+    }
+}
+
+esp_err_t app_ota_register_commands(void)
+{
+    return ESP_OK;
+}
+
+#endif // CONFIG_ENABLE_OTA_REQUESTOR
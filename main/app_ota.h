@@ -0,0 +1,68 @@
+/*
+   M5NanoC6 Matter Switch - OTA Download Instrumentation Header
+
+   Measures OTA requestor downloads (throughput, block round trips, stalls,
+   flash write time) and adapts flash write batching to link quality.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <platform/CHIPDeviceEvent.h>
+
+// Flash write batching limits (bytes). 0 = write each block through.
+#define OTA_WRITE_BATCH_MIN         1024
+#define OTA_WRITE_BATCH_MAX         4096    // One flash sector
+
+// Adapt batching when per-block flash time vs. block round trip crosses these ratios
+#define OTA_FLASH_RTT_RATIO_GROW    4       // flash * 4 > rtt: link is fast, batch more
+#define OTA_FLASH_RTT_RATIO_SHRINK  16      // flash * 16 < rtt: link is slow, write through
+
+// Writes closer together than this belong to the same BDX block (delta OTA splits blocks)
+#define OTA_BLOCK_GAP_MIN_US        500
+
+// Block gap above this multiple of the average is counted as a stall (BDX retry/timeout)
+#define OTA_STALL_FACTOR            4
+#define OTA_STALL_MIN_US            1000000
+
+typedef struct {
+    uint32_t transfers;         // Downloads started
+    uint32_t completed;         // Downloads finished and validated
+    uint32_t failed;            // Downloads failed or aborted
+    uint32_t stalls;            // Blocks that arrived after a stall (BDX retry)
+    uint32_t bytes;             // Image bytes written in the last transfer
+    uint32_t blocks;            // Blocks received in the last transfer
+    uint32_t duration_ms;       // Last transfer duration
+    uint32_t bytes_per_sec;     // Last transfer throughput
+    uint32_t rtt_avg_us;        // Block round trip (write done -> next block)
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint32_t flash_ms;          // Time spent in esp_ota_write
+    uint32_t flash_writes;      // Flash write calls after batching
+    uint32_t batch_size;        // Current adaptive write batch size
+} app_ota_stats_t;
+
+/**
+ * @brief Handle OTA state change events
+ *
+ * Starts/stops the LED progress overlay and logs per-transfer statistics
+ * as a single "OTA stats: {json}" line.
+ *
+ * @param state New OTA state from kOtaStateChanged
+ */
+void app_ota_state_changed(chip::DeviceLayer::OtaState state);
+
+/**
+ * @brief Copy current OTA statistics
+ *
+ * @param[out] out Statistics snapshot
+ */
+void app_ota_get_stats(app_ota_stats_t *out);
+
+/**
+ * @brief Register "ota-stats" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_ota_register_commands(void);
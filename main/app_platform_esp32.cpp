@@ -0,0 +1,118 @@
+/*
+   M5NanoC6 Matter Switch - ESP32 Platform Hooks
+
+   app_switch_platform.h on ESP32: WS2812 LED via app_driver and the
+   esp_matter data model for the OnOff attribute. Every OnOff change passes
+   through app_platform_led_set_power(), which mirrors it into the device
+   state word. Reads of the switch endpoint's OnOff come from there, so the
+   button task never reads the data model while the Matter thread writes it.
+*/
+
+#include <esp_log.h>
+#include <esp_matter.h>
+
+#include <app_priv.h>
+#include "app_state.h"
+#include "app_switch.h"
+#include "app_switch_platform.h"
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+
+static const char *TAG = "app_platform";
+
+// Cached attribute pointer for fast button toggle
+static attribute_t *s_onoff_attribute = NULL;
+
+static attribute_t *onoff_attribute(uint16_t endpoint_id)
+{
+    if (!s_onoff_attribute) {
+        s_onoff_attribute = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id);
+    }
+    return s_onoff_attribute;
+}
+
+void app_platform_led_set_power(bool on)
+{
+    app_state_update(APP_STATE_POWER, on ? APP_STATE_POWER : 0);
+    app_driver_led_set_power(NULL, on);
+}
+
+void app_platform_led_identify_start(void)
+{
+    app_driver_led_identify_start();
+}
+
+void app_platform_led_identify_stop(bool current_power)
+{
+    app_driver_led_identify_stop(current_power);
+}
+
+void app_platform_led_ota_progress(uint8_t percent)
+{
+    app_driver_led_ota_progress(percent);
+}
+
+static bool read_onoff_attribute(uint16_t endpoint_id)
+{
+    attribute_t *attr = onoff_attribute(endpoint_id);
+    if (!attr) {
+        return false;
+    }
+    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+    attribute::get_val(attr, &val);
+    return val.val.b;
+}
+
+bool app_platform_onoff_get(uint16_t endpoint_id)
+{
+    if (endpoint_id == app_switch_get_endpoint()) {
+        return app_state_power(app_state_get());
+    }
+    return read_onoff_attribute(endpoint_id);
+}
+
+void app_platform_onoff_set(uint16_t endpoint_id, bool on)
+{
+    if (!onoff_attribute(endpoint_id)) {
+        ESP_LOGW(TAG, "OnOff attribute not found on endpoint %d", endpoint_id);
+        return;
+    }
+    esp_matter_attr_val_t val = esp_matter_bool(on);
+    attribute::update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
+}
+
+void app_platform_onoff_timer_store(uint16_t endpoint_id, uint16_t on_time, uint16_t off_wait_time, bool report)
+{
+    esp_matter_attr_val_t on_time_val = esp_matter_uint16(on_time);
+    esp_matter_attr_val_t off_wait_val = esp_matter_uint16(off_wait_time);
+    if (report) {
+        attribute::update(endpoint_id, OnOff::Id, OnOff::Attributes::OnTime::Id, &on_time_val);
+        attribute::update(endpoint_id, OnOff::Id, OnOff::Attributes::OffWaitTime::Id, &off_wait_val);
+        return;
+    }
+
+    // Countdown step: keep reads current without a report every tick
+    attribute_t *on_time_attr = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OnTime::Id);
+    attribute_t *off_wait_attr = attribute::get(endpoint_id, OnOff::Id, OnOff::Attributes::OffWaitTime::Id);
+    if (on_time_attr) {
+        attribute::set_val(on_time_attr, &on_time_val);
+    }
+    if (off_wait_attr) {
+        attribute::set_val(off_wait_attr, &off_wait_val);
+    }
+}
+
+extern "C" void app_platform_state_init(uint16_t endpoint_id)
+{
+    // Value restored from NVS when the endpoint was created; Matter is not running yet
+    bool on = read_onoff_attribute(endpoint_id);
+    app_state_update(APP_STATE_POWER, on ? APP_STATE_POWER : 0);
+    app_driver_led_set_power(NULL, on);
+}
+
+// Get current on/off power state (used by app_ota/app_power to restore LED and simulate load)
+extern "C" bool app_get_current_power_state(void)
+{
+    return app_state_power(app_state_get());
+}
@@ -0,0 +1,354 @@
+/*
+   M5NanoC6 Matter Switch - Power/Energy Measurement
+
+   A FreeRTOS timer reads one sample per CONFIG_APP_POWER_SAMPLE_MS and feeds
+   app_power_engine. Only when the engine decides a value is worth reporting
+   is work posted to the Matter thread, which marks the changed attributes
+   dirty (subscribers get a report) or emits CumulativeEnergyMeasured.
+   The cluster delegate always returns the last published values, so reads
+   and reports agree and a sub-threshold wobble never reaches the mesh.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/timers.h>
+
+#include <app/clusters/electrical-energy-measurement-server/electrical-energy-measurement-server.h>
+#include <app/clusters/electrical-power-measurement-server/electrical-power-measurement-server.h>
+#include <app/reporting/reporting.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <system/SystemClock.h>
+
+#include <app_priv.h>
+#include "app_power.h"
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+using chip::app::DataModel::Nullable;
+
+static const char *TAG = "app_power";
+
+// Sampling state: timer task only
+static app_power_engine_t s_engine;
+static app_power_sim_t s_sim;
+static const app_power_source_t *s_source = NULL;
+static uint32_t s_read_errors = 0;
+
+// Published values and counters, shared with the Matter thread and the shell
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_power_stats_t s_stats = {};
+static uint32_t s_pending_reports = 0;      // APP_POWER_REPORT_* not yet handed to the Matter thread
+
+static uint16_t s_endpoint_id = 0;
+static bool s_started = false;
+static bool s_energy_access_ready = false; // AAI registered: a retried init must not register it again
+static uint64_t s_energy_start_ms = 0;     // Matter thread: start of the cumulative energy period
+
+static StaticTimer_t s_sample_timer_buf;
+static TimerHandle_t s_sample_timer = NULL;
+
+static esp_err_t sim_read(void *ctx, app_power_sample_t *out)
+{
+    app_power_sim_read(static_cast<app_power_sim_t *>(ctx), app_get_current_power_state(), out);
+    return ESP_OK;
+}
+
+static const app_power_source_t s_sim_source = {
+    .name = "simulated",
+    .read = sim_read,
+    .ctx = &s_sim,
+};
+
+static Nullable<int64_t> published(int32_t app_power_stats_t::*field)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t value = s_stats.*field;
+    uint32_t samples = s_stats.samples;
+    portEXIT_CRITICAL(&s_lock);
+    return samples ? Nullable<int64_t>(value) : Nullable<int64_t>();
+}
+
+namespace {
+
+using namespace ElectricalPowerMeasurement;
+
+const Structs::MeasurementAccuracyRangeStruct::Type kVoltageAccuracy[] = {
+    {.rangeMin = 0, .rangeMax = 300000, .percentMax = chip::MakeOptional(static_cast<chip::Percent100ths>(100))},
+};
+const Structs::MeasurementAccuracyRangeStruct::Type kCurrentAccuracy[] = {
+    {.rangeMin = 0, .rangeMax = 16000, .percentMax = chip::MakeOptional(static_cast<chip::Percent100ths>(100))},
+};
+const Structs::MeasurementAccuracyRangeStruct::Type kPowerAccuracy[] = {
+    {.rangeMin = 0, .rangeMax = 3680000, .percentMax = chip::MakeOptional(static_cast<chip::Percent100ths>(200))},
+};
+
+using AccuracyRanges = chip::app::DataModel::List<const Structs::MeasurementAccuracyRangeStruct::Type>;
+
+const Structs::MeasurementAccuracyStruct::Type kAccuracy[] = {
+    {.measurementType = MeasurementTypeEnum::kVoltage, .measured = true, .minMeasuredValue = 0,
+     .maxMeasuredValue = 300000, .accuracyRanges = AccuracyRanges(kVoltageAccuracy)},
+    {.measurementType = MeasurementTypeEnum::kActiveCurrent, .measured = true, .minMeasuredValue = 0,
+     .maxMeasuredValue = 16000, .accuracyRanges = AccuracyRanges(kCurrentAccuracy)},
+    {.measurementType = MeasurementTypeEnum::kActivePower, .measured = true, .minMeasuredValue = 0,
+     .maxMeasuredValue = 3680000, .accuracyRanges = AccuracyRanges(kPowerAccuracy)},
+};
+
+class PowerDelegate : public Delegate {
+public:
+    PowerModeEnum GetPowerMode() override { return PowerModeEnum::kAc; }
+    uint8_t GetNumberOfMeasurementTypes() override { return sizeof(kAccuracy) / sizeof(kAccuracy[0]); }
+
+    CHIP_ERROR StartAccuracyRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR GetAccuracyByIndex(uint8_t index, Structs::MeasurementAccuracyStruct::Type &accuracy) override
+    {
+        if (index >= GetNumberOfMeasurementTypes()) {
+            return CHIP_ERROR_PROVIDER_LIST_EXHAUSTED;
+        }
+        accuracy = kAccuracy[index];
+        return CHIP_NO_ERROR;
+    }
+    CHIP_ERROR EndAccuracyRead() override { return CHIP_NO_ERROR; }
+
+    // No ranges or harmonics: empty lists
+    CHIP_ERROR StartRangesRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR GetRangeByIndex(uint8_t, Structs::MeasurementRangeStruct::Type &) override
+    {
+        return CHIP_ERROR_PROVIDER_LIST_EXHAUSTED;
+    }
+    CHIP_ERROR EndRangesRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR StartHarmonicCurrentsRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR GetHarmonicCurrentsByIndex(uint8_t, Structs::HarmonicMeasurementStruct::Type &) override
+    {
+        return CHIP_ERROR_PROVIDER_LIST_EXHAUSTED;
+    }
+    CHIP_ERROR EndHarmonicCurrentsRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR StartHarmonicPhasesRead() override { return CHIP_NO_ERROR; }
+    CHIP_ERROR GetHarmonicPhasesByIndex(uint8_t, Structs::HarmonicMeasurementStruct::Type &) override
+    {
+        return CHIP_ERROR_PROVIDER_LIST_EXHAUSTED;
+    }
+    CHIP_ERROR EndHarmonicPhasesRead() override { return CHIP_NO_ERROR; }
+
+    Nullable<int64_t> GetVoltage() override { return published(&app_power_stats_t::voltage_mv); }
+    Nullable<int64_t> GetActiveCurrent() override { return published(&app_power_stats_t::current_ma); }
+    Nullable<int64_t> GetActivePower() override { return published(&app_power_stats_t::power_mw); }
+    Nullable<int64_t> GetReactiveCurrent() override { return {}; }
+    Nullable<int64_t> GetApparentCurrent() override { return {}; }
+    Nullable<int64_t> GetReactivePower() override { return {}; }
+    Nullable<int64_t> GetApparentPower() override { return {}; }
+    Nullable<int64_t> GetRMSVoltage() override { return {}; }
+    Nullable<int64_t> GetRMSCurrent() override { return {}; }
+    Nullable<int64_t> GetRMSPower() override { return {}; }
+    Nullable<int64_t> GetFrequency() override { return {}; }
+    Nullable<int64_t> GetPowerFactor() override { return {}; }
+    Nullable<int64_t> GetNeutralCurrent() override { return {}; }
+};
+
+} // namespace
+
+static PowerDelegate s_delegate;
+
+static const ElectricalEnergyMeasurement::Structs::MeasurementAccuracyRangeStruct::Type kEnergyAccuracy[] = {
+    {.rangeMin = 0, .rangeMax = 1000000000000LL, .percentMax = chip::MakeOptional(static_cast<chip::Percent100ths>(200))},
+};
+
+static ElectricalEnergyMeasurement::ElectricalEnergyMeasurementAttrAccess s_energy_access(
+    chip::BitMask<ElectricalEnergyMeasurement::Feature>(ElectricalEnergyMeasurement::Feature::kImportedEnergy,
+                                                        ElectricalEnergyMeasurement::Feature::kCumulativeEnergy),
+    chip::BitMask<ElectricalEnergyMeasurement::OptionalAttributes>());
+
+// Matter thread: turn engine decisions into reports
+static void report_work(intptr_t arg)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t report = s_pending_reports;
+    s_pending_reports = 0;
+    uint32_t energy_mwh = s_stats.energy_mwh;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (report & APP_POWER_REPORT_VOLTAGE) {
+        MatterReportingAttributeChangeCallback(s_endpoint_id, ElectricalPowerMeasurement::Id,
+                                               ElectricalPowerMeasurement::Attributes::Voltage::Id);
+    }
+    if (report & APP_POWER_REPORT_CURRENT) {
+        MatterReportingAttributeChangeCallback(s_endpoint_id, ElectricalPowerMeasurement::Id,
+                                               ElectricalPowerMeasurement::Attributes::ActiveCurrent::Id);
+    }
+    if (report & APP_POWER_REPORT_POWER) {
+        MatterReportingAttributeChangeCallback(s_endpoint_id, ElectricalPowerMeasurement::Id,
+                                               ElectricalPowerMeasurement::Attributes::ActivePower::Id);
+    }
+    if (report & APP_POWER_REPORT_ENERGY) {
+        uint64_t now_ms = chip::System::SystemClock().GetMonotonicMilliseconds64().count();
+        if (!s_energy_start_ms) {
+            s_energy_start_ms = now_ms;
+        }
+        ElectricalEnergyMeasurement::Structs::EnergyMeasurementStruct::Type imported;
+        imported.energy = energy_mwh;
+        imported.startSystime.SetValue(s_energy_start_ms);
+        imported.endSystime.SetValue(now_ms);
+        ElectricalEnergyMeasurement::NotifyCumulativeEnergyMeasured(s_endpoint_id, chip::MakeOptional(imported),
+                                                                    chip::NullOptional);
+    }
+}
+
+static void sample_timer_cb(TimerHandle_t timer)
+{
+    app_power_sample_t sample;
+    if (s_source->read(s_source->ctx, &sample) != ESP_OK) {
+        s_read_errors++;
+        return;
+    }
+
+    uint32_t report = app_power_engine_feed(&s_engine, esp_timer_get_time(), &sample);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.samples = s_engine.samples;
+    s_stats.reports = s_engine.reports;
+    s_stats.suppressed = s_engine.samples - s_engine.reports;
+    s_stats.attributes = s_engine.attributes;
+    s_stats.energy_reports = s_engine.energy_reports;
+    s_stats.read_errors = s_read_errors;
+    s_stats.voltage_mv = app_power_engine_published(&s_engine, APP_POWER_VOLTAGE);
+    s_stats.current_ma = app_power_engine_published(&s_engine, APP_POWER_CURRENT);
+    s_stats.power_mw = app_power_engine_published(&s_engine, APP_POWER_POWER);
+    s_stats.energy_mwh = s_engine.published_energy_mwh;
+    bool post = report && !s_pending_reports;
+    s_pending_reports |= report;
+    portEXIT_CRITICAL(&s_lock);
+
+    // One outstanding work item at most; later reports merge into it
+    if (post) {
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(report_work, 0);
+    }
+}
+
+esp_err_t app_power_create_clusters(endpoint_t *endpoint)
+{
+    s_endpoint_id = endpoint::get_id(endpoint);
+
+    cluster::electrical_power_measurement::config_t power_config;
+    power_config.delegate = &s_delegate;
+    cluster_t *power = cluster::electrical_power_measurement::create(
+        endpoint, &power_config, CLUSTER_FLAG_SERVER,
+        cluster::electrical_power_measurement::feature::alternating_current::get_id());
+    if (!power) {
+        ESP_LOGE(TAG, "Failed to create Electrical Power Measurement cluster");
+        return ESP_FAIL;
+    }
+    cluster::electrical_power_measurement::attribute::create_voltage(power, nullable<int64_t>());
+    cluster::electrical_power_measurement::attribute::create_active_current(power, nullable<int64_t>());
+
+    cluster::electrical_energy_measurement::config_t energy_config;
+    cluster_t *energy = cluster::electrical_energy_measurement::create(
+        endpoint, &energy_config, CLUSTER_FLAG_SERVER,
+        cluster::electrical_energy_measurement::feature::imported_energy::get_id() |
+        cluster::electrical_energy_measurement::feature::cumulative_energy::get_id());
+    if (!energy) {
+        ESP_LOGE(TAG, "Failed to create Electrical Energy Measurement cluster");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void app_power_set_source(const app_power_source_t *source)
+{
+    s_source = source ? source : &s_sim_source;
+}
+
+esp_err_t app_power_init(void)
+{
+    if (s_started) {
+        return ESP_OK;
+    }
+
+    if (!s_energy_access_ready) {
+        CHIP_ERROR err = s_energy_access.Init();
+        if (err != CHIP_NO_ERROR) {
+            ESP_LOGE(TAG, "Energy measurement init failed: %" CHIP_ERROR_FORMAT, err.Format());
+            return ESP_FAIL;
+        }
+        s_energy_access_ready = true;
+    }
+    ElectricalEnergyMeasurement::Structs::MeasurementAccuracyStruct::Type accuracy;
+    accuracy.measurementType = ElectricalEnergyMeasurement::MeasurementTypeEnum::kElectricalEnergy;
+    accuracy.measured = true;
+    accuracy.minMeasuredValue = 0;
+    accuracy.maxMeasuredValue = kEnergyAccuracy[0].rangeMax;
+    accuracy.accuracyRanges = chip::app::DataModel::List<
+        const ElectricalEnergyMeasurement::Structs::MeasurementAccuracyRangeStruct::Type>(kEnergyAccuracy);
+    ElectricalEnergyMeasurement::SetMeasurementAccuracy(s_endpoint_id, accuracy);
+
+    if (!s_source) {
+        app_power_sim_init(&s_sim, CONFIG_APP_POWER_SIM_SEED);
+        s_source = &s_sim_source;
+    }
+
+    app_power_thresholds_t thresholds = {
+        .delta = {CONFIG_APP_POWER_DELTA_MV, CONFIG_APP_POWER_DELTA_MA, CONFIG_APP_POWER_DELTA_MW},
+        .energy_delta_mwh = CONFIG_APP_POWER_DELTA_MWH,
+        .min_interval_us = static_cast<int64_t>(CONFIG_APP_POWER_MIN_INTERVAL_S) * 1000000,
+        .max_interval_us = static_cast<int64_t>(CONFIG_APP_POWER_MAX_INTERVAL_S) * 1000000,
+    };
+    app_power_engine_init(&s_engine, &thresholds, esp_timer_get_time());
+
+    if (!s_sample_timer) {
+        s_sample_timer = xTimerCreateStatic("power", pdMS_TO_TICKS(CONFIG_APP_POWER_SAMPLE_MS), pdTRUE, NULL,
+                                            sample_timer_cb, &s_sample_timer_buf);
+    }
+    if (!s_sample_timer || xTimerStart(s_sample_timer, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start power sampling");
+        return ESP_FAIL;
+    }
+    s_started = true;
+
+    ESP_LOGI(TAG, "Power measurement: %s source, %d ms samples, deltas %d mV/%d mA/%d mW/%d mWh, interval %d-%d s",
+             s_source->name, CONFIG_APP_POWER_SAMPLE_MS, CONFIG_APP_POWER_DELTA_MV, CONFIG_APP_POWER_DELTA_MA,
+             CONFIG_APP_POWER_DELTA_MW, CONFIG_APP_POWER_DELTA_MWH, CONFIG_APP_POWER_MIN_INTERVAL_S,
+             CONFIG_APP_POWER_MAX_INTERVAL_S);
+    return ESP_OK;
+}
+
+void app_power_get_stats(app_power_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t power_stats_handler(int argc, char **argv)
+{
+    app_power_stats_t st;
+    app_power_get_stats(&st);
+    printf("{\"source\":\"%s\",\"samples\":%" PRIu32 ",\"reports\":%" PRIu32 ",\"suppressed\":%" PRIu32
+           ",\"attributes\":%" PRIu32 ",\"energy_reports\":%" PRIu32 ",\"read_errors\":%" PRIu32
+           ",\"voltage_mv\":%" PRId32 ",\"current_ma\":%" PRId32 ",\"power_mw\":%" PRId32 ",\"energy_mwh\":%" PRIu32
+           "}\n",
+           s_source ? s_source->name : "none", st.samples, st.reports, st.suppressed, st.attributes,
+           st.energy_reports, st.read_errors, st.voltage_mv, st.current_ma, st.power_mw, st.energy_mwh);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_power_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "power-stats",
+        .description = "Print power sampling and report suppression statistics as JSON",
+        .handler = power_stats_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
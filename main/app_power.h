@@ -0,0 +1,78 @@
+/*
+   M5NanoC6 Matter Switch - Power/Energy Measurement Header
+
+   Electrical Power Measurement (voltage, active current, active power) and
+   Electrical Energy Measurement (cumulative imported energy) on the plug
+   endpoint. Samples come from a pluggable source; the default is the
+   deterministic simulator from app_power_engine.h. Reports are suppressed
+   until the thresholds in menuconfig ("M5NanoC6 Switch") are crossed.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_matter.h>
+
+#include "app_power_engine.h"
+
+/** Sample source: read() is called from the FreeRTOS timer task once per sample period */
+typedef struct {
+    const char *name;
+    esp_err_t (*read)(void *ctx, app_power_sample_t *out);
+    void *ctx;
+} app_power_source_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t reports;               // Samples that triggered a report
+    uint32_t suppressed;            // Samples that did not
+    uint32_t attributes;            // Attribute changes reported
+    uint32_t energy_reports;        // CumulativeEnergyMeasured events
+    uint32_t read_errors;
+    int32_t voltage_mv;             // Published values
+    int32_t current_ma;
+    int32_t power_mw;
+    uint32_t energy_mwh;
+} app_power_stats_t;
+
+/**
+ * @brief Add Electrical Power/Energy Measurement clusters to the plug endpoint
+ *
+ * Call before esp_matter::start().
+ *
+ * @param endpoint Plug endpoint
+ * @return ESP_OK on success
+ */
+esp_err_t app_power_create_clusters(esp_matter::endpoint_t *endpoint);
+
+/**
+ * @brief Replace the sample source
+ *
+ * @param source Source (must stay valid), NULL for the simulator
+ */
+void app_power_set_source(const app_power_source_t *source);
+
+/**
+ * @brief Start sampling
+ *
+ * Must run on the Matter thread after the server is initialized
+ * (kServerReady).
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_power_init(void);
+
+/**
+ * @brief Copy current sampling/report statistics
+ *
+ * @param[out] out Statistics snapshot
+ */
+void app_power_get_stats(app_power_stats_t *out);
+
+/**
+ * @brief Register "power-stats" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_power_register_commands(void);
@@ -0,0 +1,141 @@
+/*
+   M5NanoC6 Matter Switch - Power Measurement Engine
+
+   No ESP-IDF dependencies: see app_power_engine.h.
+*/
+
+#include "app_power_engine.h"
+
+#define MWMS_PER_MWH    3600000ULL      // mW*ms in one mWh
+
+static int64_t abs64(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+void app_power_engine_init(app_power_engine_t *engine, const app_power_thresholds_t *thresholds, int64_t now_us)
+{
+    *engine = {};
+    engine->thresholds = *thresholds;
+    engine->measurement_at_us = now_us;
+    engine->energy_at_us = now_us;
+    engine->last_sample_us = now_us;
+}
+
+uint32_t app_power_engine_feed(app_power_engine_t *engine, int64_t now_us, const app_power_sample_t *sample)
+{
+    const app_power_thresholds_t *t = &engine->thresholds;
+    const int64_t values[APP_POWER_MEASUREMENTS] = {sample->voltage_mv, sample->current_ma, sample->power_mw};
+    uint32_t report = 0;
+
+    engine->samples++;
+
+    // Integrate imported energy over the time since the previous sample
+    int64_t dt_ms = (now_us - engine->last_sample_us) / 1000;
+    engine->last_sample_us = now_us;
+    if (engine->primed && sample->power_mw > 0 && dt_ms > 0) {
+        engine->energy_rem_mwms += static_cast<uint64_t>(sample->power_mw) * static_cast<uint64_t>(dt_ms);
+        engine->energy_mwh += engine->energy_rem_mwms / MWMS_PER_MWH;
+        engine->energy_rem_mwms %= MWMS_PER_MWH;
+    }
+
+    if (!engine->primed) {
+        for (int i = 0; i < APP_POWER_MEASUREMENTS; i++) {
+            engine->filtered[i] = values[i] * (1 << APP_POWER_FRAC_BITS);
+            engine->published[i] = values[i];
+        }
+        engine->primed = true;
+        engine->measurement_at_us = now_us;
+        engine->energy_at_us = now_us;
+        engine->reports++;
+        engine->attributes += 4;
+        engine->energy_reports++;
+        return APP_POWER_REPORT_MEASUREMENTS | APP_POWER_REPORT_ENERGY;
+    }
+
+    for (int i = 0; i < APP_POWER_MEASUREMENTS; i++) {
+        engine->filtered[i] += ((values[i] * (1 << APP_POWER_FRAC_BITS)) - engine->filtered[i]) >> APP_POWER_FILTER_SHIFT;
+    }
+
+    // Measurements: delta crossed, or stale and changed at all
+    int64_t since = now_us - engine->measurement_at_us;
+    if (since >= t->min_interval_us) {
+        bool stale = since >= t->max_interval_us;
+        for (int i = 0; i < APP_POWER_MEASUREMENTS; i++) {
+            // Round to nearest milli-unit
+            int64_t value = (engine->filtered[i] + (1 << (APP_POWER_FRAC_BITS - 1))) >> APP_POWER_FRAC_BITS;
+            int64_t moved = abs64(value - engine->published[i]);
+            if (moved >= t->delta[i] || (stale && moved > 0)) {
+                engine->published[i] = value;
+                report |= (1U << i);
+            }
+        }
+        if (report || stale) {
+            engine->measurement_at_us = now_us;
+        }
+    }
+
+    // Energy: enough accumulated, or stale and increased at all
+    since = now_us - engine->energy_at_us;
+    if (since >= t->min_interval_us) {
+        uint64_t accumulated = engine->energy_mwh - engine->published_energy_mwh;
+        bool stale = since >= t->max_interval_us;
+        if (accumulated >= static_cast<uint64_t>(t->energy_delta_mwh) || (stale && accumulated > 0)) {
+            engine->published_energy_mwh = engine->energy_mwh;
+            engine->energy_reports++;
+            report |= APP_POWER_REPORT_ENERGY;
+        }
+        if (report & APP_POWER_REPORT_ENERGY || stale) {
+            engine->energy_at_us = now_us;
+        }
+    }
+
+    if (report) {
+        engine->reports++;
+        for (uint32_t bits = report; bits; bits &= bits - 1) {
+            engine->attributes++;
+        }
+    }
+    return report;
+}
+
+int64_t app_power_engine_published(const app_power_engine_t *engine, int index)
+{
+    return engine->published[index];
+}
+
+void app_power_sim_init(app_power_sim_t *sim, uint32_t seed)
+{
+    sim->seed = seed;
+    sim->n = 0;
+}
+
+// Uniform integer in [-amplitude, amplitude]
+static int32_t sim_noise(app_power_sim_t *sim, int32_t amplitude)
+{
+    sim->seed = sim->seed * 1664525U + 1013904223U;
+    return static_cast<int32_t>((sim->seed >> 8) % (2U * amplitude + 1U)) - amplitude;
+}
+
+void app_power_sim_read(app_power_sim_t *sim, bool on, app_power_sample_t *out)
+{
+    uint32_t n = sim->n++;
+
+    // 230 V mains with a +-2 V triangle wander over 600 samples and 0.1% noise
+    int32_t phase = static_cast<int32_t>(n % 600);
+    int32_t wander = (phase < 300 ? phase : 600 - phase) * 4000 / 300 - 2000;
+    int64_t voltage_mv = 230000 + wander + sim_noise(sim, 230);
+
+    // Standby draw when off; when on a 60 W load that steps to 95 W for a third of every 900 samples
+    int64_t power_mw;
+    if (on) {
+        int32_t base = (n % 900) >= 600 ? 95000 : 60000;
+        power_mw = base + sim_noise(sim, base / 100);
+    } else {
+        power_mw = 350 + sim_noise(sim, 20);
+    }
+
+    out->voltage_mv = voltage_mv;
+    out->power_mw = power_mw;
+    out->current_ma = power_mw * 1000 / voltage_mv;
+}
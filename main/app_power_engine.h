@@ -0,0 +1,125 @@
+/*
+   M5NanoC6 Matter Switch - Power Measurement Engine
+
+   Hardware-independent aggregation and report suppression for the
+   Electrical Power/Energy Measurement clusters. The driver feeds one
+   sample per period; the engine smooths voltage/current/power, integrates
+   energy and returns which attributes are worth reporting. Everything is
+   integer (milli-units as used by the clusters, 8 fractional bits in the
+   filters), so the same trace gives the same reports on the device and
+   in scripts/power_replay.py, which builds this file for the host.
+
+   A measurement is published when it moved by at least its delta since the
+   last published value, or when max_interval has passed and it moved at
+   all. Nothing is published within min_interval of the previous report.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Report bits returned by app_power_engine_feed()
+#define APP_POWER_REPORT_VOLTAGE        (1U << 0)
+#define APP_POWER_REPORT_CURRENT        (1U << 1)
+#define APP_POWER_REPORT_POWER          (1U << 2)
+#define APP_POWER_REPORT_ENERGY         (1U << 3)
+#define APP_POWER_REPORT_MEASUREMENTS   (APP_POWER_REPORT_VOLTAGE | APP_POWER_REPORT_CURRENT | APP_POWER_REPORT_POWER)
+
+#define APP_POWER_FILTER_SHIFT          2       // Exponential filter weight 1/4 per sample
+#define APP_POWER_FRAC_BITS             8       // Fractional bits of the filter accumulators
+
+enum {
+    APP_POWER_VOLTAGE,
+    APP_POWER_CURRENT,
+    APP_POWER_POWER,
+    APP_POWER_MEASUREMENTS,
+};
+
+typedef struct {
+    int64_t voltage_mv;
+    int64_t current_ma;
+    int64_t power_mw;
+} app_power_sample_t;
+
+typedef struct {
+    int64_t delta[APP_POWER_MEASUREMENTS];  // mV, mA, mW
+    int64_t energy_delta_mwh;
+    int64_t min_interval_us;
+    int64_t max_interval_us;
+} app_power_thresholds_t;
+
+typedef struct {
+    app_power_thresholds_t thresholds;
+    int64_t filtered[APP_POWER_MEASUREMENTS];   // Q(APP_POWER_FRAC_BITS)
+    int64_t published[APP_POWER_MEASUREMENTS];
+    int64_t measurement_at_us;      // Last measurement report
+    int64_t energy_at_us;           // Last energy report
+    int64_t last_sample_us;
+    uint64_t energy_mwh;            // Imported energy since boot
+    uint64_t energy_rem_mwms;       // Remainder below 1 mWh, in mW*ms
+    uint64_t published_energy_mwh;
+    uint32_t samples;
+    uint32_t reports;               // Samples that marked at least one attribute
+    uint32_t attributes;            // Attribute changes marked for reporting
+    uint32_t energy_reports;
+    bool primed;
+} app_power_engine_t;
+
+// Deterministic load for testing: mains wander, on/off load with a duty cycle, LCG noise
+typedef struct {
+    uint32_t seed;
+    uint32_t n;
+} app_power_sim_t;
+
+/**
+ * @brief Initialize engine state
+ *
+ * @param engine Engine instance
+ * @param thresholds Report thresholds (copied)
+ * @param now_us Current time
+ */
+void app_power_engine_init(app_power_engine_t *engine, const app_power_thresholds_t *thresholds, int64_t now_us);
+
+/**
+ * @brief Feed one sample
+ *
+ * Timestamps must not go backwards. The first sample is always reported.
+ *
+ * @return Bitmask of APP_POWER_REPORT_* to report for this sample
+ */
+uint32_t app_power_engine_feed(app_power_engine_t *engine, int64_t now_us, const app_power_sample_t *sample);
+
+/**
+ * @brief Published value of a measurement
+ *
+ * @param engine Engine instance
+ * @param index APP_POWER_VOLTAGE, APP_POWER_CURRENT or APP_POWER_POWER
+ * @return Value in mV, mA or mW
+ */
+int64_t app_power_engine_published(const app_power_engine_t *engine, int index);
+
+/**
+ * @brief Initialize the simulated source
+ *
+ * @param sim Simulator instance
+ * @param seed Noise seed; same seed gives the same sample sequence
+ */
+void app_power_sim_init(app_power_sim_t *sim, uint32_t seed);
+
+/**
+ * @brief Produce the next simulated sample
+ *
+ * @param sim Simulator instance
+ * @param on Plug relay state
+ * @param[out] out Sample
+ */
+void app_power_sim_read(app_power_sim_t *sim, bool on, app_power_sample_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,9 +17,18 @@
 #define M5NANOC6_BUTTON_GPIO        9
 #define M5NANOC6_LED_DATA_GPIO      20
 #define M5NANOC6_LED_POWER_GPIO     19
-#define M5NANOC6_RMT_CHANNEL        0
 
-// LED Color Configuration (GRB order for WS2812)
+// Button timing (app_button_engine; debounce and long press: appcfg)
+#define BUTTON_DEBOUNCE_MS          20      // Lockout after an accepted edge
+#define BUTTON_LONG_PRESS_MS        1500    // Hold time that starts the factory reset sequence
+#define BUTTON_EDGE_QUEUE_LEN       16      // Edges buffered between ISR and button task
+#define BUTTON_TASK_STACK_SIZE      4096    // Statically allocated, bytes; callbacks run here
+#define BUTTON_TASK_PRIORITY        6
+
+// Colors and timings below marked (appcfg) are compiled defaults: a blob in the
+// appcfg partition replaces them at boot (app_config.h, scripts/app_config_tool.py)
+
+// LED Color Configuration (appcfg; per channel, app_ws2812 sends them in WS2812 GRB wire order)
 // Format: LED_COLOR_<STATE>_<CHANNEL> where channel is G, R, or B
 #define LED_COLOR_ON_G              0
 #define LED_COLOR_ON_R              0
@@ -39,7 +48,7 @@
 #define LED_COLOR_RESET_R_MAX       255     // Red final intensity
 #define LED_COLOR_RESET_B           0
 
-// LED Timing Configuration
+// LED Timing Configuration (appcfg, except LED_RESET_UPDATE_MS)
 #define LED_IDENTIFY_BLINK_MS       500
 #define LED_REFRESH_TIMEOUT_MS      100
 #define LED_RESET_UPDATE_MS         100     // Reset countdown LED update rate
@@ -48,18 +57,34 @@
 #define LED_RESET_BLINK_START_MS    1000    // Initial blink period at 0% progress
 #define LED_RESET_BLINK_END_MS      200     // Final blink period at 100% progress
 
-// Firmware Config ID Display Configuration
+// Firmware Config ID Display Configuration (appcfg)
 #define FIRMWARE_CONFIG_ID_BITS             4       // Number of bits to display
 #define FIRMWARE_CONFIG_ID_BIT_DELAY_MS     500     // Delay showing each bit
 #define FIRMWARE_CONFIG_ID_PATTERN_DELAY_MS 1500    // Delay between pattern repetitions
 #define FIRMWARE_CONFIG_ID_REPEAT_COUNT     5       // Number of times to repeat pattern
 #define FIRMWARE_CONFIG_ID_START_DELAY_MS   1000    // Delay before binary display starts
+#define RESET_TASK_STACK_SIZE               4096    // Statically allocated, bytes
+#define RESET_TASK_PRIORITY                 5
 
 // Identify pattern configuration (repeats config ID binary pattern)
 #define IDENTIFY_CONFIG_ID_REPEAT_COUNT     2       // Repeat pattern twice for identify
+#define IDENTIFY_TASK_STACK_SIZE            4096    // Statically allocated, bytes
+#define IDENTIFY_TASK_PRIORITY              5
+
+// Status bar (CONFIG_APP_LED_BAR_PIXELS): repaints it off the Matter thread and the timer task
+#define BAR_TASK_STACK_SIZE                 2048    // Statically allocated, bytes
+#define BAR_TASK_PRIORITY                   3
+
+// Event log writer (app_evlog): appends sealed record buffers to flash
+#define EVLOG_TASK_STACK_SIZE               3072    // Statically allocated, bytes
+#define EVLOG_TASK_PRIORITY                 2       // Below everything that logs
+
+// Deferred log writer (app_log): formats APP_LOGx records off the calling tasks
+#define LOG_TASK_STACK_SIZE                 3072    // Statically allocated, bytes
+#define LOG_TASK_PRIORITY                   1       // Just above idle
 
-// LED Colors for binary code display
-// Protocol-dependent: Thread vs WiFi
+// LED Colors for binary code display (appcfg)
+// Protocol-dependent default: Thread vs WiFi
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
     // Thread: White=1, Red=0
     #define LED_COLOR_BIT_1_G   LED_COLOR_IDENTIFY_G
@@ -78,7 +103,7 @@
     #define LED_COLOR_BIT_0_B   128
 #endif
 
-// LED Colors for reset result indicators
+// LED Colors for reset result indicators (appcfg)
 // Green = reset cancelled (button released)
 #define LED_COLOR_CANCEL_R      0
 #define LED_COLOR_CANCEL_G      128
@@ -92,6 +117,12 @@
 // Duration to show result indicator
 #define FIRMWARE_CONFIG_ID_RESULT_MS    3000
 
+// LED Colors for OTA download overlay (appcfg; cyan, brightens with progress)
+#define LED_COLOR_OTA_R         0
+#define LED_COLOR_OTA_GB_MIN    20      // Green/blue intensity at 0%
+#define LED_COLOR_OTA_GB_MAX    128     // Green/blue intensity at 100%
+#define LED_OTA_BLINK_MS        250     // Overlay alternates with on/off color
+
 typedef void *app_driver_handle_t;
 
 /** Initialize the WS2812 LED indicator
@@ -104,7 +135,7 @@ app_driver_handle_t app_driver_led_init(void);
 
 /** Initialize the button driver
  *
- * Initializes the button on GPIO 9.
+ * Initializes the edge-interrupt button on GPIO 9 (see app_button.h).
  *
  * @return Handle on success, NULL on failure.
  */
@@ -122,47 +153,55 @@ app_driver_handle_t app_driver_button_init(void);
  */
 esp_err_t app_driver_led_set_power(app_driver_handle_t handle, bool power);
 
-/** Handle attribute updates from Matter stack
+/** Start LED identify pattern
+ *
+ * Displays firmware config ID as binary pattern to identify the device.
+ *
+ * @return ESP_OK on success.
+ */
+esp_err_t app_driver_led_identify_start(void);
+
+/** Stop LED identify pattern
  *
- * Called when OnOff cluster attribute changes.
+ * Stops the pattern (within one bit period) and restores normal LED state.
  *
- * @param[in] driver_handle LED driver handle.
- * @param[in] endpoint_id Endpoint ID.
- * @param[in] cluster_id Cluster ID.
- * @param[in] attribute_id Attribute ID.
- * @param[in] val Attribute value.
+ * @param[in] current_power Current on/off state to restore.
  *
  * @return ESP_OK on success.
  */
-esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
-                                      uint32_t attribute_id, const esp_matter_attr_val_t *val);
+esp_err_t app_driver_led_identify_stop(bool current_power);
 
-/** Start LED identify pattern
+/** Start OTA progress LED overlay
  *
- * Displays firmware config ID as binary pattern to identify the device.
+ * Alternates the on/off color with cyan from a timer, without blocking the caller.
+ * The identify pattern takes precedence while it is running.
  *
  * @return ESP_OK on success.
  */
-esp_err_t app_driver_led_identify_start(void);
+esp_err_t app_driver_led_ota_start(void);
 
-/** Stop LED identify pattern
+/** Update OTA progress shown by the LED overlay
  *
- * Stops the pattern and restores normal LED state.
+ * @param[in] percent Download progress, 0-100.
+ */
+void app_driver_led_ota_progress(uint8_t percent);
+
+/** Stop OTA progress LED overlay
  *
  * @param[in] current_power Current on/off state to restore.
  *
  * @return ESP_OK on success.
  */
-esp_err_t app_driver_led_identify_stop(bool current_power);
+esp_err_t app_driver_led_ota_stop(bool current_power);
 
 /** Get LED strip handle for direct access
  *
  * Used by app_reset for LED control during factory reset countdown.
  * IMPORTANT: Caller must use app_driver_led_lock/unlock for thread safety.
  *
- * @return LED strip pointer, or NULL if not initialized.
+ * @return On-board one-pixel strip (app_ws2812.h), or NULL if not initialized.
  */
-struct led_strip_s *app_driver_get_led_strip(void);
+struct app_ws2812 *app_driver_get_led_strip(void);
 
 /** Lock LED strip for exclusive access
  *
@@ -179,6 +218,15 @@ bool app_driver_led_lock(void);
  */
 void app_driver_led_unlock(void);
 
+/** Register "led-stats" shell command
+ *
+ * Prints frames sent, partial frames, skipped refreshes and the duration of
+ * the last frame for the on-board LED and the status bar as JSON.
+ *
+ * @return ESP_OK on success.
+ */
+esp_err_t app_driver_register_commands(void);
+
 /** Display firmware config ID as binary pattern on LED
  *
  * Displays 4-bit config ID as white (1) and red (0) LEDs, MSB first.
@@ -190,7 +238,8 @@ void app_driver_display_config_id_pattern(int repeat_count);
 
 /** Get current on/off power state
  *
- * Reads the current OnOff attribute value from Matter data model.
+ * Wait-free read of the device state word (app_state.h), which mirrors the
+ * OnOff attribute of the switch endpoint. Safe from any task.
  *
  * @return true if on, false if off.
  */
@@ -198,3 +247,15 @@ void app_driver_display_config_id_pattern(int repeat_count);
 extern "C"
 #endif
 bool app_get_current_power_state(void);
+
+/** Seed the device state word from the data model and show it on the LED
+ *
+ * Call once after app_switch_init(), before Matter starts
+ * (implemented in app_platform_esp32.cpp).
+ *
+ * @param[in] endpoint_id Switch endpoint.
+ */
+#ifdef __cplusplus
+extern "C"
+#endif
+void app_platform_state_init(uint16_t endpoint_id);
@@ -5,50 +5,43 @@
    Runtime only - hold button for ~23 seconds while device is running.
 */
 
-#include <atomic>
-#include <driver/gpio.h>
 #include <esp_log.h>
 #include <esp_matter.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/timers.h>
-#include <iot_button.h>
-#include <led_strip.h>
 
+#include "app_button.h"
+#include "app_config.h"
+#include "app_evlog.h"
+#include "app_log.h"
 #include "app_priv.h"
+#include "app_scenes.h"
+#include "app_state.h"
+#include "app_ws2812.h"
 #include "include/CHIPPairingConfig.h"
 
 static const char *TAG = "app_reset";
 
-// Reset state machine
-enum class ResetState : uint8_t {
-    IDLE,
-    COUNTDOWN,      // Displaying binary code and performing reset
-};
+// Reset phase lives in the device state word (APP_STATE_RESET_MASK)
+static void *s_button_handle = NULL;
 
-static TimerHandle_t s_reset_timer = NULL;
-static std::atomic<ResetState> s_reset_state{ResetState::IDLE};
-
-// Check if button is currently pressed (GPIO low = pressed, active low with pull-up)
-static bool is_button_pressed(void)
-{
-    return gpio_get_level(static_cast<gpio_num_t>(M5NANOC6_BUTTON_GPIO)) == 0;
-}
+// Reset sequence runs in its own task so the button task keeps delivering
+// press-up events (and debounced state) while the sequence blocks
+static TaskHandle_t s_reset_task = NULL;
+static StaticTask_t s_reset_task_buf;
+static StackType_t s_reset_task_stack[RESET_TASK_STACK_SIZE];
 
 // Show result indicator (green = cancelled, red = confirmed)
 static void show_result(bool will_reset)
 {
     if (!app_driver_led_lock()) return;
-    led_strip_t *strip = app_driver_get_led_strip();
+    app_ws2812_t *strip = app_driver_get_led_strip();
     if (strip) {
-        if (will_reset) {
-            // Red = confirming reset
-            strip->set_pixel(strip, 0, LED_COLOR_CONFIRM_R, LED_COLOR_CONFIRM_G, LED_COLOR_CONFIRM_B);
-        } else {
-            // Green = cancelled
-            strip->set_pixel(strip, 0, LED_COLOR_CANCEL_R, LED_COLOR_CANCEL_G, LED_COLOR_CANCEL_B);
-        }
-        strip->refresh(strip, LED_REFRESH_TIMEOUT_MS);
+        const app_config_t *config = app_config_get();
+        // Red = confirming reset, green = cancelled (defaults)
+        const app_config_color_t *color = will_reset ? &config->confirm : &config->cancel;
+        app_ws2812_set_pixel(strip, 0, color->r, color->g, color->b);
+        app_ws2812_refresh(strip, config->led_refresh_timeout_ms);
     }
     app_driver_led_unlock();
 }
@@ -60,7 +53,7 @@ static bool cancellable_delay(uint32_t delay_ms, uint32_t check_interval_ms = 50
     uint32_t elapsed = 0;
     while (elapsed < delay_ms) {
         // Check if button was released (state changed from COUNTDOWN)
-        if (s_reset_state.load() != ResetState::COUNTDOWN) {
+        if (app_state_reset_phase(app_state_get()) != APP_STATE_RESET_COUNTDOWN) {
             return false;  // Cancelled
         }
         uint32_t wait = (delay_ms - elapsed < check_interval_ms)
@@ -71,71 +64,80 @@ static bool cancellable_delay(uint32_t delay_ms, uint32_t check_interval_ms = 50
     return true;  // Completed
 }
 
-// Timer callback - no longer used, kept for compatibility
-static void reset_timer_cb(TimerHandle_t timer)
-{
-    // No-op - reset is now handled directly in button callback
-}
-
-static void button_long_press_start_cb(void *arg, void *data)
+static void reset_sequence(void)
 {
-    // Only start if idle (not already in countdown)
-    ResetState expected = ResetState::IDLE;
-    if (!s_reset_state.compare_exchange_strong(expected, ResetState::COUNTDOWN)) {
-        return;
-    }
-
     // Save current power state before starting reset sequence
-    bool saved_power_state = app_get_current_power_state();
+    bool saved_power_state = app_state_power(app_state_get());
+    const app_config_t *config = app_config_get();
 
-    ESP_LOGW(TAG, "Factory reset sequence starting in 1 second...");
+    ESP_LOGW(TAG, "Factory reset sequence starting in %u ms...", config->reset_start_delay_ms);
 
-    // Initial delay (1 second) - user can still release to cancel
-    if (!cancellable_delay(FIRMWARE_CONFIG_ID_START_DELAY_MS)) {
+    // Initial delay - user can still release to cancel
+    if (!cancellable_delay(config->reset_start_delay_ms)) {
         ESP_LOGI(TAG, "Factory reset cancelled during initial delay");
         app_driver_led_set_power(NULL, saved_power_state);
-        s_reset_state = ResetState::IDLE;
+        app_state_update(APP_STATE_RESET_MASK, app_state_reset_bits(APP_STATE_RESET_IDLE));
         return;
     }
 
     ESP_LOGW(TAG, "Displaying config ID...");
 
     // Display binary code sequence (non-cancellable - user can see pairing info)
-    app_driver_display_config_id_pattern(FIRMWARE_CONFIG_ID_REPEAT_COUNT);
+    app_driver_display_config_id_pattern(config->reset_repeat_count);
 
-    // Check if button is still held by reading GPIO directly
-    // (callback-based state won't work since we're blocking in the same task)
-    bool button_still_held = is_button_pressed();
+    // Debounced state from the button task (which is not blocked by this sequence)
+    bool button_still_held = app_button_is_pressed(s_button_handle);
 
     if (button_still_held) {
-        ESP_LOGW(TAG, "Button held - reset will proceed in 3 seconds");
+        ESP_LOGW(TAG, "Button held - reset will proceed in %u ms", config->reset_result_ms);
         show_result(true);  // Red
-        vTaskDelay(pdMS_TO_TICKS(FIRMWARE_CONFIG_ID_RESULT_MS));
+        vTaskDelay(pdMS_TO_TICKS(config->reset_result_ms));
 
         ESP_LOGW(TAG, "Performing factory reset");
-        s_reset_state = ResetState::IDLE;
+        app_state_update(APP_STATE_RESET_MASK, app_state_reset_bits(APP_STATE_RESET_CONFIRMED));
+        uint32_t kind = APP_EVLOG_RESET_FACTORY;
+        app_evlog_record(APP_EVLOG_RESET, &kind, 1);     // Flushed by the restart
+        app_scenes_discard();       // Otherwise the restart writes cached scenes back after the erase
         esp_matter::factory_reset();
     } else {
         ESP_LOGI(TAG, "Button released - reset cancelled");
         show_result(false);  // Green
-        vTaskDelay(pdMS_TO_TICKS(FIRMWARE_CONFIG_ID_RESULT_MS));
+        vTaskDelay(pdMS_TO_TICKS(config->reset_result_ms));
 
         // Restore LED to previous power state
         app_driver_led_set_power(NULL, saved_power_state);
-        s_reset_state = ResetState::IDLE;
+        app_state_update(APP_STATE_RESET_MASK, app_state_reset_bits(APP_STATE_RESET_IDLE));
+    }
+}
+
+static void reset_task(void *pvParameters)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        reset_sequence();
+    }
+}
+
+static void button_long_press_start_cb(void *arg, void *data)
+{
+    // Only start if idle (not already in countdown)
+    if (!app_state_transition(APP_STATE_RESET_MASK, app_state_reset_bits(APP_STATE_RESET_IDLE),
+                              app_state_reset_bits(APP_STATE_RESET_COUNTDOWN))) {
+        return;
     }
+    xTaskNotifyGive(s_reset_task);
 }
 
 static void button_released_cb(void *arg, void *data)
 {
     // Signal cancellation by changing state from COUNTDOWN to IDLE.
-    // The main callback (button_long_press_start_cb) handles LED restoration.
-    ResetState expected = ResetState::COUNTDOWN;
-    if (!s_reset_state.compare_exchange_strong(expected, ResetState::IDLE)) {
+    // reset_sequence() sees the change and handles LED restoration.
+    if (!app_state_transition(APP_STATE_RESET_MASK, app_state_reset_bits(APP_STATE_RESET_COUNTDOWN),
+                              app_state_reset_bits(APP_STATE_RESET_IDLE))) {
         return;
     }
 
-    ESP_LOGI(TAG, "Factory reset cancelled (button released)");
+    APP_LOGI(TAG, "Factory reset cancelled (button released)");
 }
 
 extern "C" esp_err_t app_reset_button_register(void *handle)
@@ -145,33 +147,25 @@ extern "C" esp_err_t app_reset_button_register(void *handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    auto button_handle = static_cast<button_handle_t>(handle);
     esp_err_t err;
 
-    // Pre-create reset timer to avoid allocation during operation
-    s_reset_timer = xTimerCreate("reset", pdMS_TO_TICKS(LED_RESET_UPDATE_MS), pdTRUE, NULL, reset_timer_cb);
-    if (!s_reset_timer) {
-        ESP_LOGE(TAG, "Failed to create reset timer");
-        return ESP_ERR_NO_MEM;
+    s_button_handle = handle;
+    if (!s_reset_task) {
+        s_reset_task = xTaskCreateStatic(reset_task, "reset", RESET_TASK_STACK_SIZE, NULL, RESET_TASK_PRIORITY,
+                                         s_reset_task_stack, &s_reset_task_buf);
     }
 
     // Long press start triggers countdown
-    err = iot_button_register_cb(button_handle, BUTTON_LONG_PRESS_START,
-                                  button_long_press_start_cb, NULL);
+    err = app_button_register_cb(handle, APP_BUTTON_EVENT_LONG_PRESS_START, button_long_press_start_cb, NULL);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register long press callback: %d", err);
-        xTimerDelete(s_reset_timer, 0);
-        s_reset_timer = NULL;
         return err;
     }
 
     // Release cancels if not complete
-    err = iot_button_register_cb(button_handle, BUTTON_PRESS_UP,
-                                  button_released_cb, NULL);
+    err = app_button_register_cb(handle, APP_BUTTON_EVENT_PRESS_UP, button_released_cb, NULL);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register press up callback: %d", err);
-        xTimerDelete(s_reset_timer, 0);
-        s_reset_timer = NULL;
         return err;
     }
 
@@ -18,7 +18,7 @@ extern "C" {
  * Registers long press (~23s hold) to trigger factory reset with
  * LED countdown indication.
  *
- * @param handle Button handle from app_driver_button_init()
+ * @param handle Button handle from app_driver_button_init() (app_button)
  * @return ESP_OK on success
  */
 esp_err_t app_reset_button_register(void *handle);
@@ -0,0 +1,424 @@
+/*
+   M5NanoC6 Matter Switch - Scene Table Cache
+
+   The Scenes Management server keeps its scene table (DefaultSceneTableImpl)
+   in the server's persistent storage, i.e. one NVS blob read per scene on
+   every RecallScene. Here the table is re-pointed at a PersistentStorageDelegate
+   that holds every scene key in a fixed array of slots:
+
+   - Reads are served from RAM (known-missing keys are cached too); the table
+     is preloaded at startup, so a recall is a memcpy and the OnOff value
+     reaches the LED through the normal attribute callback.
+   - Stores and deletes only touch RAM and arm a one-shot timer; the batch is
+     written to NVS SCENE_CACHE_FLUSH_MS later, and before a restart
+     (app_scenes_flush(), from the OTA path and the shutdown handler).
+   - A factory reset drops the dirty entries (app_scenes_discard()), and the
+     restart flush is skipped once the fabric index is gone from NVS, so the
+     erased storage does not get scenes written back into it.
+
+   The cache stores the scene table's own keys and TLV blobs. It is not a
+   compact OnOff/level table, because DefaultSceneTableImpl serializes the
+   entries itself, so any extension field set fits as long as it is at most
+   SCENE_CACHE_VALUE_MAX bytes. It holds one key per stored scene, one scene
+   list per fabric and the global scene count, and is sized for the most
+   the scene table can store (CHIP_CONFIG_MAX_SCENES_TABLE_SIZE scenes over
+   CHIP_CONFIG_MAX_FABRICS fabrics), so a full table is never evicted.
+   Round-robin eviction of clean slots only remains for more endpoints than
+   SCENE_CACHE_ENDPOINTS; recalling an evicted scene reads NVS again
+   (counted in "misses").
+
+   All accesses come from the Matter thread (scene commands and the flush
+   timer both run there), so the cache itself needs no locking. A restart
+   can be requested from any task, so the write-back before it is handed
+   to the Matter thread with ScheduleWork() and waited for.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <app/clusters/scenes-server/SceneTableImpl.h>
+#include <app/server/Server.h>
+#include <lib/core/CHIPPersistentStorageDelegate.h>
+#include <lib/support/DefaultStorageKeyAllocator.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include "app_scenes.h"
+
+using chip::PersistentStorageDelegate;
+
+static const char *TAG = "app_scenes";
+
+// Scene entries (all fabrics together are capped per endpoint), one scene list per fabric and
+// endpoint, and the global scene count
+#define SCENE_CACHE_SLOTS \
+    (SCENE_CACHE_ENDPOINTS * (chip::scenes::kMaxScenesPerEndpoint + CHIP_CONFIG_MAX_FABRICS) + 1)
+
+static_assert(chip::scenes::kMaxScenesPerFabric <= chip::scenes::kMaxScenesPerEndpoint,
+              "a fabric's scenes must fit in the per-endpoint scene slots");
+
+class SceneStorageCache : public PersistentStorageDelegate {
+public:
+    void Init(PersistentStorageDelegate *backing)
+    {
+        mBacking = backing;
+    }
+
+    CHIP_ERROR SyncGetKeyValue(const char *key, void *buffer, uint16_t &size) override
+    {
+        Slot *slot = Find(key);
+        if (slot) {
+            mStats.hits++;
+        } else {
+            mStats.misses++;
+            slot = Load(key);
+            if (!slot) {
+                // Too large (or unreadable) for a slot: read through
+                return mBacking->SyncGetKeyValue(key, buffer, size);
+            }
+        }
+
+        if (slot->state == SlotState::kAbsent) {
+            return CHIP_ERROR_PERSISTED_STORAGE_VALUE_NOT_FOUND;
+        }
+        if (size < slot->len) {
+            memcpy(buffer, slot->value, size);
+            return CHIP_ERROR_BUFFER_TOO_SMALL;
+        }
+        memcpy(buffer, slot->value, slot->len);
+        size = slot->len;
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR SyncSetKeyValue(const char *key, const void *value, uint16_t size) override
+    {
+        if (size > SCENE_CACHE_VALUE_MAX) {
+            ESP_LOGW(TAG, "Scene key %s (%u bytes) exceeds slot size, writing through", key, size);
+            Slot *slot = Find(key);
+            if (slot) {
+                slot->state = SlotState::kEmpty;
+                slot->dirty = false;
+            }
+            return mBacking->SyncSetKeyValue(key, value, size);
+        }
+
+        Slot *slot = Find(key);
+        if (!slot) {
+            slot = Allocate(key);
+        }
+        memcpy(slot->value, value, size);
+        slot->len = size;
+        slot->state = SlotState::kPresent;
+        MarkDirty(slot);
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR SyncDeleteKeyValue(const char *key) override
+    {
+        Slot *slot = Find(key);
+        if (slot && slot->state == SlotState::kAbsent) {
+            return CHIP_ERROR_PERSISTED_STORAGE_VALUE_NOT_FOUND;
+        }
+        if (!slot) {
+            slot = Allocate(key);
+        }
+        slot->len = 0;
+        slot->state = SlotState::kAbsent;
+        MarkDirty(slot);
+        return CHIP_NO_ERROR;
+    }
+
+    // Drop unwritten stores and deletes (storage is being erased)
+    uint32_t Discard()
+    {
+        uint32_t dropped = 0;
+        for (Slot &slot : mSlots) {
+            dropped += slot.dirty;
+            slot = {};
+        }
+        if (mFlushPending) {
+            chip::DeviceLayer::SystemLayer().CancelTimer(FlushTimerCb, this);
+            mFlushPending = false;
+        }
+        return dropped;
+    }
+
+    // False once a factory reset has erased the fabric table underneath the cache
+    bool BackingHasFabrics()
+    {
+        return mBacking->SyncDoesKeyExist(chip::DefaultStorageKeyAllocator::FabricIndexInfo().KeyName());
+    }
+
+    // Write all dirty slots to NVS
+    void Flush()
+    {
+        uint32_t written = 0;
+        for (Slot &slot : mSlots) {
+            if (!slot.dirty) {
+                continue;
+            }
+            CHIP_ERROR err = (slot.state == SlotState::kPresent)
+                             ? mBacking->SyncSetKeyValue(slot.key, slot.value, slot.len)
+                             : mBacking->SyncDeleteKeyValue(slot.key);
+            if (err != CHIP_NO_ERROR && err != CHIP_ERROR_PERSISTED_STORAGE_VALUE_NOT_FOUND) {
+                ESP_LOGE(TAG, "Scene write-back of %s failed: %" CHIP_ERROR_FORMAT, slot.key, err.Format());
+                continue;
+            }
+            slot.dirty = false;
+            written++;
+        }
+        if (written) {
+            mStats.flushes++;
+            mStats.flushed_entries += written;
+            ESP_LOGD(TAG, "Scene table: %" PRIu32 " entries written back", written);
+        }
+    }
+
+    void GetStats(app_scenes_stats_t *out) const
+    {
+        *out = mStats;
+        out->slots_used = 0;
+        out->dirty = 0;
+        for (const Slot &slot : mSlots) {
+            out->slots_used += (slot.state != SlotState::kEmpty);
+            out->dirty += slot.dirty;
+        }
+    }
+
+private:
+    enum class SlotState : uint8_t {
+        kEmpty,
+        kPresent,
+        kAbsent,        // Known not to exist in NVS
+    };
+
+    struct Slot {
+        char key[PersistentStorageDelegate::kKeyLengthMax + 1];
+        uint16_t len;
+        SlotState state;
+        bool dirty;
+        uint8_t value[SCENE_CACHE_VALUE_MAX];
+    };
+
+    Slot *Find(const char *key)
+    {
+        for (Slot &slot : mSlots) {
+            if (slot.state != SlotState::kEmpty && strcmp(slot.key, key) == 0) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    // Take an empty slot, else evict a clean one round-robin, else write back everything first
+    Slot *Allocate(const char *key)
+    {
+        Slot *slot = nullptr;
+        for (Slot &candidate : mSlots) {
+            if (candidate.state == SlotState::kEmpty) {
+                slot = &candidate;
+                break;
+            }
+        }
+        for (size_t i = 0; !slot && i < 2 * SCENE_CACHE_SLOTS; i++) {
+            Slot &candidate = mSlots[mNextEvict];
+            mNextEvict = (mNextEvict + 1) % SCENE_CACHE_SLOTS;
+            if (!candidate.dirty) {
+                slot = &candidate;
+            } else if (i == SCENE_CACHE_SLOTS - 1) {
+                Flush();
+            }
+        }
+        if (!slot) {
+            // Write-back failing: evict anyway rather than lose the new value
+            slot = &mSlots[mNextEvict];
+        }
+
+        strncpy(slot->key, key, sizeof(slot->key) - 1);
+        slot->key[sizeof(slot->key) - 1] = '\0';
+        slot->len = 0;
+        slot->state = SlotState::kEmpty;
+        slot->dirty = false;
+        return slot;
+    }
+
+    // Read a key from NVS into a slot; nullptr if it does not fit
+    Slot *Load(const char *key)
+    {
+        Slot *slot = Allocate(key);
+        uint16_t size = sizeof(slot->value);
+        CHIP_ERROR err = mBacking->SyncGetKeyValue(key, slot->value, size);
+        if (err == CHIP_NO_ERROR) {
+            slot->len = size;
+            slot->state = SlotState::kPresent;
+        } else if (err == CHIP_ERROR_PERSISTED_STORAGE_VALUE_NOT_FOUND) {
+            slot->state = SlotState::kAbsent;
+        } else {
+            slot->state = SlotState::kEmpty;
+            return nullptr;
+        }
+        return slot;
+    }
+
+    void MarkDirty(Slot *slot)
+    {
+        slot->dirty = true;
+        mStats.writes++;
+        if (!mFlushPending) {
+            mFlushPending = true;
+            chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Milliseconds32(SCENE_CACHE_FLUSH_MS),
+                                                        FlushTimerCb, this);
+        }
+    }
+
+    static void FlushTimerCb(chip::System::Layer *layer, void *context)
+    {
+        auto *self = static_cast<SceneStorageCache *>(context);
+        self->mFlushPending = false;
+        self->Flush();
+    }
+
+    PersistentStorageDelegate *mBacking = nullptr;
+    Slot mSlots[SCENE_CACHE_SLOTS] = {};
+    static_assert(sizeof(mSlots) / sizeof(mSlots[0]) >=
+                  SCENE_CACHE_ENDPOINTS * (chip::scenes::kMaxScenesPerEndpoint + CHIP_CONFIG_MAX_FABRICS) + 1,
+                  "scene cache smaller than the scene table: full tables would be evicted");
+    size_t mNextEvict = 0;
+    bool mFlushPending = false;
+    app_scenes_stats_t mStats = {};
+};
+
+static SceneStorageCache s_cache;
+static bool s_initialized = false;
+static TaskHandle_t s_matter_task = NULL;
+static SemaphoreHandle_t s_flush_done = NULL;
+static StaticSemaphore_t s_flush_done_buf;
+
+// Matter thread only
+static void flush_now(void)
+{
+    // esp_matter::factory_reset() erases NVS and then restarts through the shutdown handler
+    if (s_cache.BackingHasFabrics()) {
+        s_cache.Flush();
+    }
+}
+
+static void flush_work(intptr_t arg)
+{
+    flush_now();
+    xSemaphoreGive(s_flush_done);
+}
+
+static void flush_on_restart(void)
+{
+    app_scenes_flush();
+}
+
+esp_err_t app_scenes_init(uint16_t endpoint_id)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    s_cache.Init(&chip::Server::GetInstance().GetPersistentStorage());
+
+    // The scene table is a singleton shared by all endpoints; re-point its storage at the cache
+    chip::scenes::DefaultSceneTableImpl *table = chip::scenes::GetSceneTableImpl(endpoint_id);
+    CHIP_ERROR err = table->Init(&s_cache);
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Scene table init failed: %" CHIP_ERROR_FORMAT, err.Format());
+        return ESP_FAIL;
+    }
+    s_matter_task = xTaskGetCurrentTaskHandle();
+    s_flush_done = xSemaphoreCreateBinaryStatic(&s_flush_done_buf);
+    s_initialized = true;
+    esp_register_shutdown_handler(flush_on_restart);
+
+    // Preload every stored scene so the first recall is served from RAM as well
+    uint32_t scenes = 0;
+    for (const chip::FabricInfo &fabric : chip::Server::GetInstance().GetFabricTable()) {
+        auto *iterator = table->IterateSceneEntries(fabric.GetFabricIndex());
+        if (!iterator) {
+            continue;
+        }
+        chip::scenes::DefaultSceneTableImpl::SceneTableEntry entry;
+        while (iterator->Next(entry)) {
+            scenes++;
+        }
+        iterator->Release();
+    }
+
+    app_scenes_stats_t st;
+    s_cache.GetStats(&st);
+    ESP_LOGI(TAG, "Scene table cached in RAM: %" PRIu32 " scenes, %" PRIu32 "/%d slots", scenes, st.slots_used,
+             static_cast<int>(SCENE_CACHE_SLOTS));
+    return ESP_OK;
+}
+
+void app_scenes_flush(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+    if (xTaskGetCurrentTaskHandle() == s_matter_task) {
+        flush_now();
+        return;
+    }
+    xSemaphoreTake(s_flush_done, 0);    // Drop a give from a wait that timed out earlier
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(flush_work) != CHIP_NO_ERROR ||
+        xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(SCENE_CACHE_FLUSH_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Scene write-back did not run on the Matter thread, unwritten entries lost");
+    }
+}
+
+void app_scenes_discard(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    uint32_t dropped = s_cache.Discard();
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    ESP_LOGI(TAG, "Scene cache cleared, %" PRIu32 " unwritten entries dropped", dropped);
+}
+
+void app_scenes_get_stats(app_scenes_stats_t *out)
+{
+    if (out) {
+        s_cache.GetStats(out);
+    }
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t scene_cache_handler(int argc, char **argv)
+{
+    app_scenes_stats_t st;
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    s_cache.GetStats(&st);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    printf("{\"hits\":%" PRIu32 ",\"misses\":%" PRIu32 ",\"writes\":%" PRIu32 ",\"flushes\":%" PRIu32
+           ",\"flushed_entries\":%" PRIu32 ",\"slots_used\":%" PRIu32 ",\"dirty\":%" PRIu32 "}\n",
+           st.hits, st.misses, st.writes, st.flushes, st.flushed_entries, st.slots_used, st.dirty);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_scenes_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "scene-cache",
+        .description = "Print scene table cache statistics as JSON",
+        .handler = scene_cache_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
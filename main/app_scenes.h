@@ -0,0 +1,72 @@
+/*
+   M5NanoC6 Matter Switch - Scene Table Cache Header
+
+   Serves the Scenes Management scene table from a fixed-size RAM table so
+   RecallScene needs no flash reads or heap allocations. Stores are
+   written back to NVS in batches.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+// RAM scene table: one slot per storage key (scene entry, per-fabric scene list, counters),
+// sized in app_scenes.cpp from the scene table limits
+#define SCENE_CACHE_ENDPOINTS       1       // Endpoints with the Scenes Management cluster
+#define SCENE_CACHE_VALUE_MAX       128     // Larger values are passed through to NVS uncached
+#define SCENE_CACHE_FLUSH_MS        2000    // Write-back delay after the first dirty entry
+#define SCENE_CACHE_FLUSH_WAIT_MS   1000    // Longest wait for the Matter thread to write back before a restart
+
+typedef struct {
+    uint32_t hits;              // Reads served from RAM
+    uint32_t misses;            // Reads that went to NVS
+    uint32_t writes;            // Stores/deletes absorbed in RAM
+    uint32_t flushes;           // Write-back batches
+    uint32_t flushed_entries;   // Entries written to NVS
+    uint32_t slots_used;
+    uint32_t dirty;
+} app_scenes_stats_t;
+
+/**
+ * @brief Put the scene table on top of the RAM cache and preload it
+ *
+ * Must run on the Matter thread after the server is initialized
+ * (kServerReady).
+ *
+ * @param endpoint_id Endpoint with the Scenes Management cluster
+ * @return ESP_OK on success
+ */
+esp_err_t app_scenes_init(uint16_t endpoint_id);
+
+/**
+ * @brief Write unwritten scene entries to NVS now
+ *
+ * Call before requesting a restart. The write-back runs on the Matter
+ * thread: from another task it is scheduled there and waited for (up to
+ * SCENE_CACHE_FLUSH_WAIT_MS), so the caller must not hold the CHIP stack
+ * lock. Also runs from a shutdown handler for restarts that skip it.
+ */
+void app_scenes_flush(void);
+
+/**
+ * @brief Drop the cache without writing it back
+ *
+ * Call before a factory reset, so the restart does not write dirty scene
+ * entries into the freshly erased NVS. Takes the CHIP stack lock.
+ */
+void app_scenes_discard(void);
+
+/**
+ * @brief Copy current cache statistics
+ *
+ * @param[out] out Statistics snapshot
+ */
+void app_scenes_get_stats(app_scenes_stats_t *out);
+
+/**
+ * @brief Register "scene-cache" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_scenes_register_commands(void);
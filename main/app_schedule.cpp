@@ -0,0 +1,382 @@
+/*
+   M5NanoC6 Matter Switch - On-Device Schedule
+
+   One system timer on the Matter thread is armed for the next firing
+   returned by app_schedule_advance() (capped at SCHEDULE_MAX_SLEEP_S so
+   clock corrections and DST changes are picked up). When it expires every
+   entry due since the previous evaluation is applied through the OnOff
+   attribute, exactly like a local command. Entries that are more than
+   SCHEDULE_CATCHUP_S late (clock set forward, long outage) are skipped
+   rather than replayed; when the clock steps back by up to
+   SCHEDULE_REWIND_HOLD_S nothing fires twice. That policy lives in the
+   engine, so scripts/schedule_sim.py runs this exact code. Setting the
+   clock re-evaluates at once, through the Time Synchronization delegate.
+
+   The table is stored in NVS as one blob: a version byte followed by one
+   packed 32-bit word per used entry (at most 65 bytes).
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <nvs.h>
+
+#include <app/clusters/time-synchronization-server/DefaultTimeSyncDelegate.h>
+#include <app/clusters/time-synchronization-server/time-synchronization-server.h>
+#include <lib/support/TimeUtils.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <system/SystemClock.h>
+
+#include "app_schedule.h"
+#include "app_schedule_engine.h"
+#include "app_switch_platform.h"
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+
+static const char *TAG = "app_schedule";
+
+#define SCHEDULE_NVS_NAMESPACE      "app_sched"
+#define SCHEDULE_NVS_KEY            "table"
+#define SCHEDULE_NVS_VERSION        1
+
+// Matter thread only
+static app_schedule_t s_schedule;
+static uint16_t s_endpoint_id = 0;
+static app_schedule_eval_t s_eval;
+static bool s_timer_armed = false;
+static uint32_t s_next_fire_published = 0;     // NextFire attribute value
+
+static uint8_t s_entries_buf[APP_SCHEDULE_MAX_ENTRIES * sizeof(uint32_t)];
+
+static uint16_t pack_entries(uint8_t *out)
+{
+    uint16_t len = 0;
+    for (uint8_t i = 0; i < APP_SCHEDULE_MAX_ENTRIES; i++) {
+        if (s_schedule.entries[i].days == 0) {
+            continue;
+        }
+        uint32_t word = app_schedule_pack(i, &s_schedule.entries[i]);
+        for (int b = 0; b < 4; b++) {
+            out[len++] = static_cast<uint8_t>(word >> (8 * b));
+        }
+    }
+    return len;
+}
+
+static void load_schedule(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(SCHEDULE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;     // Nothing stored yet
+    }
+    uint8_t blob[1 + sizeof(s_entries_buf)];
+    size_t len = sizeof(blob);
+    esp_err_t err = nvs_get_blob(handle, SCHEDULE_NVS_KEY, blob, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len < 1 || blob[0] != SCHEDULE_NVS_VERSION) {
+        return;
+    }
+
+    uint32_t loaded = 0;
+    for (size_t i = 1; i + 4 <= len; i += 4) {
+        uint32_t word = blob[i] | (blob[i + 1] << 8) | (blob[i + 2] << 16) | (static_cast<uint32_t>(blob[i + 3]) << 24);
+        if (app_schedule_unpack(&s_schedule, word)) {
+            loaded++;
+        } else {
+            ESP_LOGW(TAG, "Dropping malformed stored entry 0x%08" PRIx32, word);
+        }
+    }
+    ESP_LOGI(TAG, "Loaded %" PRIu32 " schedule entries", loaded);
+}
+
+static esp_err_t save_schedule(void)
+{
+    uint8_t blob[1 + sizeof(s_entries_buf)];
+    blob[0] = SCHEDULE_NVS_VERSION;
+    size_t len = 1 + pack_entries(blob + 1);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SCHEDULE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, SCHEDULE_NVS_KEY, blob, len);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store schedule: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+// Local time from the Time Synchronization cluster; false while it is not available
+static bool local_now(int64_t *out)
+{
+    chip::System::Clock::Microseconds64 utc;
+    if (chip::System::SystemClock().GetClock_RealTime(utc) != CHIP_NO_ERROR) {
+        return false;
+    }
+
+    // No time zone configured: run on UTC
+    TimeSynchronization::TimeSynchronizationServer &time_sync = TimeSynchronization::TimeSynchronizationServer::Instance();
+    if (time_sync.GetTimeZone().size() == 0) {
+        *out = static_cast<int64_t>(utc.count() / 1000000);
+        return true;
+    }
+
+    // Time zone or DST list just changed or failed to apply: wait rather than fire on UTC
+    chip::app::DataModel::Nullable<uint64_t> local;
+    if (time_sync.GetLocalTime(chip::kRootEndpointId, local) != CHIP_NO_ERROR || local.IsNull()) {
+        return false;
+    }
+    *out = static_cast<int64_t>(local.Value() / 1000000) + chip::kChipEpochSecondsSinceUnixEpoch;
+    return true;
+}
+
+// Entries only change through the table commands; NextFire is reported when it moves
+static void publish_entries(void)
+{
+    esp_matter_attr_val_t entries = esp_matter_octet_str(s_entries_buf, pack_entries(s_entries_buf));
+    attribute::update(s_endpoint_id, SCHEDULE_CLUSTER_ID, SCHEDULE_ATTR_ENTRIES_ID, &entries);
+}
+
+static void publish_next_fire(int64_t next_fire)
+{
+    uint32_t next = (next_fire == APP_SCHEDULE_NONE) ? 0 : static_cast<uint32_t>(next_fire);
+    if (next == s_next_fire_published) {
+        return;
+    }
+    s_next_fire_published = next;
+    esp_matter_attr_val_t next_val = esp_matter_uint32(next);
+    attribute::update(s_endpoint_id, SCHEDULE_CLUSTER_ID, SCHEDULE_ATTR_NEXT_FIRE_ID, &next_val);
+}
+
+static void fire(uint32_t due_mask, int64_t at, void *arg)
+{
+    bool on = app_platform_onoff_get(s_endpoint_id);
+    bool target = app_schedule_apply(&s_schedule, due_mask, on);
+    ESP_LOGI(TAG, "Schedule at %" PRId32 ":%02" PRId32 " (entries 0x%04" PRIx32 "): %s",
+             static_cast<int32_t>((at / 3600) % 24), static_cast<int32_t>((at / 60) % 60), due_mask,
+             target ? "on" : "off");
+    if (target != on) {
+        app_platform_onoff_set(s_endpoint_id, target);
+    }
+}
+
+static void evaluate(void);
+
+static void timer_cb(chip::System::Layer *layer, void *context)
+{
+    s_timer_armed = false;
+    evaluate();
+}
+
+static void arm(uint32_t delay_s)
+{
+    if (s_timer_armed) {
+        chip::DeviceLayer::SystemLayer().CancelTimer(timer_cb, nullptr);
+    }
+    s_timer_armed = chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Seconds32(delay_s), timer_cb,
+                                                                nullptr) == CHIP_NO_ERROR;
+}
+
+// Apply everything due since the last evaluation, then sleep until the next firing
+static void evaluate(void)
+{
+    int64_t now;
+    if (!local_now(&now)) {
+        arm(SCHEDULE_UNSYNCED_RETRY_S);
+        return;
+    }
+
+    int64_t next = app_schedule_advance(&s_schedule, &s_eval, now, fire, nullptr);
+    publish_next_fire(next);
+    int64_t delay = (next == APP_SCHEDULE_NONE) ? SCHEDULE_MAX_SLEEP_S : next - now;
+    arm(static_cast<uint32_t>(delay < SCHEDULE_MAX_SLEEP_S ? delay : SCHEDULE_MAX_SLEEP_S));
+}
+
+// Re-evaluate as soon as a controller sets the clock instead of at the next capped wake-up
+class ScheduleTimeSyncDelegate : public TimeSynchronization::DefaultTimeSyncDelegate {
+public:
+    void UTCTimeAvailabilityChanged(uint64_t time) override
+    {
+        TimeSynchronization::DefaultTimeSyncDelegate::UTCTimeAvailabilityChanged(time);
+        evaluate();
+    }
+};
+
+static ScheduleTimeSyncDelegate s_time_sync_delegate;
+
+// Reads context-tagged unsigned/bool fields 0..count-1 of a command struct
+static bool read_fields(chip::TLV::TLVReader &reader, uint32_t *fields, size_t count, uint32_t *present)
+{
+    chip::TLV::TLVType outer;
+    if (reader.EnterContainer(outer) != CHIP_NO_ERROR) {
+        return false;
+    }
+    CHIP_ERROR err;
+    while ((err = reader.Next()) == CHIP_NO_ERROR) {
+        if (!chip::TLV::IsContextTag(reader.GetTag())) {
+            continue;
+        }
+        uint32_t tag = chip::TLV::TagNumFromTag(reader.GetTag());
+        if (tag >= count) {
+            continue;
+        }
+        if (reader.GetType() == chip::TLV::kTLVType_Boolean) {
+            bool value;
+            err = reader.Get(value);
+            fields[tag] = value;
+        } else {
+            err = reader.Get(fields[tag]);
+        }
+        if (err != CHIP_NO_ERROR) {
+            return false;
+        }
+        *present |= 1U << tag;
+    }
+    return err == CHIP_END_OF_TLV && reader.ExitContainer(outer) == CHIP_NO_ERROR;
+}
+
+static esp_err_t table_changed(void)
+{
+    esp_err_t err = save_schedule();
+    publish_entries();
+    evaluate();
+    return err;
+}
+
+static esp_err_t set_entry_cb(const chip::app::ConcreteCommandPath &path, chip::TLV::TLVReader &tlv, void *opaque)
+{
+    uint32_t f[5] = {};
+    uint32_t present = 0;
+    if (!read_fields(tlv, f, 5, &present) || present != 0x1F || f[0] >= APP_SCHEDULE_MAX_ENTRIES || f[1] > 0xFF ||
+        f[2] > 0xFFFF || f[3] > 0xFF) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_schedule_entry_t entry = {
+        .days = static_cast<uint8_t>(f[1]),
+        .minute = static_cast<uint16_t>(f[2]),
+        .action = static_cast<uint8_t>(f[3]),
+        .enabled = f[4] != 0,
+    };
+    if (!app_schedule_entry_valid(&entry)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_schedule.entries[f[0]] = entry;
+    ESP_LOGI(TAG, "Entry %" PRIu32 ": days 0x%02x at %02u:%02u action %u%s", f[0], entry.days, entry.minute / 60,
+             entry.minute % 60, entry.action, entry.enabled ? "" : " (disabled)");
+    return table_changed();
+}
+
+static esp_err_t remove_entry_cb(const chip::app::ConcreteCommandPath &path, chip::TLV::TLVReader &tlv, void *opaque)
+{
+    uint32_t index = 0;
+    uint32_t present = 0;
+    if (!read_fields(tlv, &index, 1, &present) || present != 0x1 || index >= APP_SCHEDULE_MAX_ENTRIES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_schedule.entries[index] = {};
+    return table_changed();
+}
+
+static esp_err_t clear_entries_cb(const chip::app::ConcreteCommandPath &path, chip::TLV::TLVReader &tlv, void *opaque)
+{
+    memset(&s_schedule, 0, sizeof(s_schedule));
+    return table_changed();
+}
+
+esp_err_t app_schedule_create_cluster(endpoint_t *endpoint)
+{
+    s_endpoint_id = endpoint::get_id(endpoint);
+    load_schedule();
+
+    // Local time source on the root endpoint
+    endpoint_t *root = endpoint::get(node::get(), chip::kRootEndpointId);
+    if (root && !cluster::get(root, TimeSynchronization::Id)) {
+        cluster::time_synchronization::config_t time_config;
+        cluster_t *time_sync = cluster::time_synchronization::create(root, &time_config, CLUSTER_FLAG_SERVER);
+        if (time_sync) {
+            cluster::time_synchronization::feature::time_zone::config_t tz_config;
+            cluster::time_synchronization::feature::time_zone::add(time_sync, &tz_config);
+        }
+    }
+    TimeSynchronization::SetDefaultDelegate(&s_time_sync_delegate);
+
+    cluster_t *cluster = cluster::create(endpoint, SCHEDULE_CLUSTER_ID, CLUSTER_FLAG_SERVER);
+    if (!cluster) {
+        ESP_LOGE(TAG, "Failed to create schedule cluster");
+        return ESP_FAIL;
+    }
+    attribute::create(cluster, SCHEDULE_ATTR_ENTRIES_ID, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_octet_str(s_entries_buf, pack_entries(s_entries_buf)), sizeof(s_entries_buf));
+    attribute::create(cluster, SCHEDULE_ATTR_NEXT_FIRE_ID, ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+    attribute::create(cluster, chip::app::Clusters::Globals::Attributes::ClusterRevision::Id, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_uint16(1));
+    attribute::create(cluster, chip::app::Clusters::Globals::Attributes::FeatureMap::Id, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_uint32(0));
+
+    command::create(cluster, SCHEDULE_CMD_SET_ENTRY_ID, COMMAND_FLAG_ACCEPTED | COMMAND_FLAG_CUSTOM, set_entry_cb);
+    command::create(cluster, SCHEDULE_CMD_REMOVE_ENTRY_ID, COMMAND_FLAG_ACCEPTED | COMMAND_FLAG_CUSTOM,
+                    remove_entry_cb);
+    command::create(cluster, SCHEDULE_CMD_CLEAR_ENTRIES_ID, COMMAND_FLAG_ACCEPTED | COMMAND_FLAG_CUSTOM,
+                    clear_entries_cb);
+    return ESP_OK;
+}
+
+esp_err_t app_schedule_init(void)
+{
+    app_schedule_eval_init(&s_eval, SCHEDULE_CATCHUP_S, SCHEDULE_REWIND_HOLD_S);
+    evaluate();
+    return ESP_OK;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void schedule_print_work(intptr_t arg)
+{
+    int64_t now = 0;
+    bool synced = local_now(&now);
+    int64_t next = app_schedule_next(&s_schedule, now, nullptr);
+
+    printf("{\"synced\":%s,\"now\":%" PRIu32 ",\"next\":%" PRIu32 ",\"fired\":%" PRIu32 ",\"skipped\":%" PRIu32
+           ",\"entries\":[", synced ? "true" : "false", static_cast<uint32_t>(now),
+           (synced && next != APP_SCHEDULE_NONE) ? static_cast<uint32_t>(next) : 0, s_eval.fired, s_eval.skipped);
+    bool first = true;
+    for (int i = 0; i < APP_SCHEDULE_MAX_ENTRIES; i++) {
+        const app_schedule_entry_t *e = &s_schedule.entries[i];
+        if (e->days == 0) {
+            continue;
+        }
+        printf("%s{\"index\":%d,\"days\":%u,\"minute\":%u,\"action\":%u,\"enabled\":%s}", first ? "" : ",", i,
+               e->days, e->minute, e->action, e->enabled ? "true" : "false");
+        first = false;
+    }
+    printf("]}\n");
+}
+
+static esp_err_t schedule_handler(int argc, char **argv)
+{
+    // Schedule state belongs to the Matter thread
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(schedule_print_work, 0);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_schedule_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "schedule",
+        .description = "Print the schedule table, clock state and next firing as JSON",
+        .handler = schedule_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
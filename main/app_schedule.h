@@ -0,0 +1,67 @@
+/*
+   M5NanoC6 Matter Switch - On-Device Schedule Header
+
+   Weekly on/off schedule evaluated on the device (app_schedule_engine.h),
+   so recurring automations do not depend on a controller being reachable
+   at the scheduled time. Controllers manage the table through a vendor
+   cluster on the plug endpoint:
+
+   Cluster 0xFFF1FC01 (test vendor 0xFFF1)
+     Attributes:
+       0x0000 Entries      octet string, 4 bytes per entry (little-endian
+                           app_schedule_pack() words)
+       0x0001 NextFire     uint32, next firing in local Unix seconds, 0 = none
+     Commands:
+       0x00 SetEntry       {0 index u8, 1 days u8, 2 minute u16, 3 action u8, 4 enabled bool}
+       0x01 RemoveEntry    {0 index u8}
+       0x02 ClearEntries   {}
+
+   Local time comes from the Time Synchronization cluster (UTC plus time
+   zone/DST offsets), or is plain UTC if no time zone is configured. Once
+   set, the device keeps time on its own clock.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter.h>
+
+#define SCHEDULE_CLUSTER_ID             0xFFF1FC01
+#define SCHEDULE_ATTR_ENTRIES_ID        0x0000
+#define SCHEDULE_ATTR_NEXT_FIRE_ID      0x0001
+#define SCHEDULE_CMD_SET_ENTRY_ID       0x00
+#define SCHEDULE_CMD_REMOVE_ENTRY_ID    0x01
+#define SCHEDULE_CMD_CLEAR_ENTRIES_ID   0x02
+
+#define SCHEDULE_CATCHUP_S              60      // Late firings within this window still apply
+#define SCHEDULE_MAX_SLEEP_S            3600    // Re-read the clock at least this often (resync, DST)
+#define SCHEDULE_UNSYNCED_RETRY_S       30      // Time check interval until the clock is set
+#define SCHEDULE_REWIND_HOLD_S          7200    // Larger backward steps restart the schedule from the new time
+
+/**
+ * @brief Load the stored schedule and add the schedule cluster
+ *
+ * Also adds the Time Synchronization cluster (TimeZone feature) to the
+ * root endpoint if it is missing. Call before esp_matter::start().
+ *
+ * @param endpoint Plug endpoint
+ * @return ESP_OK on success
+ */
+esp_err_t app_schedule_create_cluster(esp_matter::endpoint_t *endpoint);
+
+/**
+ * @brief Start evaluating the schedule
+ *
+ * Must run on the Matter thread after the server is initialized
+ * (kServerReady).
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_schedule_init(void);
+
+/**
+ * @brief Register "schedule" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_schedule_register_commands(void);
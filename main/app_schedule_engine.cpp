@@ -0,0 +1,148 @@
+/*
+   M5NanoC6 Matter Switch - Schedule Engine
+
+   No ESP-IDF dependencies: see app_schedule_engine.h.
+*/
+
+#include <stddef.h>
+
+#include "app_schedule_engine.h"
+
+#define SECONDS_PER_DAY     86400
+#define MINUTES_PER_DAY     1440
+#define EPOCH_WEEKDAY       4           // 1970-01-01 was a Thursday
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+bool app_schedule_entry_valid(const app_schedule_entry_t *entry)
+{
+    return entry->days != 0 && (entry->days & ~APP_SCHEDULE_EVERY_DAY) == 0 && entry->minute < MINUTES_PER_DAY &&
+           entry->action <= APP_SCHEDULE_ACTION_TOGGLE;
+}
+
+uint32_t app_schedule_pack(uint8_t index, const app_schedule_entry_t *entry)
+{
+    return (static_cast<uint32_t>(entry->minute) & 0x7FF) |
+           (static_cast<uint32_t>(entry->days & APP_SCHEDULE_EVERY_DAY) << 11) |
+           (static_cast<uint32_t>(entry->action & 0x3) << 18) |
+           (entry->enabled ? (1U << 20) : 0) |
+           (static_cast<uint32_t>(index) << 24);
+}
+
+bool app_schedule_unpack(app_schedule_t *schedule, uint32_t word)
+{
+    uint8_t index = word >> 24;
+    app_schedule_entry_t entry = {
+        .days = static_cast<uint8_t>((word >> 11) & APP_SCHEDULE_EVERY_DAY),
+        .minute = static_cast<uint16_t>(word & 0x7FF),
+        .action = static_cast<uint8_t>((word >> 18) & 0x3),
+        .enabled = (word & (1U << 20)) != 0,
+    };
+    if (index >= APP_SCHEDULE_MAX_ENTRIES || !app_schedule_entry_valid(&entry)) {
+        return false;
+    }
+    schedule->entries[index] = entry;
+    return true;
+}
+
+int64_t app_schedule_next(const app_schedule_t *schedule, int64_t now_s, uint32_t *due_mask)
+{
+    int64_t day = floor_div(now_s, SECONDS_PER_DAY);
+    int64_t best = APP_SCHEDULE_NONE;
+    uint32_t mask = 0;
+
+    // Today (later minutes) through the same weekday next week covers every entry
+    for (int64_t d = day; d <= day + 7 && best == APP_SCHEDULE_NONE; d++) {
+        int weekday = static_cast<int>(((d + EPOCH_WEEKDAY) % 7 + 7) % 7);
+        for (size_t i = 0; i < APP_SCHEDULE_MAX_ENTRIES; i++) {
+            const app_schedule_entry_t *entry = &schedule->entries[i];
+            if (!entry->enabled || !(entry->days & (1U << weekday))) {
+                continue;
+            }
+            int64_t at = d * SECONDS_PER_DAY + entry->minute * 60;
+            if (at <= now_s) {
+                continue;
+            }
+            if (at < best) {
+                best = at;
+                mask = 0;
+            }
+            if (at == best) {
+                mask |= 1U << i;
+            }
+        }
+    }
+
+    if (due_mask) {
+        *due_mask = mask;
+    }
+    return best;
+}
+
+bool app_schedule_apply(const app_schedule_t *schedule, uint32_t due_mask, bool on)
+{
+    for (size_t i = 0; i < APP_SCHEDULE_MAX_ENTRIES; i++) {
+        if (!(due_mask & (1U << i))) {
+            continue;
+        }
+        switch (schedule->entries[i].action) {
+        case APP_SCHEDULE_ACTION_OFF:
+            on = false;
+            break;
+        case APP_SCHEDULE_ACTION_ON:
+            on = true;
+            break;
+        case APP_SCHEDULE_ACTION_TOGGLE:
+            on = !on;
+            break;
+        }
+    }
+    return on;
+}
+
+void app_schedule_eval_init(app_schedule_eval_t *eval, uint32_t catchup_s, uint32_t rewind_hold_s)
+{
+    *eval = {};
+    eval->catchup_s = catchup_s;
+    eval->rewind_hold_s = rewind_hold_s;
+}
+
+int64_t app_schedule_advance(const app_schedule_t *schedule, app_schedule_eval_t *eval, int64_t now_s,
+                             app_schedule_fire_cb_t cb, void *arg)
+{
+    if (!eval->started || now_s < eval->last_s - eval->rewind_hold_s) {
+        // First evaluation, or the clock was wrong before: start from now
+        eval->last_s = now_s;
+        eval->started = true;
+    } else if (now_s < eval->last_s) {
+        // Small step back (DST end, resync): hold until the clock passes the
+        // last evaluation so the repeated hour does not fire twice
+    } else if (now_s - eval->last_s > eval->catchup_s) {
+        // Count what the jump skipped without replaying it
+        int64_t t = eval->last_s;
+        uint32_t mask;
+        while ((t = app_schedule_next(schedule, t, &mask)) <= now_s - eval->catchup_s) {
+            eval->skipped += __builtin_popcount(mask);
+        }
+        eval->last_s = now_s - eval->catchup_s;
+    }
+
+    uint32_t mask;
+    int64_t at;
+    while ((at = app_schedule_next(schedule, eval->last_s, &mask)) <= now_s) {
+        eval->fired++;
+        if (cb) {
+            cb(mask, at, arg);
+        }
+        eval->last_s = at;
+    }
+    if (eval->last_s < now_s) {
+        eval->last_s = now_s;
+    }
+
+    return app_schedule_next(schedule, eval->last_s, NULL);
+}
@@ -0,0 +1,143 @@
+/*
+   M5NanoC6 Matter Switch - Schedule Engine
+
+   Hardware-independent weekly on/off schedule. Each entry fires on a set
+   of weekdays at a minute of the local day. The engine never polls: the
+   caller asks for the next deadline, sleeps until then and calls
+   app_schedule_advance(), which fires what is due and applies the clock
+   step policy (late catch-up, rewind hold, restart). All times are local
+   seconds since the Unix epoch, so the same code runs against the device
+   clock and against the virtual clock of scripts/schedule_sim.py, which
+   builds this file for the host.
+
+   Entries pack into 32 bits each for storage.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_SCHEDULE_MAX_ENTRIES    16
+#define APP_SCHEDULE_NONE           INT64_MAX   // No enabled entries
+
+// Weekday bits (bit 0 = Sunday, as in the Matter DaysMaskMap)
+#define APP_SCHEDULE_SUNDAY         (1U << 0)
+#define APP_SCHEDULE_WEEKDAYS       0x3EU       // Monday-Friday
+#define APP_SCHEDULE_EVERY_DAY      0x7FU
+
+typedef enum {
+    APP_SCHEDULE_ACTION_OFF = 0,
+    APP_SCHEDULE_ACTION_ON = 1,
+    APP_SCHEDULE_ACTION_TOGGLE = 2,
+} app_schedule_action_t;
+
+typedef struct {
+    uint8_t days;               // APP_SCHEDULE_* weekday bits; 0 = free slot
+    uint16_t minute;            // Minute of the local day, 0-1439
+    uint8_t action;             // app_schedule_action_t
+    bool enabled;
+} app_schedule_entry_t;
+
+typedef struct {
+    app_schedule_entry_t entries[APP_SCHEDULE_MAX_ENTRIES];    // Index is the entry ID
+} app_schedule_t;
+
+typedef struct {
+    int64_t catchup_s;          // Late firings within this window still apply
+    int64_t rewind_hold_s;      // Larger backward steps restart from the new time
+    int64_t last_s;             // Local time of the previous evaluation
+    bool started;               // last_s is valid
+    uint32_t fired;             // Firing callbacks made
+    uint32_t skipped;           // Entries skipped by forward clock jumps
+} app_schedule_eval_t;
+
+/**
+ * @brief Called by app_schedule_advance() for each firing, oldest first
+ *
+ * @param due_mask Entries firing (bit n = entry n), for app_schedule_apply()
+ * @param at_s Local time the entries were due
+ * @param arg Caller context
+ */
+typedef void (*app_schedule_fire_cb_t)(uint32_t due_mask, int64_t at_s, void *arg);
+
+/**
+ * @brief Check an entry's fields
+ *
+ * @return true if days is non-zero and within a week, minute < 1440 and action known
+ */
+bool app_schedule_entry_valid(const app_schedule_entry_t *entry);
+
+/**
+ * @brief Pack an entry and its index into a storage word
+ *
+ * Bits 0-10 minute, 11-17 days, 18-19 action, 20 enabled, 24-31 index.
+ */
+uint32_t app_schedule_pack(uint8_t index, const app_schedule_entry_t *entry);
+
+/**
+ * @brief Unpack a storage word into the table
+ *
+ * @return false if the word is malformed (table unchanged)
+ */
+bool app_schedule_unpack(app_schedule_t *schedule, uint32_t word);
+
+/**
+ * @brief Next time after now_s at which any enabled entry fires
+ *
+ * @param schedule Schedule table
+ * @param now_s Local time, seconds since the epoch
+ * @param[out] due_mask Entry indexes firing at that time (bit n = entry n), may be NULL
+ * @return Local time of the next firing, or APP_SCHEDULE_NONE
+ */
+int64_t app_schedule_next(const app_schedule_t *schedule, int64_t now_s, uint32_t *due_mask);
+
+/**
+ * @brief Resulting OnOff value after the entries in due_mask fire
+ *
+ * Entries firing at the same minute apply in index order.
+ *
+ * @param schedule Schedule table
+ * @param due_mask Entries firing
+ * @param on Current OnOff value
+ * @return New OnOff value
+ */
+bool app_schedule_apply(const app_schedule_t *schedule, uint32_t due_mask, bool on);
+
+/**
+ * @brief Initialize the evaluation state
+ *
+ * The first app_schedule_advance() starts the schedule from its now_s.
+ *
+ * @param eval Evaluation state
+ * @param catchup_s Firings at most this late are still applied
+ * @param rewind_hold_s Backward clock steps up to this long wait for the
+ *                      clock to catch up; larger ones restart from the new time
+ */
+void app_schedule_eval_init(app_schedule_eval_t *eval, uint32_t catchup_s, uint32_t rewind_hold_s);
+
+/**
+ * @brief Fire everything due since the previous evaluation
+ *
+ * Entries more than catchup_s late (clock set forward, long outage) are
+ * counted in skipped instead of fired. After a backward step of up to
+ * rewind_hold_s nothing fires until the clock passes the previous
+ * evaluation again, so a repeated hour does not fire twice.
+ *
+ * @param schedule Schedule table
+ * @param eval Evaluation state
+ * @param now_s Local time, seconds since the epoch
+ * @param cb Called for each firing, may be NULL
+ * @param arg Passed to cb
+ * @return Local time of the next firing, or APP_SCHEDULE_NONE
+ */
+int64_t app_schedule_advance(const app_schedule_t *schedule, app_schedule_eval_t *eval, int64_t now_s,
+                             app_schedule_fire_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+/*
+   M5NanoC6 Matter Switch - Device State Word
+
+   Each successful compare-and-swap also stores the new word and its time
+   in a small trace indexed by the sequence number. Every slot has a single
+   writer (the task that produced that sequence number), so the trace takes
+   no lock either. The "state" shell command prints the snapshot and the
+   last transitions.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+
+#include "app_state.h"
+
+#define TRACE_LEN   16      // Power of two
+
+typedef struct {
+    uint32_t state;
+    uint32_t ms;
+} trace_entry_t;
+
+static uint32_t s_state = 0;
+static trace_entry_t s_trace[TRACE_LEN];
+
+static void trace(uint32_t state)
+{
+    trace_entry_t *entry = &s_trace[app_state_seq(state) & (TRACE_LEN - 1)];
+    entry->ms = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+    entry->state = state;
+}
+
+app_state_t app_state_get(void)
+{
+    return __atomic_load_n(&s_state, __ATOMIC_ACQUIRE);
+}
+
+// CAS loop shared by update and transition; expected_mask 0 = unconditional
+static bool swap(uint32_t mask, uint32_t expected_mask, uint32_t expected, uint32_t bits, app_state_t *out)
+{
+    uint32_t old = __atomic_load_n(&s_state, __ATOMIC_RELAXED);
+    for (;;) {
+        if ((old & expected_mask) != expected) {
+            *out = old;
+            return false;
+        }
+        uint32_t fields = (old & APP_STATE_FIELDS_MASK & ~mask) | (bits & mask);
+        if (fields == (old & APP_STATE_FIELDS_MASK)) {
+            *out = old;
+            return true;        // Nothing changes: no new sequence number
+        }
+        uint32_t next = fields | ((old & ~APP_STATE_FIELDS_MASK) + (1U << APP_STATE_SEQ_SHIFT));
+        if (__atomic_compare_exchange_n(&s_state, &old, next, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            trace(next);
+            *out = next;
+            return true;
+        }
+    }
+}
+
+app_state_t app_state_update(uint32_t mask, uint32_t bits)
+{
+    app_state_t state;
+    swap(mask, 0, 0, bits, &state);
+    return state;
+}
+
+bool app_state_transition(uint32_t mask, uint32_t expected, uint32_t bits)
+{
+    app_state_t state;
+    return swap(mask, mask, expected & mask, bits, &state);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void print_state(const char *prefix, uint32_t s)
+{
+    static const char *const reset_names[] = {"idle", "countdown", "confirmed", "?"};
+    printf("%s{\"seq\":%u,\"power\":%d,\"identify\":%d,\"led_phase\":%d,\"ota\":%d,\"ota_percent\":%u,"
+           "\"reset\":\"%s\",\"network\":%d,\"commissioned\":%d,\"window_open\":%d}",
+           prefix, app_state_seq(s), app_state_power(s), (s & APP_STATE_IDENTIFY) != 0,
+           (s & APP_STATE_LED_PHASE) != 0, (s & APP_STATE_OTA) != 0, app_state_ota_percent(s),
+           reset_names[app_state_reset_phase(s)], (s & APP_STATE_NETWORK) != 0, (s & APP_STATE_COMMISSIONED) != 0,
+           (s & APP_STATE_WINDOW_OPEN) != 0);
+}
+
+static esp_err_t state_handler(int argc, char **argv)
+{
+    uint32_t now = app_state_get();
+    print_state("{\"state\":", now);
+
+    // Oldest first, up to the current sequence number
+    printf(",\"trace\":[");
+    uint16_t seq = app_state_seq(now);
+    bool first = true;
+    for (uint16_t back = TRACE_LEN; back > 0; back--) {
+        uint16_t want = static_cast<uint16_t>(seq - back + 1);
+        const trace_entry_t *entry = &s_trace[want & (TRACE_LEN - 1)];
+        trace_entry_t copy = *entry;
+        if (copy.ms == 0 || app_state_seq(copy.state) != want) {
+            continue;           // Not written yet, or overwritten while printing
+        }
+        printf("%s{\"ms\":%" PRIu32 ",", first ? "" : ",", copy.ms);
+        print_state("\"state\":", copy.state);
+        printf("}");
+        first = false;
+    }
+    printf("]}\n");
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_state_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "state",
+        .description = "Print the device state word and its last transitions as JSON",
+        .handler = state_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
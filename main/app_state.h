@@ -0,0 +1,122 @@
+/*
+   M5NanoC6 Matter Switch - Device State Word Header
+
+   One 32-bit word holds the state that LED, reset and OTA decisions depend
+   on: on/off, identify, the LED blink phase, OTA progress, the factory reset
+   phase, network and commissioning status. The top 16 bits are a sequence
+   number that every transition bumps. One load gives a consistent snapshot
+   on any task, with no lock and no attribute read. Writers update the word
+   with a compare-and-swap loop.
+
+   A single word keeps this lock-free on RV32: 64-bit atomics on the
+   ESP32-C6 go through a lock in libatomic. The C6 does not cache SRAM, so
+   there is no cache line to align to.
+
+   Writers:
+     power          app_platform_led_set_power() (every OnOff change, Matter thread)
+     identify       app_driver_led_identify_start/stop() and the identify task
+     led phase      LED blink timers
+     ota            app_driver_led_ota_start/progress/stop()
+     reset          app_reset (button task and reset task)
+     network, commissioned, window   app_event_cb (Matter thread)
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_STATE_POWER             (1U << 0)       // OnOff attribute of the switch endpoint
+#define APP_STATE_IDENTIFY          (1U << 1)       // Identify pattern requested (cleared to cancel it)
+#define APP_STATE_LED_PHASE         (1U << 2)       // Blink phase of the identify/OTA patterns
+#define APP_STATE_OTA               (1U << 3)       // OTA download in progress
+#define APP_STATE_OTA_PERCENT_SHIFT 4
+#define APP_STATE_OTA_PERCENT_MASK  (0x7FU << APP_STATE_OTA_PERCENT_SHIFT)
+#define APP_STATE_RESET_SHIFT       11
+#define APP_STATE_RESET_MASK        (0x3U << APP_STATE_RESET_SHIFT)
+#define APP_STATE_NETWORK           (1U << 13)      // Thread attached / Wi-Fi station connected
+#define APP_STATE_COMMISSIONED      (1U << 14)      // At least one fabric
+#define APP_STATE_WINDOW_OPEN       (1U << 15)      // Commissioning window open
+#define APP_STATE_SEQ_SHIFT         16
+#define APP_STATE_FIELDS_MASK       ((1U << APP_STATE_SEQ_SHIFT) - 1)
+
+typedef enum {
+    APP_STATE_RESET_IDLE = 0,
+    APP_STATE_RESET_COUNTDOWN = 1,      // Button held: config ID pattern, reset if still held
+    APP_STATE_RESET_CONFIRMED = 2,      // Factory reset under way
+} app_state_reset_t;
+
+typedef uint32_t app_state_t;
+
+static inline bool app_state_power(app_state_t s)
+{
+    return (s & APP_STATE_POWER) != 0;
+}
+
+static inline uint8_t app_state_ota_percent(app_state_t s)
+{
+    return static_cast<uint8_t>((s & APP_STATE_OTA_PERCENT_MASK) >> APP_STATE_OTA_PERCENT_SHIFT);
+}
+
+static inline app_state_reset_t app_state_reset_phase(app_state_t s)
+{
+    return static_cast<app_state_reset_t>((s & APP_STATE_RESET_MASK) >> APP_STATE_RESET_SHIFT);
+}
+
+static inline uint32_t app_state_reset_bits(app_state_reset_t phase)
+{
+    return static_cast<uint32_t>(phase) << APP_STATE_RESET_SHIFT;
+}
+
+static inline uint32_t app_state_ota_percent_bits(uint8_t percent)
+{
+    return static_cast<uint32_t>(percent > 100 ? 100 : percent) << APP_STATE_OTA_PERCENT_SHIFT;
+}
+
+static inline uint16_t app_state_seq(app_state_t s)
+{
+    return static_cast<uint16_t>(s >> APP_STATE_SEQ_SHIFT);
+}
+
+/**
+ * @brief Current state (one atomic load; any task or ISR)
+ */
+app_state_t app_state_get(void);
+
+/**
+ * @brief Replace the fields in mask with bits
+ *
+ * Bumps the sequence number if anything changed.
+ *
+ * @param mask Fields to replace (APP_STATE_* bits)
+ * @param bits New values, within mask
+ * @return The state after the update
+ */
+app_state_t app_state_update(uint32_t mask, uint32_t bits);
+
+/**
+ * @brief Replace the fields in mask only if they currently equal expected
+ *
+ * @param mask Fields to compare and replace
+ * @param expected Required current values, within mask
+ * @param bits New values, within mask
+ * @return true if the transition happened
+ */
+bool app_state_transition(uint32_t mask, uint32_t expected, uint32_t bits);
+
+/**
+ * @brief Register the "state" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_state_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
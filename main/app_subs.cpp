@@ -0,0 +1,186 @@
+/*
+   M5NanoC6 Matter Switch - Subscription Accounting
+
+   A ReadHandler application callback sees every subscription from request
+   to teardown. The heap drop between OnSubscriptionRequested and
+   OnSubscriptionEstablished is what the subscription costs (read handler,
+   attribute path list, session state); the priming report buffers are
+   already released by then. One "SUBS stats: {json}" line is logged per
+   change so a host can ramp fabrics/subscriptions and read the cost back
+   from the serial log.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <freertos/FreeRTOS.h>
+
+#include <app/InteractionModelEngine.h>
+#include <app/ReadHandler.h>
+#include <app/server/Server.h>
+#include <platform/PlatformManager.h>
+
+#include "app_subs.h"
+#include "app_switch.h"
+
+using chip::app::InteractionModelEngine;
+using chip::app::ReadHandler;
+
+static const char *TAG = "app_subs";
+
+// Only touched from the Matter thread
+static size_t s_free_at_request = 0;
+static size_t s_baseline_free = 0;          // Free heap with no subscriptions
+static uint32_t s_peak_subscriptions = 0;
+static uint32_t s_established = 0;
+static uint32_t s_terminated = 0;
+static int32_t s_last_sub_heap = 0;
+
+static uint32_t active_subscriptions(void)
+{
+    return InteractionModelEngine::GetInstance()->GetNumActiveReadHandlers(ReadHandler::InteractionType::Subscribe);
+}
+
+class SubsCallback : public ReadHandler::ApplicationCallback {
+public:
+    ReadHandler::ApplicationCallback *mNext = nullptr;
+
+    CHIP_ERROR OnSubscriptionRequested(ReadHandler &handler, chip::Transport::SecureSession &session) override
+    {
+        s_free_at_request = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        if (active_subscriptions() <= 1) {
+            // This request's handler is already counted
+            s_baseline_free = s_free_at_request;
+        }
+        return mNext ? mNext->OnSubscriptionRequested(handler, session) : CHIP_NO_ERROR;
+    }
+
+    void OnSubscriptionEstablished(ReadHandler &handler) override
+    {
+        s_last_sub_heap = static_cast<int32_t>(s_free_at_request) -
+                          static_cast<int32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        s_established++;
+        uint32_t active = active_subscriptions();
+        if (active > s_peak_subscriptions) {
+            s_peak_subscriptions = active;
+        }
+        log_stats("established");
+        if (mNext) {
+            mNext->OnSubscriptionEstablished(handler);
+        }
+    }
+
+    void OnSubscriptionTerminated(ReadHandler &handler) override
+    {
+        s_terminated++;
+        log_stats("terminated");
+        if (mNext) {
+            mNext->OnSubscriptionTerminated(handler);
+        }
+    }
+
+private:
+    static void log_stats(const char *reason);
+};
+
+static SubsCallback s_callback;
+
+void app_subs_get_stats(app_subs_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    out->fabrics = chip::Server::GetInstance().GetFabricTable().FabricCount();
+    out->subscriptions = active_subscriptions();
+    out->peak_subscriptions = s_peak_subscriptions;
+    out->established = s_established;
+    out->terminated = s_terminated;
+    out->last_sub_heap = s_last_sub_heap;
+    out->free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out->largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->heap_per_sub = (out->subscriptions && s_baseline_free > out->free)
+                        ? (s_baseline_free - out->free) / out->subscriptions : 0;
+    out->max_fabrics = CHIP_CONFIG_MAX_FABRICS;
+    out->max_subscriptions = CHIP_IM_MAX_NUM_SUBSCRIPTIONS;
+}
+
+static int format_stats(char *buf, size_t len)
+{
+    app_subs_stats_t st;
+    app_subs_get_stats(&st);
+    return snprintf(buf, len,
+                    "{\"fabrics\":%" PRIu32 ",\"subscriptions\":%" PRIu32 ",\"peak_subscriptions\":%" PRIu32
+                    ",\"established\":%" PRIu32 ",\"terminated\":%" PRIu32 ",\"last_sub_heap\":%" PRId32
+                    ",\"heap_per_sub\":%" PRIu32 ",\"free\":%" PRIu32 ",\"min_free\":%" PRIu32
+                    ",\"largest\":%" PRIu32 ",\"max_fabrics\":%" PRIu32 ",\"max_subscriptions\":%" PRIu32 "}",
+                    st.fabrics, st.subscriptions, st.peak_subscriptions, st.established, st.terminated,
+                    st.last_sub_heap, st.heap_per_sub, st.free, st.min_free, st.largest, st.max_fabrics,
+                    st.max_subscriptions);
+}
+
+void SubsCallback::log_stats(const char *reason)
+{
+    char buf[384];
+    format_stats(buf, sizeof(buf));
+    ESP_LOGI(TAG, "SUBS stats (%s): %s", reason, buf);
+}
+
+esp_err_t app_subs_init(void)
+{
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    InteractionModelEngine *engine = InteractionModelEngine::GetInstance();
+    if (engine->GetAppCallback() != &s_callback) {
+        s_callback.mNext = engine->GetAppCallback();
+        engine->RegisterReadHandlerAppCallback(&s_callback);
+    }
+    s_baseline_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+
+    ESP_LOGI(TAG, "Subscription accounting enabled (limits: %d fabrics, %d subscriptions)",
+             CHIP_CONFIG_MAX_FABRICS, CHIP_IM_MAX_NUM_SUBSCRIPTIONS);
+    return ESP_OK;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t subs_stats_handler(int argc, char **argv)
+{
+    char buf[384];
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    format_stats(buf, sizeof(buf));
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    printf("%s\n", buf);
+    return ESP_OK;
+}
+
+static esp_err_t subs_toggle_handler(int argc, char **argv)
+{
+    // Same path as button_toggle_cb
+    app_switch_toggle();
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_subs_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t commands[] = {
+        {
+            .name = "subs-stats",
+            .description = "Print fabric/subscription counts and heap per subscription as JSON",
+            .handler = subs_stats_handler,
+        },
+        {
+            .name = "subs-toggle",
+            .description = "Toggle OnOff as the button does (report fan-out timing)",
+            .handler = subs_toggle_handler,
+        },
+    };
+    return esp_matter::console::add_commands(commands, sizeof(commands) / sizeof(commands[0]));
+#else
+    return ESP_OK;
+#endif
+}
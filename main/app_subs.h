@@ -0,0 +1,53 @@
+/*
+   M5NanoC6 Matter Switch - Subscription Accounting Header
+
+   Tracks fabrics and active subscriptions with the heap each subscription
+   costs, for scaling runs with scripts/subs_bench.py.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+typedef struct {
+    uint32_t fabrics;               // Commissioned fabrics
+    uint32_t subscriptions;         // Active subscriptions (all fabrics)
+    uint32_t peak_subscriptions;
+    uint32_t established;           // Subscriptions established since boot
+    uint32_t terminated;            // Subscriptions torn down since boot
+    int32_t last_sub_heap;          // Heap taken by the last subscription (request -> established)
+    uint32_t heap_per_sub;          // Heap below the no-subscription baseline / subscriptions
+    uint32_t free;                  // Current free heap
+    uint32_t min_free;              // Lowest free heap since boot
+    uint32_t largest;               // Largest free block
+    uint32_t max_fabrics;           // Build limits
+    uint32_t max_subscriptions;
+} app_subs_stats_t;
+
+/**
+ * @brief Start subscription accounting
+ *
+ * Chains a ReadHandler application callback in front of any existing one.
+ * Call after esp_matter::start().
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_subs_init(void);
+
+/**
+ * @brief Copy current subscription statistics
+ *
+ * @param[out] out Statistics snapshot
+ */
+void app_subs_get_stats(app_subs_stats_t *out);
+
+/**
+ * @brief Register "subs-stats" and "subs-toggle" shell commands
+ *
+ * subs-toggle runs the same path as a button click, so a host can time
+ * report fan-out to all subscribers without touching the device.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_subs_register_commands(void);
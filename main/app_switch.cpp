@@ -0,0 +1,187 @@
+/*
+   M5NanoC6 Matter Switch - Application Logic
+
+   Shared between the ESP32 firmware and the Linux build (linux/BUILD.gn).
+   Only depends on the CHIP core (cluster objects, CommandHandlerInterface,
+   system timers) and logging, not on esp-matter or IDF.
+
+   OnWithTimedOff is handled here instead of by the stock On/Off server,
+   whose countdown runs a timer per endpoint: all timed state goes through
+   app_onoff_timer on one shared tick that only runs while something is
+   counting. Everything below runs on the Matter thread.
+*/
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <app-common/zap-generated/ids/Attributes.h>
+#include <app-common/zap-generated/ids/Clusters.h>
+#include <app/CommandHandlerInterface.h>
+#include <app/CommandHandlerInterfaceRegistry.h>
+#include <lib/support/logging/CHIPLogging.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <system/SystemClock.h>
+
+#include "app_onoff_timer.h"
+#include "app_switch.h"
+#include "app_switch_platform.h"
+
+using namespace chip::app::Clusters;
+using chip::Protocols::InteractionModel::Status;
+
+static uint16_t s_endpoint_id = 0;
+
+// Timed on/off state of every endpoint and the shared tick driving it
+static app_onoff_timer_t s_live_timers;
+static app_onoff_timer_t *s_timers = &s_live_timers;   // Swapped only by app_switch_bench_timers()
+static bool s_tick_armed = false;
+static chip::System::Clock::Timestamp s_next_tick;
+
+static void apply_timer_actions(uint16_t endpoint_id, uint32_t actions)
+{
+    if (actions & APP_ONOFF_TIMER_STORE) {
+        // No slot left means both counters reached zero
+        const app_onoff_timer_slot_t *slot = app_onoff_timer_get(s_timers, endpoint_id);
+        app_platform_onoff_timer_store(endpoint_id, slot ? slot->on_time : 0, slot ? slot->off_wait_time : 0,
+                                       actions & APP_ONOFF_TIMER_REPORT);
+    }
+    if (actions & APP_ONOFF_TIMER_TURN_ON) {
+        app_platform_onoff_set(endpoint_id, true);
+    }
+    if (actions & APP_ONOFF_TIMER_TURN_OFF) {
+        ChipLogProgress(AppServer, "OnOff: timed on expired on endpoint %u", endpoint_id);
+        app_platform_onoff_set(endpoint_id, false);
+    }
+}
+
+static void tick_actions_cb(const app_onoff_timer_slot_t *slot, uint32_t actions, void *arg)
+{
+    apply_timer_actions(slot->endpoint_id, actions);
+}
+
+static void arm_tick(void);
+
+static void tick_cb(chip::System::Layer *layer, void *context)
+{
+    s_tick_armed = false;
+    app_onoff_timer_tick(s_timers, tick_actions_cb, nullptr);
+    arm_tick();
+}
+
+// Start or continue the shared tick; ticks are scheduled on a fixed grid so long OnTimes do not drift
+static void arm_tick(void)
+{
+    if (s_tick_armed || !app_onoff_timer_running(s_timers)) {
+        return;
+    }
+    chip::System::Clock::Timestamp now = chip::System::SystemClock().GetMonotonicTimestamp();
+    chip::System::Clock::Milliseconds32 period(APP_ONOFF_TIMER_TICK_MS);
+    if (s_next_tick + period < now) {
+        s_next_tick = now + period;     // Idle or stalled: restart the grid
+    } else {
+        s_next_tick += period;
+    }
+    chip::System::Clock::Timeout delay = s_next_tick > now ? s_next_tick - now : chip::System::Clock::kZero;
+    if (chip::DeviceLayer::SystemLayer().StartTimer(delay, tick_cb, nullptr) == CHIP_NO_ERROR) {
+        s_tick_armed = true;
+    }
+}
+
+class TimedOnOffCommandHandler : public chip::app::CommandHandlerInterface {
+public:
+    TimedOnOffCommandHandler() : CommandHandlerInterface(chip::NullOptional, OnOff::Id) {}
+
+    void InvokeCommand(HandlerContext &ctx) override
+    {
+        // Everything else stays with the On/Off server
+        if (ctx.mRequestPath.mCommandId != OnOff::Commands::OnWithTimedOff::Id) {
+            return;
+        }
+        HandleCommand<OnOff::Commands::OnWithTimedOff::DecodableType>(
+            ctx, [](HandlerContext &ctx, const OnOff::Commands::OnWithTimedOff::DecodableType &req) {
+                uint16_t endpoint_id = ctx.mRequestPath.mEndpointId;
+                bool on = app_platform_onoff_get(endpoint_id);
+                bool accept_only_when_on = req.onOffControl.Has(OnOff::OnOffControlBitmap::kAcceptOnlyWhenOn);
+                uint32_t actions = app_onoff_timer_on_with_timed_off(s_timers, endpoint_id, on, accept_only_when_on,
+                                                                     req.onTime, req.offWaitTime);
+                if (actions & APP_ONOFF_TIMER_NO_SLOT) {
+                    ctx.mCommandHandler.AddStatus(ctx.mRequestPath, Status::ResourceExhausted);
+                    return;
+                }
+                // Discarded commands still succeed (spec: AcceptOnlyWhenOn while off)
+                ChipLogDetail(AppServer, "OnWithTimedOff: endpoint %u, on %u, off wait %u%s", endpoint_id,
+                              req.onTime, req.offWaitTime, (accept_only_when_on && !on) ? " (discarded)" : "");
+                apply_timer_actions(endpoint_id, actions);
+                arm_tick();
+                ctx.mCommandHandler.AddStatus(ctx.mRequestPath, Status::Success);
+            });
+    }
+};
+
+static TimedOnOffCommandHandler s_timed_handler;
+
+void app_switch_init(uint16_t endpoint_id)
+{
+    s_endpoint_id = endpoint_id;
+    app_onoff_timer_init(s_timers);
+    if (chip::app::CommandHandlerInterfaceRegistry::Instance().RegisterCommandHandler(&s_timed_handler) !=
+        CHIP_NO_ERROR) {
+        ChipLogError(AppServer, "OnWithTimedOff handler registration failed");
+    }
+}
+
+uint16_t app_switch_get_endpoint(void)
+{
+    return s_endpoint_id;
+}
+
+app_onoff_timer_t *app_switch_bench_timers(app_onoff_timer_t *timers)
+{
+    app_onoff_timer_t *previous = s_timers;
+    s_timers = timers ? timers : &s_live_timers;
+    return previous;
+}
+
+void app_switch_attribute_changed(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, uint32_t value)
+{
+    if (cluster_id == OnOff::Id) {
+        if (attribute_id == OnOff::Attributes::OnOff::Id) {
+            ChipLogDetail(AppServer, "OnOff: endpoint %u, value %u", endpoint_id, static_cast<unsigned>(value));
+            app_platform_led_set_power(value != 0);
+            apply_timer_actions(endpoint_id, app_onoff_timer_onoff_changed(s_timers, endpoint_id, value != 0));
+            arm_tick();
+        } else if (attribute_id == OnOff::Attributes::OnTime::Id ||
+                   attribute_id == OnOff::Attributes::OffWaitTime::Id) {
+            app_onoff_timer_attribute_written(s_timers, endpoint_id, app_platform_onoff_get(endpoint_id),
+                                              attribute_id == OnOff::Attributes::OnTime::Id,
+                                              static_cast<uint16_t>(value));
+            arm_tick();
+        }
+    } else if (cluster_id == OtaSoftwareUpdateRequestor::Id) {
+        // Nullable: null (0xFF) when no download is in progress
+        if (attribute_id == OtaSoftwareUpdateRequestor::Attributes::UpdateStateProgress::Id && value <= 100) {
+            app_platform_led_ota_progress(static_cast<uint8_t>(value));
+        }
+    }
+}
+
+void app_switch_identify(app_switch_identify_t type)
+{
+    if (type == APP_SWITCH_IDENTIFY_START || type == APP_SWITCH_IDENTIFY_EFFECT) {
+        app_platform_led_identify_start();
+    } else if (type == APP_SWITCH_IDENTIFY_STOP) {
+        app_platform_led_identify_stop(app_switch_get_power());
+    }
+}
+
+bool app_switch_get_power(void)
+{
+    return app_platform_onoff_get(s_endpoint_id);
+}
+
+void app_switch_toggle(void)
+{
+    bool current_state = app_platform_onoff_get(s_endpoint_id);
+    ChipLogDetail(AppServer, "Button: toggle %d -> %d", current_state, !current_state);
+
+    // Update the attribute (reports to subscribers and updates the LED via the attribute callback)
+    app_platform_onoff_set(s_endpoint_id, !current_state);
+}
@@ -0,0 +1,74 @@
+/*
+   M5NanoC6 Matter Switch - Application Logic Header
+
+   Platform-independent switch behaviour: attribute changes to LED,
+   identify handling, local toggle and On/Off Lighting timed on/off.
+   Builds for ESP32 (esp-matter) and for the connectedhomeip Linux
+   platform (linux/); platform specifics go through app_switch_platform.h.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_onoff_timer.h"
+
+typedef enum {
+    APP_SWITCH_IDENTIFY_START,
+    APP_SWITCH_IDENTIFY_STOP,
+    APP_SWITCH_IDENTIFY_EFFECT,
+} app_switch_identify_t;
+
+/** Set the endpoint carrying the On/Off cluster
+ *
+ * Also registers the OnWithTimedOff handler (app_onoff_timer.h) for all
+ * endpoints with the On/Off cluster.
+ *
+ * @param[in] endpoint_id Switch endpoint.
+ */
+void app_switch_init(uint16_t endpoint_id);
+
+/** Get the switch endpoint
+ *
+ * @return Endpoint passed to app_switch_init().
+ */
+uint16_t app_switch_get_endpoint(void);
+
+/** Run the OnOff timer logic on another table (benchmarking)
+ *
+ * Lets main/app_bench.cpp time app_switch_attribute_changed() without
+ * touching live OnTime/OffWaitTime countdowns. Swap in and back out
+ * within one hold of the CHIP stack lock, so the shared tick never sees
+ * the other table.
+ *
+ * @param[in] timers Table to use, or NULL for the live one.
+ * @return Table used before the call.
+ */
+app_onoff_timer_t *app_switch_bench_timers(app_onoff_timer_t *timers);
+
+/** Handle an attribute change from the data model
+ *
+ * @param[in] endpoint_id Endpoint ID.
+ * @param[in] cluster_id Cluster ID.
+ * @param[in] attribute_id Attribute ID.
+ * @param[in] value Boolean, uint8 or uint16 attribute value (OnOff, UpdateStateProgress,
+ *                  OnTime/OffWaitTime).
+ */
+void app_switch_attribute_changed(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, uint32_t value);
+
+/** Handle Identify cluster start/stop/effect
+ *
+ * @param[in] type Identify event.
+ */
+void app_switch_identify(app_switch_identify_t type);
+
+/** Get the current on/off state
+ *
+ * @return true if on.
+ */
+bool app_switch_get_power(void);
+
+/** Toggle the OnOff attribute (local button)
+ */
+void app_switch_toggle(void);
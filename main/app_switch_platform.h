@@ -0,0 +1,65 @@
+/*
+   M5NanoC6 Matter Switch - Platform Hooks
+
+   Implemented once per platform and called by the shared switch logic
+   (app_switch.cpp):
+   - ESP32: main/app_platform_esp32.cpp (WS2812 LED, esp_matter data model)
+   - Linux: linux/app_platform_linux.cpp (virtual LED, ZAP data model)
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Show on/off state on the LED
+ *
+ * @param[in] on true = on, false = off.
+ */
+void app_platform_led_set_power(bool on);
+
+/** Start the identify indication */
+void app_platform_led_identify_start(void);
+
+/** Stop the identify indication and restore the on/off state
+ *
+ * @param[in] current_power Current on/off state to restore.
+ */
+void app_platform_led_identify_stop(bool current_power);
+
+/** Show OTA download progress
+ *
+ * @param[in] percent Download progress, 0-100.
+ */
+void app_platform_led_ota_progress(uint8_t percent);
+
+/** Read the OnOff attribute
+ *
+ * @param[in] endpoint_id Switch endpoint.
+ *
+ * @return Current value, false if it cannot be read.
+ */
+bool app_platform_onoff_get(uint16_t endpoint_id);
+
+/** Write the OnOff attribute through the data model
+ *
+ * Reports go to subscribers and the attribute change comes back through
+ * app_switch_attribute_changed().
+ *
+ * @param[in] endpoint_id Switch endpoint.
+ * @param[in] on New value.
+ */
+void app_platform_onoff_set(uint16_t endpoint_id, bool on);
+
+/** Write OnTime and OffWaitTime
+ *
+ * Called from the shared 100 ms tick while a timed on/off is counting
+ * down, so it must be cheap.
+ *
+ * @param[in] endpoint_id Switch endpoint.
+ * @param[in] on_time OnTime, 1/10 s.
+ * @param[in] off_wait_time OffWaitTime, 1/10 s.
+ * @param[in] report false to update the stored value without a report
+ *                   (quieter reporting of the countdown).
+ */
+void app_platform_onoff_timer_store(uint16_t endpoint_id, uint16_t on_time, uint16_t off_wait_time, bool report);
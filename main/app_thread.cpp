@@ -0,0 +1,312 @@
+/*
+   M5NanoC6 Matter Switch - Thread Reachability
+
+   Milestones are timed from app start (esp_timer). Attach comes from the
+   kThreadStateChange platform event; SRP registration and the first CASE
+   session have no event of their own, so a SystemLayer timer polls the
+   SRP client and the secure session table until both are seen. Everything
+   runs on the Matter thread; OpenThread state is read under the Thread
+   stack lock.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <nvs.h>
+
+#include <platform/CHIPDeviceLayer.h>
+
+#include "app_thread.h"
+
+#if CHIP_DEVICE_CONFIG_ENABLE_THREAD
+
+#include <app/server/Server.h>
+#include <esp_openthread.h>
+#include <openthread/srp_client.h>
+#include <openthread/thread.h>
+#if CONFIG_OPENTHREAD_FTD
+#include <openthread/thread_ftd.h>
+#endif
+#include <platform/ThreadStackManager.h>
+#include <transport/SecureSessionTable.h>
+
+#define THREAD_NVS_NAMESPACE    "app_thread"
+#define THREAD_NVS_KEY_ROLE     "role"
+
+static const char *TAG = "app_thread";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_thread_reach_t s_reach = {};
+#if CONFIG_OPENTHREAD_FTD
+static uint8_t s_default_jitter = 0;    // Restored once the router role is back (0 = untouched)
+#endif
+
+static uint32_t now_ms(void)
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+static bool is_attached(uint8_t role)
+{
+    return role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER;
+}
+
+static const char *role_name(uint8_t role)
+{
+    switch (role) {
+    case OT_DEVICE_ROLE_DISABLED: return "disabled";
+    case OT_DEVICE_ROLE_DETACHED: return "detached";
+    case OT_DEVICE_ROLE_CHILD:    return "child";
+    case OT_DEVICE_ROLE_ROUTER:   return "router";
+    case OT_DEVICE_ROLE_LEADER:   return "leader";
+    default:                      return "unknown";
+    }
+}
+
+static uint8_t load_role(void)
+{
+    nvs_handle_t handle;
+    uint8_t role = OT_DEVICE_ROLE_DISABLED;
+    if (nvs_open(THREAD_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u8(handle, THREAD_NVS_KEY_ROLE, &role);
+        nvs_close(handle);
+    }
+    return role;
+}
+
+static void save_role(uint8_t role)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(THREAD_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_u8(handle, THREAD_NVS_KEY_ROLE, role);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store role: %s", esp_err_to_name(err));
+    }
+}
+
+static int format_reach(char *buf, size_t size)
+{
+    app_thread_reach_t r;
+    app_thread_get_reach(&r);
+    return snprintf(buf, size,
+                    "{\"attached_ms\":%" PRIu32 ",\"srp_ms\":%" PRIu32 ",\"case_ms\":%" PRIu32
+                    ",\"role\":\"%s\",\"prev_role\":\"%s\",\"attaches\":%" PRIu32 ",\"detaches\":%" PRIu32 "}",
+                    r.attached_ms, r.srp_ms, r.case_ms, role_name(r.role), role_name(r.prev_role), r.attaches,
+                    r.detaches);
+}
+
+static void report(void)
+{
+    char buf[256];
+    format_reach(buf, sizeof(buf));
+    ESP_LOGI(TAG, "THREAD reach: %s", buf);
+}
+
+// Host and every service accepted by the SRP server
+static bool srp_registered(otInstance *instance)
+{
+    const otSrpClientHostInfo *host = otSrpClientGetHostInfo(instance);
+    const otSrpClientService *services = otSrpClientGetServices(instance);
+    if (host->mState != OT_SRP_CLIENT_ITEM_STATE_REGISTERED || services == nullptr) {
+        return false;
+    }
+    for (const otSrpClientService *s = services; s != nullptr; s = s->mNext) {
+        if (s->mState != OT_SRP_CLIENT_ITEM_STATE_REGISTERED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool have_case_session(void)
+{
+    bool found = false;
+    chip::Server::GetInstance().GetSecureSessionManager().GetSecureSessions().ForEachSession(
+        [&found](chip::Transport::SecureSession *session) {
+            if (session->GetSecureSessionType() == chip::Transport::SecureSession::Type::kCASE &&
+                session->IsActiveSession()) {
+                found = true;
+                return chip::Loop::Break;
+            }
+            return chip::Loop::Continue;
+        });
+    return found;
+}
+
+static void poll_cb(chip::System::Layer *layer, void *ctx)
+{
+    uint32_t now = now_ms();
+
+    app_thread_reach_t r;
+    app_thread_get_reach(&r);
+    if (r.srp_ms == 0 && is_attached(r.role)) {
+        chip::DeviceLayer::ThreadStackMgr().LockThreadStack();
+        bool registered = srp_registered(esp_openthread_get_instance());
+        chip::DeviceLayer::ThreadStackMgr().UnlockThreadStack();
+        if (registered) {
+            r.srp_ms = now;
+        }
+    }
+    if (r.case_ms == 0 && have_case_session()) {
+        r.case_ms = now;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_reach.srp_ms = r.srp_ms;
+    s_reach.case_ms = r.case_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (r.srp_ms && r.case_ms) {
+        report();
+        return;
+    }
+    if (now >= CONFIG_APP_THREAD_REACH_TIMEOUT_S * 1000U) {
+        ESP_LOGW(TAG, "Reachability milestones incomplete after %d s", CONFIG_APP_THREAD_REACH_TIMEOUT_S);
+        report();
+        return;
+    }
+    chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Milliseconds32(CONFIG_APP_THREAD_REACH_POLL_MS),
+                                                poll_cb, nullptr);
+}
+
+static void on_role_changed(void)
+{
+    chip::DeviceLayer::ThreadStackMgr().LockThreadStack();
+    otInstance *instance = esp_openthread_get_instance();
+    uint8_t role = static_cast<uint8_t>(otThreadGetDeviceRole(instance));
+#if CONFIG_OPENTHREAD_FTD
+    if (s_default_jitter && (role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER)) {
+        otThreadSetRouterSelectionJitter(instance, s_default_jitter);
+        s_default_jitter = 0;
+    }
+#endif
+    chip::DeviceLayer::ThreadStackMgr().UnlockThreadStack();
+
+    portENTER_CRITICAL(&s_lock);
+    uint8_t old = s_reach.role;
+    s_reach.role = role;
+    if (is_attached(role) && !is_attached(old)) {
+        s_reach.attaches++;
+        if (s_reach.attached_ms == 0) {
+            s_reach.attached_ms = now_ms();
+        }
+    } else if (!is_attached(role) && is_attached(old)) {
+        s_reach.detaches++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (role != old) {
+        ESP_LOGI(TAG, "Role %s -> %s", role_name(old), role_name(role));
+    }
+    // Only attached roles are worth restoring; a detach before reboot says nothing
+    if (is_attached(role) && role != load_role()) {
+        save_role(role);
+    }
+}
+
+static void event_handler(const chip::DeviceLayer::ChipDeviceEvent *event, intptr_t arg)
+{
+    if (event->Type == chip::DeviceLayer::DeviceEventType::kThreadStateChange &&
+        event->ThreadStateChange.RoleChanged) {
+        on_role_changed();
+    }
+}
+
+esp_err_t app_thread_init(void)
+{
+    uint8_t prev_role = load_role();
+
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    s_reach.prev_role = prev_role;
+    s_reach.role = OT_DEVICE_ROLE_DISABLED;
+#if CONFIG_OPENTHREAD_FTD
+    if (prev_role == OT_DEVICE_ROLE_ROUTER || prev_role == OT_DEVICE_ROLE_LEADER) {
+        // OpenThread first tries to restore the role with a Link Request; if that fails
+        // it attaches as a child and would wait up to the full jitter before upgrading
+        chip::DeviceLayer::ThreadStackMgr().LockThreadStack();
+        otInstance *instance = esp_openthread_get_instance();
+        s_default_jitter = otThreadGetRouterSelectionJitter(instance);
+        otThreadSetRouterSelectionJitter(instance, CONFIG_APP_THREAD_ROUTER_RESTORE_JITTER_S);
+        chip::DeviceLayer::ThreadStackMgr().UnlockThreadStack();
+    }
+#endif
+    CHIP_ERROR err = chip::DeviceLayer::PlatformMgr().AddEventHandler(event_handler, 0);
+    if (err == CHIP_NO_ERROR) {
+        // The stack was started before this handler existed
+        on_role_changed();
+        err = chip::DeviceLayer::SystemLayer().StartTimer(
+            chip::System::Clock::Milliseconds32(CONFIG_APP_THREAD_REACH_POLL_MS), poll_cb, nullptr);
+    }
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to start reachability tracking: %" CHIP_ERROR_FORMAT, err.Format());
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Reachability tracking started (previous role %s)", role_name(prev_role));
+    return ESP_OK;
+}
+
+void app_thread_get_reach(app_thread_reach_t *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_reach;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t thread_reach_handler(int argc, char **argv)
+{
+    char buf[256];
+    format_reach(buf, sizeof(buf));
+    printf("%s\n", buf);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t app_thread_register_commands(void)
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    static const esp_matter::console::command_t command = {
+        .name = "thread-reach",
+        .description = "Print attach, SRP registration and first CASE times since boot as JSON",
+        .handler = thread_reach_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+#else
+    return ESP_OK;
+#endif
+}
+
+#else // !CHIP_DEVICE_CONFIG_ENABLE_THREAD
+
+esp_err_t app_thread_init(void)
+{
+    return ESP_OK;
+}
+
+void app_thread_get_reach(app_thread_reach_t *out)
+{
+    if (out) {
+        *out = {};
+    }
+}
+
+esp_err_t app_thread_register_commands(void)
+{
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+   M5NanoC6 Matter Switch - Thread Reachability Header
+
+   Times the path from boot to reachable on a Thread build: attach, SRP
+   registration of the operational service and the first CASE session.
+   Logs one "THREAD reach: {json}" line per boot so a host can collect
+   reboot cycles from the serial log (scripts/thread_reattach_bench.py runs
+   the same milestones on the OpenThread simulator).
+
+   The dataset, role, parent and SRP key are already persisted by
+   OpenThread in the "nvs" partition, so a reboot reattaches with a Child
+   Update / Link Request instead of a fresh parent search and re-registers
+   under the same SRP key. This module also persists the last role so a
+   router that comes back as a child is promoted again without waiting out
+   the full router selection jitter.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+typedef struct {
+    uint32_t attached_ms;       // First attach since boot (0 = not yet)
+    uint32_t srp_ms;            // Host and all services registered (0 = not yet)
+    uint32_t case_ms;           // First CASE session (0 = not yet)
+    uint8_t role;               // otDeviceRole now
+    uint8_t prev_role;          // otDeviceRole persisted by the previous boot
+    uint32_t attaches;          // Attach transitions since boot
+    uint32_t detaches;          // Detach transitions since boot
+} app_thread_reach_t;
+
+/**
+ * @brief Start reachability tracking
+ *
+ * Registers a platform event handler and polls SRP/CASE state until both
+ * milestones are reached or CONFIG_APP_THREAD_REACH_TIMEOUT_S passes.
+ * Does nothing on Wi-Fi builds. Call after esp_matter::start().
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_thread_init(void);
+
+/**
+ * @brief Copy the milestones reached so far this boot
+ *
+ * @param[out] out Snapshot
+ */
+void app_thread_get_reach(app_thread_reach_t *out);
+
+/**
+ * @brief Register the "thread-reach" shell command
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t app_thread_register_commands(void);
@@ -0,0 +1,127 @@
+/*
+   M5NanoC6 Matter Switch - WS2812 Driver
+
+   The simple encoder callback runs in the RMT ISR (and, with DMA, when the
+   transaction starts). It only indexes the framebuffer and copies table
+   words, so it keeps ahead of the wire: one ping-pong half is 24 symbols,
+   30 us of output.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <soc/soc_caps.h>
+
+#include "app_ws2812.h"
+
+static const char *TAG = "app_ws2812";
+
+#define WS2812_TRANS_QUEUE_DEPTH    4
+#if SOC_RMT_SUPPORT_DMA
+#define WS2812_WITH_DMA             1
+#define WS2812_MEM_BLOCK_SYMBOLS    1024    // DMA buffer
+#else
+#define WS2812_WITH_DMA             0
+#define WS2812_MEM_BLOCK_SYMBOLS    SOC_RMT_MEM_WORDS_PER_CHANNEL
+#endif
+
+static app_ws2812_lut_t s_lut;
+static bool s_lut_ready = false;
+
+static_assert(sizeof(rmt_symbol_word_t) == sizeof(uint32_t), "RMT symbol is not one word");
+
+static size_t encode_cb(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                        rmt_symbol_word_t *symbols, bool *done, void *arg)
+{
+    return app_ws2812_encode(static_cast<const app_ws2812_lut_t *>(arg), static_cast<const uint8_t *>(data),
+                             data_size, symbols_written, reinterpret_cast<uint32_t *>(symbols), symbols_free, done);
+}
+
+esp_err_t app_ws2812_init(app_ws2812_t *strip, int gpio, uint8_t *buf, uint16_t count)
+{
+    *strip = {};
+    if (!s_lut_ready) {
+        app_ws2812_lut_init(&s_lut, APP_WS2812_RESOLUTION_HZ);
+        s_lut_ready = true;
+    }
+    app_ws2812_fb_init(&strip->fb, buf, count);
+
+    rmt_tx_channel_config_t channel_config = {
+        .gpio_num = static_cast<gpio_num_t>(gpio),
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = APP_WS2812_RESOLUTION_HZ,
+        .mem_block_symbols = WS2812_MEM_BLOCK_SYMBOLS,
+        .trans_queue_depth = WS2812_TRANS_QUEUE_DEPTH,
+    };
+    channel_config.flags.with_dma = WS2812_WITH_DMA;
+    esp_err_t err = rmt_new_tx_channel(&channel_config, &strip->channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "RMT channel on GPIO %d failed: %s", gpio, esp_err_to_name(err));
+        return err;
+    }
+
+    rmt_simple_encoder_config_t encoder_config = {
+        .callback = encode_cb,
+        .arg = &s_lut,
+        .min_chunk_size = APP_WS2812_SYMBOLS_PER_BYTE,
+    };
+    err = rmt_new_simple_encoder(&encoder_config, &strip->encoder);
+    if (err == ESP_OK) {
+        err = rmt_enable(strip->channel);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "WS2812 encoder on GPIO %d failed: %s", gpio, esp_err_to_name(err));
+        if (strip->encoder) {
+            rmt_del_encoder(strip->encoder);
+        }
+        rmt_del_channel(strip->channel);
+        *strip = {};
+        return err;
+    }
+    ESP_LOGI(TAG, "WS2812 strip: %u pixels on GPIO %d (%s)", count, gpio, WS2812_WITH_DMA ? "DMA" : "ping-pong");
+    return ESP_OK;
+}
+
+void app_ws2812_set_pixel(app_ws2812_t *strip, uint16_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    app_ws2812_fb_set(&strip->fb, index, red, green, blue);
+}
+
+void app_ws2812_fill(app_ws2812_t *strip, uint16_t first, uint16_t n, uint8_t red, uint8_t green, uint8_t blue)
+{
+    app_ws2812_fb_fill(&strip->fb, first, n, red, green, blue);
+}
+
+esp_err_t app_ws2812_refresh(app_ws2812_t *strip, uint32_t timeout_ms)
+{
+    if (!strip->channel) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint16_t pixels = app_ws2812_fb_take_dirty(&strip->fb);
+    if (pixels == 0) {
+        strip->skipped++;
+        return ESP_OK;
+    }
+
+    int64_t start = esp_timer_get_time();
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    esp_err_t err = rmt_transmit(strip->channel, strip->encoder, strip->fb.grb,
+                                 static_cast<size_t>(pixels) * APP_WS2812_BYTES_PER_PIXEL, &tx_config);
+    if (err == ESP_OK) {
+        err = rmt_tx_wait_all_done(strip->channel, static_cast<int>(timeout_ms));
+    }
+    if (err != ESP_OK) {
+        // Send everything again next time: the chain state is unknown
+        strip->fb.dirty_end = strip->fb.count;
+        return err;
+    }
+
+    strip->refreshes++;
+    if (pixels < strip->fb.count) {
+        strip->partial++;
+    }
+    strip->last_pixels = pixels;
+    strip->last_us = static_cast<uint32_t>(esp_timer_get_time() - start);
+    return ESP_OK;
+}
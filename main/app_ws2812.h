@@ -0,0 +1,64 @@
+/*
+   M5NanoC6 Matter Switch - WS2812 Driver Header
+
+   WS2812 chains on RMT TX channels (driver/rmt_tx.h). Each strip owns a
+   framebuffer supplied by the caller. An RMT simple encoder streams it
+   through app_ws2812_encode(), so no symbol buffer is held per pixel. The
+   ESP32-C6 RMT has no DMA: the channel refills its ping-pong memory from
+   the encoder in its ISR. Targets with RMT DMA (SOC_RMT_SUPPORT_DMA) use it.
+
+   Not thread-safe: callers serialize access (app_driver_led_lock()).
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <driver/rmt_tx.h>
+#include <esp_err.h>
+
+#include "app_ws2812_engine.h"
+
+typedef struct app_ws2812 {
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t encoder;
+    app_ws2812_fb_t fb;
+    // Statistics
+    uint32_t refreshes;         // Frames sent
+    uint32_t partial;           // Frames that stopped before the end of the chain
+    uint32_t skipped;           // Refreshes with nothing changed
+    uint32_t last_pixels;       // Pixels sent by the last frame
+    uint32_t last_us;           // Duration of the last frame (encode + wire + latch)
+} app_ws2812_t;
+
+/**
+ * @brief Create a strip on a GPIO
+ *
+ * @param strip Strip to initialize (statically allocated by the caller)
+ * @param gpio Data GPIO
+ * @param buf Framebuffer, count * APP_WS2812_BYTES_PER_PIXEL bytes
+ * @param count Number of pixels
+ * @return ESP_OK on success
+ */
+esp_err_t app_ws2812_init(app_ws2812_t *strip, int gpio, uint8_t *buf, uint16_t count);
+
+/**
+ * @brief Set one pixel in the framebuffer (sent on the next refresh)
+ */
+void app_ws2812_set_pixel(app_ws2812_t *strip, uint16_t index, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * @brief Set pixels [first, first + n) in the framebuffer
+ */
+void app_ws2812_fill(app_ws2812_t *strip, uint16_t first, uint16_t n, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * @brief Send changed pixels and wait for the frame to latch
+ *
+ * Sends pixels up to the last one that changed; does nothing if none did.
+ *
+ * @param strip Strip
+ * @param timeout_ms Time to wait for the transmission
+ * @return ESP_OK on success
+ */
+esp_err_t app_ws2812_refresh(app_ws2812_t *strip, uint32_t timeout_ms);
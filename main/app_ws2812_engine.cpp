@@ -0,0 +1,136 @@
+/*
+   M5NanoC6 Matter Switch - WS2812 Encoding Engine
+
+   No ESP-IDF dependencies: see app_ws2812_engine.h.
+*/
+
+#include <string.h>
+
+#include "app_ws2812_engine.h"
+
+#define LEVEL_HIGH          (1U << 15)
+#define DURATION_MAX        0x7FFFU
+
+static uint32_t ns_to_ticks(uint32_t ns, uint32_t resolution_hz)
+{
+    uint64_t ticks = (static_cast<uint64_t>(ns) * resolution_hz + 500000000ULL) / 1000000000ULL;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    return ticks > DURATION_MAX ? DURATION_MAX : static_cast<uint32_t>(ticks);
+}
+
+// High for high_ns, then low for low_ns
+static uint32_t bit_symbol(uint32_t high_ns, uint32_t low_ns, uint32_t resolution_hz)
+{
+    return ns_to_ticks(high_ns, resolution_hz) | LEVEL_HIGH | (ns_to_ticks(low_ns, resolution_hz) << 16);
+}
+
+void app_ws2812_lut_init(app_ws2812_lut_t *lut, uint32_t resolution_hz)
+{
+    const uint32_t zero = bit_symbol(APP_WS2812_T0H_NS, APP_WS2812_T0L_NS, resolution_hz);
+    const uint32_t one = bit_symbol(APP_WS2812_T1H_NS, APP_WS2812_T1L_NS, resolution_hz);
+
+    for (int value = 0; value < 16; value++) {
+        for (int bit = 0; bit < 4; bit++) {
+            lut->nibble[value][bit] = (value & (0x8 >> bit)) ? one : zero;
+        }
+    }
+    // Split over both halves of the symbol: each holds at most DURATION_MAX ticks
+    uint32_t half = ns_to_ticks(APP_WS2812_RESET_US * 500U, resolution_hz);
+    lut->reset = half | (half << 16);
+}
+
+static inline void put_byte(const app_ws2812_lut_t *lut, uint8_t byte, uint32_t *out)
+{
+    memcpy(out, lut->nibble[byte >> 4], sizeof(lut->nibble[0]));
+    memcpy(out + 4, lut->nibble[byte & 0x0F], sizeof(lut->nibble[0]));
+}
+
+size_t app_ws2812_encode(const app_ws2812_lut_t *lut, const uint8_t *data, size_t len, size_t symbols_written,
+                         uint32_t *out, size_t symbols_free, bool *done)
+{
+    size_t pos = symbols_written / APP_WS2812_SYMBOLS_PER_BYTE;
+    size_t n = len - pos;
+    if (n > symbols_free / APP_WS2812_SYMBOLS_PER_BYTE) {
+        n = symbols_free / APP_WS2812_SYMBOLS_PER_BYTE;
+    }
+    const uint8_t *src = data + pos;
+    uint32_t *dst = out;
+
+    // Up to a word boundary, then four bytes per load
+    while (n > 0 && (reinterpret_cast<uintptr_t>(src) & 3U)) {
+        put_byte(lut, *src++, dst);
+        dst += APP_WS2812_SYMBOLS_PER_BYTE;
+        n--;
+    }
+    for (; n >= 4; n -= 4) {
+        uint32_t word;
+        memcpy(&word, src, sizeof(word));
+        src += 4;
+        // Wire order is memory order: byte 0 first
+        for (int i = 0; i < 4; i++) {
+            put_byte(lut, static_cast<uint8_t>(word >> (8 * i)), dst);
+            dst += APP_WS2812_SYMBOLS_PER_BYTE;
+        }
+    }
+    while (n > 0) {
+        put_byte(lut, *src++, dst);
+        dst += APP_WS2812_SYMBOLS_PER_BYTE;
+        n--;
+    }
+
+    size_t written = static_cast<size_t>(dst - out);
+    if (static_cast<size_t>(src - data) == len && written < symbols_free) {
+        out[written++] = lut->reset;
+        *done = true;
+    }
+    return written;
+}
+
+void app_ws2812_fb_init(app_ws2812_fb_t *fb, uint8_t *buf, uint16_t count)
+{
+    fb->grb = buf;
+    fb->count = count;
+    memset(buf, 0, static_cast<size_t>(count) * APP_WS2812_BYTES_PER_PIXEL);
+    fb->dirty_end = count;
+}
+
+bool app_ws2812_fb_set(app_ws2812_fb_t *fb, uint16_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    if (index >= fb->count) {
+        return false;
+    }
+    uint8_t *p = fb->grb + static_cast<size_t>(index) * APP_WS2812_BYTES_PER_PIXEL;
+    if (p[0] == green && p[1] == red && p[2] == blue) {
+        return false;
+    }
+    p[0] = green;
+    p[1] = red;
+    p[2] = blue;
+    if (index >= fb->dirty_end) {
+        fb->dirty_end = index + 1;
+    }
+    return true;
+}
+
+uint16_t app_ws2812_fb_fill(app_ws2812_fb_t *fb, uint16_t first, uint16_t n, uint8_t red, uint8_t green,
+                            uint8_t blue)
+{
+    uint16_t changed = 0;
+    uint32_t end = static_cast<uint32_t>(first) + n;
+    if (end > fb->count) {
+        end = fb->count;
+    }
+    for (uint32_t i = first; i < end; i++) {
+        changed += app_ws2812_fb_set(fb, static_cast<uint16_t>(i), red, green, blue) ? 1 : 0;
+    }
+    return changed;
+}
+
+uint16_t app_ws2812_fb_take_dirty(app_ws2812_fb_t *fb)
+{
+    uint16_t n = fb->dirty_end;
+    fb->dirty_end = 0;
+    return n;
+}
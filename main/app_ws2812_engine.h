@@ -0,0 +1,109 @@
+/*
+   M5NanoC6 Matter Switch - WS2812 Encoding Engine
+
+   Hardware-independent framebuffer and RMT symbol encoder for WS2812
+   chains. Pixels live in one contiguous buffer in wire order (G, R, B).
+   The encoder turns those bytes into 32-bit RMT symbol words in the
+   layout of rmt_symbol_word_t (duration0:15, level0:1, duration1:15,
+   level1:1). It reads the buffer a 32-bit word at a time and emits four
+   precomputed symbol words per nibble from a 256-byte table, with no
+   per-bit branches. It keeps no state between calls: the position comes
+   from the number of symbols already written. So it can refill an RMT
+   ping-pong buffer or DMA buffer in whatever chunks the driver asks for.
+   scripts/ws2812_bench.py builds this file for the host.
+
+   Partial updates stay cheap. Writes that do not change a pixel are
+   dropped. A refresh only sends pixels up to the last one that changed,
+   because pixels past the end of a frame keep their latched color.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_WS2812_RESOLUTION_HZ    10000000    // 0.1 us RMT ticks
+#define APP_WS2812_BYTES_PER_PIXEL  3
+#define APP_WS2812_SYMBOLS_PER_BYTE 8
+#define APP_WS2812_T0H_NS           300
+#define APP_WS2812_T0L_NS           900
+#define APP_WS2812_T1H_NS           900
+#define APP_WS2812_T1L_NS           300
+#define APP_WS2812_RESET_US         300         // Latch: line low for at least 280 us
+
+typedef struct {
+    uint32_t nibble[16][4];     // Symbol words for each nibble value, MSB first
+    uint32_t reset;             // Low-only symbol that latches the frame
+} app_ws2812_lut_t;
+
+typedef struct {
+    uint8_t *grb;               // count * 3 bytes, wire order
+    uint16_t count;
+    uint16_t dirty_end;         // Pixels [0, dirty_end) must be sent (0 = nothing changed)
+} app_ws2812_fb_t;
+
+/**
+ * @brief Build the symbol table for an RMT tick rate
+ *
+ * @param lut Table to fill
+ * @param resolution_hz RMT channel resolution
+ */
+void app_ws2812_lut_init(app_ws2812_lut_t *lut, uint32_t resolution_hz);
+
+/**
+ * @brief Encode the next chunk of a frame
+ *
+ * Writes whole bytes only (8 symbols each), then the reset symbol. Returns
+ * 0 without setting *done if not even one byte fits.
+ *
+ * @param lut Symbol table
+ * @param data Bytes to send
+ * @param len Number of bytes to send
+ * @param symbols_written Symbols already written for this frame
+ * @param out Symbol words to fill
+ * @param symbols_free Room in out
+ * @param[out] done Set once the reset symbol has been written
+ * @return Number of symbol words written
+ */
+size_t app_ws2812_encode(const app_ws2812_lut_t *lut, const uint8_t *data, size_t len, size_t symbols_written,
+                         uint32_t *out, size_t symbols_free, bool *done);
+
+/**
+ * @brief Attach a buffer and mark every pixel for sending
+ *
+ * @param fb Framebuffer
+ * @param buf count * APP_WS2812_BYTES_PER_PIXEL bytes (cleared to black)
+ * @param count Number of pixels
+ */
+void app_ws2812_fb_init(app_ws2812_fb_t *fb, uint8_t *buf, uint16_t count);
+
+/**
+ * @brief Set one pixel; out-of-range indices are ignored
+ *
+ * @return true if the pixel changed
+ */
+bool app_ws2812_fb_set(app_ws2812_fb_t *fb, uint16_t index, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * @brief Set pixels [first, first + n), clipped to the strip
+ *
+ * @return Number of pixels that changed
+ */
+uint16_t app_ws2812_fb_fill(app_ws2812_fb_t *fb, uint16_t first, uint16_t n, uint8_t red, uint8_t green,
+                            uint8_t blue);
+
+/**
+ * @brief Take the pixels that need sending and mark the buffer clean
+ *
+ * @return Number of pixels to send from the start of the chain (0 = skip the refresh)
+ */
+uint16_t app_ws2812_fb_take_dirty(app_ws2812_fb_t *fb);
+
+#ifdef __cplusplus
+}
+#endif
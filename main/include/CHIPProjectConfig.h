@@ -26,3 +26,13 @@
  * Run 'make generate-pairing' to regenerate with new random values.
  */
 #include "CHIPPairingConfig.h"
+
+/*
+ * Subscription Resumption
+ * Subscriptions are stored in NVS; after a reboot the device re-establishes
+ * CASE to each subscriber and resumes them, instead of waiting for the
+ * controller to notice the dropped subscription (up to its max interval).
+ */
+#ifndef CHIP_CONFIG_PERSIST_SUBSCRIPTIONS
+#define CHIP_CONFIG_PERSIST_SUBSCRIPTIONS 1
+#endif
@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+"""
+Build and check runtime configuration blobs for the appcfg partition
+
+The firmware reads LED colors, blink periods and button/reset timings from
+the "appcfg" partition when it holds a valid blob, and falls back to the
+defaults compiled from main/app_priv.h otherwise (main/app_config.h). The
+format is described in main/app_config_engine.h.
+
+A configuration is a JSON object with any subset of the fields printed by
+`defaults`. Missing fields take the compiled defaults of the selected
+transport (Thread or WiFi: the config ID colors differ). Colors are
+[r, g, b] lists.
+
+Blobs are checked by main/app_config_engine.cpp, which is built for the
+host, so the tool applies exactly the checks the firmware applies.
+`selftest` compares the tool's encoder with the engine and checks that
+corrupted, truncated and out-of-range blobs are rejected.
+
+Usage:
+    python3 scripts/app_config_tool.py defaults [--wifi] > config.json
+    python3 scripts/app_config_tool.py build config.json -o build/appcfg.bin [--wifi]
+    python3 scripts/app_config_tool.py check build/appcfg.bin [--json]
+    python3 scripts/app_config_tool.py selftest
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import re
+import shutil
+import struct
+import sys
+import tempfile
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PRIV_HEADER = os.path.join(REPO_ROOT, 'main', 'app_priv.h')
+
+MAGIC = 0x47464341
+VERSION = 1
+HEADER = struct.Struct('<IHHI')
+PARTITION_SIZE = 0x1000     # partitions.csv
+
+# Wire order of app_config_t with the app_priv.h defines that provide the defaults
+TIMINGS = [
+    ('identify_blink_ms', 'LED_IDENTIFY_BLINK_MS'),
+    ('ota_blink_ms', 'LED_OTA_BLINK_MS'),
+    ('led_refresh_timeout_ms', 'LED_REFRESH_TIMEOUT_MS'),
+    ('button_debounce_ms', 'BUTTON_DEBOUNCE_MS'),
+    ('button_long_press_ms', 'BUTTON_LONG_PRESS_MS'),
+    ('id_bit_ms', 'FIRMWARE_CONFIG_ID_BIT_DELAY_MS'),
+    ('id_pattern_gap_ms', 'FIRMWARE_CONFIG_ID_PATTERN_DELAY_MS'),
+    ('reset_start_delay_ms', 'FIRMWARE_CONFIG_ID_START_DELAY_MS'),
+    ('reset_result_ms', 'FIRMWARE_CONFIG_ID_RESULT_MS'),
+]
+COUNTS = [
+    ('id_bits', 'FIRMWARE_CONFIG_ID_BITS'),
+    ('reset_repeat_count', 'FIRMWARE_CONFIG_ID_REPEAT_COUNT'),
+    ('identify_repeat_count', 'IDENTIFY_CONFIG_ID_REPEAT_COUNT'),
+]
+COLORS = [
+    ('on', ('LED_COLOR_ON_R', 'LED_COLOR_ON_G', 'LED_COLOR_ON_B')),
+    ('off', ('LED_COLOR_OFF_R', 'LED_COLOR_OFF_G', 'LED_COLOR_OFF_B')),
+    ('identify', ('LED_COLOR_IDENTIFY_R', 'LED_COLOR_IDENTIFY_G', 'LED_COLOR_IDENTIFY_B')),
+    ('bit_1', ('LED_COLOR_BIT_1_R', 'LED_COLOR_BIT_1_G', 'LED_COLOR_BIT_1_B')),
+    ('bit_0', ('LED_COLOR_BIT_0_R', 'LED_COLOR_BIT_0_G', 'LED_COLOR_BIT_0_B')),
+    ('cancel', ('LED_COLOR_CANCEL_R', 'LED_COLOR_CANCEL_G', 'LED_COLOR_CANCEL_B')),
+    ('confirm', ('LED_COLOR_CONFIRM_R', 'LED_COLOR_CONFIRM_G', 'LED_COLOR_CONFIRM_B')),
+    ('ota_min', ('LED_COLOR_OTA_R', 'LED_COLOR_OTA_GB_MIN', 'LED_COLOR_OTA_GB_MIN')),
+    ('ota_max', ('LED_COLOR_OTA_R', 'LED_COLOR_OTA_GB_MAX', 'LED_COLOR_OTA_GB_MAX')),
+]
+PAYLOAD = struct.Struct('<' + 'H' * len(TIMINGS) + 'B' * len(COUNTS) + 'B' * 3 * len(COLORS) + '2x')
+STATUS_NAMES = ['ok', 'erased', 'bad-magic', 'bad-version', 'bad-length', 'bad-crc', 'bad-value']
+
+
+def priv_defines(thread):
+    """Integer #defines of app_priv.h, taking the Thread or WiFi branch of the transport #if."""
+    defines = {}
+    branch = []         # Per open #if: True if its lines apply
+    with open(PRIV_HEADER) as f:
+        for line in f:
+            line = line.split('//')[0].strip()
+            if line.startswith('#if'):
+                applies = thread if 'CHIP_DEVICE_CONFIG_ENABLE_THREAD' in line else True
+                branch.append(applies)
+            elif line.startswith('#else'):
+                branch[-1] = not branch[-1]
+            elif line.startswith('#endif'):
+                branch.pop()
+            elif all(branch):
+                m = re.match(r'#define\s+(\w+)\s+(\w+)$', line)
+                if m:
+                    defines[m.group(1)] = m.group(2)
+
+    def value(name):
+        token = defines[name]
+        return int(token, 0) if token[0].isdigit() else value(token)
+
+    return {name: value(name) for name in defines if defines[name][0].isdigit() or defines[name] in defines}
+
+
+def defaults(thread):
+    d = priv_defines(thread)
+    config = {name: d[macro] for name, macro in TIMINGS + COUNTS}
+    config.update({name: [d[m] for m in macros] for name, macros in COLORS})
+    return config
+
+
+def encode_payload(config):
+    values = [config[name] for name, _ in TIMINGS + COUNTS]
+    for name, _ in COLORS:
+        values += config[name]
+    return PAYLOAD.pack(*values)
+
+
+def decode_payload(payload):
+    values = list(PAYLOAD.unpack_from(payload))
+    config = {}
+    for name, _ in TIMINGS + COUNTS:
+        config[name] = values.pop(0)
+    for name, _ in COLORS:
+        config[name] = values[:3]
+        del values[:3]
+    return config
+
+
+def encode_blob(payload, version=VERSION, magic=MAGIC):
+    return HEADER.pack(magic, version, len(payload), zlib.crc32(payload)) + payload
+
+
+def merge(base, overrides):
+    config = dict(base)
+    for key, val in overrides.items():
+        if key not in config:
+            raise ValueError(f'unknown field "{key}" (see `defaults` for the list)')
+        if isinstance(config[key], list):
+            if not (isinstance(val, list) and len(val) == 3 and all(isinstance(c, int) and 0 <= c <= 255
+                                                                   for c in val)):
+                raise ValueError(f'"{key}" must be [r, g, b] with 0-255 channels')
+        elif not (isinstance(val, int) and 0 <= val <= (0xFFFF if key.endswith('_ms') else 0xFF)):
+            raise ValueError(f'"{key}" must be an integer in the field range')
+        config[key] = val
+    return config
+
+
+class Engine:
+    """main/app_config_engine.cpp built for the host."""
+
+    def __init__(self, workdir):
+        self.lib = host_engine.build(workdir, 'app_config_engine', ['app_config_engine.cpp'])
+        self.lib.app_config_blob_check.argtypes = [ctypes.c_char_p, ctypes.c_size_t,
+                                                   ctypes.POINTER(ctypes.c_void_p)]
+        self.lib.app_config_values_check.argtypes = [ctypes.c_char_p]
+        self.lib.app_config_values_check.restype = ctypes.c_char_p
+        self.lib.app_config_blob_build.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+        self.lib.app_config_blob_build.restype = ctypes.c_size_t
+
+    def check(self, blob):
+        """(status name, payload offset or None, first bad field or None)"""
+        buf = ctypes.create_string_buffer(bytes(blob), len(blob))
+        out = ctypes.c_void_p()
+        status = self.lib.app_config_blob_check(buf, len(blob), ctypes.byref(out))
+        offset = out.value - ctypes.addressof(buf) if status == 0 else None
+        bad = None
+        if STATUS_NAMES[status] == 'bad-value':
+            bad = self.lib.app_config_values_check(bytes(blob[HEADER.size:])).decode()
+        return STATUS_NAMES[status], offset, bad
+
+    def build(self, payload):
+        out = ctypes.create_string_buffer(HEADER.size + len(payload))
+        size = self.lib.app_config_blob_build(payload, out)
+        return out.raw[:size]
+
+
+def with_engine(fn):
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_appcfg_')
+    try:
+        return fn(Engine(workdir))
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+
+def cmd_defaults(args):
+    print(json.dumps(defaults(not args.wifi), indent=2))
+
+
+def cmd_build(args):
+    with open(args.config) as f:
+        overrides = json.load(f)
+    try:
+        config = merge(defaults(not args.wifi), overrides)
+    except ValueError as e:
+        sys.exit(f'Error: {e}')
+    blob = encode_blob(encode_payload(config))
+
+    status, _, bad = with_engine(lambda engine: engine.check(blob))
+    if status != 'ok':
+        sys.exit(f'Error: firmware would reject this blob ({status}{": " + bad if bad else ""})')
+
+    # Pad with the erased value: flashing the whole partition leaves nothing stale behind
+    image = blob + b'\xff' * (PARTITION_SIZE - len(blob))
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    changed = sorted(k for k in overrides if overrides[k] != defaults(not args.wifi)[k])
+    print(f'Wrote {args.output}: {len(blob)}-byte blob v{VERSION}, crc32 0x{zlib.crc32(blob[HEADER.size:]):08x}, '
+          f'{len(changed)} field(s) differ from the {"WiFi" if args.wifi else "Thread"} defaults'
+          f'{": " + ", ".join(changed) if changed else ""}')
+
+
+def cmd_check(args):
+    with open(args.blob, 'rb') as f:
+        blob = f.read()
+    status, offset, bad = with_engine(lambda engine: engine.check(blob))
+    result = {'status': status}
+    if len(blob) >= HEADER.size:
+        magic, version, length, crc = HEADER.unpack_from(blob)
+        result.update({'version': version, 'length': length, 'crc32': f'0x{crc:08x}'})
+    if bad:
+        result['bad_field'] = bad
+    if offset is not None:
+        result['config'] = decode_payload(blob[offset:])
+    if args.json:
+        print(json.dumps(result, indent=2))
+    else:
+        print(f"{args.blob}: {status}{' (' + bad + ')' if bad else ''}")
+        for key, val in result.get('config', {}).items():
+            print(f'  {key:24} {val}')
+    sys.exit(0 if status == 'ok' else 1)
+
+
+def selftest_cases(engine):
+    failures = []
+
+    def expect(name, blob, want_status, want_field=None):
+        status, _, bad = engine.check(blob)
+        if status != want_status or (want_field and bad != want_field):
+            failures.append(f'{name}: got {status}/{bad}, want {want_status}/{want_field}')
+
+    cases = 0
+    for thread in (True, False):
+        config = defaults(thread)
+        payload = encode_payload(config)
+        blob = encode_blob(payload)
+        label = 'thread' if thread else 'wifi'
+
+        if engine.build(payload) != blob:
+            failures.append(f'{label}: tool and engine encode differently')
+        expect(f'{label} defaults', blob, 'ok')
+        status, offset, _ = engine.check(blob + b'\xff' * (PARTITION_SIZE - len(blob)))
+        if status != 'ok' or decode_payload(blob[offset:]) != config:
+            failures.append(f'{label}: padded blob does not decode to the defaults')
+        cases += 3
+
+    config = defaults(True)
+    payload = encode_payload(config)
+    blob = encode_blob(payload)
+
+    expect('erased', b'\xff' * PARTITION_SIZE, 'erased')
+    expect('short partition', blob[:8], 'bad-length')
+    expect('bad magic', encode_blob(payload, magic=0x12345678), 'bad-magic')
+    expect('bad version', encode_blob(payload, version=VERSION + 1), 'bad-version')
+    expect('truncated payload', encode_blob(payload[:-1]), 'bad-length')
+    expect('length past the partition', blob[:-1], 'bad-length')
+    expect('appended field', encode_blob(payload + b'\x07\x00'), 'ok')
+    cases += 7
+
+    # Any single corrupted payload byte must fail the CRC
+    for i in range(HEADER.size, len(blob)):
+        corrupt = bytearray(blob)
+        corrupt[i] ^= 0x5A
+        expect(f'payload byte {i - HEADER.size}', bytes(corrupt), 'bad-crc')
+        cases += 1
+
+    # Range checks, one field at a time
+    bad_values = {
+        'identify_blink_ms': [19, 10001], 'ota_blink_ms': [0, 10001], 'led_refresh_timeout_ms': [9, 1001],
+        'button_debounce_ms': [0, 201], 'button_long_press_ms': [299, 10001, config['button_debounce_ms']],
+        'id_bit_ms': [49, 5001], 'id_pattern_gap_ms': [10001], 'reset_start_delay_ms': [10001],
+        'reset_result_ms': [10001], 'id_bits': [0, 9], 'reset_repeat_count': [0, 21],
+        'identify_repeat_count': [0, 21],
+    }
+    for field, values in bad_values.items():
+        for val in values:
+            expect(f'{field}={val}', encode_blob(encode_payload(dict(config, **{field: val}))), 'bad-value', field)
+            cases += 1
+    reserved = bytearray(payload)
+    reserved[-1] = 1
+    expect('reserved byte set', encode_blob(bytes(reserved)), 'bad-value', 'reserved')
+    cases += 1
+    return cases, failures
+
+
+def cmd_selftest(args):
+    cases, failures = with_engine(selftest_cases)
+    for failure in failures:
+        print(f'FAIL {failure}')
+    print(f'{cases - len(failures)}/{cases} checks passed ({PAYLOAD.size}-byte payload, '
+          f'{HEADER.size + PAYLOAD.size}-byte blob)')
+    sys.exit(1 if failures else 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Build and check runtime configuration blobs for the appcfg partition',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('defaults', help='Print the compiled defaults as JSON')
+    p.add_argument('--wifi', action='store_true', help='WiFi build defaults (default: Thread)')
+    p.set_defaults(func=cmd_defaults)
+
+    p = sub.add_parser('build', help='Build a partition image from a JSON configuration')
+    p.add_argument('config', help='JSON object with the fields to change')
+    p.add_argument('-o', '--output', required=True, help='Partition image to write (4 KB)')
+    p.add_argument('--wifi', action='store_true', help='Fill missing fields from the WiFi defaults')
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser('check', help='Check a blob or partition dump the way the firmware does')
+    p.add_argument('blob', help='Partition image or dump')
+    p.add_argument('--json', action='store_true', help='Print results as JSON')
+    p.set_defaults(func=cmd_check)
+
+    p = sub.add_parser('selftest', help='Check the encoder and the firmware checks against each other')
+    p.set_defaults(func=cmd_selftest)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
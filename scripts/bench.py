@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+"""
+Time the toggle and LED hot paths and compare them with checked-in baselines
+
+Two targets, same JSON result format:
+
+  device  Sends "matter bench" over the serial console and reads the JSON
+          line it prints (main/app_bench.cpp). Cycles per call, from the
+          CPU cycle counter, for the attribute dispatch, the OnOff get_val,
+          the state word load, the LED lock, set_pixel + refresh, and the
+          identify timer period change. --log reads the line from a saved
+          monitor log instead.
+  host    Builds the portable engines on those paths for the host and times
+          them in batches: button gesture detection, OnOff timer dispatch,
+          framebuffer update + symbol encoding, and the deferred log
+          capture. Nanoseconds per call.
+
+Each case median is compared with scripts/bench_baselines.json (section
+"host" or the device target, e.g. "esp32c6"). A case fails when it is slower
+than its baseline by more than the tolerance. Faster cases are reported so
+the baseline can be tightened. A case without a baseline fails as well,
+so a target whose baselines were never recorded cannot pass. --update
+writes the measured medians into the baselines file. Exit status is 1 on
+any regression, missing baseline or call that reported an error (0 with
+--update).
+
+Usage:
+    python3 scripts/bench.py host
+    python3 scripts/bench.py device --port /dev/ttyACM0
+    python3 scripts/bench.py device --log logs/monitor_20260101_120000.log --json
+    python3 scripts/bench.py host --update
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+ENGINE_SRCS = ['app_button_engine.cpp', 'app_onoff_timer.cpp', 'app_ws2812_engine.cpp', 'app_log_engine.cpp']
+BASELINES = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'bench_baselines.json')
+RESULT_PREFIX = '{"bench":'
+
+# One function per case; each call is one pass through the path, i varies the input
+HARNESS_SRC = r'''
+#include <chrono>
+#include <stdint.h>
+#include <string.h>
+
+#include "app_button_engine.h"
+#include "app_log_engine.h"
+#include "app_onoff_timer.h"
+#include "app_ws2812_engine.h"
+
+static volatile uint32_t s_sink;
+
+static app_button_engine_t s_button;
+static int64_t s_now_us;
+
+static app_onoff_timer_t s_timers;
+
+static app_ws2812_lut_t s_lut;
+static app_ws2812_fb_t s_fb;
+static uint8_t s_grb[APP_WS2812_BYTES_PER_PIXEL];
+static uint32_t s_symbols[APP_WS2812_BYTES_PER_PIXEL * 8 + 1];
+
+static app_log_slot_t s_slots[64];
+static app_log_ring_t s_ring;
+static app_log_record_t s_out;
+
+static void setup(void)
+{
+    s_now_us = 0;
+    app_button_engine_init(&s_button, 20, 1500, false, s_now_us);
+    app_onoff_timer_init(&s_timers);
+    app_ws2812_lut_init(&s_lut, APP_WS2812_RESOLUTION_HZ);
+    app_ws2812_fb_init(&s_fb, s_grb, 1);
+    app_log_ring_init(&s_ring, s_slots, 64);
+}
+
+// Press, release 80 ms later, then the sample at the engine's deadline (single click)
+static void button_click(uint32_t i)
+{
+    s_now_us += 2000000;
+    uint32_t events = app_button_engine_feed(&s_button, s_now_us, true);
+    events |= app_button_engine_feed(&s_button, s_now_us + 80000, false);
+    int64_t deadline = app_button_engine_next_deadline(&s_button);
+    if (deadline != APP_BUTTON_NO_DEADLINE) {
+        events |= app_button_engine_feed(&s_button, deadline, false);
+    }
+    s_sink = events;
+}
+
+// Timer side of app_switch_attribute_changed for an OnOff write
+static void onoff_changed(uint32_t i)
+{
+    s_sink = app_onoff_timer_onoff_changed(&s_timers, 1, i & 1);
+}
+
+// CPU part of app_ws2812_set_pixel + app_ws2812_refresh for the on-board pixel
+static void led_set_encode(uint32_t i)
+{
+    app_ws2812_fb_set(&s_fb, 0, 0, 0, 128 ^ (i & 1));
+    uint16_t pixels = app_ws2812_fb_take_dirty(&s_fb);
+    bool done = false;
+    size_t written = 0;
+    while (!done) {
+        written += app_ws2812_encode(&s_lut, s_fb.grb, pixels * APP_WS2812_BYTES_PER_PIXEL, written,
+                                     s_symbols, sizeof(s_symbols) / sizeof(s_symbols[0]), &done);
+    }
+    s_sink = s_symbols[0];
+}
+
+static void led_set_unchanged(uint32_t i)
+{
+    app_ws2812_fb_set(&s_fb, 0, 0, 0, 128);
+    s_sink = app_ws2812_fb_take_dirty(&s_fb);
+}
+
+// APP_LOGD in app_driver_led_set_power, then the log task taking the record
+static void log_capture(uint32_t i)
+{
+    uint32_t pos;
+    app_log_record_t *record = app_log_ring_claim(&s_ring, &pos);
+    if (record) {
+        app_log_capture(record, APP_LOG_DEBUG, "app_driver", i, "LED set to %s", (i & 1) ? "ON" : "OFF");
+        app_log_ring_commit(&s_ring, pos);
+    }
+    s_sink = app_log_ring_take(&s_ring, &s_out);
+}
+
+static const struct {
+    const char *name;
+    void (*op)(uint32_t);
+} s_cases[] = {
+    {"button_click", button_click},
+    {"onoff_changed", onoff_changed},
+    {"led_set_encode", led_set_encode},
+    {"led_set_unchanged", led_set_unchanged},
+    {"log_capture", log_capture},
+};
+
+extern "C" int bench_case_count(void)
+{
+    return sizeof(s_cases) / sizeof(s_cases[0]);
+}
+
+extern "C" const char *bench_case_name(int index)
+{
+    return s_cases[index].name;
+}
+
+// ns per call for each batch
+extern "C" void bench_run(int index, int batches, int calls, double *ns_per_call)
+{
+    setup();
+    void (*op)(uint32_t) = s_cases[index].op;
+    for (int i = 0; i < calls; i++) {
+        op(i);      // Warm-up
+    }
+    for (int b = 0; b < batches; b++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) {
+            op(i);
+        }
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        ns_per_call[b] = ns / calls;
+    }
+}
+'''
+
+
+def build_engine(workdir):
+    """Compile the engines and the timing harness into a shared library."""
+    # The log capture copies "ON"/"OFF" with a bound of the record's free space, which GCC flags
+    lib = host_engine.build(workdir, 'bench', ENGINE_SRCS, harness=HARNESS_SRC, flags=['-Wno-stringop-overread'])
+    lib.bench_case_count.restype = ctypes.c_int
+    lib.bench_case_name.argtypes = [ctypes.c_int]
+    lib.bench_case_name.restype = ctypes.c_char_p
+    lib.bench_run.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_double)]
+    return lib
+
+
+def summarize(samples):
+    ordered = sorted(samples)
+    n = len(ordered)
+    return {'n': n, 'min': ordered[0], 'median': ordered[n // 2], 'p90': ordered[n * 9 // 10],
+            'max': ordered[-1], 'errors': 0}
+
+
+def run_host(args):
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_bench_')
+    try:
+        lib = build_engine(workdir)
+        compiler = subprocess.run([host_engine.find_cxx(), '--version'], capture_output=True, text=True).stdout.splitlines()[0]
+        cases = []
+        for index in range(lib.bench_case_count()):
+            name = lib.bench_case_name(index).decode()
+            if args.case and name != args.case:
+                continue
+            samples = (ctypes.c_double * args.batches)()
+            lib.bench_run(index, args.batches, args.calls, samples)
+            case = {'name': name}
+            case.update({k: round(v, 2) if isinstance(v, float) else v for k, v in summarize(list(samples)).items()})
+            cases.append(case)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+    if args.case and not cases:
+        sys.exit(f'Error: unknown host case "{args.case}"')
+    return {'target': 'host', 'unit': 'ns', 'machine': platform.machine(), 'compiler': compiler,
+            'calls_per_batch': args.calls, 'cases': cases}
+
+
+def find_result(lines):
+    result = None
+    for line in lines:
+        start = line.find(RESULT_PREFIX)
+        if start >= 0:
+            try:
+                result = json.loads(line[start:].strip())['bench']
+            except ValueError:
+                continue        # Line cut by other console output; keep looking
+    return result
+
+
+def run_device(args):
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            result = find_result(f)
+        if not result:
+            sys.exit(f'Error: no bench result in {args.log}')
+        return result
+
+    try:
+        import serial
+    except ImportError:
+        sys.exit('Error: pyserial library not found. Install with: pip install pyserial')
+    with serial.Serial(args.port, args.baud, timeout=1) as port:
+        port.reset_input_buffer()
+        port.write(f'matter bench {args.case or "all"} {args.iterations}\n'.encode())
+        deadline = time.monotonic() + args.timeout
+        while time.monotonic() < deadline:
+            result = find_result([port.readline().decode('utf-8', errors='replace')])
+            if result:
+                return result
+    sys.exit(f'Error: no bench result from {args.port} within {args.timeout} s')
+
+
+def compare(result, baselines):
+    section = baselines.get(result['target'], {})
+    if section.get('unit', result['unit']) != result['unit']:
+        sys.exit(f"Error: baseline unit {section['unit']} does not match result unit {result['unit']}")
+    default_tolerance = section.get('tolerance', 0.1)
+    rows = []
+    for case in result['cases']:
+        row = {'name': case['name'], 'median': case.get('median')}
+        base = section.get('cases', {}).get(case['name'])
+        if case.get('skipped'):
+            row['status'] = 'skipped'
+        elif case.get('errors'):
+            row['status'] = 'errors'
+        elif base is None:
+            row['status'] = 'new'
+        else:
+            tolerance = base.get('tolerance', default_tolerance)
+            row.update({'baseline': base['median'], 'tolerance': tolerance,
+                        'change': round(case['median'] / base['median'] - 1, 3) if base['median'] else None})
+            if case['median'] > base['median'] * (1 + tolerance):
+                row['status'] = 'regression'
+            elif case['median'] < base['median'] * (1 - tolerance):
+                row['status'] = 'faster'
+            else:
+                row['status'] = 'ok'
+        rows.append(row)
+    return rows
+
+
+def update_baselines(result, baselines):
+    section = baselines.setdefault(result['target'], {'unit': result['unit'], 'tolerance': 0.1, 'cases': {}})
+    section['unit'] = result['unit']
+    section['recorded'] = {k: result[k] for k in ('version', 'cpu_mhz', 'transport', 'machine', 'compiler')
+                           if k in result}
+    cases = section.setdefault('cases', {})
+    for case in result['cases']:
+        if not case.get('skipped') and not case.get('errors'):
+            entry = cases.setdefault(case['name'], {})
+            entry['median'] = case['median']
+    with open(BASELINES, 'w') as f:
+        json.dump(baselines, f, indent=2)
+        f.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Time the toggle and LED hot paths and compare them with checked-in baselines',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    sub = parser.add_subparsers(dest='target', required=True)
+
+    p = sub.add_parser('host', help='Time the portable engines on the host (ns per call)')
+    p.add_argument('--batches', type=int, default=51, help='Timed batches per case (default: 51)')
+    p.add_argument('--calls', type=int, default=20000, help='Calls per batch (default: 20000)')
+
+    p_dev = sub.add_parser('device', help='Run "matter bench" on the device (cycles per call)')
+    source = p_dev.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='Device serial port')
+    source.add_argument('--log', help='Monitor log containing a bench result line')
+    p_dev.add_argument('--baud', type=int, default=115200, help='Serial baud rate (default: 115200)')
+    p_dev.add_argument('--iterations', type=int, default=64, help='Calls per case, 1-256 (default: 64)')
+    p_dev.add_argument('--timeout', type=int, default=30, help='Seconds to wait for the result (default: 30)')
+
+    for p in (p, p_dev):
+        p.add_argument('--case', help='Run one case only')
+        p.add_argument('--update', action='store_true', help='Write the measured medians into the baselines')
+        p.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+
+    result = run_host(args) if args.target == 'host' else run_device(args)
+    with open(BASELINES) as f:
+        baselines = json.load(f)
+    rows = compare(result, baselines)
+    if args.update:
+        update_baselines(result, baselines)
+
+    failed = [r for r in rows if r['status'] in ('regression', 'errors', 'new')]
+    if args.json:
+        print(json.dumps({'result': result, 'comparison': rows}, indent=2))
+    else:
+        extra = f"{result['cpu_mhz']} MHz, {result.get('version', '?')}" if 'cpu_mhz' in result else \
+            f"{result['machine']}, {result['compiler']}"
+        print(f"Target {result['target']} ({extra}), {result['unit']} per call, median vs baseline:")
+        for row in rows:
+            if row['status'] in ('skipped', 'errors', 'new'):
+                detail = '' if row['median'] is None else f"{row['median']:>10}"
+            else:
+                detail = f"{row['median']:>10} vs {row['baseline']:>10} ({row['change']:+.1%}, " \
+                         f"tolerance {row['tolerance']:.0%})"
+            print(f"  {row['name']:22} {row['status']:10} {detail}")
+        if args.update:
+            print(f'Baselines updated: {os.path.relpath(BASELINES, REPO_ROOT)}')
+        elif any(r['status'] == 'new' for r in rows):
+            print(f"No baseline for the cases marked new: record them with --update (target {result['target']})")
+    sys.exit(1 if failed and not args.update else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""
+Replay button bounce traces through the firmware's debounce/gesture engine
+
+Builds main/app_button_engine.cpp for the host and drives it the way the
+button task does: app_button_engine_feed() on every edge, and again at
+app_button_engine_next_deadline() with the line level at that time. The
+events it returns are checked against the presses in the trace:
+
+  - exactly one PRESS_DOWN per bounced press, at its first pressed edge
+  - chatter inside the debounce lockout raises no events
+  - SINGLE_CLICK on release when the press was not longer than the long
+    press time, otherwise LONG_PRESS_START exactly that long after the press
+    and no click (a release at exactly the long press time is fed before
+    the deadline sample, so it is a click)
+
+Traces are grouped into bursts: edges closer together than the debounce
+time belong to one press or release. A burst that bounces for longer than
+the lockout, or that ends at the level it started from (a glitch), is
+reported as a trace problem, since the engine does not promise one event
+for it.
+
+Built-in traces cover clicks just either side of the long press time,
+chatter up to the end of the lockout, fast double clicks, and randomly
+generated presses. Recorded traces are CSV files with t_us,pressed rows
+(pressed = 1 while the button is down, active low already inverted), one
+row per edge, as exported from a logic analyzer.
+
+Usage:
+    python3 scripts/button_replay.py
+    python3 scripts/button_replay.py --trace press_capture.csv --json
+    python3 scripts/button_replay.py --presses 5000 --seed 7 --max-bounce-ms 19
+"""
+
+import argparse
+import csv
+import ctypes
+import json
+import os
+import random
+import re
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+PRESS_DOWN, PRESS_UP, SINGLE_CLICK, LONG_PRESS_START = 1, 2, 4, 8
+NO_DEADLINE = 2**63 - 1
+EVENT_NAMES = {PRESS_DOWN: 'PRESS_DOWN', PRESS_UP: 'PRESS_UP', SINGLE_CLICK: 'SINGLE_CLICK',
+               LONG_PRESS_START: 'LONG_PRESS_START'}
+
+
+class Engine(ctypes.Structure):
+    _fields_ = [('debounce_us', ctypes.c_int64), ('long_press_us', ctypes.c_int64),
+                ('last_change_us', ctypes.c_int64), ('pressed_at_us', ctypes.c_int64),
+                ('raw_pressed', ctypes.c_bool), ('pressed', ctypes.c_bool), ('long_fired', ctypes.c_bool)]
+
+
+def build_engine(workdir):
+    """Compile the engine into a shared library and bind its functions."""
+    lib = host_engine.build(workdir, 'app_button_engine', ['app_button_engine.cpp'])
+    lib.app_button_engine_init.argtypes = [ctypes.POINTER(Engine), ctypes.c_uint32, ctypes.c_uint32, ctypes.c_bool,
+                                           ctypes.c_int64]
+    lib.app_button_engine_feed.argtypes = [ctypes.POINTER(Engine), ctypes.c_int64, ctypes.c_bool]
+    lib.app_button_engine_feed.restype = ctypes.c_uint32
+    lib.app_button_engine_next_deadline.argtypes = [ctypes.POINTER(Engine)]
+    lib.app_button_engine_next_deadline.restype = ctypes.c_int64
+    return lib
+
+
+def priv_define(name, fallback):
+    """Integer #define from main/app_priv.h (the firmware's button timings)."""
+    try:
+        with open(os.path.join(host_engine.MAIN_DIR, 'app_priv.h')) as f:
+            match = re.search(rf'#define\s+{name}\s+(\d+)', f.read())
+    except OSError:
+        match = None
+    return int(match.group(1)) if match else fallback
+
+
+def replay(lib, edges, debounce_ms, long_press_ms):
+    """Feed edges and deadlines as button_task does.
+
+    Returns [(t_us, event bits)] and a failure string if a deadline sample
+    left the deadline where it was (the task would spin on it).
+    """
+    engine = Engine()
+    start_us = edges[0][0] - 1000000 if edges else 0
+    lib.app_button_engine_init(ctypes.byref(engine), debounce_ms, long_press_ms, False, start_us)
+    level = False
+    events = []
+    i = 0
+    sampled_at = None
+    while True:
+        deadline = lib.app_button_engine_next_deadline(ctypes.byref(engine))
+        if i < len(edges) and edges[i][0] <= deadline:
+            t_us, level = edges[i]
+            i += 1
+        elif deadline == sampled_at:
+            return events, f'deadline {deadline} us not advanced by sampling at it'
+        elif deadline != NO_DEADLINE:
+            t_us = sampled_at = deadline    # Queue wait timed out: sample the line
+        else:
+            break
+        bits = lib.app_button_engine_feed(ctypes.byref(engine), t_us, level)
+        if bits:
+            events.append((t_us, bits))
+    return events, None
+
+
+def group_presses(edges, debounce_ms):
+    """Split a trace into presses [(down_us, up_us or None)] and a list of trace problems."""
+    debounce_us = debounce_ms * 1000
+    presses = []
+    problems = []
+    chatter = 0
+    level = False
+    i = 0
+    while i < len(edges):
+        j = i
+        while j + 1 < len(edges) and edges[j + 1][0] - edges[j][0] < debounce_us:
+            j += 1
+        burst = edges[i:j + 1]
+        i = j + 1
+        changes = [t for t, pressed in burst if pressed != level]
+        if not changes:
+            continue                # Same level re-read after a missed edge
+        first = changes[0]
+        chatter += sum(1 for t, _ in burst if t > first)
+        if burst[-1][1] == level:
+            problems.append(f'glitch at {first} us: back to {"pressed" if level else "released"} '
+                            f'after {(burst[-1][0] - first) / 1000:.1f} ms')
+            continue
+        if burst[-1][0] - first >= debounce_us:
+            problems.append(f'bounce at {first} us lasts {(burst[-1][0] - first) / 1000:.1f} ms, '
+                            f'longer than the {debounce_ms} ms lockout')
+        level = burst[-1][1]
+        if level:
+            presses.append([first, None])
+        else:
+            presses[-1][1] = first
+    return presses, problems, chatter
+
+
+def check(events, presses, long_press_ms):
+    """Compare engine events with the presses; returns failure strings."""
+    long_us = long_press_ms * 1000
+    expected = []
+    for down, up in presses:
+        expected.append((down, PRESS_DOWN))
+        if up is None or up - down > long_us:
+            expected.append((down + long_us, LONG_PRESS_START))
+        if up is not None:
+            expected.append((up, PRESS_UP | (SINGLE_CLICK if up - down <= long_us else 0)))
+    # One entry per event bit, so events raised by the same feed compare regardless of grouping
+    got = sorted((t, bit) for t, bits in events for bit in EVENT_NAMES if bits & bit)
+    want = sorted((t, bit) for t, bits in expected for bit in EVENT_NAMES if bits & bit)
+    failures = []
+    for t, bit in sorted(set(got) - set(want)):
+        failures.append(f'unexpected {EVENT_NAMES[bit]} at {t} us')
+    for t, bit in sorted(set(want) - set(got)):
+        failures.append(f'missing {EVENT_NAMES[bit]} at {t} us')
+    if not failures and len(got) != len(want):
+        failures.append(f'{len(got)} events, expected {len(want)} (duplicates)')
+    return failures
+
+
+def bounce(rng, t_us, pressed, max_bounce_us):
+    """Edges of one transition: chatter for up to max_bounce_us, ending at the new level.
+
+    The ISR reads the level after the edge, so a fast bounce can be seen as
+    the same level twice; some reads are flipped to the settled level.
+    """
+    edges = [(t_us, pressed)]
+    end_us = t_us + rng.randint(0, max_bounce_us)
+    t = t_us
+    level = pressed
+    while True:
+        t += rng.randint(50, 3000)
+        if t >= end_us:
+            break
+        level = not level
+        edges.append((t, pressed if rng.random() < 0.2 else level))
+    if edges[-1][1] != pressed:
+        edges.append((min(t, end_us), pressed))
+    return edges
+
+
+def trace_from_holds(rng, holds_ms, gap_ms, max_bounce_us):
+    """Presses with the given hold times, gap_ms apart, each edge bounced."""
+    edges = []
+    t_us = 1000000
+    for hold_ms in holds_ms:
+        edges += bounce(rng, t_us, True, max_bounce_us)
+        t_us += int(hold_ms * 1000)
+        edges += bounce(rng, t_us, False, max_bounce_us)
+        t_us += int(gap_ms * 1000)
+    return edges
+
+
+def builtin_traces(args, debounce_ms, long_press_ms):
+    rng = random.Random(args.seed)
+    lockout_us = debounce_ms * 1000 - 100   # Chatter that ends just inside the lockout
+    max_bounce_us = int(args.max_bounce_ms * 1000)
+    traces = {
+        'click': trace_from_holds(rng, [120], 500, max_bounce_us),
+        'click_below_long': trace_from_holds(rng, [long_press_ms - 1], 500, max_bounce_us),
+        'release_at_long': trace_from_holds(rng, [long_press_ms], 500, max_bounce_us),
+        'long_above': trace_from_holds(rng, [long_press_ms + 1, 5000], 500, max_bounce_us),
+        'chatter_to_lockout': trace_from_holds(rng, [80, 300, long_press_ms + 200], 400, lockout_us),
+        'double_click': trace_from_holds(rng, [60, 60], 3 * debounce_ms, max_bounce_us),
+    }
+    # Bounce can last up to the lockout, so holds and gaps stay above it
+    floor_ms = 2 * debounce_ms
+    holds = [rng.choice([rng.uniform(floor_ms, 400), rng.uniform(400, 4000)]) for _ in range(args.presses)]
+    holds = [h if abs(h - long_press_ms) > 1 else h + 2 for h in holds]     # 1 ms either side is covered above
+    edges = []
+    t_us = 1000000
+    for hold_ms in holds:
+        edges += bounce(rng, t_us, True, max_bounce_us)
+        t_us += int(hold_ms * 1000)
+        edges += bounce(rng, t_us, False, max_bounce_us)
+        t_us += int(rng.uniform(floor_ms, 2000) * 1000)
+    traces[f'random_{args.presses}'] = edges
+    return traces
+
+
+def load_trace(path):
+    edges = []
+    with open(path, newline='') as f:
+        for row in csv.reader(f):
+            if not row or not row[0].strip().isdigit():
+                continue            # Header or comment
+            edges.append((int(row[0]), row[1].strip() not in ('0', 'false', 'False')))
+    edges.sort(key=lambda e: e[0])
+    return edges
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Replay button bounce traces through the firmware debounce/gesture engine',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--trace', action='append', default=[], help='Recorded trace CSV (t_us,pressed), repeatable')
+    parser.add_argument('--presses', type=int, default=2000, help='Random presses to generate (default: 2000)')
+    parser.add_argument('--max-bounce-ms', type=float, default=15,
+                        help='Longest generated bounce, below the debounce time (default: 15)')
+    parser.add_argument('--seed', type=int, default=1, help='Random seed (default: 1)')
+    parser.add_argument('--debounce-ms', type=int, default=priv_define('BUTTON_DEBOUNCE_MS', 20),
+                        help='Lockout after an accepted edge (default: app_priv.h)')
+    parser.add_argument('--long-press-ms', type=int, default=priv_define('BUTTON_LONG_PRESS_MS', 1500),
+                        help='Long press time (default: app_priv.h)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+
+    if args.max_bounce_ms >= args.debounce_ms:
+        sys.exit(f'Error: --max-bounce-ms must be below the {args.debounce_ms} ms debounce time')
+
+    traces = {os.path.basename(path): load_trace(path) for path in args.trace}
+    traces.update(builtin_traces(args, args.debounce_ms, args.long_press_ms))
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_button_')
+    try:
+        lib = build_engine(workdir)
+        results = []
+        for name, edges in traces.items():
+            presses, problems, chatter = group_presses(edges, args.debounce_ms)
+            events, stuck = replay(lib, edges, args.debounce_ms, args.long_press_ms)
+            failures = problems + ([stuck] if stuck else []) + check(events, presses, args.long_press_ms)
+            results.append({
+                'trace': name,
+                'edges': len(edges),
+                'presses': len(presses),
+                'long_presses': sum(1 for d, u in presses if u is None or u - d > args.long_press_ms * 1000),
+                'chatter_edges': chatter,
+                'events': len(events),
+                'failures': failures,
+            })
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    failed = [r for r in results if r['failures']]
+    if args.json:
+        print(json.dumps({'debounce_ms': args.debounce_ms, 'long_press_ms': args.long_press_ms,
+                          'traces': results}, indent=2))
+    else:
+        print(f'Debounce {args.debounce_ms} ms, long press {args.long_press_ms} ms')
+        for r in results:
+            status = 'FAIL' if r['failures'] else 'ok'
+            print(f"  {r['trace']:22} {status:5} {r['presses']:5} presses ({r['long_presses']} long), "
+                  f"{r['edges']:6} edges, {r['chatter_edges']:6} chatter edges ignored")
+            for failure in r['failures'][:10]:
+                print(f'      {failure}')
+            if len(r['failures']) > 10:
+                print(f"      ... {len(r['failures']) - 10} more")
+        print(f'{len(results) - len(failed)}/{len(results)} traces passed')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,379 @@
+#!/usr/bin/env python3
+"""
+Decode a flash dump of the persistent event log partition
+
+Reads the "evlog" partition (read it with `make evlog-dump`, or
+`esptool read_flash 0x3E6000 0x10000 evlog.bin`), and prints the records
+oldest first, grouped by boot. Format: main/app_evlog_engine.h.
+
+With --elf, panic addresses are resolved with riscv32-esp-elf-addr2line
+when it is on PATH.
+
+--selftest builds main/app_evlog_engine.cpp for the host. It writes
+several boots of random records through a simulated NOR flash, including
+ring wrap-around and a write torn by power loss. The dump is then decoded
+and checked against what was written.
+
+Usage:
+    python3 scripts/evlog_decode.py evlog.bin
+    python3 scripts/evlog_decode.py evlog.bin --elf build/M5NanoC6-Switch.elf
+    python3 scripts/evlog_decode.py evlog.bin --json
+    python3 scripts/evlog_decode.py --selftest
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+SECTOR_SIZE = 4096
+MAGIC = 0x474C5645
+SECTOR_HEADER = 8
+CHUNK_HEADER = 4
+CHUNK_MAX = SECTOR_SIZE - SECTOR_HEADER - CHUNK_HEADER
+MAX_ARGS = 15
+
+BOOT, EVENT, BUTTON, RESET, OTA, PANIC, LOST = range(1, 8)
+TYPE_NAMES = {BOOT: 'boot', EVENT: 'event', BUTTON: 'button', RESET: 'reset', OTA: 'ota', PANIC: 'panic',
+              LOST: 'lost'}
+
+RESET_REASONS = ['unknown', 'power-on', 'external', 'software', 'panic', 'interrupt-wdt', 'task-wdt', 'wdt',
+                 'deep-sleep', 'brownout', 'sdio', 'usb', 'jtag', 'efuse', 'power-glitch', 'cpu-lockup']
+EVENTS = {1: 'ip-changed', 2: 'commissioning-complete', 3: 'fail-safe-expired', 4: 'session-started',
+          5: 'session-stopped', 6: 'window-opened', 7: 'window-closed', 8: 'fabric-removed',
+          9: 'fabric-will-be-removed', 10: 'fabric-updated', 11: 'fabric-committed', 12: 'ble-deinitialized',
+          13: 'server-ready'}
+BUTTON_GESTURES = {1 << 2: 'single-click', 1 << 3: 'long-press'}
+RESET_KINDS = {1: 'factory-reset', 2: 'restart'}
+OTA_OUTCOMES = {1: 'started', 2: 'complete', 3: 'failed', 4: 'aborted', 5: 'apply-failed'}
+PANIC_EXCEPTIONS = ['debug', 'interrupt-wdt', 'task-wdt', 'abort', 'fault', 'cache-error']
+MCAUSE = {0: 'instruction address misaligned', 1: 'instruction access fault', 2: 'illegal instruction',
+          3: 'breakpoint', 4: 'load address misaligned', 5: 'load access fault', 6: 'store address misaligned',
+          7: 'store access fault', 8: 'ecall (U)', 11: 'ecall (M)'}
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError('truncated varint')
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def parse_chunk(payload):
+    """Records of one chunk as (uptime_ms, type, args)."""
+    records = []
+    uptime, pos = varint(payload, 0)
+    while pos < len(payload):
+        header, pos = varint(payload, pos)
+        dt, pos = varint(payload, pos)
+        args = []
+        for _ in range(header & 0xF):
+            value, pos = varint(payload, pos)
+            args.append(value)
+        uptime += dt
+        records.append((uptime, header >> 4, args))
+    return records
+
+
+def decode(dump):
+    """All records oldest first as dicts, plus per-sector notes."""
+    sectors = []
+    for index in range(len(dump) // SECTOR_SIZE):
+        base = index * SECTOR_SIZE
+        magic, seq = struct.unpack_from('<II', dump, base)
+        if magic == MAGIC and seq != 0xFFFFFFFF:
+            sectors.append((seq, index))
+    sectors.sort()
+
+    records = []
+    notes = []
+    for seq, index in sectors:
+        base = index * SECTOR_SIZE
+        offset = SECTOR_HEADER
+        while offset + CHUNK_HEADER <= SECTOR_SIZE:
+            length, crc = struct.unpack_from('<HH', dump, base + offset)
+            if length == 0xFFFF:
+                break
+            payload = dump[base + offset + CHUNK_HEADER:base + offset + CHUNK_HEADER + length]
+            if length == 0 or offset + CHUNK_HEADER + length > SECTOR_SIZE or crc16(payload) != crc:
+                notes.append(f'sector {index} (seq {seq}): torn chunk at offset {offset}, rest of sector skipped')
+                break
+            try:
+                chunk = parse_chunk(payload)
+            except ValueError as e:
+                notes.append(f'sector {index} (seq {seq}): malformed chunk at offset {offset}: {e}')
+                break
+            for uptime, rtype, args in chunk:
+                records.append({'seq': seq, 'uptime_ms': uptime, 'type': rtype, 'args': args})
+            offset += CHUNK_HEADER + length
+    return records, notes
+
+
+def resolve(addr2line, elf, address):
+    if not addr2line or not elf or not address:
+        return ''
+    out = subprocess.run([addr2line, '-pfiaC', '-e', elf, f'0x{address:x}'], capture_output=True, text=True)
+    return out.stdout.strip().split(': ', 1)[-1]
+
+
+def describe(record, addr2line=None, elf=None):
+    rtype, args = record['type'], record['args']
+    arg = args + [0] * 2
+    if rtype == BOOT:
+        reason = RESET_REASONS[arg[0]] if arg[0] < len(RESET_REASONS) else str(arg[0])
+        return f'boot reason={reason} elf={arg[1]:08x}'
+    if rtype == EVENT:
+        return f'event {EVENTS.get(arg[0], arg[0])}'
+    if rtype == BUTTON:
+        gestures = [name for bit, name in BUTTON_GESTURES.items() if arg[0] & bit]
+        return f"button {'+'.join(gestures) or hex(arg[0])}"
+    if rtype == RESET:
+        return f'reset {RESET_KINDS.get(arg[0], arg[0])}'
+    if rtype == OTA:
+        return f'ota {OTA_OUTCOMES.get(arg[0], arg[0])} bytes={arg[1]}'
+    if rtype == PANIC:
+        core, exception, mcause, mepc, mtval, ra, sp = (args + [0] * 7)[:7]
+        name = PANIC_EXCEPTIONS[exception] if exception < len(PANIC_EXCEPTIONS) else str(exception)
+        lines = [f'panic core={core} {name} mcause={mcause} ({MCAUSE.get(mcause & 0x7FFFFFFF, "?")}) '
+                 f'mtval=0x{mtval:08x} sp=0x{sp:08x}',
+                 f'      mepc=0x{mepc:08x} {resolve(addr2line, elf, mepc)}'.rstrip(),
+                 f'      ra  =0x{ra:08x} {resolve(addr2line, elf, ra)}'.rstrip()]
+        if args[7:]:
+            lines.append('      stack ' + ' '.join(f'{w:08x}' for w in args[7:]))
+        return '\n'.join(lines)
+    if rtype == LOST:
+        return f'lost {arg[0]} records (buffers full)'
+    return f'type {rtype} args={args}'
+
+
+def print_records(records, notes, elf):
+    addr2line = shutil.which('riscv32-esp-elf-addr2line') if elf else None
+    boot = 0
+    for record in records:
+        if record['type'] == BOOT:
+            boot += 1
+            print(f'--- boot {boot} ---')
+        ms = record['uptime_ms']
+        print(f"  {ms // 3600000:3d}:{ms // 60000 % 60:02d}:{ms // 1000 % 60:02d}.{ms % 1000:03d}  "
+              f"{describe(record, addr2line, elf)}")
+    for note in notes:
+        print(f'Note: {note}')
+    print(f'{len(records)} records, {boot} boots')
+
+
+# ---------------------------------------------------------------------------
+# Self-test against the firmware engine
+# ---------------------------------------------------------------------------
+
+class Buffer(ctypes.Structure):
+    _fields_ = [('magic', ctypes.c_uint32), ('order', ctypes.c_uint32), ('last_ms', ctypes.c_uint32),
+                ('len', ctypes.c_uint16), ('data', ctypes.c_uint8 * CHUNK_MAX)]
+
+
+READ_FN = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p, ctypes.c_uint32)
+WRITE_FN = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p, ctypes.c_uint32)
+ERASE_FN = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_uint32)
+
+
+class Flash(ctypes.Structure):
+    _fields_ = [('read', READ_FN), ('write', WRITE_FN), ('erase_sector', ERASE_FN), ('ctx', ctypes.c_void_p),
+                ('sector_count', ctypes.c_uint32)]
+
+
+class Ring(ctypes.Structure):
+    _fields_ = [('flash', Flash), ('sector', ctypes.c_uint32), ('offset', ctypes.c_uint32),
+                ('seq', ctypes.c_uint32), ('erases', ctypes.c_uint32), ('chunks', ctypes.c_uint32),
+                ('bytes', ctypes.c_uint32), ('errors', ctypes.c_uint32)]
+
+
+class SimFlash:
+    """NOR flash: erase sets 0xFF, programming can only clear bits."""
+
+    def __init__(self, sectors):
+        self.data = bytearray(b'\xff' * sectors * SECTOR_SIZE)
+        self.tear_after = None      # Bytes still programmed before a simulated power loss
+        self.erases = 0
+        self.read = READ_FN(self._read)
+        self.write = WRITE_FN(self._write)
+        self.erase = ERASE_FN(self._erase)
+
+    def _read(self, ctx, offset, buf, length):
+        ctypes.memmove(buf, bytes(self.data[offset:offset + length]), length)
+        return 0
+
+    def _write(self, ctx, offset, buf, length):
+        src = ctypes.string_at(buf, length)
+        if self.tear_after is not None:
+            src = src[:self.tear_after]
+            self.tear_after = max(0, self.tear_after - length)
+        for i, byte in enumerate(src):
+            self.data[offset + i] &= byte
+        return 0 if len(src) == length else -1
+
+    def _erase(self, ctx, offset):
+        self.data[offset:offset + SECTOR_SIZE] = b'\xff' * SECTOR_SIZE
+        self.erases += 1
+        return 0
+
+
+def build_engine(workdir):
+    """Compile the engine into a shared library and bind its functions."""
+    lib = host_engine.build(workdir, 'app_evlog_engine', ['app_evlog_engine.cpp'])
+    lib.app_evlog_buffer_reset.argtypes = [ctypes.POINTER(Buffer), ctypes.c_uint32]
+    lib.app_evlog_buffer_add.argtypes = [ctypes.POINTER(Buffer), ctypes.c_uint8, ctypes.c_uint32,
+                                         ctypes.POINTER(ctypes.c_uint32), ctypes.c_uint8]
+    lib.app_evlog_buffer_add.restype = ctypes.c_bool
+    lib.app_evlog_ring_open.argtypes = [ctypes.POINTER(Ring), ctypes.POINTER(Flash)]
+    lib.app_evlog_ring_append.argtypes = [ctypes.POINTER(Ring), ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint16]
+    return lib
+
+
+def random_record(rng):
+    rtype = rng.choice([EVENT, EVENT, BUTTON, OTA, RESET, PANIC, LOST])
+    if rtype == PANIC:
+        args = [0, 4, 7, rng.getrandbits(32), rng.getrandbits(32), rng.getrandbits(32), 0x4080_0000 + rng.randrange(1 << 16)]
+        args += [rng.getrandbits(32) for _ in range(4)]
+    elif rtype == OTA:
+        args = [rng.randrange(1, 6), rng.randrange(1 << 21)]
+    else:
+        args = [rng.randrange(1, 14)]
+    return rtype, args
+
+
+def selftest(args):
+    rng = random.Random(args.seed)
+    flash = SimFlash(args.sectors)
+    committed = []          # Records of chunks that reached flash intact, in write order
+    torn = 0
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_evlog_')
+    try:
+        lib = build_engine(workdir)
+        for boot in range(args.boots):
+            desc = Flash(flash.read, flash.write, flash.erase, None, args.sectors)
+            ring = Ring()
+            if lib.app_evlog_ring_open(ctypes.byref(ring), ctypes.byref(desc)):
+                sys.exit('Error: ring_open failed')
+            buf = Buffer()
+            lib.app_evlog_buffer_reset(ctypes.byref(buf), 1)
+            pending = []
+            power_lost = False
+
+            def write_chunk():
+                nonlocal power_lost, torn
+                if boot == args.boots // 2 and not power_lost and rng.random() < 0.5:
+                    flash.tear_after = CHUNK_HEADER + buf.len // 2      # Power lost mid-chunk
+                    power_lost = True
+                err = lib.app_evlog_ring_append(ctypes.byref(ring), buf.data, buf.len)
+                if power_lost:
+                    flash.tear_after = None
+                    torn += 1
+                    return False
+                if err:
+                    sys.exit(f'Error: ring_append failed ({err})')
+                committed.extend(pending)
+                return True
+
+            t = rng.randrange(100, 5000)
+            events = [(BOOT, [rng.randrange(1, 8), rng.getrandbits(32)])]
+            events += [random_record(rng) for _ in range(rng.randrange(50, 2500))]
+            for rtype, rargs in events:
+                t += rng.choice([0, 1, 20, 300, 5000, 70000])
+                arr = (ctypes.c_uint32 * MAX_ARGS)(*rargs)
+                if not lib.app_evlog_buffer_add(ctypes.byref(buf), rtype, t, arr, len(rargs)):
+                    if not write_chunk():
+                        break
+                    lib.app_evlog_buffer_reset(ctypes.byref(buf), 1)
+                    pending = []
+                    if not lib.app_evlog_buffer_add(ctypes.byref(buf), rtype, t, arr, len(rargs)):
+                        sys.exit('Error: record does not fit an empty buffer')
+                pending.append({'uptime_ms': t, 'type': rtype, 'args': list(rargs)})
+            if not power_lost and buf.len:
+                write_chunk()       # Shutdown flush
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    records, notes = decode(bytes(flash.data))
+    got = [(r['uptime_ms'], r['type'], r['args']) for r in records]
+    want = [(r['uptime_ms'], r['type'], r['args']) for r in committed]
+    ok = bool(got) and got == want[len(want) - len(got):]
+    result = {
+        'boots': args.boots,
+        'sectors': args.sectors,
+        'erases': flash.erases,
+        'wrapped': flash.erases > args.sectors,
+        'records_written': len(want),
+        'records_decoded': len(got),
+        'torn_chunks': torn,
+        'notes': notes,
+        'match': ok,
+    }
+    if args.json:
+        print(json.dumps(result, indent=2))
+    else:
+        print(f"Wrote {len(want)} records in {args.boots} boots, {flash.erases} sector erases "
+              f"({'wrapped' if result['wrapped'] else 'no wrap'}), {torn} torn chunk(s)")
+        for note in notes:
+            print(f'Note: {note}')
+        print(f"Decoded {len(got)} newest records: {'match' if ok else 'MISMATCH'}")
+    sys.exit(0 if ok else 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decode a flash dump of the persistent event log partition',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('dump', nargs='?', help='Raw dump of the evlog partition')
+    parser.add_argument('--elf', help='Firmware ELF to resolve panic addresses')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    parser.add_argument('--selftest', action='store_true', help='Check the decoder against the firmware engine')
+    parser.add_argument('--seed', type=int, default=1, help='Self-test random seed (default: 1)')
+    parser.add_argument('--boots', type=int, default=12, help='Self-test boots (default: 12)')
+    parser.add_argument('--sectors', type=int, default=16, help='Self-test partition sectors (default: 16)')
+    args = parser.parse_args()
+
+    if args.selftest:
+        selftest(args)
+    if not args.dump:
+        parser.error('dump file required (or --selftest)')
+
+    with open(args.dump, 'rb') as f:
+        dump = f.read()
+    if len(dump) % SECTOR_SIZE:
+        sys.exit(f'Error: dump size {len(dump)} is not a multiple of {SECTOR_SIZE}')
+    records, notes = decode(dump)
+
+    if args.json:
+        for record in records:
+            record['name'] = TYPE_NAMES.get(record['type'], str(record['type']))
+        print(json.dumps({'records': records, 'notes': notes}, indent=2))
+    else:
+        print_records(records, notes, args.elf)
+
+
+if __name__ == '__main__':
+    main()
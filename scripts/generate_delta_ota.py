@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+Generate and verify delta OTA images for the Matter OTA requestor
+
+A delta image is a compressed binary diff (detools, heatshrink) between the
+firmware currently running on the device and the new firmware. With
+CONFIG_ENABLE_DELTA_OTA the OTA requestor applies it as a stream while the
+BDX download is in progress: reads come from the running partition, writes go
+to the update partition and esp_ota_end() validates the SHA-256 appended to
+the reconstructed image.
+
+Usage:
+    # Create a delta and wrap it in a Matter OTA image
+    python3 scripts/generate_delta_ota.py create base.bin new.bin -o delta.bin \\
+        --ota-image delta.ota --version 2 --version-str 1.1
+
+    # Apply the delta on the host and check the result matches new.bin
+    python3 scripts/generate_delta_ota.py verify base.bin delta.ota new.bin
+"""
+
+import argparse
+import hashlib
+import io
+import os
+import struct
+import subprocess
+import sys
+
+try:
+    import detools
+except ImportError:
+    print("Error: detools library not found. Install with: pip install detools")
+    sys.exit(1)
+
+# Delta patch header expected by esp_delta_ota:
+#   magic (4 bytes, LE) | SHA-256 of the base image (32 bytes) | reserved (28 bytes)
+DELTA_OTA_MAGIC = 0xfccdde10
+DELTA_OTA_HEADER_SIZE = 64
+DIGEST_SIZE = 32
+
+# Matter OTA image header (src/app/ota_image_tool.py)
+MATTER_OTA_FILE_ID = 0x1BEEF11E
+
+ESP_IMAGE_MAGIC = 0xE9
+
+# Thread 802.15.4 PHY rate, used for the transfer time estimate
+THREAD_BITRATE = 250000
+
+
+def read_app_image(path):
+    """Read an ESP-IDF app image and return (data, appended SHA-256).
+
+    The build appends a SHA-256 of the image; that digest is what the device
+    compares against the running partition before applying a delta.
+    """
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < DIGEST_SIZE or data[0] != ESP_IMAGE_MAGIC:
+        raise ValueError(f"{path}: not an ESP app image")
+    digest = data[-DIGEST_SIZE:]
+    if hashlib.sha256(data[:-DIGEST_SIZE]).digest() != digest:
+        raise ValueError(f"{path}: no valid appended SHA-256 digest")
+    return data, digest
+
+
+def strip_matter_ota_header(data):
+    """Return the payload of a Matter OTA image, or data unchanged if not wrapped."""
+    if len(data) < 16:
+        return data
+    file_id, total_size, header_size = struct.unpack_from('<IQI', data, 0)
+    if file_id != MATTER_OTA_FILE_ID:
+        return data
+    if total_size != len(data):
+        raise ValueError(f"Matter OTA image size mismatch: header {total_size}, file {len(data)}")
+    return data[16 + header_size:]
+
+
+def find_ota_image_tool():
+    """Locate connectedhomeip's ota_image_tool.py."""
+    esp_matter_path = os.environ.get('ESP_MATTER_PATH', '')
+    tool = os.path.join(esp_matter_path, 'connectedhomeip/connectedhomeip/src/app/ota_image_tool.py')
+    return tool if esp_matter_path and os.path.exists(tool) else None
+
+
+def cmd_create(args):
+    base, base_digest = read_app_image(args.base)
+    new, _ = read_app_image(args.new)
+
+    patch = io.BytesIO()
+    detools.create_patch(io.BytesIO(base), io.BytesIO(new), patch, compression='heatshrink')
+
+    header = struct.pack('<I', DELTA_OTA_MAGIC) + base_digest
+    header += bytes(DELTA_OTA_HEADER_SIZE - len(header))
+    delta = header + patch.getvalue()
+
+    with open(args.output, 'wb') as f:
+        f.write(delta)
+
+    print(f"Base image:  {args.base} ({len(base)} bytes, sha256 {base_digest.hex()[:16]}...)")
+    print(f"New image:   {args.new} ({len(new)} bytes)")
+    print(f"Delta:       {args.output} ({len(delta)} bytes, {100.0 * len(delta) / len(new):.1f}% of full image)")
+    print(f"Thread airtime at 250 kbit/s: full {len(new) * 8 / THREAD_BITRATE:.0f}s, "
+          f"delta {len(delta) * 8 / THREAD_BITRATE:.0f}s (payload only)")
+
+    if args.ota_image:
+        tool = find_ota_image_tool()
+        if not tool:
+            print("Error: ota_image_tool.py not found. Set ESP_MATTER_PATH to wrap the delta in a Matter OTA image")
+            sys.exit(1)
+        subprocess.run([sys.executable, tool, 'create',
+                        '-v', hex(args.vendor_id), '-p', hex(args.product_id),
+                        '-vn', str(args.version), '-vs', args.version_str,
+                        '-da', 'sha256', args.output, args.ota_image], check=True)
+        print(f"OTA image:   {args.ota_image}")
+
+
+def cmd_verify(args):
+    base, base_digest = read_app_image(args.base)
+    new, new_digest = read_app_image(args.new)
+
+    with open(args.delta, 'rb') as f:
+        delta = strip_matter_ota_header(f.read())
+
+    magic, = struct.unpack_from('<I', delta, 0)
+    if magic != DELTA_OTA_MAGIC:
+        print(f"FAIL: bad delta magic 0x{magic:08x}")
+        sys.exit(1)
+    if delta[4:4 + DIGEST_SIZE] != base_digest:
+        print("FAIL: delta was not generated from this base image")
+        sys.exit(1)
+
+    result = io.BytesIO()
+    detools.apply_patch(io.BytesIO(base), io.BytesIO(delta[DELTA_OTA_HEADER_SIZE:]), result)
+    result = result.getvalue()
+
+    if hashlib.sha256(result).digest() != hashlib.sha256(new).digest():
+        print(f"FAIL: reconstructed image differs from {args.new}")
+        sys.exit(1)
+    if result[-DIGEST_SIZE:] != new_digest:
+        print("FAIL: reconstructed image has wrong appended SHA-256")
+        sys.exit(1)
+
+    print(f"OK: delta ({len(delta)} bytes) reconstructs {args.new} ({len(new)} bytes), "
+          f"sha256 {new_digest.hex()[:16]}...")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate and verify delta OTA images',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  # Keep the image that is on the devices, then build the new one
+  cp build/M5NanoC6-Switch.bin base.bin
+  make build
+
+  # Create and check a delta OTA image
+  python3 %(prog)s create base.bin build/M5NanoC6-Switch.bin -o delta.bin --ota-image delta.ota --version 2
+  python3 %(prog)s verify base.bin delta.ota build/M5NanoC6-Switch.bin
+        """
+    )
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    create = sub.add_parser('create', help='Create a delta between two app images')
+    create.add_argument('base', help='App image currently running on the devices')
+    create.add_argument('new', help='New app image')
+    create.add_argument('-o', '--output', required=True, help='Delta output file')
+    create.add_argument('--ota-image', default=None, help='Also wrap the delta in a Matter OTA image')
+    create.add_argument('--vendor-id', type=lambda x: int(x, 0), default=0xFFF1,
+                        help='Vendor ID (default: 0xFFF1)')
+    create.add_argument('--product-id', type=lambda x: int(x, 0), default=0x8000,
+                        help='Product ID (default: 0x8000)')
+    create.add_argument('--version', type=int, default=None,
+                        help='Software version of the new image (PROJECT_VER_NUMBER)')
+    create.add_argument('--version-str', default=None,
+                        help='Software version string (default: same as --version)')
+    create.set_defaults(func=cmd_create)
+
+    verify = sub.add_parser('verify', help='Apply a delta on the host and compare with the new image')
+    verify.add_argument('base', help='App image the delta was created from')
+    verify.add_argument('delta', help='Delta or Matter OTA image')
+    verify.add_argument('new', help='Expected result')
+    verify.set_defaults(func=cmd_verify)
+
+    args = parser.parse_args()
+
+    if args.command == 'create' and args.ota_image:
+        if args.version is None:
+            print("Error: --version is required with --ota-image")
+            sys.exit(1)
+        if args.version_str is None:
+            args.version_str = str(args.version)
+
+    try:
+        args.func(args)
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}")
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,382 @@
+#!/usr/bin/env python3
+"""
+Generate per-device Matter factory partitions from a CSV manifest
+
+Each manifest row describes one device. For every device this script generates
+a discriminator and passcode (unless given), a per-device SPAKE2+ salt and
+verifier, an NVS image for the 'fctry' partition and a QR label. Labels are
+also composed into printable sheets.
+
+Firmware built with sdkconfig.defaults.factory reads commissioning data from
+the 'fctry' partition at boot, so a single firmware binary serves every device.
+
+Usage:
+    python3 scripts/generate_factory_partitions.py manifest.csv -o factory_out
+
+Manifest format (header row required, only serial_num is mandatory):
+    serial_num,discriminator,passcode,mfg_date
+    SW0001,,,
+    SW0002,0x620,5143243,2026-03-14
+
+The partition also carries the device instance info (vendor/product name,
+hardware version, manufacturing date), because the factory build reads
+BasicInformation from it instead of CHIPProjectConfig.h.
+"""
+
+import argparse
+import base64
+import csv
+import datetime
+import os
+import re
+import secrets
+import subprocess
+import sys
+from concurrent.futures import ProcessPoolExecutor
+
+from generate_pairing_config import (
+    DEFAULT_ITERATION_COUNT,
+    HAS_QRCODE,
+    INVALID_PASSCODES,
+    format_manual_code,
+    generate_qrcode_manual,
+    generate_verifier,
+    render_qr_label,
+)
+
+if HAS_QRCODE:
+    from PIL import Image, ImageDraw, ImageFont
+
+# Must match partitions.csv (fctry, 0x3E0000, 0x6000)
+FCTRY_PARTITION_SIZE = 0x6000
+FCTRY_PARTITION_OFFSET = 0x3E0000
+
+# NVS namespace and keys read by the ESP32 factory data provider
+FACTORY_NAMESPACE = 'chip-factory'
+
+SALT_LENGTH = 32
+
+# Names the default provider reports, so the factory build keeps them
+PROJECT_CONFIG = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                              'main', 'include', 'CHIPProjectConfig.h')
+
+# Label sheet layout (labels per row / rows per sheet)
+SHEET_COLUMNS = 4
+SHEET_ROWS = 6
+SHEET_MARGIN = 40
+
+
+def find_nvs_partition_gen():
+    """Locate the ESP-IDF NVS partition generator.
+
+    Returns the command prefix used to invoke it.
+    """
+    idf_path = os.environ.get('IDF_PATH', '')
+    script = os.path.join(idf_path, 'components/nvs_flash/nvs_partition_generator/nvs_partition_gen.py')
+    if idf_path and os.path.exists(script):
+        return [sys.executable, script]
+    try:
+        import esp_idf_nvs_partition_gen  # noqa: F401
+        return [sys.executable, '-m', 'esp_idf_nvs_partition_gen']
+    except ImportError:
+        return None
+
+
+def project_config_string(name, fallback):
+    """Read a string #define from CHIPProjectConfig.h."""
+    try:
+        with open(PROJECT_CONFIG) as f:
+            match = re.search(rf'#define\s+{name}\s+"([^"]*)"', f.read())
+    except OSError:
+        match = None
+    return match.group(1) if match else fallback
+
+
+def parse_date(value):
+    """Parse an optional YYYY-MM-DD manifest field."""
+    value = (value or '').strip()
+    return datetime.date.fromisoformat(value).isoformat() if value else None
+
+
+def parse_int(value):
+    """Parse an optional decimal or 0x-prefixed manifest field."""
+    value = (value or '').strip()
+    return int(value, 0) if value else None
+
+
+def random_passcode(used):
+    """Pick a random valid passcode not yet assigned in this batch."""
+    while True:
+        passcode = secrets.randbelow(99999999) + 1
+        if passcode not in INVALID_PASSCODES and passcode not in used:
+            return passcode
+
+
+def load_manifest(path, mfg_date):
+    """Read the manifest and assign discriminators and passcodes.
+
+    Assignment happens here (single process) so passcodes are unique across
+    the batch; the expensive per-device work is done by the worker pool.
+    """
+    devices = []
+    serials = set()
+    used_passcodes = set()
+
+    with open(path, newline='') as f:
+        reader = csv.DictReader(f)
+        if not reader.fieldnames or 'serial_num' not in reader.fieldnames:
+            raise ValueError("Manifest must have a 'serial_num' column")
+
+        for line, row in enumerate(reader, start=2):
+            serial = (row.get('serial_num') or '').strip()
+            if not serial:
+                raise ValueError(f"Line {line}: empty serial_num")
+            if serial in serials:
+                raise ValueError(f"Line {line}: duplicate serial_num {serial}")
+            serials.add(serial)
+
+            discriminator = parse_int(row.get('discriminator'))
+            if discriminator is None:
+                discriminator = secrets.randbelow(0x1000)
+            elif not 0 <= discriminator <= 0xFFF:
+                raise ValueError(f"Line {line}: discriminator must be 0-4095, got {discriminator}")
+
+            passcode = parse_int(row.get('passcode'))
+            if passcode is None:
+                passcode = random_passcode(used_passcodes)
+            elif not 1 <= passcode <= 99999999 or passcode in INVALID_PASSCODES:
+                raise ValueError(f"Line {line}: invalid passcode {passcode}")
+            elif passcode in used_passcodes:
+                raise ValueError(f"Line {line}: passcode {passcode} already used in this batch")
+            used_passcodes.add(passcode)
+
+            try:
+                date = parse_date(row.get('mfg_date')) or mfg_date
+            except ValueError:
+                raise ValueError(f"Line {line}: mfg_date must be YYYY-MM-DD, got {row.get('mfg_date')}")
+
+            devices.append({
+                'serial_num': serial,
+                'discriminator': discriminator,
+                'passcode': passcode,
+                'salt': base64.b64encode(secrets.token_bytes(SALT_LENGTH)).decode('ascii'),
+                'mfg_date': date,
+            })
+
+    return devices
+
+
+def write_nvs_csv(path, device, verifier, opts):
+    """Write the nvs_partition_gen input CSV for one device.
+
+    Covers both the commissionable data and the device instance info
+    providers, which the factory build switches to this partition.
+    """
+    rows = [
+        ('key', 'type', 'encoding', 'value'),
+        (FACTORY_NAMESPACE, 'namespace', '', ''),
+        ('serial-num', 'data', 'string', device['serial_num']),
+        ('discriminator', 'data', 'u32', device['discriminator']),
+        ('iteration-count', 'data', 'u32', opts['iterations']),
+        ('salt', 'data', 'string', device['salt']),
+        ('verifier', 'data', 'string', verifier),
+        ('vendor-id', 'data', 'u32', opts['vendor_id']),
+        ('product-id', 'data', 'u32', opts['product_id']),
+        ('vendor-name', 'data', 'string', opts['vendor_name']),
+        ('product-name', 'data', 'string', opts['product_name']),
+        ('hardware-ver', 'data', 'u32', opts['hardware_ver']),
+        ('hw-ver-str', 'data', 'string', opts['hw_ver_str']),
+        ('mfg-date', 'data', 'string', device['mfg_date']),
+    ]
+    with open(path, 'w', newline='') as f:
+        csv.writer(f).writerows(rows)
+
+
+def provision_device(job):
+    """Worker: generate all artifacts for a single device."""
+    device, opts = job
+    serial = device['serial_num']
+    device_dir = os.path.join(opts['out_dir'], serial)
+    os.makedirs(device_dir, exist_ok=True)
+
+    verifier = generate_verifier(device['passcode'], base64.b64decode(device['salt']), opts['iterations'])
+    qr_code, manual_code = generate_qrcode_manual(device['discriminator'], device['passcode'],
+                                                  opts['vendor_id'], opts['product_id'],
+                                                  opts['discovery'])
+
+    nvs_csv = os.path.join(device_dir, f'{serial}-fctry.csv')
+    nvs_bin = os.path.join(device_dir, f'{serial}-fctry.bin')
+    write_nvs_csv(nvs_csv, device, verifier, opts)
+
+    result = subprocess.run(opts['nvs_gen'] + ['generate', nvs_csv, nvs_bin, hex(FCTRY_PARTITION_SIZE)],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{serial}: nvs_partition_gen failed:\n{result.stdout}")
+
+    qr_image = None
+    if opts['labels']:
+        qr_image = os.path.join(device_dir, f'{serial}-qr.png')
+        img, _ = render_qr_label(qr_code, manual_code)
+        img.save(qr_image)
+
+    return {
+        'serial_num': serial,
+        'discriminator': device['discriminator'],
+        'passcode': device['passcode'],
+        'qr_code': qr_code,
+        'manual_code': format_manual_code(manual_code),
+        'fctry_bin': os.path.relpath(nvs_bin, opts['out_dir']),
+        'qr_image': qr_image,
+    }
+
+
+def write_label_sheets(results, out_dir):
+    """Compose per-device QR labels into printable sheets with serial numbers."""
+    per_sheet = SHEET_COLUMNS * SHEET_ROWS
+    sheets = []
+
+    try:
+        font = ImageFont.truetype("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", 24)
+    except Exception:
+        font = ImageFont.load_default()
+
+    for start in range(0, len(results), per_sheet):
+        labels = [Image.open(r['qr_image']) for r in results[start:start + per_sheet]]
+        cell_w = max(img.size[0] for img in labels)
+        cell_h = max(img.size[1] for img in labels) + 40  # Room for serial number
+
+        sheet = Image.new('RGB', (SHEET_COLUMNS * cell_w + 2 * SHEET_MARGIN,
+                                  SHEET_ROWS * cell_h + 2 * SHEET_MARGIN), 'white')
+        draw = ImageDraw.Draw(sheet)
+        for i, (img, result) in enumerate(zip(labels, results[start:start + per_sheet])):
+            x = SHEET_MARGIN + (i % SHEET_COLUMNS) * cell_w
+            y = SHEET_MARGIN + (i // SHEET_COLUMNS) * cell_h
+            sheet.paste(img, (x, y))
+            draw.text((x + 40, y + img.size[1]), result['serial_num'], fill='black', font=font)
+
+        path = os.path.join(out_dir, f'labels-{start // per_sheet + 1:03d}.png')
+        sheet.save(path)
+        sheets.append(path)
+
+    return sheets
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate per-device Matter factory partitions from a CSV manifest',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=f"""
+Examples:
+  # Provision every device in the manifest using all CPU cores
+  python3 %(prog)s manifest.csv -o factory_out
+
+  # Flash one device's factory partition
+  esptool write_flash 0x{FCTRY_PARTITION_OFFSET:X} factory_out/SW0001/SW0001-fctry.bin
+        """
+    )
+    parser.add_argument('manifest', help='CSV manifest with a serial_num column')
+    parser.add_argument('-o', '--out-dir', default='factory_out',
+                        help='Output directory (default: factory_out)')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(),
+                        help='Number of parallel workers (default: CPU count)')
+    parser.add_argument('--vendor-id', type=lambda x: int(x, 0), default=0xFFF1,
+                        help='Vendor ID (default: 0xFFF1)')
+    parser.add_argument('--product-id', type=lambda x: int(x, 0), default=0x8000,
+                        help='Product ID (default: 0x8000)')
+    parser.add_argument('--vendor-name', default=project_config_string('CHIP_DEVICE_CONFIG_DEVICE_VENDOR_NAME', ''),
+                        help='Vendor name (default: from CHIPProjectConfig.h)')
+    parser.add_argument('--product-name', default=project_config_string('CHIP_DEVICE_CONFIG_DEVICE_PRODUCT_NAME', ''),
+                        help='Product name (default: from CHIPProjectConfig.h)')
+    parser.add_argument('--hardware-ver', type=int, default=1,
+                        help='Hardware version number (default: 1)')
+    parser.add_argument('--hw-ver-str', default='1.0',
+                        help='Hardware version string (default: 1.0)')
+    parser.add_argument('--mfg-date', type=parse_date, default=datetime.date.today().isoformat(),
+                        help='Manufacturing date YYYY-MM-DD for rows without mfg_date (default: today)')
+    parser.add_argument('--iterations', type=int, default=DEFAULT_ITERATION_COUNT,
+                        help=f'SPAKE2+ iteration count (default: {DEFAULT_ITERATION_COUNT})')
+    parser.add_argument('--discovery', type=int, default=2,
+                        help='Discovery capabilities bitmask: 1=SoftAP, 2=BLE, 4=OnNetwork (default: 2 for BLE)')
+    parser.add_argument('--no-labels', action='store_true',
+                        help='Skip QR label images and label sheets')
+
+    args = parser.parse_args()
+
+    if not args.vendor_name or not args.product_name:
+        print("Error: Set --vendor-name and --product-name (CHIPProjectConfig.h not found)")
+        sys.exit(1)
+    if not 0 <= args.hardware_ver <= 0xFFFF:
+        print(f"Error: Hardware version must be 0-65535, got {args.hardware_ver}")
+        sys.exit(1)
+
+    if not 1000 <= args.iterations <= 100000:
+        print(f"Error: Iteration count must be 1000-100000, got {args.iterations}")
+        sys.exit(1)
+
+    nvs_gen = find_nvs_partition_gen()
+    if not nvs_gen:
+        print("Error: nvs_partition_gen not found. Set IDF_PATH or run: pip install esp-idf-nvs-partition-gen")
+        sys.exit(1)
+
+    labels = not args.no_labels
+    if labels and not HAS_QRCODE:
+        print("Error: qrcode library not installed. Run: pip install qrcode pillow (or use --no-labels)")
+        sys.exit(1)
+
+    # Placeholder codes from the fallback path are useless on a device label
+    try:
+        import SetupPayload  # noqa: F401
+    except ImportError:
+        print("Error: SetupPayload not found. Set ESP_MATTER_PATH and run: pip install bitarray construct stdnum click")
+        sys.exit(1)
+
+    try:
+        devices = load_manifest(args.manifest, args.mfg_date)
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}")
+        sys.exit(1)
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    opts = {
+        'out_dir': args.out_dir,
+        'iterations': args.iterations,
+        'vendor_id': args.vendor_id,
+        'product_id': args.product_id,
+        'vendor_name': args.vendor_name,
+        'product_name': args.product_name,
+        'hardware_ver': args.hardware_ver,
+        'hw_ver_str': args.hw_ver_str,
+        'discovery': args.discovery,
+        'nvs_gen': nvs_gen,
+        'labels': labels,
+    }
+
+    print(f"Provisioning {len(devices)} devices with {args.jobs} workers...")
+    jobs = [(device, opts) for device in devices]
+    chunksize = max(1, len(jobs) // (args.jobs * 4))
+    results = []
+    with ProcessPoolExecutor(max_workers=args.jobs) as pool:
+        for i, result in enumerate(pool.map(provision_device, jobs, chunksize=chunksize), start=1):
+            results.append(result)
+            if i % 100 == 0 or i == len(jobs):
+                print(f"  {i}/{len(jobs)}")
+
+    summary = os.path.join(args.out_dir, 'summary.csv')
+    with open(summary, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['serial_num', 'discriminator', 'passcode', 'qr_code', 'manual_code', 'fctry_bin'])
+        for r in results:
+            writer.writerow([r['serial_num'], f"0x{r['discriminator']:03X}", r['passcode'],
+                             r['qr_code'], r['manual_code'], r['fctry_bin']])
+    print(f"Summary:     {summary}")
+
+    if labels:
+        for sheet in write_label_sheets(results, args.out_dir):
+            print(f"Label sheet: {sheet}")
+
+    print()
+    print(f"Flash each device with: esptool write_flash 0x{FCTRY_PARTITION_OFFSET:X} <fctry_bin>")
+
+
+if __name__ == '__main__':
+    main()
@@ -95,6 +95,68 @@ def generate_qrcode_manual(discriminator: int, passcode: int, vendor_id: int = 0
             return "<Install dependencies: pip install bitarray construct stdnum click>", "<N/A>"
 
 
+def format_manual_code(manual_code) -> str:
+    """Format an 11-digit manual pairing code as XXXX-XXX-XXXX."""
+    manual_code_str = str(manual_code)
+    if len(manual_code_str) == 11:
+        return f"{manual_code_str[0:4]}-{manual_code_str[4:7]}-{manual_code_str[7:11]}"
+    return manual_code_str
+
+
+def render_qr_label(qr_code, manual_code):
+    """Render QR code with the formatted manual code underneath.
+
+    Returns (PIL image, formatted manual code).
+    """
+    qr = qrcode.QRCode(
+        version=1,
+        error_correction=qrcode.constants.ERROR_CORRECT_M,
+        box_size=10,
+        border=4,
+    )
+    qr.add_data(qr_code)
+    qr.make(fit=True)
+
+    qr_img = qr.make_image(fill_color="black", back_color="white")
+
+    # Convert to PIL Image if necessary
+    if not isinstance(qr_img, Image.Image):
+        qr_img = qr_img.convert('RGB')
+
+    # Format manual code as XXXX-XXX-XXXX
+    formatted_code = format_manual_code(manual_code)
+
+    # Add text below QR code
+    qr_width, qr_height = qr_img.size
+    text_height = 60  # Height for text area
+
+    # Create new image with extra space for text
+    img = Image.new('RGB', (qr_width, qr_height + text_height), 'white')
+    img.paste(qr_img, (0, 0))
+
+    # Add manual code text
+    draw = ImageDraw.Draw(img)
+
+    # Try to use a nice font, fall back to default if not available
+    try:
+        font = ImageFont.truetype("/System/Library/Fonts/Helvetica.ttc", 36)
+    except:
+        try:
+            font = ImageFont.truetype("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf", 36)
+        except:
+            font = ImageFont.load_default()
+
+    # Center the text
+    bbox = draw.textbbox((0, 0), formatted_code, font=font)
+    text_width = bbox[2] - bbox[0]
+    text_x = (qr_width - text_width) // 2
+    text_y = qr_height + 10
+
+    draw.text((text_x, text_y), formatted_code, fill='black', font=font)
+
+    return img, formatted_code
+
+
 def read_current_config_id(filepath):
     """Read current FIRMWARE_CONFIG_ID from header file."""
     if not os.path.exists(filepath):
@@ -328,56 +390,7 @@ Examples:
             print("Error: qrcode library not installed. Run: pip install qrcode pillow")
             sys.exit(1)
 
-        qr = qrcode.QRCode(
-            version=1,
-            error_correction=qrcode.constants.ERROR_CORRECT_M,
-            box_size=10,
-            border=4,
-        )
-        qr.add_data(qr_code)
-        qr.make(fit=True)
-
-        qr_img = qr.make_image(fill_color="black", back_color="white")
-
-        # Convert to PIL Image if necessary
-        if not isinstance(qr_img, Image.Image):
-            qr_img = qr_img.convert('RGB')
-
-        # Format manual code as XXXX-XXX-XXXX
-        manual_code_str = str(manual_code)
-        if len(manual_code_str) == 11:
-            formatted_code = f"{manual_code_str[0:4]}-{manual_code_str[4:7]}-{manual_code_str[7:11]}"
-        else:
-            formatted_code = manual_code_str
-
-        # Add text below QR code
-        qr_width, qr_height = qr_img.size
-        text_height = 60  # Height for text area
-
-        # Create new image with extra space for text
-        img = Image.new('RGB', (qr_width, qr_height + text_height), 'white')
-        img.paste(qr_img, (0, 0))
-
-        # Add manual code text
-        draw = ImageDraw.Draw(img)
-
-        # Try to use a nice font, fall back to default if not available
-        try:
-            font = ImageFont.truetype("/System/Library/Fonts/Helvetica.ttc", 36)
-        except:
-            try:
-                font = ImageFont.truetype("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf", 36)
-            except:
-                font = ImageFont.load_default()
-
-        # Center the text
-        bbox = draw.textbbox((0, 0), formatted_code, font=font)
-        text_width = bbox[2] - bbox[0]
-        text_x = (qr_width - text_width) // 2
-        text_y = qr_height + 10
-
-        draw.text((text_x, text_y), formatted_code, fill='black', font=font)
-
+        img, formatted_code = render_qr_label(qr_code, manual_code)
         img.save(args.qr_image)
         print(f"QR Image:    {args.qr_image}")
         print(f"Manual Code: {formatted_code}")
@@ -0,0 +1,43 @@
+"""
+Build firmware engines for the host
+
+The main/app_*_engine.cpp files (and app_onoff_timer.cpp) have no ESP-IDF
+dependencies. The checks and benchmarks in this directory compile them,
+optionally with a C++ harness, into a shared library and bind the functions
+they call with ctypes. The caller owns the work directory.
+"""
+
+import ctypes
+import os
+import shutil
+import subprocess
+import sys
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAIN_DIR = os.path.join(REPO_ROOT, 'main')
+
+
+def find_cxx():
+    """C++ compiler from $CXX or the PATH; exits if there is none."""
+    cxx = os.environ.get('CXX') or shutil.which('c++') or shutil.which('g++') or shutil.which('clang++')
+    if not cxx:
+        sys.exit('Error: no C++ compiler found (set CXX)')
+    return cxx
+
+
+def build(workdir, name, sources, harness=None, flags=()):
+    """Compile sources (paths relative to main/) into workdir/lib<name>.so and load it.
+
+    harness is C++ source text compiled along with them, with main/ on the
+    include path.
+    """
+    paths = [os.path.join(MAIN_DIR, src) for src in sources]
+    if harness:
+        harness_path = os.path.join(workdir, f'{name}_harness.cpp')
+        with open(harness_path, 'w') as f:
+            f.write(harness)
+        paths.append(harness_path)
+    lib_path = os.path.join(workdir, f'lib{name}.so')
+    subprocess.run([find_cxx(), '-std=gnu++17', '-O2', '-shared', '-fPIC', *flags, '-I', MAIN_DIR] + paths +
+                   ['-o', lib_path], check=True)
+    return ctypes.CDLL(lib_path)
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+Benchmark the Linux build of the switch (linux/) with chip-tool over loopback
+
+Starts m5nanoc6-switch-app with a fresh KVS, commissions it from one
+`chip-tool interactive` session, subscribes to OnOff and then sends
+On/Off/Toggle commands one at a time. For every command it measures:
+
+  invoke latency  command written -> command response received
+  report latency  command written -> subscription report with the new value
+
+and the sustained command rate with one command outstanding. Each command
+changes the OnOff value so every command produces a report.
+
+Usage:
+    python3 scripts/linux_bench.py --app linux/out/m5nanoc6-switch-app \\
+        --chip-tool out/chip-tool/chip-tool --iterations 100
+"""
+
+import argparse
+import json
+import os
+import queue
+import re
+import shutil
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+PASSCODE = 20202021
+DISCRIMINATOR = 3840
+NODE_ID = 0x5E
+ENDPOINT = 1
+
+# Each command flips the OnOff value: off -> on -> off -> on -> off
+SEQUENCE = [('on', True), ('off', False), ('toggle', True), ('toggle', False)]
+COMMAND_IDS = {'off': 0, 'on': 1, 'toggle': 2}
+
+COMMISSIONED_PATTERN = re.compile(r'Device commissioning completed with success')
+SUBSCRIBED_PATTERN = re.compile(r'Subscription established')
+REPORT_PATTERN = re.compile(r'OnOff: (TRUE|FALSE)')
+RESPONSE_PATTERN = re.compile(r'Received Command Response Status for Endpoint=\d+ Cluster=0x0000_0006 '
+                              r'Command=0x0000_000(\d) Status=0x(\w+)')
+
+
+class ChipToolSession:
+    """chip-tool interactive session with timestamped output lines."""
+
+    def __init__(self, chip_tool, storage_dir):
+        self.proc = subprocess.Popen([chip_tool, 'interactive', 'start', '--storage-directory', storage_dir],
+                                     stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                     text=True, bufsize=1)
+        self.lines = queue.Queue()
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        for line in self.proc.stdout:
+            self.lines.put((time.monotonic(), line))
+        self.lines.put((time.monotonic(), None))
+
+    def send(self, command):
+        """Write one command, returning the time it was written."""
+        sent = time.monotonic()
+        self.proc.stdin.write(command + '\n')
+        self.proc.stdin.flush()
+        return sent
+
+    def wait_for(self, pattern, timeout):
+        """Return (time, match) for the next line matching pattern."""
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError(f"timed out waiting for '{pattern.pattern}'")
+            try:
+                stamp, line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if line is None:
+                raise RuntimeError('chip-tool exited')
+            match = pattern.search(line)
+            if match:
+                return stamp, match
+
+    def wait_response_and_report(self, command_id, value, timeout):
+        """Wait for both the command response and the matching report, in any order."""
+        response_at = report_at = None
+        deadline = time.monotonic() + timeout
+        while response_at is None or report_at is None:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError('timed out waiting for command response/report')
+            try:
+                stamp, line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if line is None:
+                raise RuntimeError('chip-tool exited')
+            match = RESPONSE_PATTERN.search(line)
+            if match and int(match.group(1)) == command_id:
+                if int(match.group(2), 16) != 0:
+                    raise RuntimeError(f'command failed: {line.strip()}')
+                response_at = stamp
+                continue
+            match = REPORT_PATTERN.search(line)
+            if match and (match.group(1) == 'TRUE') == value:
+                report_at = stamp
+        return response_at, report_at
+
+    def close(self):
+        if self.proc.poll() is None:
+            try:
+                self.send('quit')
+                self.proc.wait(timeout=5)
+            except (BrokenPipeError, subprocess.TimeoutExpired):
+                self.proc.kill()
+
+
+def summarize(samples_ms):
+    """Latency summary in milliseconds."""
+    ordered = sorted(samples_ms)
+    return {
+        'count': len(ordered),
+        'min_ms': round(ordered[0], 2),
+        'avg_ms': round(statistics.mean(ordered), 2),
+        'p50_ms': round(ordered[len(ordered) // 2], 2),
+        'p95_ms': round(ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))], 2),
+        'max_ms': round(ordered[-1], 2),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmark the Linux switch app with chip-tool over loopback',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--app', default='linux/out/m5nanoc6-switch-app', help='Path to m5nanoc6-switch-app')
+    parser.add_argument('--chip-tool', default=shutil.which('chip-tool') or 'chip-tool', help='Path to chip-tool')
+    parser.add_argument('--iterations', type=int, default=25,
+                        help='Command sequences to run; each sends on/off/toggle/toggle (default: 25)')
+    parser.add_argument('--timeout', type=float, default=10.0, help='Per-command timeout in seconds (default: 10)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_bench_')
+    app_log = open(os.path.join(workdir, 'app.log'), 'w')
+    app = subprocess.Popen([args.app, '--KVS', os.path.join(workdir, 'kvs'),
+                            '--discriminator', str(DISCRIMINATOR), '--passcode', str(PASSCODE)],
+                           stdout=app_log, stderr=subprocess.STDOUT)
+    time.sleep(1)
+
+    session = ChipToolSession(args.chip_tool, workdir)
+    invoke = {name: [] for name in COMMAND_IDS}
+    report = {name: [] for name in COMMAND_IDS}
+    try:
+        session.send(f'pairing onnetwork {NODE_ID} {PASSCODE}')
+        session.wait_for(COMMISSIONED_PATTERN, 60)
+
+        # Start from a known state, then subscribe with no minimum interval so reports are immediate
+        session.send(f'onoff off {NODE_ID} {ENDPOINT}')
+        session.wait_for(RESPONSE_PATTERN, args.timeout)
+        session.send(f'onoff subscribe on-off 0 60 {NODE_ID} {ENDPOINT} --keepSubscriptions true')
+        session.wait_for(SUBSCRIBED_PATTERN, args.timeout)
+
+        started = time.monotonic()
+        for _ in range(args.iterations):
+            for command, value in SEQUENCE:
+                sent = session.send(f'onoff {command} {NODE_ID} {ENDPOINT}')
+                response_at, report_at = session.wait_response_and_report(COMMAND_IDS[command], value, args.timeout)
+                invoke[command].append((response_at - sent) * 1000)
+                report[command].append((report_at - sent) * 1000)
+        elapsed = time.monotonic() - started
+    except (TimeoutError, RuntimeError) as e:
+        print(f"Error: {e} (app log: {app_log.name})")
+        sys.exit(1)
+    finally:
+        session.close()
+        app.send_signal(signal.SIGINT)
+        try:
+            app.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            app.kill()
+
+    total = sum(len(v) for v in invoke.values())
+    results = {
+        'commands': total,
+        'elapsed_s': round(elapsed, 3),
+        'commands_per_sec': round(total / elapsed, 1),
+        'invoke': {name: summarize(v) for name, v in invoke.items()},
+        'report': {name: summarize(v) for name, v in report.items()},
+    }
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+        return
+
+    print(f"{total} commands in {results['elapsed_s']}s: {results['commands_per_sec']} commands/s "
+          f"(one outstanding)")
+    for kind in ('invoke', 'report'):
+        for name, s in results[kind].items():
+            print(f"  {kind:6} {name:6} avg {s['avg_ms']:7.2f} ms  p50 {s['p50_ms']:7.2f}  "
+                  f"p95 {s['p95_ms']:7.2f}  min {s['min_ms']:7.2f}  max {s['max_ms']:7.2f}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,390 @@
+#!/usr/bin/env python3
+"""
+Check the deferred logger and compare its call cost with inline formatting
+
+Builds main/app_log_engine.cpp for the host with a small C++ harness and:
+  1. formats a set of messages through the ring (capture on the caller,
+     app_log_format() on the consumer) and compares each one with snprintf
+     on the same format and arguments
+  2. runs several producer threads against one consumer on a small ring,
+     and checks that every record arrives once and in order per producer
+     and that every record that did not arrive was counted as dropped
+  3. times one log call on the calling thread: deferred (claim, capture,
+     commit) against inline (vsnprintf and a write, as ESP_LOGx does), and
+     the consumer's cost per record
+
+On the device, the inline cost also includes the console: each line blocks
+the caller for its wire time once the UART FIFO is full. The report shows
+that time for a typical line at --baud. "matter log-stats" prints the
+ring counters.
+
+Usage:
+    python3 scripts/log_bench.py
+    python3 scripts/log_bench.py --producers 8 --records 200000 --json
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+UART_FIFO = 128                 # ESP32-C6 UART TX FIFO, bytes
+LINE_PREFIX = len('I (123456) app_main: ')
+
+HARNESS_SRC = r'''
+#include <atomic>
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "app_log_engine.h"
+
+enum Kind { KIND_A = 1, KIND_B = 200 };
+
+static int s_cases = 0;
+static char *s_fail = nullptr;
+static size_t s_fail_size = 0;
+
+template <typename... Args> static bool check(const char *fmt, Args... args)
+{
+    char expected[256];
+    char got[256];
+    snprintf(expected, sizeof(expected), fmt, args...);
+    app_log_record_t record;
+    app_log_capture(&record, APP_LOG_INFO, "test", 0, fmt, args...);
+    app_log_format(&record, got, sizeof(got));
+    s_cases++;
+    if (strcmp(expected, got) != 0) {
+        snprintf(s_fail, s_fail_size, "format \"%s\": got \"%s\", want \"%s\"", fmt, got, expected);
+        return false;
+    }
+    return true;
+}
+
+#define CHECK(...) if (!check(__VA_ARGS__)) return -1
+
+extern "C" int log_check_formats(char *fail, size_t size)
+{
+    s_fail = fail;
+    s_fail_size = size;
+    s_cases = 0;
+    int x = 42;
+    CHECK("no arguments");
+    CHECK("100%% done");
+    CHECK("Identification callback: type: %u, effect: %u, variant: %u", 1u, (uint8_t)2, (uint8_t)3);
+    CHECK("LED set to %s", "ON");
+    CHECK("%d %i %u", -7, -2147483647 - 1, 4294967295u);
+    CHECK("%u", -1);
+    CHECK("%d", 4294967295u);
+    CHECK("%x %X %o %#x %#o", 0xBEEFu, 0xBEEFu, 8u, 255u, 8u);
+    CHECK("%08" PRIx32 " %-6d| %+d % d", (uint32_t)0xABCD, 12, 5, 5);
+    CHECK("%hhu %hhd %hu %hd", 300, 200, 70000, 40000);
+    CHECK("%" PRIu32 " %" PRIi32 " %" PRIu16 " %" PRIu8, (uint32_t)4000000000u, (int32_t)-5, (uint16_t)65535, (uint8_t)255);
+    CHECK("%" PRId64 " %" PRIu64 " %" PRIx64, (int64_t)-9000000000LL, (uint64_t)18446744073709551615ULL, (uint64_t)0x123456789ABCULL);
+    CHECK("%lld %llu %ld %lu", -1LL, 1ULL << 63, -3L, 7UL);
+    CHECK("%zu %zd %td", (size_t)123456, (ptrdiff_t)-3, (ptrdiff_t)9);
+    CHECK("[%c%c%3c]", 'o', 'k', 'x');
+    CHECK("[%s] [%.3s] [%8s] [%-8s]", "alpha", "bravo", "cs", "dl");
+    CHECK("%s=%s %s", "key", "", "x");
+    CHECK("%p %p", (void *)&x, (void *)nullptr);
+    CHECK("%f %.2f %e %g %10.3f", 3.25, 2.0 / 3, 12345.678, 0.0001, -1.5);
+    CHECK("%.1f%% of %d", 99.95f, 100);
+    CHECK("[%*d] [%-*d] [%.*s]", 6, 42, 4, 7, 2, "abcdef");
+    CHECK("[%*.*f]", 8, 3, 3.14159);
+    CHECK("bool %d %d", true, false);
+    CHECK("enum %d %u", KIND_A, KIND_B);
+    CHECK("%s %s %s", "first", "second", "third");
+    CHECK("trailing %");
+    return s_cases;
+}
+
+extern "C" int log_check_truncation(void)
+{
+    // Copied text is capped per record; the message itself is capped by the output buffer
+    const char *long_text = "0123456789012345678901234567890123456789012345678901234567890123456789";
+    app_log_record_t record;
+    char out[256];
+    app_log_capture(&record, APP_LOG_INFO, "test", 0, "[%s] [%s] %d", long_text, "after", 7);
+    app_log_format(&record, out, sizeof(out));
+    char want[256];
+    snprintf(want, sizeof(want), "[%.*s] [] 7", APP_LOG_TEXT_BYTES - 1, long_text);
+    if (strcmp(out, want) != 0) {
+        return 1;
+    }
+    app_log_capture(&record, APP_LOG_INFO, "test", 0, "%d %s", 1);      // Missing argument
+    app_log_format(&record, out, sizeof(out));
+    if (strcmp(out, "1 (?)") != 0) {
+        return 2;
+    }
+    app_log_capture(&record, APP_LOG_INFO, "test", 0, "value %d of %d", 12345, 67890);
+    size_t n = app_log_format(&record, out, 10);
+    if (n != 9 || strcmp(out, "value 123") != 0) {
+        return 3;
+    }
+    return 0;
+}
+
+extern "C" int log_check_levels(void)
+{
+    app_log_levels_t levels;
+    app_log_levels_init(&levels, APP_LOG_INFO);
+    const char *other = "app_other";
+    if (!app_log_levels_enabled(&levels, APP_LOG_INFO, other) || app_log_levels_enabled(&levels, APP_LOG_DEBUG, other)) {
+        return 1;
+    }
+    char tag[] = "app_driver";        // Not the same pointer as a literal: matched by name
+    app_log_levels_set(&levels, tag, APP_LOG_VERBOSE);
+    if (!app_log_levels_enabled(&levels, APP_LOG_DEBUG, "app_driver") || app_log_levels_enabled(&levels, APP_LOG_DEBUG, other)) {
+        return 2;
+    }
+    app_log_levels_set(&levels, "app_main", APP_LOG_NONE);
+    if (app_log_levels_enabled(&levels, APP_LOG_ERROR, "app_main") || levels.max_level != APP_LOG_VERBOSE) {
+        return 3;
+    }
+    app_log_levels_set(&levels, "app_driver", APP_LOG_WARN);
+    if (levels.max_level != APP_LOG_INFO || app_log_levels_enabled(&levels, APP_LOG_INFO, "app_driver")) {
+        return 4;
+    }
+    app_log_levels_set(&levels, "*", APP_LOG_ERROR);
+    if (levels.max_level != APP_LOG_ERROR || app_log_levels_enabled(&levels, APP_LOG_WARN, "app_driver") ||
+        !app_log_levels_enabled(&levels, APP_LOG_ERROR, "app_main") || strcmp(levels.tags[0].tag, "app_driver") != 0) {
+        return 5;   // "*" resets entries in place, never rewrites their tags
+    }
+    for (int i = levels.count; i < APP_LOG_MAX_TAGS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "tag%d", i);
+        if (!app_log_levels_set(&levels, name, APP_LOG_DEBUG)) {
+            return 6;
+        }
+    }
+    if (app_log_levels_set(&levels, "one_too_many", APP_LOG_DEBUG) ||
+        app_log_levels_set(&levels, "a_tag_name_that_is_far_too_long", APP_LOG_DEBUG)) {
+        return 7;
+    }
+    return 0;
+}
+
+// Producers log (id, n); the consumer checks order per producer
+extern "C" int log_stress(int producers, int per_producer, int slots, uint32_t *taken_out, uint32_t *dropped_out)
+{
+    std::vector<app_log_slot_t> storage(slots);
+    app_log_ring_t ring;
+    if (!app_log_ring_init(&ring, storage.data(), slots)) {
+        return 1;
+    }
+    std::atomic<int> running{producers};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (int n = 0; n < per_producer; n++) {
+                // Give the consumer a moment when full, then log anyway (some records are dropped)
+                for (int wait = 0; wait < 4 && app_log_ring_pending(&ring) >= static_cast<uint32_t>(slots); wait++) {
+                    std::this_thread::yield();
+                }
+                uint32_t pos;
+                app_log_record_t *record = app_log_ring_claim(&ring, &pos);
+                if (record) {
+                    app_log_capture(record, APP_LOG_INFO, "stress", 0, "%d %d", p, n);
+                    app_log_ring_commit(&ring, pos);
+                }
+            }
+            running--;
+        });
+    }
+    std::vector<int> last(producers, -1);
+    uint32_t taken = 0;
+    int error = 0;
+    app_log_record_t record;
+    for (;;) {
+        bool idle = running.load() == 0;
+        bool any = false;
+        while (app_log_ring_take(&ring, &record)) {
+            any = true;
+            taken++;
+            int p = static_cast<int>(record.args[0]);
+            int n = static_cast<int>(record.args[1]);
+            if (record.nargs != 2 || p < 0 || p >= producers || n <= last[p]) {
+                error = 2;
+            } else {
+                last[p] = n;
+            }
+        }
+        if (idle && !any) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    *taken_out = taken;
+    *dropped_out = ring.dropped;
+    if (!error && (ring.written != taken || taken + ring.dropped != static_cast<uint32_t>(producers * per_producer))) {
+        error = 3;
+    }
+    if (!error && app_log_ring_pending(&ring) != 0) {
+        error = 4;
+    }
+    return error;
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Per-call cost: inline (format + write on the caller) and deferred (capture), plus consumer cost per record
+extern "C" void log_bench(int iterations, double *inline_ns, double *deferred_ns, double *consumer_ns)
+{
+    const int slots = 256;
+    static app_log_slot_t storage[slots];
+    app_log_ring_t ring;
+    app_log_ring_init(&ring, storage, slots);
+    FILE *sink = fopen("/dev/null", "w");
+    char line[256];
+    app_log_record_t record;
+    double produce = 0;
+    double consume = 0;
+    int rounds = iterations / slots;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds * slots; i++) {
+        int n = snprintf(line, sizeof(line), "I (%" PRIu32 ") %s: Identification callback: type: %u, effect: %u, variant: %u\n",
+                         (uint32_t)i, "app_main", 1u, (unsigned)(i & 0xFF), 0u);
+        fwrite(line, 1, n, sink);
+    }
+    *inline_ns = elapsed_ns(start) / (rounds * slots);
+
+    for (int r = 0; r < rounds; r++) {
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < slots; i++) {
+            uint32_t pos;
+            app_log_record_t *slot = app_log_ring_claim(&ring, &pos);
+            app_log_capture(slot, APP_LOG_INFO, "app_main", static_cast<uint32_t>(i),
+                            "Identification callback: type: %u, effect: %u, variant: %u", 1u, (uint8_t)(i & 0xFF), (uint8_t)0);
+            app_log_ring_commit(&ring, pos);
+        }
+        produce += elapsed_ns(start);
+        start = std::chrono::steady_clock::now();
+        while (app_log_ring_take(&ring, &record)) {
+            app_log_format(&record, line, sizeof(line));
+            fputs(line, sink);
+        }
+        consume += elapsed_ns(start);
+    }
+    fclose(sink);
+    *deferred_ns = produce / (rounds * slots);
+    *consumer_ns = consume / (rounds * slots);
+}
+'''
+
+
+def build_engine(workdir):
+    """Compile the engine and the harness into a shared library and bind their functions."""
+    lib = host_engine.build(workdir, 'log_bench', ['app_log_engine.cpp'], harness=HARNESS_SRC,
+                            flags=['-pthread', '-Wno-format-security'])
+    lib.log_check_formats.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.log_check_formats.restype = ctypes.c_int
+    lib.log_check_truncation.restype = ctypes.c_int
+    lib.log_check_levels.restype = ctypes.c_int
+    lib.log_stress.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_uint32),
+                               ctypes.POINTER(ctypes.c_uint32)]
+    lib.log_stress.restype = ctypes.c_int
+    lib.log_bench.argtypes = [ctypes.c_int] + [ctypes.POINTER(ctypes.c_double)] * 3
+    return lib
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Check the deferred logger and compare its call cost with inline formatting',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--producers', type=int, default=4, help='Producer threads in the stress test (default: 4)')
+    parser.add_argument('--records', type=int, default=50000, help='Records per producer (default: 50000)')
+    parser.add_argument('--slots', type=int, default=64, help='Ring slots in the stress test (default: 64)')
+    parser.add_argument('--iterations', type=int, default=200000, help='Timed log calls (default: 200000)')
+    parser.add_argument('--baud', type=int, default=115200, help='Console baud rate for the wire time (default: 115200)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+
+    failures = []
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_log_')
+    try:
+        lib = build_engine(workdir)
+
+        fail = ctypes.create_string_buffer(512)
+        cases = lib.log_check_formats(fail, len(fail))
+        if cases < 0:
+            failures.append(fail.value.decode(errors='replace'))
+        err = lib.log_check_truncation()
+        if err:
+            failures.append(f'truncation check {err} failed')
+        err = lib.log_check_levels()
+        if err:
+            failures.append(f'per-tag level check {err} failed')
+
+        taken = ctypes.c_uint32()
+        dropped = ctypes.c_uint32()
+        err = lib.log_stress(args.producers, args.records, args.slots, ctypes.byref(taken), ctypes.byref(dropped))
+        if err:
+            failures.append(f'stress test failed ({["", "bad slot count", "lost order", "counts do not add up", "records left"][err]})')
+
+        inline_ns, deferred_ns, consumer_ns = ctypes.c_double(), ctypes.c_double(), ctypes.c_double()
+        lib.log_bench(args.iterations, ctypes.byref(inline_ns), ctypes.byref(deferred_ns), ctypes.byref(consumer_ns))
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    line_len = LINE_PREFIX + len('Identification callback: type: 1, effect: 0, variant: 0') + 1
+    wire_us = line_len * 10 * 1e6 / args.baud
+    results = {
+        'format_cases': max(cases, 0),
+        'stress': {
+            'producers': args.producers,
+            'records': args.producers * args.records,
+            'slots': args.slots,
+            'taken': taken.value,
+            'dropped': dropped.value,
+        },
+        'inline_ns': round(inline_ns.value, 1),
+        'deferred_ns': round(deferred_ns.value, 1),
+        'consumer_ns': round(consumer_ns.value, 1),
+        'line_bytes': line_len,
+        'line_wire_us': round(wire_us, 1),
+        'failures': failures,
+    }
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+    else:
+        if failures:
+            for f in failures:
+                print(f'FAIL: {f}')
+        else:
+            print(f'{results["format_cases"]} formats match snprintf; truncation and per-tag levels check out')
+            s = results['stress']
+            print(f'Stress: {s["producers"]} producers, {s["records"]} records through {s["slots"]} slots: '
+                  f'{s["taken"]} taken in order, {s["dropped"]} dropped and counted')
+        print()
+        print('Host cost of one log call on the calling task:')
+        print(f'  inline   (format + write)   {results["inline_ns"]:8.1f} ns')
+        print(f'  deferred (capture to ring)  {results["deferred_ns"]:8.1f} ns  '
+              f'({results["inline_ns"] / max(results["deferred_ns"], 0.1):.1f}x less)')
+        print(f'  consumer (format + write)   {results["consumer_ns"]:8.1f} ns per record, on the log task')
+        print()
+        print(f'On the device an inline {line_len}-byte line also holds the caller for {wire_us:.0f} us '
+              f'at {args.baud} baud once the {UART_FIFO}-byte UART FIFO is full.')
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+"""
+Replay OnOff Lighting command sequences through the timed on/off engine
+
+Builds main/app_onoff_timer.cpp for the host and drives it the way
+main/app_switch.cpp does: OnWithTimedOff through
+app_onoff_timer_on_with_timed_off(), OnOff changes through
+app_onoff_timer_onoff_changed(), OnTime/OffWaitTime writes through
+app_onoff_timer_attribute_written(), and the shared 1/10 s tick. The
+actions it returns are applied like apply_timer_actions(): TURN_ON and
+TURN_OFF change OnOff (which comes back as an OnOff change), STORE copies
+the counters into the attributes.
+
+After every step OnOff, OnTime and OffWaitTime (engine state and the
+stored attributes) are compared with a model written from the On/Off
+cluster specification (OnWithTimedOff command and the timed on/off
+behaviour of the Lighting feature):
+
+  - AcceptOnlyWhenOn discards the command while off
+  - the delayed off guard (off, OffWaitTime > 0) only shortens OffWaitTime
+  - otherwise OnTime = max(OnTime, command OnTime), OffWaitTime = command
+    OffWaitTime and OnOff = TRUE
+  - command OnTime/OffWaitTime are clamped to 0xFFFE
+  - while on, OnTime counts down; at zero OffWaitTime is cleared and OnOff
+    set FALSE (expiry). While off, OffWaitTime counts down. Nothing counts
+    while either attribute is 0xFFFF
+  - turning on with OnTime zero clears OffWaitTime; turning off clears OnTime
+
+Named scenarios cover each rule; random sequences over several endpoints
+cover their interaction. The script exits with status 1 on any mismatch.
+
+Usage:
+    python3 scripts/onoff_timer_replay.py
+    python3 scripts/onoff_timer_replay.py --steps 50000 --seed 7 --json
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import random
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+SLOTS = 4
+FOREVER = 0xFFFF
+MAX_TIME = 0xFFFE       # Largest OnTime/OffWaitTime a command can set
+TURN_ON, TURN_OFF, STORE, REPORT, NO_SLOT = 1, 2, 4, 8, 16
+
+
+class Slot(ctypes.Structure):
+    _fields_ = [('endpoint_id', ctypes.c_uint16), ('on_time', ctypes.c_uint16), ('off_wait_time', ctypes.c_uint16),
+                ('on', ctypes.c_bool), ('used', ctypes.c_bool)]
+
+
+class Timer(ctypes.Structure):
+    _fields_ = [('slots', Slot * SLOTS)]
+
+
+TICK_CB = ctypes.CFUNCTYPE(None, ctypes.POINTER(Slot), ctypes.c_uint32, ctypes.c_void_p)
+
+
+def build_engine(workdir):
+    """Compile the engine into a shared library and bind its functions."""
+    lib = host_engine.build(workdir, 'app_onoff_timer', ['app_onoff_timer.cpp'])
+    lib.app_onoff_timer_init.argtypes = [ctypes.POINTER(Timer)]
+    lib.app_onoff_timer_init.restype = None
+    lib.app_onoff_timer_on_with_timed_off.argtypes = [ctypes.POINTER(Timer), ctypes.c_uint16, ctypes.c_bool,
+                                                      ctypes.c_bool, ctypes.c_uint16, ctypes.c_uint16]
+    lib.app_onoff_timer_on_with_timed_off.restype = ctypes.c_uint32
+    lib.app_onoff_timer_onoff_changed.argtypes = [ctypes.POINTER(Timer), ctypes.c_uint16, ctypes.c_bool]
+    lib.app_onoff_timer_onoff_changed.restype = ctypes.c_uint32
+    lib.app_onoff_timer_attribute_written.argtypes = [ctypes.POINTER(Timer), ctypes.c_uint16, ctypes.c_bool,
+                                                      ctypes.c_bool, ctypes.c_uint16]
+    lib.app_onoff_timer_attribute_written.restype = None
+    lib.app_onoff_timer_tick.argtypes = [ctypes.POINTER(Timer), TICK_CB, ctypes.c_void_p]
+    lib.app_onoff_timer_tick.restype = None
+    lib.app_onoff_timer_running.argtypes = [ctypes.POINTER(Timer)]
+    lib.app_onoff_timer_running.restype = ctypes.c_bool
+    lib.app_onoff_timer_get.argtypes = [ctypes.POINTER(Timer), ctypes.c_uint16]
+    lib.app_onoff_timer_get.restype = ctypes.POINTER(Slot)
+    return lib
+
+
+class Device:
+    """The engine plus the OnOff/OnTime/OffWaitTime attributes, wired like main/app_switch.cpp."""
+
+    def __init__(self, lib):
+        self.lib = lib
+        self.timer = Timer()
+        lib.app_onoff_timer_init(ctypes.byref(self.timer))
+        self.onoff = {}
+        self.attrs = {}         # endpoint -> [OnTime, OffWaitTime] as stored
+        self.tick_cb = TICK_CB(self._tick_actions)
+
+    def counters(self, endpoint):
+        slot = self.lib.app_onoff_timer_get(ctypes.byref(self.timer), endpoint)
+        return (slot.contents.on_time, slot.contents.off_wait_time) if slot else (0, 0)
+
+    def state(self, endpoint):
+        return self.onoff.get(endpoint, False), self.counters(endpoint), tuple(self.attrs.get(endpoint, (0, 0)))
+
+    def set_onoff(self, endpoint, on):
+        # Attribute callback only on a change, as from the data model
+        if self.onoff.get(endpoint, False) == on:
+            return
+        self.onoff[endpoint] = on
+        self.apply(endpoint, self.lib.app_onoff_timer_onoff_changed(ctypes.byref(self.timer), endpoint, on))
+
+    def apply(self, endpoint, actions):
+        if actions & STORE:
+            self.attrs[endpoint] = list(self.counters(endpoint))
+        if actions & TURN_ON:
+            self.set_onoff(endpoint, True)
+        if actions & TURN_OFF:
+            self.set_onoff(endpoint, False)
+
+    def command(self, endpoint, accept_only_when_on, on_time, off_wait_time):
+        actions = self.lib.app_onoff_timer_on_with_timed_off(ctypes.byref(self.timer), endpoint,
+                                                             self.onoff.get(endpoint, False), accept_only_when_on,
+                                                             on_time, off_wait_time)
+        if actions & NO_SLOT:
+            return 'no_slot'
+        self.apply(endpoint, actions)
+        return 'ok'
+
+    def write(self, endpoint, is_on_time, value):
+        self.attrs.setdefault(endpoint, [0, 0])[0 if is_on_time else 1] = value
+        self.lib.app_onoff_timer_attribute_written(ctypes.byref(self.timer), endpoint, self.onoff.get(endpoint, False),
+                                                   is_on_time, value)
+
+    def _tick_actions(self, slot, actions, _arg):
+        self.pending.append((slot.contents.endpoint_id, actions))
+
+    def tick(self):
+        self.pending = []
+        self.lib.app_onoff_timer_tick(ctypes.byref(self.timer), self.tick_cb, None)
+        for endpoint, actions in self.pending:
+            self.apply(endpoint, actions)
+
+
+class Spec:
+    """On/Off cluster timed on/off behaviour, per endpoint; no use of the engine."""
+
+    def __init__(self):
+        self.onoff = {}
+        self.on_time = {}
+        self.off_wait = {}
+
+    def tracked(self):
+        return {ep for ep in set(self.on_time) | set(self.off_wait)
+                if self.on_time.get(ep, 0) or self.off_wait.get(ep, 0)}
+
+    def state(self, endpoint):
+        counters = (self.on_time.get(endpoint, 0), self.off_wait.get(endpoint, 0))
+        return self.onoff.get(endpoint, False), counters, counters
+
+    def set_onoff(self, endpoint, on):
+        if self.onoff.get(endpoint, False) == on:
+            return
+        self.onoff[endpoint] = on
+        if on and self.on_time.get(endpoint, 0) == 0:
+            self.off_wait[endpoint] = 0
+        elif not on:
+            self.on_time[endpoint] = 0
+
+    def command(self, endpoint, accept_only_when_on, on_time, off_wait_time):
+        on = self.onoff.get(endpoint, False)
+        if accept_only_when_on and not on:
+            return 'ok'
+        if endpoint not in self.tracked() and len(self.tracked()) >= SLOTS:
+            return 'no_slot'
+        on_time = min(on_time, MAX_TIME)
+        off_wait_time = min(off_wait_time, MAX_TIME)
+        if not on and self.off_wait.get(endpoint, 0) > 0:
+            self.off_wait[endpoint] = min(self.off_wait[endpoint], off_wait_time)
+        else:
+            self.on_time[endpoint] = max(self.on_time.get(endpoint, 0), on_time)
+            self.off_wait[endpoint] = off_wait_time
+            self.onoff[endpoint] = True
+        return 'ok'
+
+    def write(self, endpoint, is_on_time, value):
+        (self.on_time if is_on_time else self.off_wait)[endpoint] = value
+
+    def tick(self):
+        for endpoint in sorted(self.tracked()):
+            on_time, off_wait = self.on_time.get(endpoint, 0), self.off_wait.get(endpoint, 0)
+            if self.onoff.get(endpoint, False):
+                if 0 < on_time < FOREVER and off_wait < FOREVER:
+                    self.on_time[endpoint] = on_time - 1
+                    if on_time == 1:
+                        self.off_wait[endpoint] = 0
+                        self.onoff[endpoint] = False
+            elif 0 < off_wait < FOREVER:
+                self.off_wait[endpoint] = off_wait - 1
+
+
+def scenarios():
+    """Named step lists, one per rule. Steps: (op, endpoint, ...)."""
+    return {
+        'accept_only_when_on_discarded': [('cmd', 1, True, 50, 20), ('tick', 10)],
+        'accept_only_when_on_applied': [('on', 1), ('cmd', 1, True, 50, 20), ('tick', 60)],
+        'timed_on_expiry': [('cmd', 1, False, 30, 10), ('tick', 29), ('tick', 1), ('tick', 20)],
+        'delayed_off_guard': [('cmd', 1, False, 100, 50), ('off', 1), ('cmd', 1, False, 100, 30),
+                              ('cmd', 1, False, 100, 80), ('tick', 31), ('cmd', 1, False, 100, 5), ('tick', 120)],
+        'on_time_keeps_longer': [('cmd', 1, False, 50, 0), ('tick', 5), ('cmd', 1, False, 20, 0), ('tick', 50)],
+        'clamp_to_max': [('cmd', 1, False, 0xFFFF, 0xFFFF), ('tick', 3), ('off', 1), ('tick', 3)],
+        'forever_holds': [('on', 1), ('write', 1, True, FOREVER), ('tick', 10), ('write', 1, True, 20),
+                          ('write', 1, False, FOREVER), ('tick', 30), ('write', 1, False, 0), ('tick', 30)],
+        'command_on_time_zero': [('cmd', 1, False, 0, 50), ('tick', 10), ('off', 1), ('tick', 60)],
+        'on_clears_off_wait': [('cmd', 1, False, 10, 40), ('off', 1), ('tick', 5), ('on', 1), ('tick', 50)],
+        'slot_table_full': [('cmd', ep, False, 100, 10) for ep in range(1, SLOTS + 2)] +
+                           [('tick', 101), ('cmd', SLOTS + 1, False, 100, 10), ('tick', 5)],
+    }
+
+
+def random_steps(rng, count, endpoints):
+    times = [0, 1, 5, 30, 300, MAX_TIME, FOREVER]
+    steps = []
+    for _ in range(count):
+        ep = rng.randint(1, endpoints)
+        op = rng.choices(['cmd', 'on', 'off', 'tick', 'write'], weights=[4, 2, 2, 6, 1])[0]
+        if op == 'cmd':
+            steps.append(('cmd', ep, rng.random() < 0.3, rng.choice(times + [rng.randint(0, 200)]),
+                          rng.choice(times + [rng.randint(0, 200)])))
+        elif op == 'tick':
+            steps.append(('tick', rng.choice([1, 1, 2, 10, 50])))
+        elif op == 'write':
+            steps.append(('write', ep, rng.random() < 0.5, rng.choice(times + [rng.randint(0, 200)])))
+        else:
+            steps.append((op, ep))
+    return steps
+
+
+def replay(lib, steps):
+    """Run steps on the engine and the model; returns (ticks, failure or None)."""
+    device, spec = Device(lib), Spec()
+    endpoints = sorted({s[1] for s in steps if s[0] != 'tick'})
+    ticks = 0
+    for index, step in enumerate(steps):
+        op = step[0]
+        results = []
+        for target in (device, spec):
+            if op == 'cmd':
+                results.append(target.command(*step[1:]))
+            elif op in ('on', 'off'):
+                target.set_onoff(step[1], op == 'on')
+            elif op == 'write':
+                target.write(*step[1:])
+        if op == 'tick':
+            for _ in range(step[1]):
+                device.tick()
+                spec.tick()
+                ticks += 1
+                for ep in endpoints:
+                    if device.state(ep) != spec.state(ep):
+                        return ticks, _mismatch(index, step, ep, device, spec)
+        if results and results[0] != results[1]:
+            return ticks, f'step {index} {step}: engine {results[0]}, spec {results[1]}'
+        for ep in endpoints:
+            if device.state(ep) != spec.state(ep):
+                return ticks, _mismatch(index, step, ep, device, spec)
+        if lib.app_onoff_timer_running(ctypes.byref(device.timer)) != _spec_running(spec):
+            return ticks, f'step {index} {step}: running {not _spec_running(spec)}, spec {_spec_running(spec)}'
+    return ticks, None
+
+
+def _spec_running(spec):
+    for ep in spec.tracked():
+        on_time, off_wait = spec.on_time.get(ep, 0), spec.off_wait.get(ep, 0)
+        if spec.onoff.get(ep, False):
+            if 0 < on_time < FOREVER and off_wait < FOREVER:
+                return True
+        elif 0 < off_wait < FOREVER:
+            return True
+    return False
+
+
+def _mismatch(index, step, endpoint, device, spec):
+    def fmt(state):
+        on, (on_time, off_wait), attrs = state
+        return f'{"on" if on else "off"} OnTime {on_time} OffWaitTime {off_wait} (stored {attrs[0]}/{attrs[1]})'
+    return f'step {index} {step}, endpoint {endpoint}: engine {fmt(device.state(endpoint))}, ' \
+           f'spec {fmt(spec.state(endpoint))}'
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Check the OnOff timed on/off engine against the On/Off cluster rules',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--steps', type=int, default=20000, help='Random steps to generate (default: 20000)')
+    parser.add_argument('--endpoints', type=int, default=SLOTS,
+                        help=f'Endpoints in the random steps, 1-{SLOTS} (default: {SLOTS})')
+    parser.add_argument('--seed', type=int, default=1, help='Random seed (default: 1)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+    if not 1 <= args.endpoints <= SLOTS:
+        sys.exit(f'Error: --endpoints must be 1-{SLOTS} (writes beyond the slot table are not tracked)')
+
+    runs = scenarios()
+    runs[f'random_{args.steps}'] = random_steps(random.Random(args.seed), args.steps, args.endpoints)
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_onoff_timer_')
+    try:
+        lib = build_engine(workdir)
+        results = []
+        for name, steps in runs.items():
+            ticks, failure = replay(lib, steps)
+            results.append({'scenario': name, 'steps': len(steps), 'ticks': ticks, 'failure': failure})
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    failed = [r for r in results if r['failure']]
+    if args.json:
+        print(json.dumps({'scenarios': results}, indent=2))
+    else:
+        for r in results:
+            print(f"  {r['scenario']:30} {'FAIL' if r['failure'] else 'ok':5} {r['steps']:6} steps, "
+                  f"{r['ticks']:7} ticks")
+            if r['failure']:
+                print(f"      {r['failure']}")
+        print(f'{len(results) - len(failed)}/{len(results)} scenarios passed')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
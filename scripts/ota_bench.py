@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Benchmark OTA downloads against a local chip-ota-provider-app on Linux
+
+Starts chip-ota-provider-app serving an OTA image, commissions it into the
+same chip-tool fabric as the device, announces it to the device and waits for
+the device's "OTA stats: {json}" log line (see main/app_ota.cpp) on the serial
+port. Repeats for --runs transfers and prints a summary.
+
+The device must already be commissioned with the same chip-tool (node ID
+--device-node-id) and running firmware older than the image.
+
+Usage:
+    python3 scripts/ota_bench.py --image build/delta.ota --port /dev/ttyACM0 \\
+        --chip-tool out/chip-tool/chip-tool \\
+        --provider-app out/ota-provider/chip-ota-provider-app
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    print("Error: pyserial library not found. Install with: pip install pyserial")
+    sys.exit(1)
+
+STATS_PATTERN = re.compile(r'OTA stats: (\{.*\})')
+
+PROVIDER_PASSCODE = 20202021
+PROVIDER_DISCRIMINATOR = 3841
+PROVIDER_PORT = 5565
+
+# ACL on the provider: admin for chip-tool, operate OTA Provider cluster (41) for everyone
+PROVIDER_ACL = ('[{"fabricIndex": 1, "privilege": 5, "authMode": 2, "subjects": [112233], "targets": null},'
+                ' {"fabricIndex": 1, "privilege": 3, "authMode": 2, "subjects": null,'
+                ' "targets": [{"cluster": 41, "endpoint": null, "deviceType": null}]}]')
+
+
+def chip_tool(args, *cmd):
+    """Run a chip-tool command, raising on failure."""
+    result = subprocess.run([args.chip_tool, *[str(c) for c in cmd]],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, timeout=120)
+    if result.returncode != 0:
+        raise RuntimeError(f"chip-tool {' '.join(str(c) for c in cmd)} failed:\n{result.stdout[-2000:]}")
+    return result.stdout
+
+
+def start_provider(args):
+    """Start chip-ota-provider-app with a fresh KVS and commission it."""
+    kvs = '/tmp/chip_kvs_ota_bench'
+    if os.path.exists(kvs):
+        os.remove(kvs)
+
+    log = open('/tmp/ota_bench_provider.log', 'w')
+    provider = subprocess.Popen([args.provider_app, '-f', args.image,
+                                 '--discriminator', str(PROVIDER_DISCRIMINATOR),
+                                 '--secured-device-port', str(PROVIDER_PORT),
+                                 '--KVS', kvs],
+                                stdout=log, stderr=subprocess.STDOUT)
+    time.sleep(2)
+
+    chip_tool(args, 'pairing', 'onnetwork-long', args.provider_node_id, PROVIDER_PASSCODE, PROVIDER_DISCRIMINATOR)
+    chip_tool(args, 'accesscontrol', 'write', 'acl', PROVIDER_ACL, args.provider_node_id, 0)
+    return provider
+
+
+def wait_for_stats(port, timeout):
+    """Read device log lines until an OTA stats line appears."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        line = port.readline().decode('utf-8', errors='replace')
+        match = STATS_PATTERN.search(line)
+        if match:
+            return json.loads(match.group(1))
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmark OTA downloads against a local chip-ota-provider-app',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--image', required=True, help='Matter OTA image (.ota) to serve')
+    parser.add_argument('--port', required=True, help='Device serial port')
+    parser.add_argument('--baud', type=int, default=115200, help='Serial baud rate (default: 115200)')
+    parser.add_argument('--chip-tool', default=shutil.which('chip-tool') or 'chip-tool',
+                        help='Path to chip-tool')
+    parser.add_argument('--provider-app', default=shutil.which('chip-ota-provider-app') or 'chip-ota-provider-app',
+                        help='Path to chip-ota-provider-app')
+    parser.add_argument('--device-node-id', type=int, default=1, help='Device node ID (default: 1)')
+    parser.add_argument('--provider-node-id', type=int, default=100, help='Provider node ID (default: 100)')
+    parser.add_argument('--runs', type=int, default=1, help='Number of transfers (default: 1)')
+    parser.add_argument('--timeout', type=int, default=1800, help='Per-transfer timeout in seconds (default: 1800)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+
+    args = parser.parse_args()
+
+    results = []
+    provider = start_provider(args)
+    try:
+        with serial.Serial(args.port, args.baud, timeout=1) as port:
+            for run in range(1, args.runs + 1):
+                port.reset_input_buffer()
+                started = time.time()
+                # announce-otaprovider <provider-node> <vendor> <reason: UpdateAvailable> <endpoint> <node> <ep>
+                chip_tool(args, 'otasoftwareupdaterequestor', 'announce-otaprovider',
+                          args.provider_node_id, 0, 1, 0, args.device_node_id, 0)
+                stats = wait_for_stats(port, args.timeout)
+                if stats is None:
+                    print(f"Run {run}: timed out waiting for OTA stats")
+                    break
+                stats['wall_s'] = round(time.time() - started, 1)
+                results.append(stats)
+                if not args.json:
+                    print(f"Run {run}: {stats['bytes']} bytes in {stats['duration_ms'] / 1000:.1f}s "
+                          f"({stats['bytes_per_sec']} B/s), rtt avg {stats['rtt_avg_us'] / 1000:.1f}ms "
+                          f"[{stats['rtt_min_us'] / 1000:.1f}-{stats['rtt_max_us'] / 1000:.1f}], "
+                          f"stalls {stats['stalls']}, flash {stats['flash_ms']}ms "
+                          f"in {stats['flash_writes']} writes, batch {stats['batch_size']}")
+    finally:
+        provider.send_signal(signal.SIGINT)
+        provider.wait(timeout=10)
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+    elif results:
+        rates = [r['bytes_per_sec'] for r in results]
+        print(f"Throughput: min {min(rates)} / avg {sum(rates) // len(rates)} / max {max(rates)} B/s")
+
+
+if __name__ == '__main__':
+    main()
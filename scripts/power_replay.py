@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Replay power samples through the firmware's report suppression engine
+
+Builds main/app_power_engine.cpp for the host and feeds it either a
+recorded trace or the deterministic simulated source (the same one the
+firmware uses until a meter driver is installed). It counts the reports the
+device would send and compares them with reporting every sample. It also
+estimates the 802.15.4 airtime that the suppression saves on a Thread mesh.
+
+Trace CSV columns: t_ms,voltage_mv,current_ma,power_mw (header optional).
+
+Usage:
+    python3 scripts/power_replay.py --duration 3600 --toggle-every 600
+    python3 scripts/power_replay.py --trace samples.csv --delta-mw 2000 --json
+"""
+
+import argparse
+import csv
+import ctypes
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+REPORT_VOLTAGE, REPORT_CURRENT, REPORT_POWER, REPORT_ENERGY = 1, 2, 4, 8
+MEASUREMENTS = 3
+
+# Airtime model (IEEE 802.15.4 O-QPSK, 250 kbit/s)
+US_PER_BYTE = 32
+PHY_OVERHEAD = 6            # Preamble, SFD, PHR
+MAX_FRAME = 127             # PSDU
+FRAME_OVERHEAD = 25         # MAC header + FCS + 6LoWPAN/mesh headers per frame
+ACK_US = 192 + (5 + PHY_OVERHEAD) * US_PER_BYTE    # Turnaround + ACK frame
+CSMA_US = 1120              # Mean first-attempt backoff + CCA
+REPORT_BASE_BYTES = 62      # IPv6/UDP (compressed) + Matter header/MIC + ReportData envelope
+ATTRIBUTE_BYTES = 22        # AttributeReportIB with an int64 value
+EVENT_BYTES = 48            # CumulativeEnergyMeasured EventReportIB
+STATUS_RESPONSE_BYTES = 48  # Subscriber's StatusResponse (piggybacks the MRP ack)
+
+
+class Sample(ctypes.Structure):
+    _fields_ = [('voltage_mv', ctypes.c_int64), ('current_ma', ctypes.c_int64), ('power_mw', ctypes.c_int64)]
+
+
+class Thresholds(ctypes.Structure):
+    _fields_ = [('delta', ctypes.c_int64 * MEASUREMENTS), ('energy_delta_mwh', ctypes.c_int64),
+                ('min_interval_us', ctypes.c_int64), ('max_interval_us', ctypes.c_int64)]
+
+
+class Engine(ctypes.Structure):
+    _fields_ = [('thresholds', Thresholds), ('filtered', ctypes.c_int64 * MEASUREMENTS),
+                ('published', ctypes.c_int64 * MEASUREMENTS), ('measurement_at_us', ctypes.c_int64),
+                ('energy_at_us', ctypes.c_int64), ('last_sample_us', ctypes.c_int64),
+                ('energy_mwh', ctypes.c_uint64), ('energy_rem_mwms', ctypes.c_uint64),
+                ('published_energy_mwh', ctypes.c_uint64), ('samples', ctypes.c_uint32),
+                ('reports', ctypes.c_uint32), ('attributes', ctypes.c_uint32),
+                ('energy_reports', ctypes.c_uint32), ('primed', ctypes.c_bool)]
+
+
+class Sim(ctypes.Structure):
+    _fields_ = [('seed', ctypes.c_uint32), ('n', ctypes.c_uint32)]
+
+
+def build_engine(workdir):
+    """Compile the engine into a shared library and bind its functions."""
+    lib = host_engine.build(workdir, 'app_power_engine', ['app_power_engine.cpp'])
+    lib.app_power_engine_init.argtypes = [ctypes.POINTER(Engine), ctypes.POINTER(Thresholds), ctypes.c_int64]
+    lib.app_power_engine_feed.argtypes = [ctypes.POINTER(Engine), ctypes.c_int64, ctypes.POINTER(Sample)]
+    lib.app_power_engine_feed.restype = ctypes.c_uint32
+    lib.app_power_sim_init.argtypes = [ctypes.POINTER(Sim), ctypes.c_uint32]
+    lib.app_power_sim_read.argtypes = [ctypes.POINTER(Sim), ctypes.c_bool, ctypes.POINTER(Sample)]
+    return lib
+
+
+def frame_airtime_us(payload):
+    """Airtime of one message including fragmentation, ACKs and CSMA."""
+    per_frame = MAX_FRAME - FRAME_OVERHEAD
+    frames = max(1, -(-payload // per_frame))
+    total_bytes = payload + frames * (FRAME_OVERHEAD + PHY_OVERHEAD)
+    return total_bytes * US_PER_BYTE + frames * (ACK_US + CSMA_US)
+
+
+def report_airtime_us(bits):
+    attributes = bin(bits & (REPORT_VOLTAGE | REPORT_CURRENT | REPORT_POWER)).count('1')
+    payload = REPORT_BASE_BYTES + attributes * ATTRIBUTE_BYTES + (EVENT_BYTES if bits & REPORT_ENERGY else 0)
+    return frame_airtime_us(payload) + frame_airtime_us(STATUS_RESPONSE_BYTES)
+
+
+def trace_samples(path):
+    with open(path, newline='') as f:
+        for row in csv.reader(f):
+            if not row or not row[0].strip().lstrip('-').isdigit():
+                continue
+            t_ms, voltage, current, power = (int(v) for v in row[:4])
+            yield t_ms, Sample(voltage, current, power)
+
+
+def sim_samples(lib, args):
+    sim = Sim()
+    lib.app_power_sim_init(ctypes.byref(sim), args.seed)
+    for i in range(int(args.duration * 1000 // args.sample_ms)):
+        t_ms = i * args.sample_ms
+        on = (t_ms // (args.toggle_every * 1000)) % 2 == 1 if args.toggle_every else True
+        sample = Sample()
+        lib.app_power_sim_read(ctypes.byref(sim), on, ctypes.byref(sample))
+        yield t_ms, sample
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Replay power samples through the firmware report suppression engine',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--trace', help='CSV trace (t_ms,voltage_mv,current_ma,power_mw); default: simulated source')
+    parser.add_argument('--duration', type=float, default=3600, help='Simulated seconds (default: 3600)')
+    parser.add_argument('--sample-ms', type=int, default=1000, help='Simulated sample period (default: 1000)')
+    parser.add_argument('--seed', type=int, default=1, help='Simulator noise seed (default: 1)')
+    parser.add_argument('--toggle-every', type=float, default=600,
+                        help='Simulated seconds between on/off toggles, 0 = always on (default: 600)')
+    parser.add_argument('--delta-mv', type=int, default=2000, help='Voltage delta (default: 2000)')
+    parser.add_argument('--delta-ma', type=int, default=50, help='Active current delta (default: 50)')
+    parser.add_argument('--delta-mw', type=int, default=5000, help='Active power delta (default: 5000)')
+    parser.add_argument('--delta-mwh', type=int, default=10000, help='Energy delta (default: 10000)')
+    parser.add_argument('--min-interval', type=float, default=5, help='Minimum seconds between reports (default: 5)')
+    parser.add_argument('--max-interval', type=float, default=300, help='Report any change after (default: 300)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_power_')
+    try:
+        lib = build_engine(workdir)
+
+        thresholds = Thresholds((ctypes.c_int64 * MEASUREMENTS)(args.delta_mv, args.delta_ma, args.delta_mw),
+                                args.delta_mwh, int(args.min_interval * 1e6), int(args.max_interval * 1e6))
+        engine = Engine()
+        samples = trace_samples(args.trace) if args.trace else sim_samples(lib, args)
+
+        airtime_us = 0
+        baseline_us = 0
+        every_sample = report_airtime_us(REPORT_VOLTAGE | REPORT_CURRENT | REPORT_POWER | REPORT_ENERGY)
+        first = True
+        last_ms = 0
+        for t_ms, sample in samples:
+            if first:
+                lib.app_power_engine_init(ctypes.byref(engine), ctypes.byref(thresholds), t_ms * 1000)
+                first = False
+            bits = lib.app_power_engine_feed(ctypes.byref(engine), t_ms * 1000, ctypes.byref(sample))
+            baseline_us += every_sample
+            if bits:
+                airtime_us += report_airtime_us(bits)
+            last_ms = t_ms
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    if first:
+        sys.exit('Error: no samples')
+
+    result = {
+        'samples': engine.samples,
+        'reports': engine.reports,
+        'suppressed': engine.samples - engine.reports,
+        'suppression_ratio': round(1 - engine.reports / engine.samples, 4),
+        'attributes': engine.attributes,
+        'energy_reports': engine.energy_reports,
+        'energy_mwh': engine.energy_mwh,
+        'duration_s': round(last_ms / 1000, 1),
+        'airtime_ms': round(airtime_us / 1000, 1),
+        'baseline_airtime_ms': round(baseline_us / 1000, 1),
+        'airtime_saved_ms': round((baseline_us - airtime_us) / 1000, 1),
+        'airtime_saved_ratio': round(1 - airtime_us / baseline_us, 4),
+    }
+
+    if args.json:
+        print(json.dumps(result, indent=2))
+        return
+
+    print(f"Samples:      {result['samples']} over {result['duration_s']} s")
+    print(f"Reports:      {result['reports']} ({result['attributes']} attributes, "
+          f"{result['energy_reports']} energy events)")
+    print(f"Suppressed:   {result['suppressed']} samples ({result['suppression_ratio'] * 100:.1f}%)")
+    print(f"Energy:       {result['energy_mwh']} mWh")
+    print(f"Airtime:      {result['airtime_ms']} ms vs {result['baseline_airtime_ms']} ms reporting every sample "
+          f"({result['airtime_saved_ratio'] * 100:.1f}% saved)")
+
+
+if __name__ == '__main__':
+    main()
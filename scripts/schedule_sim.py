@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""
+Fast-forward the on-device schedule through a virtual week
+
+Builds main/app_schedule_engine.cpp for the host and drives it the way
+app_schedule.cpp does: one timer armed for the next firing returned by
+app_schedule_advance() (capped at SCHEDULE_MAX_SLEEP_S), plus an immediate
+evaluation whenever the clock is set. The catch-up, rewind-hold and
+restart policy is the firmware's own code in app_schedule_advance(). The
+virtual clock runs a week in a few seconds and can be stepped forward and
+back (controller resync, DST) at chosen points.
+
+Every firing is checked against a brute-force reference. The reference
+evaluates the catch-up and rewind rules once per virtual second and
+matches entries against the calendar with datetime, without the engine.
+The script exits non-zero on the first mismatch.
+
+Usage:
+    python3 scripts/schedule_sim.py
+    python3 scripts/schedule_sim.py --seed 7 --entries 16 --days 28 --json
+"""
+
+import argparse
+import calendar
+import ctypes
+import datetime
+import json
+import os
+import random
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+MAX_ENTRIES = 16
+NONE = 2**63 - 1
+ACTION_OFF, ACTION_ON, ACTION_TOGGLE = 0, 1, 2
+
+# Firmware policy (main/app_schedule.h)
+CATCHUP_S = 60
+MAX_SLEEP_S = 3600
+REWIND_HOLD_S = 7200
+
+# Local clock at the start: Monday 2026-03-02 00:00
+START_LOCAL = calendar.timegm((2026, 3, 2, 0, 0, 0))
+
+
+class Entry(ctypes.Structure):
+    _fields_ = [('days', ctypes.c_uint8), ('minute', ctypes.c_uint16), ('action', ctypes.c_uint8),
+                ('enabled', ctypes.c_bool)]
+
+
+class Schedule(ctypes.Structure):
+    _fields_ = [('entries', Entry * MAX_ENTRIES)]
+
+
+class Eval(ctypes.Structure):
+    _fields_ = [('catchup_s', ctypes.c_int64), ('rewind_hold_s', ctypes.c_int64), ('last_s', ctypes.c_int64),
+                ('started', ctypes.c_bool), ('fired', ctypes.c_uint32), ('skipped', ctypes.c_uint32)]
+
+
+FIRE_CB = ctypes.CFUNCTYPE(None, ctypes.c_uint32, ctypes.c_int64, ctypes.c_void_p)
+
+
+def build_engine(workdir):
+    """Compile the engine into a shared library and bind its functions."""
+    lib = host_engine.build(workdir, 'app_schedule_engine', ['app_schedule_engine.cpp'])
+    lib.app_schedule_entry_valid.argtypes = [ctypes.POINTER(Entry)]
+    lib.app_schedule_entry_valid.restype = ctypes.c_bool
+    lib.app_schedule_pack.argtypes = [ctypes.c_uint8, ctypes.POINTER(Entry)]
+    lib.app_schedule_pack.restype = ctypes.c_uint32
+    lib.app_schedule_unpack.argtypes = [ctypes.POINTER(Schedule), ctypes.c_uint32]
+    lib.app_schedule_unpack.restype = ctypes.c_bool
+    lib.app_schedule_next.argtypes = [ctypes.POINTER(Schedule), ctypes.c_int64, ctypes.POINTER(ctypes.c_uint32)]
+    lib.app_schedule_next.restype = ctypes.c_int64
+    lib.app_schedule_apply.argtypes = [ctypes.POINTER(Schedule), ctypes.c_uint32, ctypes.c_bool]
+    lib.app_schedule_apply.restype = ctypes.c_bool
+    lib.app_schedule_eval_init.argtypes = [ctypes.POINTER(Eval), ctypes.c_uint32, ctypes.c_uint32]
+    lib.app_schedule_eval_init.restype = None
+    lib.app_schedule_advance.argtypes = [ctypes.POINTER(Schedule), ctypes.POINTER(Eval), ctypes.c_int64, FIRE_CB,
+                                         ctypes.c_void_p]
+    lib.app_schedule_advance.restype = ctypes.c_int64
+    return lib
+
+
+def random_schedule(rng, count):
+    """Random table with shared minutes (ordering) and entries inside the DST hour."""
+    entries = []
+    for i in range(count):
+        days = rng.choice([0x7F, 0x3E, 0x41, 1 << rng.randrange(7), rng.randrange(1, 0x80)])
+        if i % 5 == 1 and entries:
+            minute = entries[-1][1]
+        elif i % 5 == 2:
+            minute = 2 * 60 + rng.randrange(60)
+        else:
+            minute = rng.randrange(1440)
+        entries.append((days, minute, rng.choice([ACTION_OFF, ACTION_ON, ACTION_TOGGLE]), rng.random() > 0.15))
+    return entries
+
+
+def load_schedule(lib, entries):
+    """Fill the table through pack/unpack, as the firmware loads it from NVS."""
+    schedule = Schedule()
+    for index, (days, minute, action, enabled) in enumerate(entries):
+        entry = Entry(days, minute, action, enabled)
+        if not lib.app_schedule_entry_valid(ctypes.byref(entry)):
+            sys.exit(f'Error: entry {index} rejected')
+        word = lib.app_schedule_pack(index, ctypes.byref(entry))
+        if not lib.app_schedule_unpack(ctypes.byref(schedule), word):
+            sys.exit(f'Error: entry {index} did not survive pack/unpack (0x{word:08x})')
+    return schedule
+
+
+def default_steps(days):
+    """Clock steps as (virtual second, seconds): resync forward, DST end, DST start, big correction."""
+    steps = [(1 * 86400 + 10 * 3600 + 7 * 60, 3 * 3600),
+             (3 * 86400 + 3 * 3600, -3600),
+             (5 * 86400 + 2 * 3600, 3600),
+             (6 * 86400 + 12 * 3600, -3 * 86400)]
+    return [s for s in steps if s[0] < days * 86400]
+
+
+class Device:
+    """Timer-driven evaluation, mirroring evaluate() in main/app_schedule.cpp."""
+
+    def __init__(self, lib, schedule):
+        self.lib = lib
+        self.schedule = schedule
+        self.state = Eval()
+        lib.app_schedule_eval_init(ctypes.byref(self.state), CATCHUP_S, REWIND_HOLD_S)
+        self.on = False
+        self.wakeups = 0
+        self.firings = []
+        self.real = 0
+        self.fire_cb = FIRE_CB(self.fire)     # Kept referenced while the engine may call it
+
+    @property
+    def skipped(self):
+        return self.state.skipped
+
+    def fire(self, mask, at, _arg):
+        self.on = self.lib.app_schedule_apply(ctypes.byref(self.schedule), mask, self.on)
+        self.firings.append((self.real, at, mask, self.on))
+
+    def evaluate(self, real, now):
+        """Returns the delay until the next wake-up."""
+        self.wakeups += 1
+        self.real = real
+        at = self.lib.app_schedule_advance(ctypes.byref(self.schedule), ctypes.byref(self.state), now, self.fire_cb,
+                                           None)
+        return MAX_SLEEP_S if at == NONE else min(at - now, MAX_SLEEP_S)
+
+    def run(self, seconds, steps):
+        offset = 0
+        pending = sorted(steps)
+        wake = self.evaluate(0, START_LOCAL)
+        while True:
+            step_at = pending[0][0] if pending else None
+            if step_at is not None and step_at <= wake:
+                # Clock set: the Time Synchronization delegate re-evaluates at once
+                offset += pending.pop(0)[1]
+                wake = step_at + self.evaluate(step_at, START_LOCAL + step_at + offset)
+            elif wake <= seconds:
+                wake += self.evaluate(wake, START_LOCAL + wake + offset)
+            else:
+                break
+
+
+def reference(entries, seconds, steps):
+    """Per-second evaluation with calendar matching; no use of the engine."""
+    def due(lo, hi):
+        """Entry indexes per minute in (lo, hi]."""
+        minute = (lo // 60 + 1) * 60
+        while minute <= hi:
+            dt = datetime.datetime.fromtimestamp(minute, datetime.timezone.utc)
+            weekday_bit = 1 << ((dt.weekday() + 1) % 7)    # Python Monday=0, schedule Sunday=bit 0
+            of_day = dt.hour * 60 + dt.minute
+            mask = 0
+            for index, (days, m, _action, enabled) in enumerate(entries):
+                if enabled and days & weekday_bit and m == of_day:
+                    mask |= 1 << index
+            if mask:
+                yield minute, mask
+            minute += 60
+
+    def apply(mask, on):
+        for index, (_days, _minute, action, _enabled) in enumerate(entries):
+            if mask & (1 << index):
+                on = {ACTION_OFF: False, ACTION_ON: True, ACTION_TOGGLE: not on}[action]
+        return on
+
+    offsets = {}
+    for at, delta in steps:
+        offsets[at] = offsets.get(at, 0) + delta
+    offset = 0
+    last = None
+    on = False
+    skipped = 0
+    firings = []
+    for real in range(seconds + 1):
+        offset += offsets.get(real, 0)
+        now = START_LOCAL + real + offset
+        if last is None or now < last - REWIND_HOLD_S:
+            last = now
+        elif now < last:
+            pass
+        elif now - last > CATCHUP_S:
+            skipped += sum(bin(mask).count('1') for _, mask in due(last, now - CATCHUP_S))
+            last = now - CATCHUP_S
+        for at, mask in due(last, now):
+            on = apply(mask, on)
+            firings.append((real, at, mask, on))
+        last = max(last, now)
+    return firings, skipped
+
+
+def fmt(local):
+    return datetime.datetime.fromtimestamp(local, datetime.timezone.utc).strftime('%a %H:%M')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Fast-forward the on-device schedule engine through a virtual week',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--seed', type=int, default=1, help='Random schedule seed (default: 1)')
+    parser.add_argument('--entries', type=int, default=12, help=f'Entries, 1-{MAX_ENTRIES} (default: 12)')
+    parser.add_argument('--days', type=int, default=7, help='Virtual days to run (default: 7)')
+    parser.add_argument('--no-steps', action='store_true', help='Keep the clock steady (no resync or DST steps)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+    if not 1 <= args.entries <= MAX_ENTRIES:
+        sys.exit(f'Error: --entries must be 1-{MAX_ENTRIES}')
+
+    entries = random_schedule(random.Random(args.seed), args.entries)
+    seconds = args.days * 86400
+    steps = [] if args.no_steps else default_steps(args.days)
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_schedule_')
+    try:
+        lib = build_engine(workdir)
+        device = Device(lib, load_schedule(lib, entries))
+        device.run(seconds, steps)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    expected, expected_skipped = reference(entries, seconds, steps)
+
+    mismatch = None
+    for i in range(max(len(device.firings), len(expected))):
+        got = device.firings[i] if i < len(device.firings) else None
+        want = expected[i] if i < len(expected) else None
+        if got != want:
+            mismatch = {'index': i, 'device': got, 'reference': want}
+            break
+    if mismatch is None and device.skipped != expected_skipped:
+        mismatch = {'skipped_device': device.skipped, 'skipped_reference': expected_skipped}
+
+    result = {
+        'days': args.days,
+        'entries': args.entries,
+        'clock_steps': len(steps),
+        'firings': len(device.firings),
+        'skipped': device.skipped,
+        'wakeups': device.wakeups,
+        'minute_polls': seconds // 60,
+        'final_on': device.on,
+        'match': mismatch is None,
+    }
+    if mismatch:
+        result['mismatch'] = mismatch
+
+    if args.json:
+        print(json.dumps(result, indent=2))
+    else:
+        for real, at, mask, on in device.firings:
+            indexes = ','.join(str(i) for i in range(MAX_ENTRIES) if mask & (1 << i))
+            print(f"  day {real // 86400} +{real % 86400:>5} s  local {fmt(at)}  entries {indexes:<8} -> "
+                  f"{'on' if on else 'off'}")
+        print(f"Firings:      {result['firings']} ({result['skipped']} skipped by clock steps)")
+        print(f"Wake-ups:     {result['wakeups']} vs {result['minute_polls']} for per-minute polling")
+        if mismatch:
+            print(f"MISMATCH:     {mismatch}")
+        else:
+            print("Reference:    match")
+
+    sys.exit(0 if mismatch is None else 1)
+
+
+if __name__ == '__main__':
+    main()
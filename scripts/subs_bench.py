@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+"""
+Ramp fabrics and OnOff subscriptions and measure report fan-out
+
+Each fabric is one chip-tool interactive session with its own storage and
+commissioner. Fabric 1 commissions the target. Every further fabric joins
+through a commissioning window that fabric 1 opens. Within each fabric the script
+adds --subs-per-fabric OnOff subscriptions. After each new subscription it
+flips OnOff the same way the button does and times how long every subscriber
+takes to receive the report (fan-out). The ramp continues until a
+commissioning or subscription fails, which marks the scaling limit.
+
+Targets:
+  --app PATH     Linux build (make linux-build). Toggles go through the
+                 virtual button FIFO. No heap figures.
+  --port DEV     Device already commissioned by the chip-tool storage in
+                 --storage (fabric 1, node --node-id). Toggles go through
+                 the "matter subs-toggle" shell command. Heap per subscription
+                 comes from the device's "SUBS stats" log lines
+                 (main/app_subs.cpp).
+
+Usage:
+    python3 scripts/subs_bench.py --app linux/out/m5nanoc6-switch-app --fabrics 5
+    python3 scripts/subs_bench.py --port /dev/ttyACM0 --storage /tmp/chip_tool --node-id 1
+"""
+
+import argparse
+import json
+import os
+import queue
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from linux_bench import ChipToolSession, DISCRIMINATOR, PASSCODE  # noqa: E402
+
+# chip-tool commissioner names: alpha/beta/gamma, then numeric fabric IDs
+COMMISSIONERS = ['alpha', 'beta', 'gamma'] + [str(i) for i in range(4, 17)]
+BUTTON_FIFO = '/tmp/m5nanoc6-switch-button'
+ENDPOINT = 1
+
+COMMISSIONED_PATTERN = re.compile(r'Device commissioning completed with success')
+SUBSCRIBED_PATTERN = re.compile(r'Subscription established')
+FAILURE_PATTERN = re.compile(r'Run command failure: (.*)')
+MANUAL_CODE_PATTERN = re.compile(r'Manual pairing code: \[(\d+)\]')
+RESPONSE_PATTERN = re.compile(r'Received Command Response Status for Endpoint=\d+ Cluster=0x0000_0006')
+STATS_PATTERN = re.compile(r'SUBS stats \((\w+)\): (\{.*\})')
+
+
+class FabricSession(ChipToolSession):
+    """chip-tool interactive session bound to one commissioner (fabric)."""
+
+    def __init__(self, chip_tool, storage_dir, commissioner):
+        super().__init__(chip_tool, storage_dir)
+        self.commissioner = commissioner
+        self.subscriptions = 0
+
+    def command(self, text):
+        return self.send(f'{text} --commissioner-name {self.commissioner}')
+
+    def wait_any(self, patterns, timeout):
+        """Return (index, match) of the first line matching one of patterns."""
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError('timed out')
+            try:
+                _, line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if line is None:
+                raise RuntimeError('chip-tool exited')
+            for i, pattern in enumerate(patterns):
+                match = pattern.search(line)
+                if match:
+                    return i, match
+
+    def wait_reports(self, value, count, deadline):
+        """Arrival times of the next count OnOff reports carrying value."""
+        pattern = re.compile(r'OnOff: ' + ('TRUE' if value else 'FALSE'))
+        arrivals = []
+        while len(arrivals) < count:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            try:
+                stamp, line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if line is None:
+                break
+            if pattern.search(line):
+                arrivals.append(stamp)
+        return arrivals
+
+
+class DeviceLink:
+    """Serial console: toggles the switch and collects SUBS stats lines."""
+
+    def __init__(self, port, baud):
+        import serial
+        self.port = serial.Serial(port, baud, timeout=1)
+        self.stats = None
+        self.stats_event = threading.Event()
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        while True:
+            line = self.port.readline().decode('utf-8', errors='replace')
+            match = STATS_PATTERN.search(line)
+            if match:
+                self.stats = json.loads(match.group(2))
+                self.stats_event.set()
+
+    def toggle(self):
+        sent = time.monotonic()
+        self.port.write(b'matter subs-toggle\n')
+        return sent
+
+    def wait_stats(self, timeout):
+        self.stats_event.wait(timeout)
+        self.stats_event.clear()
+        return self.stats
+
+
+class LinuxApp:
+    """Linux switch app with a fresh KVS; toggles through the virtual button."""
+
+    def __init__(self, app, workdir):
+        self.log = open(os.path.join(workdir, 'app.log'), 'w')
+        self.proc = subprocess.Popen([app, '--KVS', os.path.join(workdir, 'kvs'),
+                                      '--discriminator', str(DISCRIMINATOR), '--passcode', str(PASSCODE)],
+                                     stdout=self.log, stderr=subprocess.STDOUT)
+        time.sleep(1)
+
+    def toggle(self):
+        sent = time.monotonic()
+        with open(BUTTON_FIFO, 'w') as fifo:
+            fifo.write('click\n')
+        return sent
+
+    def wait_stats(self, timeout):
+        return None
+
+    def close(self):
+        self.proc.send_signal(signal.SIGINT)
+        try:
+            self.proc.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+
+
+def add_fabric(args, sessions, workdir):
+    """Commission the next fabric; returns the session or raises on failure."""
+    index = len(sessions)
+    if index >= len(COMMISSIONERS):
+        raise RuntimeError('out of chip-tool commissioner names')
+
+    if index == 0 and args.storage:
+        session = FabricSession(args.chip_tool, args.storage, COMMISSIONERS[0])
+        sessions.append(session)
+        return session
+
+    storage = os.path.join(workdir, f'fabric{index + 1}')
+    os.makedirs(storage, exist_ok=True)
+    session = FabricSession(args.chip_tool, storage, COMMISSIONERS[index])
+
+    if index == 0:
+        session.command(f'pairing onnetwork {args.node_id} {PASSCODE}')
+    else:
+        # Fabric 1 opens an enhanced commissioning window for the new fabric
+        sessions[0].command(f'pairing open-commissioning-window {args.node_id} 1 300 1000 {DISCRIMINATOR}')
+        i, match = sessions[0].wait_any([MANUAL_CODE_PATTERN, FAILURE_PATTERN], args.timeout)
+        if i != 0:
+            session.close()
+            raise RuntimeError(f'open commissioning window failed: {match.group(1)}')
+        session.command(f'pairing code {args.node_id} {match.group(1)}')
+
+    i, match = session.wait_any([COMMISSIONED_PATTERN, FAILURE_PATTERN], 120)
+    if i != 0:
+        session.close()
+        raise RuntimeError(f'commissioning fabric {index + 1} failed: {match.group(1)}')
+    sessions.append(session)
+    return session
+
+
+def measure_fanout(args, sessions, target, value):
+    """Toggle toggles times, return fan-out samples (ms) and the final OnOff value."""
+    samples = []
+    for _ in range(args.toggles):
+        value = not value
+        sent = target.toggle()
+        deadline = sent + args.timeout
+        arrivals = []
+        for session in sessions:
+            got = session.wait_reports(value, session.subscriptions, deadline)
+            if len(got) < session.subscriptions:
+                raise RuntimeError(f'{session.subscriptions - len(got)} report(s) missing on '
+                                   f'fabric {session.commissioner}')
+            arrivals.extend(got)
+        samples.append({
+            'first_ms': round((min(arrivals) - sent) * 1000, 2),
+            'last_ms': round((max(arrivals) - sent) * 1000, 2),
+        })
+    return samples, value
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Ramp fabrics and OnOff subscriptions and measure report fan-out',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    target_group = parser.add_mutually_exclusive_group(required=True)
+    target_group.add_argument('--app', help='Linux switch app (m5nanoc6-switch-app)')
+    target_group.add_argument('--port', help='Device serial port')
+    parser.add_argument('--baud', type=int, default=115200, help='Serial baud rate (default: 115200)')
+    parser.add_argument('--storage', help='chip-tool storage that commissioned the device (device mode)')
+    parser.add_argument('--chip-tool', default=shutil.which('chip-tool') or 'chip-tool', help='Path to chip-tool')
+    parser.add_argument('--node-id', type=int, default=1, help='Device node ID on every fabric (default: 1)')
+    parser.add_argument('--fabrics', type=int, default=5, help='Fabrics to ramp to (default: 5)')
+    parser.add_argument('--subs-per-fabric', type=int, default=3, help='Subscriptions per fabric (default: 3)')
+    parser.add_argument('--toggles', type=int, default=5, help='Toggles per ramp step (default: 5)')
+    parser.add_argument('--timeout', type=float, default=15.0, help='Per-operation timeout in seconds (default: 15)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+
+    args = parser.parse_args()
+    if args.port and not args.storage:
+        parser.error('--port requires --storage (chip-tool storage of fabric 1)')
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_subs_')
+    target = LinuxApp(args.app, workdir) if args.app else DeviceLink(args.port, args.baud)
+
+    sessions = []
+    steps = []
+    limit = None
+    try:
+        add_fabric(args, sessions, workdir)
+        sessions[0].command(f'onoff off {args.node_id} {ENDPOINT}')
+        sessions[0].wait_any([RESPONSE_PATTERN], args.timeout)
+        value = False
+
+        for fabric in range(1, args.fabrics + 1):
+            if fabric > len(sessions):
+                add_fabric(args, sessions, workdir)
+            session = sessions[fabric - 1]
+
+            for _ in range(args.subs_per_fabric):
+                session.command(f'onoff subscribe on-off 0 60 {args.node_id} {ENDPOINT} --keepSubscriptions true')
+                i, match = session.wait_any([SUBSCRIBED_PATTERN, FAILURE_PATTERN], args.timeout)
+                if i != 0:
+                    raise RuntimeError(f'subscription failed: {match.group(1)}')
+                session.subscriptions += 1
+
+                stats = target.wait_stats(2)
+                samples, value = measure_fanout(args, sessions, target, value)
+                step = {
+                    'fabrics': len(sessions),
+                    'subscriptions': sum(s.subscriptions for s in sessions),
+                    'fanout_first_ms': round(sum(s['first_ms'] for s in samples) / len(samples), 2),
+                    'fanout_last_ms': round(sum(s['last_ms'] for s in samples) / len(samples), 2),
+                    'fanout_max_ms': max(s['last_ms'] for s in samples),
+                }
+                if stats:
+                    step.update({k: stats[k] for k in ('last_sub_heap', 'heap_per_sub', 'free', 'min_free',
+                                                       'largest', 'max_fabrics', 'max_subscriptions')})
+                steps.append(step)
+                if not args.json:
+                    heap = (f"  sub heap {step['last_sub_heap']} B, free {step['free']} B, "
+                            f"largest {step['largest']} B" if stats else '')
+                    print(f"fabrics {step['fabrics']} subs {step['subscriptions']:3}: fan-out "
+                          f"first {step['fanout_first_ms']:7.2f} ms last {step['fanout_last_ms']:7.2f} ms "
+                          f"(max {step['fanout_max_ms']:7.2f}){heap}")
+    except (TimeoutError, RuntimeError) as e:
+        limit = {
+            'fabrics': len(sessions),
+            'subscriptions': sum(s.subscriptions for s in sessions),
+            'error': str(e),
+        }
+    finally:
+        for session in sessions:
+            session.close()
+        if args.app:
+            target.close()
+
+    if args.json:
+        print(json.dumps({'steps': steps, 'limit': limit}, indent=2))
+    elif limit:
+        print(f"Limit: {limit['error']} at {limit['fabrics']} fabric(s), {limit['subscriptions']} subscription(s)")
+    else:
+        print(f"No failure up to {args.fabrics} fabric(s) x {args.subs_per_fabric} subscription(s)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,348 @@
+#!/usr/bin/env python3
+"""
+Measure time-to-reachable across Thread reboot cycles
+
+Simulator (--ot-cli):
+  Runs two OpenThread POSIX simulation nodes (ot-cli-ftd from an OpenThread
+  "script/cmake-build simulation" build). Node 1 forms the network and runs
+  the SRP server. Node 2 stands in for the switch. Each cycle kills node 2
+  (a power cut), restarts it, and times three milestones from process
+  start:
+    attached    role is child/router/leader
+    srp         SRP host and the _matter._tcp service are Registered
+    reachable   node 1 gets a ping reply from node 2's mesh-local EID
+
+  The modes:
+    warm   node 2 keeps its settings file, as the device keeps OpenThread
+           state in NVS. It restores its role with a Child Update / Link
+           Request and re-registers under the same SRP key.
+    cold   the settings file is deleted and the dataset re-entered, so the
+           node runs a full parent search and generates a new SRP key. Each
+           cold boot registers a fresh host name: the server would refuse
+           the old name to a new key until the key lease expires, which is
+           the state that persistence protects.
+    router warm reboots of node 2 as a router, run twice: once with the
+           OpenThread default router selection jitter and once with the
+           shortened jitter main/app_thread.cpp applies after rebooting as
+           a router (CONFIG_APP_THREAD_ROUTER_RESTORE_JITTER_S). While
+           node 2 is down the leader releases its router ID, so the Link
+           Request restore fails and node 2 attaches as a child first, the
+           case the shortened jitter is for. Adds a fourth milestone:
+    router     role is router again
+
+Device (--port):
+  Resets the device through the serial RTS line and reads the
+  "THREAD reach: {json}" line that main/app_thread.cpp logs once the SRP
+  and first CASE milestones are in (keep a controller subscribed so CASE
+  comes back after each reboot).
+
+Usage:
+    python3 scripts/thread_reattach_bench.py --ot-cli ~/openthread/build/simulation/examples/apps/cli/ot-cli-ftd
+    python3 scripts/thread_reattach_bench.py --ot-cli ... --mode warm --cycles 100 --json
+    python3 scripts/thread_reattach_bench.py --ot-cli ... --mode router --cycles 10
+    python3 scripts/thread_reattach_bench.py --port /dev/ttyACM0 --cycles 20
+"""
+
+import argparse
+import glob
+import json
+import os
+import queue
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from linux_bench import summarize  # noqa: E402
+
+LEADER_ID = 1
+DUT_ID = 2
+SERVICE = '_matter._tcp'
+SERVICE_PORT = 5540
+MILESTONES = ('attached', 'srp', 'reachable')
+ROUTER_MILESTONES = ('attached', 'router', 'srp', 'reachable')
+ATTACHED_ROLES = ('child', 'router', 'leader')
+ROUTER_ROLES = ('router', 'leader')
+OT_DEFAULT_JITTER_S = 120          # OpenThread router selection jitter default
+
+PING_OK_PATTERN = re.compile(r'(\d+) packets transmitted, (\d+) packets received')
+IPV6_PATTERN = re.compile(r'^[0-9a-f:]+$')
+REACH_PATTERN = re.compile(r'THREAD reach: (\{.*\})')
+
+
+class OtNode:
+    """One ot-cli-ftd simulation process driven through its CLI."""
+
+    def __init__(self, ot_cli, node_id, workdir):
+        self.node_id = node_id
+        self.workdir = workdir
+        self.lines = queue.Queue()
+        self.started = time.monotonic()
+        self.proc = subprocess.Popen([ot_cli, str(node_id)], cwd=workdir, stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, bufsize=1)
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        for line in self.proc.stdout:
+            # The prompt is printed without a newline and prefixes the next output line
+            self.lines.put(line.strip().removeprefix('> ').strip())
+        self.lines.put(None)
+
+    def cmd(self, text, timeout=10.0):
+        """Run a CLI command and return its output lines; raises on Error."""
+        while not self.lines.empty():
+            self.lines.get_nowait()
+        self.proc.stdin.write(text + '\n')
+        self.proc.stdin.flush()
+        out = []
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError(f'node {self.node_id}: "{text}" timed out')
+            try:
+                line = self.lines.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if line is None:
+                raise RuntimeError(f'node {self.node_id} exited')
+            if line == 'Done':
+                return out
+            if line.startswith('Error'):
+                raise RuntimeError(f'node {self.node_id}: "{text}": {line}')
+            if line and line != text:
+                out.append(line)
+
+    def state(self):
+        out = self.cmd('state')
+        return out[-1] if out else ''
+
+    def kill(self):
+        self.proc.send_signal(signal.SIGKILL)
+        self.proc.wait()
+
+
+def wipe_settings(workdir, node_id):
+    for path in glob.glob(os.path.join(workdir, 'tmp', f'*_{node_id}.*')):
+        os.remove(path)
+
+
+def start_leader(args, workdir):
+    leader = OtNode(args.ot_cli, LEADER_ID, workdir)
+    for command in ('dataset init new', 'dataset commit active', 'ifconfig up', 'thread start'):
+        leader.cmd(command)
+    deadline = time.monotonic() + args.timeout
+    while leader.state() != 'leader':
+        if time.monotonic() > deadline:
+            raise TimeoutError('leader did not form a network')
+        time.sleep(0.2)
+    leader.cmd('srp server enable')
+    dataset = leader.cmd('dataset active -x')[-1]
+    return leader, dataset
+
+
+def boot_dut(args, workdir, mode, dataset, cycle, jitter=None):
+    """Restart node 2 as the device does after a power cut."""
+    if mode == 'cold':
+        wipe_settings(workdir, DUT_ID)
+    dut = OtNode(args.ot_cli, DUT_ID, workdir)
+    host = f'm5nanoc6-{cycle}' if mode == 'cold' else 'm5nanoc6'
+    commands = [f'dataset set active {dataset}'] if mode == 'cold' else []
+    if jitter is not None:
+        # Not persisted: app_thread_init() sets it on every boot that follows a router role
+        commands.append(f'routerselectionjitter {jitter}')
+    # Services are not persisted: the Matter stack re-adds them on every boot as well
+    commands += ['ifconfig up', 'thread start', f'srp client host name {host}', 'srp client host address auto',
+                 f'srp client service add {host} {SERVICE} {SERVICE_PORT}', 'srp client autostart enable']
+    for command in commands:
+        dut.cmd(command)
+    return dut
+
+
+def poll_milestones(args, leader, dut, milestones=MILESTONES, timeout=None):
+    """Milestone times in ms since node 2 started, or None on timeout."""
+    times = {}
+    mleid = None
+    deadline = dut.started + (timeout or args.timeout)
+    while len(times) < len(milestones):
+        if time.monotonic() > deadline:
+            return None
+        now_ms = (time.monotonic() - dut.started) * 1000
+        state = dut.state()
+        if 'attached' not in times and state in ATTACHED_ROLES:
+            times['attached'] = now_ms
+            mleid = next((line for line in dut.cmd('ipaddr mleid') if IPV6_PATTERN.match(line)), None)
+        if 'router' in milestones and 'router' not in times and state in ROUTER_ROLES:
+            times['router'] = now_ms
+        if 'attached' in times and 'srp' not in times:
+            host_state = dut.cmd('srp client host state')
+            services = dut.cmd('srp client service')
+            if host_state and host_state[-1] == 'Registered' and services and \
+                    all('state:Registered' in line for line in services):
+                times['srp'] = now_ms
+        if 'srp' in times and 'reachable' not in times and mleid:
+            # The command returns after the reply timeout; the reply itself came in at send time + RTT
+            sent_ms = (time.monotonic() - dut.started) * 1000
+            match = None
+            for line in leader.cmd(f'ping {mleid} 8 1 1 64 1', timeout=5):
+                match = PING_OK_PATTERN.search(line) or match
+            if match and int(match.group(2)) > 0:
+                times['reachable'] = sent_ms
+                continue
+        time.sleep(args.poll_ms / 1000)
+    return times
+
+
+def release_router_id(leader, dut):
+    """Make the leader forget node 2's router ID so the Link Request after reboot fails."""
+    rloc16 = int(dut.cmd('rloc16')[-1], 16)
+    dut.kill()
+    try:
+        leader.cmd(f'releaserouterid {rloc16 >> 10}')
+    except RuntimeError as e:
+        raise RuntimeError(f'{e} (the leader needs the releaserouterid CLI command)') from e
+
+
+def make_router(args, workdir, leader, dataset):
+    """Warm boot node 2 with a 1 s jitter until it is a router, so the router cycles start from that role."""
+    dut = boot_dut(args, workdir, 'warm', dataset, 0, jitter=1)
+    if poll_milestones(args, leader, dut, ROUTER_MILESTONES) is None:
+        raise TimeoutError('node 2 did not become a router')
+    release_router_id(leader, dut)
+
+
+def run_simulator(args):
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_reattach_')
+    results = {}
+    leader = None
+    try:
+        leader, dataset = start_leader(args, workdir)
+        # First boot commissions node 2 (dataset in its settings) for the warm cycles
+        dut = boot_dut(args, workdir, 'cold', dataset, 0)
+        if poll_milestones(args, leader, dut) is None:
+            raise TimeoutError('initial attach did not complete')
+        dut.kill()
+
+        for mode in args.modes:
+            jitter = {'router-default': OT_DEFAULT_JITTER_S, 'router-restore': args.restore_jitter}.get(mode)
+            milestones = MILESTONES if jitter is None else ROUTER_MILESTONES
+            if jitter is not None:
+                make_router(args, workdir, leader, dataset)
+            samples = {name: [] for name in milestones}
+            failures = 0
+            for cycle in range(1, args.cycles + 1):
+                time.sleep(args.down_s)
+                boot_mode = 'warm' if jitter is not None else mode
+                dut = boot_dut(args, workdir, boot_mode, dataset, cycle, jitter)
+                # Router cycles may sit out the whole jitter as a child
+                times = poll_milestones(args, leader, dut, milestones, args.timeout + (jitter or 0))
+                if jitter is not None and times is not None:
+                    release_router_id(leader, dut)
+                else:
+                    dut.kill()
+                if times is None:
+                    failures += 1
+                    if jitter is not None:
+                        make_router(args, workdir, leader, dataset)
+                    continue
+                for name in milestones:
+                    samples[name].append(times[name])
+                if not args.json:
+                    print(f'{mode} {cycle:4d}: ' + ' '.join(f'{name}={times[name]:.0f}ms' for name in milestones))
+            results[mode] = {'cycles': args.cycles, 'failures': failures}
+            if jitter is not None:
+                results[mode]['jitter_s'] = jitter
+            results[mode].update({name: summarize(v) for name, v in samples.items() if v})
+    finally:
+        if leader:
+            leader.kill()
+        shutil.rmtree(workdir, ignore_errors=True)
+    return results
+
+
+def run_device(args):
+    import serial
+    port = serial.Serial(args.port, args.baud, timeout=1)
+    samples = {'attached_ms': [], 'srp_ms': [], 'case_ms': []}
+    failures = 0
+    for cycle in range(1, args.cycles + 1):
+        # Same reset sequence as esptool's hard reset
+        port.rts = True
+        time.sleep(0.1)
+        port.rts = False
+        deadline = time.monotonic() + args.timeout
+        reach = None
+        while reach is None and time.monotonic() < deadline:
+            match = REACH_PATTERN.search(port.readline().decode('utf-8', errors='replace'))
+            if match:
+                reach = json.loads(match.group(1))
+        if reach is None or not all(reach[name] for name in samples):
+            failures += 1
+            continue
+        for name in samples:
+            samples[name].append(reach[name])
+        if not args.json:
+            print(f'device {cycle:4d}: ' + ' '.join(f'{name}={reach[name]}' for name in samples) +
+                  f' role={reach["role"]}')
+    result = {'cycles': args.cycles, 'failures': failures}
+    result.update({name.removesuffix('_ms'): summarize(v) for name, v in samples.items() if v})
+    return {'device': result}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure Thread time-to-reachable across reboot cycles',
+        epilog=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    target_group = parser.add_mutually_exclusive_group(required=True)
+    target_group.add_argument('--ot-cli', help='OpenThread simulation ot-cli-ftd binary')
+    target_group.add_argument('--port', help='Device serial port')
+    parser.add_argument('--baud', type=int, default=115200, help='Serial baud rate (default: 115200)')
+    parser.add_argument('--mode', choices=['warm', 'cold', 'both', 'router'], default='both',
+                        help='Simulator: keep (warm) or wipe (cold) node settings across reboots, or reboot as a '
+                             'router with the default and the restore jitter (default: both)')
+    parser.add_argument('--restore-jitter', type=int, default=10,
+                        help='Simulator: CONFIG_APP_THREAD_ROUTER_RESTORE_JITTER_S for --mode router (default: 10)')
+    parser.add_argument('--cycles', type=int, default=25, help='Reboot cycles per mode (default: 25)')
+    parser.add_argument('--timeout', type=float, default=60.0, help='Per-cycle timeout in seconds (default: 60)')
+    parser.add_argument('--poll-ms', type=int, default=50, help='Simulator milestone poll period (default: 50)')
+    parser.add_argument('--down-s', type=float, default=1.0, help='Simulator power-off time per cycle (default: 1)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+
+    args = parser.parse_args()
+    args.modes = {'both': ['warm', 'cold'], 'router': ['router-default', 'router-restore']}.get(args.mode, [args.mode])
+    if not 1 <= args.restore_jitter <= 255:
+        sys.exit('Error: --restore-jitter must be 1-255')
+
+    try:
+        results = run_device(args) if args.port else run_simulator(args)
+    except (TimeoutError, RuntimeError) as e:
+        print(f'Error: {e}')
+        sys.exit(1)
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+        return
+
+    print()
+    for mode, result in results.items():
+        print(f'{mode}: {result["cycles"]} cycles, {result["failures"]} timed out')
+        for name, summary in result.items():
+            if isinstance(summary, dict):
+                print(f'  {name:<10} p50 {summary["p50_ms"]:8.1f} ms  p95 {summary["p95_ms"]:8.1f} ms  '
+                      f'max {summary["max_ms"]:8.1f} ms')
+
+    default, restore = results.get('router-default', {}), results.get('router-restore', {})
+    if 'router' in default and 'router' in restore:
+        print(f'router role regained: p50 {restore["router"]["p50_ms"]:.0f} ms with a {restore["jitter_s"]} s jitter, '
+              f'{default["router"]["p50_ms"]:.0f} ms with the default {default["jitter_s"]} s')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""
+Check and time the WS2812 symbol encoder against a 60 Hz frame budget
+
+Builds main/app_ws2812_engine.cpp for the host with a small timing loop and:
+  1. checks the encoder against a bit-by-bit reference for random frames,
+     fed in random chunk sizes as the RMT driver refills its buffer
+  2. checks the framebuffer's changed-pixel tracking
+  3. times encoding per pixel, in 24-symbol refills (ESP32-C6 ping-pong
+     half block) and 1024-symbol refills (RMT DMA buffer)
+  4. shows that a full frame fits the frame budget: the encoder runs ahead
+     of the wire in the refill interrupt, so a frame takes its wire time
+     (30 us per pixel) plus the latch, as long as one refill encodes faster
+     than it transmits
+  5. counts the pixels an OTA progress bar actually sends, compared with
+     full frames
+
+Host timings are for the host CPU. On the device, "matter led-stats" prints
+the measured duration of the last frame (last_us).
+
+Usage:
+    python3 scripts/ws2812_bench.py --pixels 300
+    python3 scripts/ws2812_bench.py --pixels 540 --fps 60 --json
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import random
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import host_engine  # noqa: E402
+
+RESOLUTION_HZ = 10000000
+BYTES_PER_PIXEL = 3
+SYMBOLS_PER_PIXEL = 24
+BIT_NS = 1250                       # T0H + T0L = T1H + T1L
+RESET_US = 300
+PINGPONG_SYMBOLS = 24               # Half of the 48-symbol channel memory (ESP32-C6)
+DMA_SYMBOLS = 1024
+LENGTHS = (1, 60, 150, 300, 540, 1024)
+
+# Timing loop: encodes a frame in chunk-sized refills, returns ns per frame
+HARNESS_SRC = r'''
+#include <chrono>
+#include <stdint.h>
+#include "app_ws2812_engine.h"
+
+extern "C" double ws2812_bench_encode(const app_ws2812_lut_t *lut, const uint8_t *data, size_t len, size_t chunk,
+                                      int iterations, uint32_t *sink)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        size_t written = 0;
+        bool done = false;
+        while (!done) {
+            written += app_ws2812_encode(lut, data, len, written, sink, chunk, &done);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+'''
+
+
+class Lut(ctypes.Structure):
+    _fields_ = [('nibble', (ctypes.c_uint32 * 4) * 16), ('reset', ctypes.c_uint32)]
+
+
+class Framebuffer(ctypes.Structure):
+    _fields_ = [('grb', ctypes.POINTER(ctypes.c_uint8)), ('count', ctypes.c_uint16), ('dirty_end', ctypes.c_uint16)]
+
+
+def build_engine(workdir):
+    """Compile the engine and the timing loop into a shared library and bind their functions."""
+    lib = host_engine.build(workdir, 'ws2812_bench', ['app_ws2812_engine.cpp'], harness=HARNESS_SRC)
+    lib.app_ws2812_lut_init.argtypes = [ctypes.POINTER(Lut), ctypes.c_uint32]
+    lib.app_ws2812_encode.argtypes = [ctypes.POINTER(Lut), ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t,
+                                      ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_bool)]
+    lib.app_ws2812_encode.restype = ctypes.c_size_t
+    lib.app_ws2812_fb_init.argtypes = [ctypes.POINTER(Framebuffer), ctypes.c_void_p, ctypes.c_uint16]
+    lib.app_ws2812_fb_set.argtypes = [ctypes.POINTER(Framebuffer), ctypes.c_uint16, ctypes.c_uint8, ctypes.c_uint8,
+                                      ctypes.c_uint8]
+    lib.app_ws2812_fb_set.restype = ctypes.c_bool
+    lib.app_ws2812_fb_fill.argtypes = [ctypes.POINTER(Framebuffer), ctypes.c_uint16, ctypes.c_uint16,
+                                       ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8]
+    lib.app_ws2812_fb_fill.restype = ctypes.c_uint16
+    lib.app_ws2812_fb_take_dirty.argtypes = [ctypes.POINTER(Framebuffer)]
+    lib.app_ws2812_fb_take_dirty.restype = ctypes.c_uint16
+    lib.ws2812_bench_encode.argtypes = [ctypes.POINTER(Lut), ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t,
+                                        ctypes.c_int, ctypes.c_void_p]
+    lib.ws2812_bench_encode.restype = ctypes.c_double
+    return lib
+
+
+def reference_symbols(data):
+    """Bit-by-bit encoding at RESOLUTION_HZ: 0 = 0.3/0.9 us, 1 = 0.9/0.3 us, then the latch."""
+    zero = 3 | (1 << 15) | (9 << 16)
+    one = 9 | (1 << 15) | (3 << 16)
+    out = []
+    for byte in data:
+        for bit in range(7, -1, -1):
+            out.append(one if byte >> bit & 1 else zero)
+    half = RESET_US * RESOLUTION_HZ // 2000000
+    out.append(half | (half << 16))
+    return out
+
+
+def encode_chunked(lib, lut, data, rng):
+    """Encode like the RMT driver: refills of varying size until the encoder reports done."""
+    buf = (ctypes.c_uint8 * max(1, len(data))).from_buffer_copy(bytes(data) or b'\0')
+    symbols = []
+    done = ctypes.c_bool(False)
+    while not done.value:
+        free = rng.choice((PINGPONG_SYMBOLS, 48, DMA_SYMBOLS, rng.randint(1, 100)))
+        out = (ctypes.c_uint32 * free)()
+        n = lib.app_ws2812_encode(ctypes.byref(lut), buf, len(data), len(symbols), out, free, ctypes.byref(done))
+        if n > free:
+            raise AssertionError(f'encoder wrote {n} symbols into {free}')
+        symbols.extend(out[:n])
+    return symbols
+
+
+def check_encoder(lib, lut, rng, frames):
+    for _ in range(frames):
+        pixels = rng.choice((0, 1, 2, 5, 60, rng.randint(1, 400)))
+        data = bytes(rng.getrandbits(8) for _ in range(pixels * BYTES_PER_PIXEL))
+        got = encode_chunked(lib, lut, data, rng)
+        if got != reference_symbols(data):
+            first = next((i for i, (a, b) in enumerate(zip(got, reference_symbols(data))) if a != b), len(got))
+            raise AssertionError(f'{pixels}-pixel frame differs from the reference at symbol {first}')
+
+
+def check_framebuffer(lib):
+    count = 10
+    buf = (ctypes.c_uint8 * (count * BYTES_PER_PIXEL))()
+    fb = Framebuffer()
+    lib.app_ws2812_fb_init(ctypes.byref(fb), buf, count)
+    checks = [
+        (lib.app_ws2812_fb_take_dirty(ctypes.byref(fb)), count, 'a new buffer sends every pixel'),
+        (lib.app_ws2812_fb_take_dirty(ctypes.byref(fb)), 0, 'nothing changed'),
+        (lib.app_ws2812_fb_set(ctypes.byref(fb), 3, 0, 0, 0), False, 'writing the same color is not a change'),
+        (lib.app_ws2812_fb_set(ctypes.byref(fb), 3, 1, 2, 3), True, 'a new color is a change'),
+        (bytes(buf[9:12]), bytes((2, 1, 3)), 'wire order is G, R, B'),
+        (lib.app_ws2812_fb_set(ctypes.byref(fb), 1, 9, 9, 9), True, 'a second change'),
+        (lib.app_ws2812_fb_take_dirty(ctypes.byref(fb)), 4, 'send up to the last changed pixel'),
+        (lib.app_ws2812_fb_fill(ctypes.byref(fb), 8, 5, 7, 7, 7), 2, 'fills are clipped to the strip'),
+        (lib.app_ws2812_fb_take_dirty(ctypes.byref(fb)), count, 'a change at the end sends the whole chain'),
+        (lib.app_ws2812_fb_set(ctypes.byref(fb), count, 1, 1, 1), False, 'out of range is ignored'),
+    ]
+    for got, want, what in checks:
+        if got != want:
+            raise AssertionError(f'framebuffer: {what}: got {got!r}, want {want!r}')
+
+
+def time_encode(lib, lut, pixels, chunk, rng):
+    data = bytes(rng.getrandbits(8) for _ in range(pixels * BYTES_PER_PIXEL))
+    buf = (ctypes.c_uint8 * len(data)).from_buffer_copy(data)
+    sink = (ctypes.c_uint32 * chunk)()
+    iterations = max(20, 200000 // pixels)
+    lib.ws2812_bench_encode(ctypes.byref(lut), buf, len(data), chunk, 10, sink)    # Warm up
+    return lib.ws2812_bench_encode(ctypes.byref(lut), buf, len(data), chunk, iterations, sink)
+
+
+def progress_bar_pixels(lib, pixels):
+    """Pixels sent while an OTA progress bar goes 0-100% over an on-colored bar, as app_driver renders it."""
+    buf = (ctypes.c_uint8 * (pixels * BYTES_PER_PIXEL))()
+    fb = Framebuffer()
+    lib.app_ws2812_fb_init(ctypes.byref(fb), buf, pixels)
+    lib.app_ws2812_fb_fill(ctypes.byref(fb), 0, pixels, 0, 0, 128)
+    lib.app_ws2812_fb_take_dirty(ctypes.byref(fb))
+    sent = frames = 0
+    for percent in range(101):
+        lit = pixels * percent // 100
+        lib.app_ws2812_fb_fill(ctypes.byref(fb), 0, lit, 0, 128, 128)
+        lib.app_ws2812_fb_fill(ctypes.byref(fb), lit, pixels - lit, 0, 0, 128)
+        n = lib.app_ws2812_fb_take_dirty(ctypes.byref(fb))
+        sent += n
+        frames += 1 if n else 0
+    return sent, frames
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Check and time the WS2812 symbol encoder against a frame budget',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+    )
+    parser.add_argument('--pixels', type=int, default=300, help='Status bar length to check (default: 300)')
+    parser.add_argument('--fps', type=float, default=60.0, help='Frame rate to fit (default: 60)')
+    parser.add_argument('--frames', type=int, default=200, help='Random frames checked against the reference')
+    parser.add_argument('--seed', type=int, default=1, help='Random seed (default: 1)')
+    parser.add_argument('--json', action='store_true', help='Print results as JSON')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    budget_us = 1e6 / args.fps
+    refill_period_ns = PINGPONG_SYMBOLS * BIT_NS
+
+    workdir = tempfile.mkdtemp(prefix='m5nanoc6_ws2812_')
+    try:
+        lib = build_engine(workdir)
+        lut = Lut()
+        lib.app_ws2812_lut_init(ctypes.byref(lut), RESOLUTION_HZ)
+        try:
+            check_encoder(lib, lut, rng, args.frames)
+            check_framebuffer(lib)
+        except AssertionError as e:
+            print(f'FAIL: {e}')
+            sys.exit(1)
+
+        rows = []
+        for pixels in sorted(set(LENGTHS) | {args.pixels}):
+            pingpong_ns = time_encode(lib, lut, pixels, PINGPONG_SYMBOLS, rng)
+            dma_ns = time_encode(lib, lut, pixels, DMA_SYMBOLS, rng)
+            wire_us = pixels * SYMBOLS_PER_PIXEL * BIT_NS / 1000 + RESET_US
+            # Every refill after the first overlaps the wire; only the first delays the frame
+            refill_ns = pingpong_ns / pixels * PINGPONG_SYMBOLS / SYMBOLS_PER_PIXEL
+            frame_us = wire_us + refill_ns / 1000
+            rows.append({
+                'pixels': pixels,
+                'encode_ns_per_pixel': round(pingpong_ns / pixels, 1),
+                'encode_ns_per_pixel_dma': round(dma_ns / pixels, 1),
+                'refill_margin': round(refill_period_ns / refill_ns, 1),
+                'frame_us': round(frame_us, 1),
+                'fits': frame_us <= budget_us,
+            })
+        sent, frames = progress_bar_pixels(lib, args.pixels)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    max_pixels = int((budget_us - RESET_US) * 1000 // (SYMBOLS_PER_PIXEL * BIT_NS))
+    target = next(r for r in rows if r['pixels'] == args.pixels)
+    results = {
+        'checked_frames': args.frames,
+        'budget_us': round(budget_us, 1),
+        'max_pixels_in_budget': max_pixels,
+        'lengths': rows,
+        'progress_bar': {
+            'pixels': args.pixels,
+            'frames': frames,
+            'pixels_sent': sent,
+            'full_frame_pixels': frames * args.pixels,
+        },
+        'pass': target['fits'] and target['refill_margin'] > 1,
+    }
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+    else:
+        print(f'Encoder matches the reference on {args.frames} random frames; framebuffer checks pass')
+        print(f'Frame budget at {args.fps:g} Hz: {budget_us:.0f} us -> at most {max_pixels} pixels on the wire')
+        print()
+        print(f'{"pixels":>7} {"ns/px":>8} {"ns/px dma":>10} {"refill margin":>14} {"frame us":>10}  fits')
+        for r in rows:
+            print(f'{r["pixels"]:>7} {r["encode_ns_per_pixel"]:>8} {r["encode_ns_per_pixel_dma"]:>10} '
+                  f'{r["refill_margin"]:>13}x {r["frame_us"]:>10}  {"yes" if r["fits"] else "NO"}')
+        print()
+        print(f'OTA progress 0-100% on {args.pixels} pixels: {frames} frames sent {sent} pixels '
+              f'({100 * sent / max(1, frames * args.pixels):.0f}% of full frames)')
+    if not results['pass']:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()